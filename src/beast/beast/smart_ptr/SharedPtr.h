@@ -178,14 +178,14 @@ public:
 #if BEAST_SHAREDPTR_PROVIDE_COMPILER_WORKAROUNDS
     SharedPtr& operator= (SharedPtr && sp)
     {
-        return assign (sp.swap <T> (nullptr));
+        return transfer (sp.swap <T> (nullptr));
     }
 #endif
 
     template <class U>
     SharedPtr& operator= (SharedPtr <U>&& sp)
     {
-        return assign (sp.template swap <U> (nullptr));
+        return transfer (sp.template swap <U> (nullptr));
     }
     /** @} */
 #endif
@@ -262,6 +262,16 @@ private:
         return *this;
     }
 
+    // Take over a reference to u which the caller already holds.
+    // Any previous reference is released.
+    //
+    template <class U>
+    SharedPtr& transfer (U* u)
+    {
+        release (this->swap (u));
+        return *this;
+    }
+
     T* m_p;
 };
 
@@ -0,0 +1,747 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_SHARDEDTAGGEDCACHE_H_INCLUDED
+#define RIPPLE_SHARDEDTAGGEDCACHE_H_INCLUDED
+
+#include "../../beast/beast/chrono/abstract_clock.h"
+#include "../../beast/beast/chrono/chrono_io.h"
+#include "../../beast/beast/Insight.h"
+#include "../../beast/beast/container/hardened_hash.h"
+
+#include <boost/smart_ptr.hpp>
+#include <boost/thread/locks.hpp>
+
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace ripple {
+
+// VFALCO NOTE Deprecated
+struct TaggedCacheLog;
+
+namespace detail {
+
+/** A small reader/writer lock for short critical sections.
+    Acquiring or releasing a shared lock is a single atomic operation when
+    there is no writer, which is much cheaper than boost::shared_mutex.
+    Writers have priority: once a writer is waiting, new readers back off
+    until it is done. Waiters yield instead of blocking in the kernel, so
+    this is only suitable when the lock is held very briefly.
+*/
+class shared_spin_mutex
+{
+public:
+    shared_spin_mutex ()
+        : m_state (0)
+    {
+    }
+
+    shared_spin_mutex (shared_spin_mutex const&) = delete;
+    shared_spin_mutex& operator= (shared_spin_mutex const&) = delete;
+
+    void lock ()
+    {
+        // Claim the writer bit, then wait for the readers to drain
+        std::uint32_t expected (m_state.load (std::memory_order_relaxed));
+        for (;;)
+        {
+            if ((expected & writer) == 0 && m_state.compare_exchange_weak (
+                expected, expected | writer, std::memory_order_acquire))
+                break;
+            std::this_thread::yield ();
+            expected = m_state.load (std::memory_order_relaxed);
+        }
+
+        while (m_state.load (std::memory_order_acquire) != writer)
+            std::this_thread::yield ();
+    }
+
+    void unlock ()
+    {
+        m_state.store (0, std::memory_order_release);
+    }
+
+    void lock_shared ()
+    {
+        std::uint32_t expected (m_state.load (std::memory_order_relaxed));
+        for (;;)
+        {
+            if ((expected & writer) == 0 && m_state.compare_exchange_weak (
+                expected, expected + 1, std::memory_order_acquire))
+                break;
+            if ((expected & writer) != 0)
+            {
+                std::this_thread::yield ();
+                expected = m_state.load (std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void unlock_shared ()
+    {
+        m_state.fetch_sub (1, std::memory_order_release);
+    }
+
+private:
+    static std::uint32_t const writer = 0x80000000;
+
+    std::atomic <std::uint32_t> m_state;
+};
+
+}
+
+/** Lock-striped map/cache combination.
+
+    This has the same semantics and interface as TaggedCache, except that
+    the keys are spread across a fixed number of independent partitions
+    selected by hashing the key. Each partition has its own reader/writer
+    lock, its own counters, and is swept on its own, so threads working on
+    different keys rarely contend.
+
+    Lookups only take the partition lock in shared mode, and a hit on a
+    strongly cached entry never upgrades it: the access time and hit
+    counter are updated atomically. Insertions and promotions of weakly
+    held entries take the partition lock exclusively.
+
+    Since there is no single mutex, peekMutex() is not provided. Callers
+    who need to hold a lock across several cache operations must use
+    TaggedCache instead.
+
+    @note Callers must not modify data objects that are stored in the cache
+          unless they hold their own lock over all cache operations.
+*/
+template <
+    class Key,
+    class T,
+    class Hash = beast::hardened_hash <Key>,
+    class KeyEqual = std::equal_to <Key>,
+    std::size_t Partitions = 16,
+    class SharedMutex = detail::shared_spin_mutex
+>
+class ShardedTaggedCache
+{
+public:
+    typedef SharedMutex mutex_type;
+    typedef std::unique_lock <mutex_type> unique_lock;
+    typedef boost::shared_lock <mutex_type> shared_lock;
+    typedef Key key_type;
+    typedef T mapped_type;
+    typedef boost::weak_ptr <mapped_type> weak_mapped_ptr;
+    typedef boost::shared_ptr <mapped_type> mapped_ptr;
+    typedef beast::abstract_clock <std::chrono::seconds> clock_type;
+
+    static_assert (Partitions > 0, "Partitions must be positive");
+
+private:
+    static int const npartitions = static_cast <int> (Partitions);
+
+public:
+    ShardedTaggedCache (std::string const& name, int size,
+        clock_type::rep expiration_seconds, clock_type& clock, beast::Journal journal,
+            beast::insight::Collector::ptr const& collector = beast::insight::NullCollector::New ())
+        : m_journal (journal)
+        , m_clock (clock)
+        , m_stats (name,
+            std::bind (&ShardedTaggedCache::collect_metrics, this),
+                collector)
+        , m_name (name)
+        , m_target_size (size)
+        , m_target_age (expiration_seconds)
+    {
+        for (auto& p : m_partitions)
+            p.reset (new Partition);
+    }
+
+public:
+    /** Return the clock associated with the cache. */
+    clock_type& clock ()
+    {
+        return m_clock;
+    }
+
+    int getTargetSize () const
+    {
+        return m_target_size.load ();
+    }
+
+    void setTargetSize (int s)
+    {
+        m_target_size.store (s);
+
+        if (s > 0)
+        {
+            // Each partition gets an even share of the target
+            int const share ((s + npartitions - 1) / npartitions);
+            for (auto& p : m_partitions)
+            {
+                unique_lock lock (p->mutex);
+                p->cache.rehash (static_cast<std::size_t> (
+                    (share + (share >> 2)) / p->cache.max_load_factor () + 1));
+            }
+        }
+
+        if (m_journal.debug) m_journal.debug <<
+            m_name << " target size set to " << s;
+    }
+
+    clock_type::rep getTargetAge () const
+    {
+        return m_target_age.load ();
+    }
+
+    void setTargetAge (clock_type::rep s)
+    {
+        m_target_age.store (s);
+        if (m_journal.debug) m_journal.debug <<
+            m_name << " target age set to " << std::chrono::seconds (s);
+    }
+
+    int getCacheSize ()
+    {
+        int count (0);
+        for (auto& p : m_partitions)
+        {
+            shared_lock lock (p->mutex);
+            count += p->cache_count;
+        }
+        return count;
+    }
+
+    int getTrackSize ()
+    {
+        int count (0);
+        for (auto& p : m_partitions)
+        {
+            shared_lock lock (p->mutex);
+            count += p->cache.size ();
+        }
+        return count;
+    }
+
+    float getHitRate ()
+    {
+        std::uint64_t hits (0);
+        std::uint64_t misses (0);
+        get_counts (hits, misses);
+        return (static_cast<float> (hits) * 100) / (1.0f + hits + misses);
+    }
+
+    void clearStats ()
+    {
+        for (auto& p : m_partitions)
+        {
+            p->hits.store (0, std::memory_order_relaxed);
+            p->misses.store (0, std::memory_order_relaxed);
+        }
+    }
+
+    void clear ()
+    {
+        for (auto& p : m_partitions)
+        {
+            unique_lock lock (p->mutex);
+            p->cache.clear ();
+            p->cache_count = 0;
+        }
+    }
+
+    /** Age out entries.
+        Partitions are swept one at a time, and only the partition being
+        swept is locked. Objects released by the sweep are destroyed
+        outside of every lock.
+    */
+    void sweep ()
+    {
+        int cacheRemovals = 0;
+        int mapRemovals = 0;
+        int trackSize = 0;
+
+        clock_type::time_point const now (m_clock.now());
+        int const target_size (m_target_size.load ());
+        clock_type::duration const target_age (
+            std::chrono::seconds (m_target_age.load ()));
+        // Each partition is measured against its share of the target
+        int const share ((target_size + npartitions - 1) / npartitions);
+
+        for (auto& p : m_partitions)
+        {
+            // Keep references to all the stuff we sweep
+            // so that we can destroy them outside the lock.
+            //
+            std::vector <mapped_ptr> stuffToSweep;
+
+            {
+                unique_lock lock (p->mutex);
+
+                clock_type::time_point when_expire;
+
+                if (target_size == 0 ||
+                    (static_cast<int> (p->cache.size ()) <= share))
+                {
+                    when_expire = now - target_age;
+                }
+                else
+                {
+                    when_expire = now - clock_type::duration (
+                        target_age.count() * share / p->cache.size ());
+
+                    clock_type::duration const minimumAge (
+                        std::chrono::seconds (1));
+                    if (when_expire > (now - minimumAge))
+                        when_expire = now - minimumAge;
+                }
+
+                stuffToSweep.reserve (p->cache.size ());
+
+                cache_iterator cit = p->cache.begin ();
+
+                while (cit != p->cache.end ())
+                {
+                    if (cit->second.isWeak ())
+                    {
+                        // weak
+                        if (cit->second.isExpired ())
+                        {
+                            ++mapRemovals;
+                            cit = p->cache.erase (cit);
+                        }
+                        else
+                        {
+                            ++cit;
+                        }
+                    }
+                    else if (cit->second.last_access () <= when_expire)
+                    {
+                        // strong, expired
+                        --p->cache_count;
+                        ++cacheRemovals;
+                        if (cit->second.ptr.unique ())
+                        {
+                            stuffToSweep.push_back (cit->second.ptr);
+                            ++mapRemovals;
+                            cit = p->cache.erase (cit);
+                        }
+                        else
+                        {
+                            // remains weakly cached
+                            cit->second.ptr.reset ();
+                            ++cit;
+                        }
+                    }
+                    else
+                    {
+                        // strong, not expired
+                        ++cit;
+                    }
+                }
+
+                trackSize += p->cache.size ();
+            }
+
+            // stuffToSweep goes out of scope here, outside the lock
+        }
+
+        if (m_journal.trace && (mapRemovals || cacheRemovals)) m_journal.trace <<
+            m_name << ": cache = " << trackSize << "-" << cacheRemovals <<
+                ", map-=" << mapRemovals;
+    }
+
+    bool del (const key_type& key, bool valid)
+    {
+        // Remove from cache, if !valid, remove from map too. Returns true if removed from cache
+        Partition& p (partition (key));
+        unique_lock lock (p.mutex);
+
+        cache_iterator cit = p.cache.find (key);
+
+        if (cit == p.cache.end ())
+            return false;
+
+        Entry& entry = cit->second;
+
+        bool ret = false;
+
+        if (entry.isCached ())
+        {
+            --p.cache_count;
+            entry.ptr.reset ();
+            ret = true;
+        }
+
+        if (!valid || entry.isExpired ())
+            p.cache.erase (cit);
+
+        return ret;
+    }
+
+    /** Replace aliased objects with originals.
+        @see TaggedCache::canonicalize
+    */
+    bool canonicalize (const key_type& key, boost::shared_ptr<T>& data, bool replace = false)
+    {
+        // Return canonical value, store if needed, refresh in cache
+        // Return values: true=we had the data already
+        Partition& p (partition (key));
+        unique_lock lock (p.mutex);
+
+        cache_iterator cit = p.cache.find (key);
+
+        if (cit == p.cache.end ())
+        {
+            p.cache.insert (cache_pair (key, Entry (m_clock.now(), data)));
+            ++p.cache_count;
+            return false;
+        }
+
+        Entry& entry = cit->second;
+        entry.touch (m_clock.now());
+
+        if (entry.isCached ())
+        {
+            if (replace)
+            {
+                entry.ptr = data;
+                entry.weak_ptr = data;
+            }
+            else
+            {
+                data = entry.ptr;
+            }
+
+            return true;
+        }
+
+        mapped_ptr cachedData = entry.lock ();
+
+        if (cachedData)
+        {
+            if (replace)
+            {
+                entry.ptr = data;
+                entry.weak_ptr = data;
+            }
+            else
+            {
+                entry.ptr = cachedData;
+                data = cachedData;
+            }
+
+            ++p.cache_count;
+            return true;
+        }
+
+        entry.ptr = data;
+        entry.weak_ptr = data;
+        ++p.cache_count;
+
+        return false;
+    }
+
+    boost::shared_ptr<T> fetch (const key_type& key)
+    {
+        Partition& p (partition (key));
+
+        // Fast path: a strongly cached hit only needs the shared lock
+        {
+            shared_lock lock (p.mutex);
+
+            cache_iterator cit = p.cache.find (key);
+
+            if (cit == p.cache.end ())
+            {
+                p.misses.fetch_add (1, std::memory_order_relaxed);
+                return mapped_ptr ();
+            }
+
+            Entry& entry = cit->second;
+
+            if (entry.isCached ())
+            {
+                entry.touch (m_clock.now());
+                p.hits.fetch_add (1, std::memory_order_relaxed);
+                return entry.ptr;
+            }
+        }
+
+        // Slow path: the entry is weak and has to be promoted or removed
+        unique_lock lock (p.mutex);
+
+        cache_iterator cit = p.cache.find (key);
+
+        if (cit == p.cache.end ())
+        {
+            p.misses.fetch_add (1, std::memory_order_relaxed);
+            return mapped_ptr ();
+        }
+
+        Entry& entry = cit->second;
+        entry.touch (m_clock.now());
+
+        if (entry.isCached ())
+        {
+            // promoted by another thread while we were unlocked
+            p.hits.fetch_add (1, std::memory_order_relaxed);
+            return entry.ptr;
+        }
+
+        entry.ptr = entry.lock ();
+
+        if (entry.isCached ())
+        {
+            // independent of cache size, so not counted as a hit
+            ++p.cache_count;
+            return entry.ptr;
+        }
+
+        p.cache.erase (cit);
+        p.misses.fetch_add (1, std::memory_order_relaxed);
+        return mapped_ptr ();
+    }
+
+    /** Insert the element into the container.
+        If the key already exists, nothing happens.
+        @return `true` If the element was inserted
+    */
+    bool insert (key_type const& key, T const& value)
+    {
+        mapped_ptr p (boost::make_shared <T> (
+            std::cref (value)));
+        return canonicalize (key, p);
+    }
+
+    bool retrieve (const key_type& key, T& data)
+    {
+        // retrieve the value of the stored data
+        mapped_ptr entry = fetch (key);
+
+        if (!entry)
+            return false;
+
+        data = *entry;
+        return true;
+    }
+
+    /** Refresh the expiration time on a key.
+
+        @param key The key to refresh.
+        @return `true` if the key was found and the object is cached.
+    */
+    bool refreshIfPresent (const key_type& key)
+    {
+        Partition& p (partition (key));
+
+        {
+            shared_lock lock (p.mutex);
+
+            cache_iterator cit = p.cache.find (key);
+
+            if (cit == p.cache.end ())
+                return false;
+
+            if (cit->second.isCached ())
+            {
+                cit->second.touch (m_clock.now());
+                return true;
+            }
+        }
+
+        unique_lock lock (p.mutex);
+
+        cache_iterator cit = p.cache.find (key);
+
+        if (cit == p.cache.end ())
+            return false;
+
+        Entry& entry = cit->second;
+
+        if (! entry.isCached ())
+        {
+            // Convert weak to strong.
+            entry.ptr = entry.lock ();
+
+            if (! entry.isCached ())
+            {
+                // Couldn't get strong pointer,
+                // object fell out of the cache so remove the entry.
+                p.cache.erase (cit);
+                return false;
+            }
+
+            // We just put the object back in cache
+            ++p.cache_count;
+        }
+
+        entry.touch (m_clock.now());
+        return true;
+    }
+
+private:
+    void get_counts (std::uint64_t& hits, std::uint64_t& misses) const
+    {
+        for (auto const& p : m_partitions)
+        {
+            hits += p->hits.load (std::memory_order_relaxed);
+            misses += p->misses.load (std::memory_order_relaxed);
+        }
+    }
+
+    void collect_metrics ()
+    {
+        m_stats.size.set (getCacheSize ());
+
+        {
+            beast::insight::Gauge::value_type hit_rate (0);
+            std::uint64_t hits (0);
+            std::uint64_t misses (0);
+            get_counts (hits, misses);
+            auto const total (hits + misses);
+            if (total != 0)
+                hit_rate = (hits * 100) / total;
+            m_stats.hit_rate.set (hit_rate);
+        }
+    }
+
+private:
+    struct Stats
+    {
+        template <class Handler>
+        Stats (std::string const& prefix, Handler const& handler,
+            beast::insight::Collector::ptr const& collector)
+            : hook (collector->make_hook (handler))
+            , size (collector->make_gauge (prefix, "size"))
+            , hit_rate (collector->make_gauge (prefix, "hit_rate"))
+            { }
+
+        beast::insight::Hook hook;
+        beast::insight::Gauge size;
+        beast::insight::Gauge hit_rate;
+    };
+
+    class Entry
+    {
+    public:
+        mapped_ptr ptr;
+        weak_mapped_ptr weak_ptr;
+
+        Entry (clock_type::time_point const& last_access_,
+            mapped_ptr const& ptr_)
+            : ptr (ptr_)
+            , weak_ptr (ptr_)
+            , m_last_access (last_access_.time_since_epoch().count())
+        {
+        }
+
+        Entry (Entry const& other)
+            : ptr (other.ptr)
+            , weak_ptr (other.weak_ptr)
+            , m_last_access (other.m_last_access.load ())
+        {
+        }
+
+        bool isWeak () const { return ptr == nullptr; }
+        bool isCached () const { return ptr != nullptr; }
+        bool isExpired () const { return weak_ptr.expired (); }
+        mapped_ptr lock () { return weak_ptr.lock (); }
+
+        clock_type::time_point last_access () const
+        {
+            return clock_type::time_point (clock_type::duration (
+                m_last_access.load (std::memory_order_relaxed)));
+        }
+
+        // May be called with only a shared lock held on the partition
+        void touch (clock_type::time_point const& now)
+        {
+            m_last_access.store (now.time_since_epoch().count(),
+                std::memory_order_relaxed);
+        }
+
+    private:
+        std::atomic <clock_type::rep> m_last_access;
+    };
+
+    typedef std::pair <key_type, Entry> cache_pair;
+    typedef std::unordered_map <key_type, Entry, Hash, KeyEqual> cache_type;
+    typedef typename cache_type::iterator cache_iterator;
+
+    struct Partition
+    {
+        Partition ()
+            : cache_count (0)
+            , hits (0)
+            , misses (0)
+        {
+        }
+
+        mutex_type mutable mutex;
+
+        // Number of items cached, protected by the exclusive lock
+        int cache_count;
+        cache_type cache;
+
+        std::atomic <std::uint64_t> hits;
+        std::atomic <std::uint64_t> misses;
+    };
+
+    Partition& partition (key_type const& key)
+    {
+        return *m_partitions [partition_index (m_partition_hash (key))];
+    }
+
+    // hardened_hash may share one process-wide seed, so the partition hash
+    // can equal the hash of the maps inside the partitions. Choosing the
+    // partition from the low bits would then leave each map with keys from
+    // only one residue class. Mix the value and use its high bits instead.
+    static std::size_t partition_index (std::size_t h)
+    {
+        std::uint64_t x (h);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        return static_cast <std::size_t> ((x >> 32) % Partitions);
+    }
+
+    beast::Journal m_journal;
+    clock_type& m_clock;
+    Stats m_stats;
+
+    // Used for logging
+    std::string m_name;
+
+    // Desired number of cache entries (0 = ignore)
+    std::atomic <int> m_target_size;
+
+    // Desired maximum cache age in seconds
+    std::atomic <clock_type::rep> m_target_age;
+
+    // Selects the partition, see partition_index
+    Hash m_partition_hash;
+    std::array <std::unique_ptr <Partition>, Partitions> m_partitions;
+};
+
+}
+
+#endif
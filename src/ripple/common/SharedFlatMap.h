@@ -0,0 +1,267 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_SHAREDFLATMAP_H_INCLUDED
+#define RIPPLE_SHAREDFLATMAP_H_INCLUDED
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace ripple {
+
+/** An ordered map kept in one sorted vector, shared between copies.
+
+    Elements are stored contiguously in key order, so lookups are a binary
+    search and a full copy of the elements is a single allocation.
+
+    Copying the map is constant time: the copies share their elements until
+    one of them calls a non-const member, which gives that map a private
+    copy first. Any mutable iterator obtained before the map was copied
+    must not be used afterwards. Inserting or erasing invalidates all
+    iterators, as it does for std::vector.
+*/
+template <
+    class Key,
+    class T,
+    class Compare = std::less <Key>,
+    class Allocator = std::allocator <std::pair <Key, T>>
+>
+class SharedFlatMap
+{
+public:
+    typedef Key                         key_type;
+    typedef T                           mapped_type;
+    typedef std::pair <Key, T>          value_type;
+    typedef Compare                     key_compare;
+    typedef Allocator                   allocator_type;
+
+private:
+    typedef std::vector <value_type, Allocator> list_type;
+
+public:
+    typedef typename list_type::size_type       size_type;
+    typedef typename list_type::iterator        iterator;
+    typedef typename list_type::const_iterator  const_iterator;
+
+    explicit SharedFlatMap (Compare const& compare = Compare (),
+        Allocator const& alloc = Allocator ())
+        : m_compare (compare)
+        , m_alloc (alloc)
+        , m_list (std::allocate_shared <list_type> (m_alloc, m_alloc))
+    {
+    }
+
+    // Declared so that moves also share, leaving the source usable
+    SharedFlatMap (SharedFlatMap const& other)
+        : m_compare (other.m_compare)
+        , m_alloc (other.m_alloc)
+        , m_list (other.m_list)
+    {
+    }
+
+    SharedFlatMap& operator= (SharedFlatMap const& other)
+    {
+        m_compare = other.m_compare;
+        m_alloc = other.m_alloc;
+        m_list = other.m_list;
+        return *this;
+    }
+
+    /** Returns `true` if this map shares its elements with another. */
+    bool shared () const
+    {
+        return ! m_list.unique ();
+    }
+
+    bool empty () const
+    {
+        return list ().empty ();
+    }
+
+    size_type size () const
+    {
+        return list ().size ();
+    }
+
+    const_iterator begin () const
+    {
+        return list ().begin ();
+    }
+
+    const_iterator end () const
+    {
+        return list ().end ();
+    }
+
+    const_iterator cbegin () const
+    {
+        return list ().begin ();
+    }
+
+    const_iterator cend () const
+    {
+        return list ().end ();
+    }
+
+    iterator begin ()
+    {
+        return modify ().begin ();
+    }
+
+    iterator end ()
+    {
+        return modify ().end ();
+    }
+
+    const_iterator find (Key const& key) const
+    {
+        const_iterator const iter (lower_bound (key));
+        if (iter != end () && ! m_compare (key, iter->first))
+            return iter;
+        return end ();
+    }
+
+    iterator find (Key const& key)
+    {
+        iterator const iter (lower_bound (key));
+        if (iter != end () && ! m_compare (key, iter->first))
+            return iter;
+        return end ();
+    }
+
+    const_iterator lower_bound (Key const& key) const
+    {
+        return std::lower_bound (begin (), end (), key, KeyLess (m_compare));
+    }
+
+    iterator lower_bound (Key const& key)
+    {
+        list_type& list (modify ());
+        return std::lower_bound (list.begin (), list.end (), key,
+            KeyLess (m_compare));
+    }
+
+    const_iterator upper_bound (Key const& key) const
+    {
+        return std::upper_bound (begin (), end (), key, KeyLess (m_compare));
+    }
+
+    /** Insert an element if its key is not already present.
+        @return The element with the key, and `true` if it was inserted.
+    */
+    std::pair <iterator, bool> insert (value_type const& value)
+    {
+        iterator const iter (lower_bound (value.first));
+        if (iter != end () && ! m_compare (value.first, iter->first))
+            return std::make_pair (iter, false);
+        return std::make_pair (modify ().insert (iter, value), true);
+    }
+
+    iterator erase (iterator pos)
+    {
+        return modify ().erase (pos);
+    }
+
+    size_type erase (Key const& key)
+    {
+        iterator const iter (find (key));
+        if (iter == end ())
+            return 0;
+        erase (iter);
+        return 1;
+    }
+
+    /** Remove all elements.
+        Capacity is kept when the elements are not shared.
+    */
+    void clear ()
+    {
+        if (shared ())
+            m_list = std::allocate_shared <list_type> (m_alloc, m_alloc);
+        else
+            m_list->clear ();
+    }
+
+    void swap (SharedFlatMap& other)
+    {
+        std::swap (m_compare, other.m_compare);
+        std::swap (m_alloc, other.m_alloc);
+        m_list.swap (other.m_list);
+    }
+
+private:
+    // Orders elements against a bare key for the binary searches
+    struct KeyLess
+    {
+        explicit KeyLess (Compare const& compare)
+            : m_compare (compare)
+        {
+        }
+
+        bool operator() (value_type const& lhs, Key const& rhs) const
+        {
+            return m_compare (lhs.first, rhs);
+        }
+
+        bool operator() (Key const& lhs, value_type const& rhs) const
+        {
+            return m_compare (lhs, rhs.first);
+        }
+
+        Compare const& m_compare;
+    };
+
+    list_type const& list () const
+    {
+        return *m_list;
+    }
+
+    // Returns the elements, first making them private to this map
+    list_type& modify ()
+    {
+        if (! m_list.unique ())
+        {
+            // Leave room to grow, since the copy is about to be modified
+            std::shared_ptr <list_type> list (
+                std::allocate_shared <list_type> (m_alloc, m_alloc));
+            list->reserve (m_list->size () + m_list->size () / 2 + 4);
+            list->assign (m_list->begin (), m_list->end ());
+            m_list = list;
+        }
+        return *m_list;
+    }
+
+    Compare m_compare;
+    Allocator m_alloc;
+    std::shared_ptr <list_type> m_list;
+};
+
+template <class Key, class T, class Compare, class Allocator>
+void swap (SharedFlatMap <Key, T, Compare, Allocator>& lhs,
+    SharedFlatMap <Key, T, Compare, Allocator>& rhs)
+{
+    lhs.swap (rhs);
+}
+
+}
+
+#endif
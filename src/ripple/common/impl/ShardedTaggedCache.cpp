@@ -0,0 +1,260 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include "../ShardedTaggedCache.h"
+#include "../TaggedCache.h"
+
+#include "../../beast/beast/unit_test/suite.h"
+#include "../../beast/beast/chrono/manual_clock.h"
+
+#include <chrono>
+#include <sstream>
+#include <thread>
+
+namespace ripple {
+
+class ShardedTaggedCache_test : public beast::unit_test::suite
+{
+public:
+    void run ()
+    {
+        beast::Journal const j;
+
+        beast::manual_clock <std::chrono::seconds> clock;
+        clock.set (0);
+
+        typedef int Key;
+        typedef std::string Value;
+        typedef ShardedTaggedCache <Key, Value> Cache;
+
+        Cache c ("test", 1, 1, clock, j);
+
+        // Insert an item, retrieve it, and age it so it gets purged.
+        {
+            expect (c.getCacheSize() == 0);
+            expect (c.getTrackSize() == 0);
+            expect (! c.insert (1, "one"));
+            expect (c.getCacheSize() == 1);
+            expect (c.getTrackSize() == 1);
+
+            {
+                std::string s;
+                expect (c.retrieve (1, s));
+                expect (s == "one");
+            }
+
+            ++clock;
+            c.sweep ();
+            expect (c.getCacheSize () == 0);
+            expect (c.getTrackSize () == 0);
+        }
+
+        // Insert an item, maintain a strong pointer, age it, and
+        // verify that the entry still exists.
+        {
+            expect (! c.insert (2, "two"));
+            expect (c.getCacheSize() == 1);
+            expect (c.getTrackSize() == 1);
+
+            {
+                Cache::mapped_ptr p (c.fetch (2));
+                expect (p != nullptr);
+                ++clock;
+                c.sweep ();
+                expect (c.getCacheSize() == 0);
+                expect (c.getTrackSize() == 1);
+
+                // A fetch promotes the weak entry back into the cache
+                expect (c.fetch (2) == p);
+                expect (c.getCacheSize() == 1);
+                ++clock;
+                c.sweep ();
+                expect (c.getCacheSize() == 0);
+                expect (c.getTrackSize() == 1);
+            }
+
+            // Make sure its gone now that our reference is gone
+            ++clock;
+            c.sweep ();
+            expect (c.getCacheSize() == 0);
+            expect (c.getTrackSize() == 0);
+        }
+
+        // Insert the same key/value pair and make sure we get the same result
+        {
+            expect (! c.insert (3, "three"));
+
+            {
+                Cache::mapped_ptr const p1 (c.fetch (3));
+                Cache::mapped_ptr p2 (boost::make_shared <Value> ("three"));
+                c.canonicalize (3, p2);
+                expect (p1.get() == p2.get());
+            }
+            ++clock;
+            c.sweep ();
+            expect (c.getCacheSize() == 0);
+            expect (c.getTrackSize() == 0);
+        }
+
+        // Put an object in but keep a strong pointer to it, advance the clock a lot,
+        // then canonicalize a new object with the same key, make sure you get the
+        // original object.
+        {
+            expect (! c.insert (4, "four"));
+            expect (c.getCacheSize() == 1);
+            expect (c.getTrackSize() == 1);
+
+            {
+                Cache::mapped_ptr p1 (c.fetch (4));
+                expect (p1 != nullptr);
+                ++clock;
+                c.sweep ();
+                expect (c.getCacheSize() == 0);
+                expect (c.getTrackSize() == 1);
+                Cache::mapped_ptr p2 (boost::make_shared <std::string> ("four"));
+                expect (c.canonicalize (4, p2, false));
+                expect (c.getCacheSize() == 1);
+                expect (c.getTrackSize() == 1);
+                expect (p1.get() == p2.get());
+            }
+
+            ++clock;
+            c.sweep ();
+            expect (c.getCacheSize() == 0);
+            expect (c.getTrackSize() == 0);
+        }
+
+        // Keys must spread across partitions and all be found again
+        {
+            for (int i = 0; i < 1000; ++i)
+                c.insert (i, std::to_string (i));
+            expect (c.getCacheSize() == 1000);
+
+            bool ok (true);
+            for (int i = 0; i < 1000; ++i)
+            {
+                Cache::mapped_ptr const p (c.fetch (i));
+                if (! p || *p != std::to_string (i))
+                    ok = false;
+            }
+            expect (ok, "all keys found");
+            expect (! c.fetch (1000));
+
+            expect (c.del (10, false));
+            expect (! c.fetch (10));
+            expect (c.getTrackSize() == 999);
+
+            c.clear ();
+            expect (c.getCacheSize() == 0);
+            expect (c.getTrackSize() == 0);
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(ShardedTaggedCache,common,ripple);
+
+//------------------------------------------------------------------------------
+
+/** Compares multi-threaded fetch throughput of the two cache flavors. */
+class TaggedCache_timing_test : public beast::unit_test::suite
+{
+public:
+    typedef std::chrono::steady_clock clock_type;
+
+    static int const keyCount = 65536;
+    static int const fetchesPerThread = 1000000;
+
+    template <class Cache>
+    void fill (Cache& c)
+    {
+        for (int i = 0; i < keyCount; ++i)
+        {
+            typename Cache::mapped_ptr p (
+                boost::make_shared <int> (i));
+            c.canonicalize (i, p);
+        }
+    }
+
+    // When `hits` is false every key looked up is absent from the cache
+    template <class Cache>
+    static void worker (Cache& c, int id, bool hits)
+    {
+        int const base (hits ? 0 : keyCount);
+        std::uint32_t x (2166136261u ^ id);
+        for (int i = 0; i < fetchesPerThread; ++i)
+        {
+            x = x * 1664525u + 1013904223u;
+            c.fetch (base + static_cast <int> (x % keyCount));
+        }
+    }
+
+    template <class Cache>
+    void measure (std::string const& name, int nThreads, bool hits)
+    {
+        beast::Journal const j;
+        beast::manual_clock <std::chrono::seconds> clock;
+        clock.set (0);
+
+        Cache c ("timing", keyCount, 60, clock, j);
+        fill (c);
+
+        std::vector <std::thread> threads;
+        threads.reserve (nThreads);
+
+        clock_type::time_point const start (clock_type::now ());
+        for (int i = 0; i < nThreads; ++i)
+            threads.emplace_back (&TaggedCache_timing_test::worker <Cache>,
+                std::ref (c), i, hits);
+        for (auto& t : threads)
+            t.join ();
+        double const seconds (std::chrono::duration_cast <
+            std::chrono::duration <double>> (clock_type::now () - start).count ());
+
+        std::stringstream ss;
+        ss << name << ", " << nThreads << " threads, " <<
+            (hits ? "hits: " : "misses: ") <<
+            static_cast <std::int64_t> (
+                (double (nThreads) * fetchesPerThread) / seconds) <<
+            " fetches/sec";
+        log << ss.str();
+    }
+
+    void run ()
+    {
+        typedef TaggedCache <int, int> Single;
+        typedef ShardedTaggedCache <int, int> Sharded;
+
+        int const maxThreads (std::max (8u,
+            std::thread::hardware_concurrency ()));
+
+        for (int n = 1; n <= maxThreads; n *= 2)
+        {
+            testcase (std::to_string (n) + " threads");
+            measure <Single> ("TaggedCache", n, true);
+            measure <Sharded> ("ShardedTaggedCache", n, true);
+            measure <Single> ("TaggedCache", n, false);
+            measure <Sharded> ("ShardedTaggedCache", n, false);
+            pass ();
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(TaggedCache_timing,common,ripple);
+
+}
@@ -0,0 +1,122 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include "../SharedFlatMap.h"
+
+#include "../../beast/beast/unit_test/suite.h"
+
+#include <map>
+#include <string>
+
+namespace ripple {
+
+class SharedFlatMap_test : public beast::unit_test::suite
+{
+public:
+    typedef SharedFlatMap <int, std::string> Map;
+
+    void testOrdering ()
+    {
+        testcase ("ordering");
+
+        Map m;
+        std::map <int, std::string> expected;
+
+        // Insert in a scrambled order and compare against std::map
+        for (int i = 0; i < 100; ++i)
+        {
+            int const key ((i * 37) % 101);
+            std::string const value (std::to_string (i));
+            bool const inserted (m.insert (std::make_pair (key, value)).second);
+            expect (inserted == expected.insert (
+                std::make_pair (key, value)).second);
+        }
+
+        expect (! m.insert (std::make_pair (37, std::string ("dup"))).second);
+        expect (m.find (37)->second == "1");
+        expect (m.find (1000) == m.end ());
+        expect (m.size () == expected.size ());
+
+        bool same (true);
+        std::map <int, std::string>::const_iterator iter (expected.begin ());
+        for (Map::const_iterator mi (m.begin ()); mi != m.end (); ++mi, ++iter)
+            if (mi->first != iter->first || mi->second != iter->second)
+                same = false;
+        expect (same, "Same order as std::map");
+
+        expect (m.lower_bound (50)->first == 50);
+        expect (m.upper_bound (50)->first == 51);
+        expect (m.upper_bound (100) == m.end ());
+
+        expect (m.erase (50) == 1);
+        expect (m.erase (50) == 0);
+        expect (m.find (50) == m.end ());
+        expect (m.upper_bound (49)->first == 51);
+    }
+
+    void testSharing ()
+    {
+        testcase ("sharing");
+
+        Map a;
+        a.insert (std::make_pair (1, std::string ("one")));
+        a.insert (std::make_pair (2, std::string ("two")));
+
+        Map b (a);
+        expect (a.shared () && b.shared ());
+
+        // Reading does not separate the copies
+        Map const& cb (b);
+        expect (cb.find (1)->second == "one");
+        expect (b.shared ());
+
+        // Writing gives the writer its own elements
+        b.find (1)->second = "uno";
+        expect (! a.shared () && ! b.shared ());
+        expect (a.find (1)->second == "one");
+        expect (b.find (1)->second == "uno");
+
+        b.insert (std::make_pair (3, std::string ("three")));
+        expect (a.size () == 2);
+        expect (b.size () == 3);
+
+        // Assignment and swap share or exchange without copying
+        Map c;
+        c = b;
+        expect (c.shared ());
+        c.clear ();
+        expect (c.empty ());
+        expect (b.size () == 3);
+
+        a.swap (b);
+        expect (a.size () == 3);
+        expect (b.size () == 2);
+        expect (a.find (1)->second == "uno");
+    }
+
+    void run ()
+    {
+        testOrdering ();
+        testSharing ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(SharedFlatMap,common,ripple);
+
+}
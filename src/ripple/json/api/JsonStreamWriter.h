@@ -0,0 +1,103 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_JSONSTREAMWRITER_H_INCLUDED
+#define RIPPLE_JSONSTREAMWRITER_H_INCLUDED
+
+namespace ripple {
+
+/** Writes JSON text incrementally to an output function.
+
+    Text is collected in a buffer of the chunk size and handed to the
+    output each time the buffer fills, so a document can be sent while it
+    is still being produced and is never held whole in memory. Members
+    and elements are either whole Json::Value objects or nested objects
+    and arrays opened and closed explicitly. The text is the same as
+    Json::FastWriter produces, without the trailing newline.
+*/
+class JsonStreamWriter : public beast::Uncopyable
+{
+public:
+    typedef std::function <void (void const*, std::size_t)> Output;
+
+    explicit JsonStreamWriter (Output const& output,
+        std::size_t chunkSize = defaultChunkSize);
+
+    /** Flushes any buffered text. */
+    ~JsonStreamWriter ();
+
+    /** Open an object, as an array element or the top level value. */
+    void startObject ();
+
+    /** Open an object as a member of the current object. */
+    void startObject (std::string const& key);
+
+    void endObject ();
+
+    /** Open an array, as an array element or the top level value. */
+    void startArray ();
+
+    /** Open an array as a member of the current object. */
+    void startArray (std::string const& key);
+
+    void endArray ();
+
+    /** Write a member of the current object. */
+    void add (std::string const& key, Json::Value const& value);
+
+    /** Write an array element or the top level value. */
+    void append (Json::Value const& value);
+
+    /** Hand any buffered text to the output. */
+    void flush ();
+
+    /** Returns the number of bytes written so far, including buffered text. */
+    std::size_t size () const;
+
+    /** Returns the number of bytes value takes when written. */
+    static std::size_t measure (Json::Value const& value);
+
+    enum
+    {
+        defaultChunkSize = 16384
+    };
+
+private:
+    void key (std::string const& name);
+    void element ();
+    void open (char bracket);
+    void close (char bracket);
+
+    void write (char c);
+    void write (char const* s, std::size_t n);
+    void writeString (char const* s);
+    void writeValue (Json::Value const& value);
+
+    Output m_output;
+    std::size_t m_chunkSize;
+    std::string m_buffer;
+    std::size_t m_flushed;
+
+    // One entry per open container, true once it has a member
+    std::vector <bool> m_stack;
+};
+
+}
+
+#endif
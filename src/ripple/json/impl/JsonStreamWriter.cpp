@@ -0,0 +1,410 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include "../../../beast/beast/unit_test/suite.h"
+
+namespace ripple {
+
+JsonStreamWriter::JsonStreamWriter (Output const& output, std::size_t chunkSize)
+    : m_output (output)
+    , m_chunkSize (chunkSize)
+    , m_flushed (0)
+{
+    m_buffer.reserve (m_chunkSize + 64);
+    m_stack.reserve (16);
+}
+
+JsonStreamWriter::~JsonStreamWriter ()
+{
+    flush ();
+}
+
+void JsonStreamWriter::startObject ()
+{
+    element ();
+    open ('{');
+}
+
+void JsonStreamWriter::startObject (std::string const& name)
+{
+    key (name);
+    open ('{');
+}
+
+void JsonStreamWriter::endObject ()
+{
+    close ('}');
+}
+
+void JsonStreamWriter::startArray ()
+{
+    element ();
+    open ('[');
+}
+
+void JsonStreamWriter::startArray (std::string const& name)
+{
+    key (name);
+    open ('[');
+}
+
+void JsonStreamWriter::endArray ()
+{
+    close (']');
+}
+
+void JsonStreamWriter::add (std::string const& name, Json::Value const& value)
+{
+    key (name);
+    writeValue (value);
+}
+
+void JsonStreamWriter::append (Json::Value const& value)
+{
+    element ();
+    writeValue (value);
+}
+
+void JsonStreamWriter::flush ()
+{
+    if (! m_buffer.empty ())
+    {
+        m_output (m_buffer.data (), m_buffer.size ());
+        m_flushed += m_buffer.size ();
+        m_buffer.clear ();
+    }
+}
+
+std::size_t JsonStreamWriter::size () const
+{
+    return m_flushed + m_buffer.size ();
+}
+
+std::size_t JsonStreamWriter::measure (Json::Value const& value)
+{
+    JsonStreamWriter w ([](void const*, std::size_t) { });
+    w.append (value);
+    return w.size ();
+}
+
+//------------------------------------------------------------------------------
+
+void JsonStreamWriter::key (std::string const& name)
+{
+    JSON_ASSERT_MESSAGE (! m_stack.empty (), "JsonStreamWriter: no open object");
+
+    if (m_stack.back ())
+        write (',');
+    else
+        m_stack.back () = true;
+
+    writeString (name.c_str ());
+    write (':');
+}
+
+void JsonStreamWriter::element ()
+{
+    if (m_stack.empty ())
+        return;
+
+    if (m_stack.back ())
+        write (',');
+    else
+        m_stack.back () = true;
+}
+
+void JsonStreamWriter::open (char bracket)
+{
+    write (bracket);
+    m_stack.push_back (false);
+}
+
+void JsonStreamWriter::close (char bracket)
+{
+    JSON_ASSERT_MESSAGE (! m_stack.empty (), "JsonStreamWriter: nothing to close");
+
+    m_stack.pop_back ();
+    write (bracket);
+}
+
+void JsonStreamWriter::write (char c)
+{
+    m_buffer.push_back (c);
+
+    if (m_buffer.size () >= m_chunkSize)
+        flush ();
+}
+
+void JsonStreamWriter::write (char const* s, std::size_t n)
+{
+    m_buffer.append (s, n);
+
+    if (m_buffer.size () >= m_chunkSize)
+        flush ();
+}
+
+void JsonStreamWriter::writeString (char const* s)
+{
+    static char const hex [] = "0123456789ABCDEF";
+
+    write ('"');
+
+    // Copy runs of plain characters in one piece
+    char const* run = s;
+
+    for (; *s != 0; ++s)
+    {
+        char const c = *s;
+        char const* escape = nullptr;
+
+        switch (c)
+        {
+        case '\"': escape = "\\\""; break;
+        case '\\': escape = "\\\\"; break;
+        case '\b': escape = "\\b";  break;
+        case '\f': escape = "\\f";  break;
+        case '\n': escape = "\\n";  break;
+        case '\r': escape = "\\r";  break;
+        case '\t': escape = "\\t";  break;
+        default:
+            if (c > 0 && c <= 0x1F)
+                break;
+            continue;
+        }
+
+        write (run, s - run);
+        run = s + 1;
+
+        if (escape != nullptr)
+        {
+            write (escape, 2);
+        }
+        else
+        {
+            char const u [] = { '\\', 'u', '0', '0', hex [c >> 4], hex [c & 0xF] };
+            write (u, sizeof (u));
+        }
+    }
+
+    write (run, s - run);
+    write ('"');
+}
+
+void JsonStreamWriter::writeValue (Json::Value const& value)
+{
+    switch (value.type ())
+    {
+    case Json::nullValue:
+        write ("null", 4);
+        break;
+
+    case Json::intValue:
+    case Json::uintValue:
+    {
+        // Digits are produced backwards from the end of the buffer
+        char digits [24];
+        char* const end = digits + sizeof (digits);
+        char* p = end;
+        bool const negative = value.type () == Json::intValue && value.asInt () < 0;
+        std::uint64_t n = negative
+            ? std::uint64_t (-std::int64_t (value.asInt ()))
+            : (value.type () == Json::intValue ? std::uint64_t (value.asInt ()) : value.asUInt ());
+
+        do
+        {
+            *--p = char ('0' + n % 10);
+            n /= 10;
+        }
+        while (n != 0);
+
+        if (negative)
+            *--p = '-';
+
+        write (p, end - p);
+    }
+    break;
+
+    case Json::realValue:
+    {
+        std::string const s (Json::valueToString (value.asDouble ()));
+        write (s.data (), s.size ());
+    }
+    break;
+
+    case Json::stringValue:
+        writeString (value.asCString ());
+        break;
+
+    case Json::booleanValue:
+        if (value.asBool ())
+            write ("true", 4);
+        else
+            write ("false", 5);
+        break;
+
+    case Json::arrayValue:
+    {
+        write ('[');
+
+        for (Json::Value::const_iterator it = value.begin (); it != value.end (); ++it)
+        {
+            if (it != value.begin ())
+                write (',');
+
+            writeValue (*it);
+        }
+
+        write (']');
+    }
+    break;
+
+    case Json::objectValue:
+    {
+        write ('{');
+
+        for (Json::Value::const_iterator it = value.begin (); it != value.end (); ++it)
+        {
+            if (it != value.begin ())
+                write (',');
+
+            writeString (it.memberName ());
+            write (':');
+            writeValue (*it);
+        }
+
+        write ('}');
+    }
+    break;
+    }
+}
+
+//------------------------------------------------------------------------------
+
+class JsonStreamWriter_test : public beast::unit_test::suite
+{
+public:
+    static std::string fastWrite (Json::Value const& value)
+    {
+        Json::FastWriter w;
+        std::string s (w.write (value));
+        s.resize (s.size () - 1);
+        return s;
+    }
+
+    static Json::Value sample ()
+    {
+        Json::Value v (Json::objectValue);
+        v ["null"] = Json::Value ();
+        v ["int"] = -2147483647 - 1;
+        v ["uint"] = Json::UInt (4294967295u);
+        v ["real"] = 0.25;
+        v ["bool"] = false;
+        v ["text"] = "quote \" slash \\ tab \t bell \x07 end";
+        v ["empty"] = Json::Value (Json::objectValue);
+
+        Json::Value& a (v ["array"] = Json::Value (Json::arrayValue));
+        for (int i = 0; i < 20; ++i)
+        {
+            Json::Value& e (a.append (Json::objectValue));
+            e ["index"] = i;
+            e ["list"] = Json::Value (Json::arrayValue);
+            e ["list"].append (true);
+            e ["list"].append ("x");
+        }
+
+        return v;
+    }
+
+    void testValue ()
+    {
+        testcase ("value");
+
+        Json::Value const v (sample ());
+        std::string const expected (fastWrite (v));
+
+        // Small chunks make every write cross a chunk boundary
+        for (std::size_t chunk = 1; chunk <= 64; chunk *= 4)
+        {
+            std::string s;
+            std::size_t calls = 0;
+            {
+                JsonStreamWriter w ([&s, &calls] (void const* data, std::size_t bytes)
+                {
+                    s.append (static_cast <char const*> (data), bytes);
+                    ++calls;
+                }, chunk);
+
+                w.append (v);
+            }
+
+            expect (s == expected, "Matches FastWriter");
+            expect (calls >= expected.size () / (chunk + 16), "Written in chunks");
+        }
+
+        expect (JsonStreamWriter::measure (v) == expected.size (), "Measured size");
+    }
+
+    void testIncremental ()
+    {
+        testcase ("incremental");
+
+        Json::Value const v (sample ());
+        std::string s;
+        {
+            JsonStreamWriter w ([&s] (void const* data, std::size_t bytes)
+            {
+                s.append (static_cast <char const*> (data), bytes);
+            });
+
+            w.startObject ();
+            w.add ("first", v ["text"]);
+            w.startArray ("array");
+            for (int i = 0; i < 20; ++i)
+                w.append (v ["array"][i]);
+            w.startObject ();
+            w.endObject ();
+            w.endArray ();
+            w.startObject ("object");
+            w.add ("int", v ["int"]);
+            w.endObject ();
+            w.endObject ();
+        }
+
+        Json::Value expected (Json::objectValue);
+        expected ["first"] = v ["text"];
+        expected ["array"] = v ["array"];
+        expected ["array"].append (Json::objectValue);
+        expected ["object"]["int"] = v ["int"];
+
+        Json::Value parsed;
+        Json::Reader r;
+        expect (r.parse (s, parsed), "Parses");
+        expect (fastWrite (parsed) == fastWrite (expected), "Matches built value");
+    }
+
+    void run ()
+    {
+        testValue ();
+        testIncremental ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(JsonStreamWriter,json,ripple);
+
+}
@@ -47,3 +47,4 @@
 #include "impl/Tests.cpp"
 
 #include "impl/JsonPropertyStream.cpp"
+#include "impl/JsonStreamWriter.cpp"
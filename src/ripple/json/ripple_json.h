@@ -24,8 +24,10 @@
 
 #include "../beast/beast/strings/String.h"
 #include "../beast/beast/utility/PropertyStream.h"
+#include "../beast/beast/Uncopyable.h"
 
 #include <deque>
+#include <functional>
 #include <stack>
 #include <vector>
 
@@ -49,5 +51,6 @@
 #include "api/json_writer.h"
 
 #include "api/JsonPropertyStream.h"
+#include "api/JsonStreamWriter.h"
 
 #endif
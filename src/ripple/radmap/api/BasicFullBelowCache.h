@@ -84,6 +84,17 @@ public:
         m_cache.sweep ();
     }
 
+    /** Remove every item.
+        Used when nodes may have left the store, so that a key can no
+        longer claim its descendants are resident.
+        Thread safety:
+            Safe to call from any thread.
+    */
+    void clear ()
+    {
+        m_cache.clear ();
+    }
+
     /** Refresh the last access time of an item, if it exists.
         Thread safety:
             Safe to call from any thread.
@@ -0,0 +1,831 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include "../../beast/beast/unit_test/suite.h"
+
+namespace ripple {
+
+AccountTxIndex::~AccountTxIndex ()
+{
+}
+
+//------------------------------------------------------------------------------
+
+class SqliteAccountTxIndex
+    : public AccountTxIndex
+    , public beast::LeakChecked <SqliteAccountTxIndex>
+{
+public:
+    SqliteAccountTxIndex (DatabaseCon& txnDB, beast::Journal journal)
+        : m_txnDB (txnDB)
+        , m_journal (journal)
+    {
+    }
+
+    std::string getName () const
+    {
+        return "SQLite";
+    }
+
+    void insertLedger (std::uint32_t ledgerSeq,
+        std::vector <LedgerTxn> const& txns)
+    {
+        static std::string const deleteLedger ("DELETE FROM AccountTransactions WHERE LedgerSeq = ?;");
+        static std::string const deleteTxn ("DELETE FROM AccountTransactions WHERE TransID = ?;");
+        static std::string const insertTxn ("INSERT INTO AccountTransactions "
+            "(TransID, Account, LedgerSeq, TxnSeq) VALUES (?, ?, ?, ?);");
+
+        SqliteDatabase* db = m_txnDB.getDB ()->getSqliteDB ();
+        DeprecatedScopedLock sl (m_txnDB.getDBLock ());
+
+        {
+            SqliteStatement& statement (db->getStatement (deleteLedger));
+            statement.bind (1, ledgerSeq);
+            step (statement);
+        }
+
+        BOOST_FOREACH (LedgerTxn const& txn, txns)
+        {
+            std::string const txID (txn.txID.GetHex ());
+
+            {
+                SqliteStatement& statement (db->getStatement (deleteTxn));
+                statement.bindStatic (1, txID);
+                step (statement);
+            }
+
+            BOOST_FOREACH (RippleAddress const& account, txn.accounts)
+            {
+                SqliteStatement& statement (db->getStatement (insertTxn));
+                statement.bindStatic (1, txID);
+                statement.bind (2, account.humanAccountID ());
+                statement.bind (3, ledgerSeq);
+                statement.bind (4, txn.txnSeq);
+                step (statement);
+            }
+        }
+    }
+
+    std::vector <Entry> getEntries (RippleAddress const& account,
+        std::uint32_t minLedger, std::uint32_t maxLedger, bool forward,
+            Entry const* marker, std::uint32_t offset, std::uint32_t limit)
+    {
+        std::vector <Entry> entries;
+
+        std::string const sql (entriesSQL ("", "AccountTransactions",
+            account, minLedger, maxLedger, forward, marker, offset, limit));
+
+        Database* db = m_txnDB.getDB ();
+        DeprecatedScopedLock sl (m_txnDB.getDBLock ());
+
+        SQL_FOREACH (db, sql)
+        {
+            entries.push_back (getEntry (db));
+        }
+
+        return entries;
+    }
+
+    std::vector <Entry> loadTransactions (RippleAddress const& account,
+        std::uint32_t minLedger, std::uint32_t maxLedger, bool forward,
+            Entry const* marker, std::uint32_t offset, std::uint32_t limit,
+                std::function <void (Database*)> const& onRow)
+    {
+        std::vector <Entry> entries;
+
+        // The entries of a transaction are deleted when it is saved in
+        // another ledger, so matching LedgerSeq only guards against races
+        std::string const sql (entriesSQL (",Status,RawTxn,TxnMeta",
+            "AccountTransactions INNER JOIN Transactions "
+            "ON Transactions.TransID = AccountTransactions.TransID "
+            "AND Transactions.LedgerSeq = AccountTransactions.LedgerSeq",
+            account, minLedger, maxLedger, forward, marker, offset, limit));
+
+        Database* db = m_txnDB.getDB ();
+        DeprecatedScopedLock sl (m_txnDB.getDBLock ());
+
+        SQL_FOREACH (db, sql)
+        {
+            entries.push_back (getEntry (db));
+            onRow (db);
+        }
+
+        return entries;
+    }
+
+    std::vector <RippleAddress> getAffectedAccounts (std::uint32_t ledgerSeq)
+    {
+        std::vector <RippleAddress> accounts;
+        std::string const sql = boost::str (boost::format
+            ("SELECT DISTINCT Account FROM AccountTransactions INDEXED BY AcctLgrIndex WHERE LedgerSeq = '%u';")
+                % ledgerSeq);
+
+        RippleAddress account;
+
+        Database* db = m_txnDB.getDB ();
+        DeprecatedScopedLock sl (m_txnDB.getDBLock ());
+
+        SQL_FOREACH (db, sql)
+        {
+            if (account.setAccountID (db->getStrBinary ("Account")))
+                accounts.push_back (account);
+        }
+
+        return accounts;
+    }
+
+    void deleteBefore (std::uint32_t ledgerSeq)
+    {
+        static std::string const deleteLedgers ("DELETE FROM AccountTransactions WHERE LedgerSeq < ?;");
+
+        SqliteDatabase* db = m_txnDB.getDB ()->getSqliteDB ();
+        DeprecatedScopedLock sl (m_txnDB.getDBLock ());
+
+        SqliteStatement& statement (db->getStatement (deleteLedgers));
+        statement.bind (1, ledgerSeq);
+        step (statement);
+    }
+
+private:
+    // Selects a page of entries, followed by any extra columns
+    std::string entriesSQL (std::string const& columns, std::string const& tables,
+        RippleAddress const& account,
+        std::uint32_t minLedger, std::uint32_t maxLedger, bool forward,
+            Entry const* marker, std::uint32_t offset, std::uint32_t limit)
+    {
+        // Start at the marker by position instead of by counting rows
+        std::string markerClause;
+
+        if (marker != nullptr)
+            markerClause = boost::str (boost::format (
+                "AND (AccountTransactions.LedgerSeq %s %u OR "
+                "(AccountTransactions.LedgerSeq = %u AND TxnSeq %s %u)) ")
+                    % (forward ? ">" : "<")
+                    % marker->ledgerSeq
+                    % marker->ledgerSeq
+                    % (forward ? ">=" : "<=")
+                    % marker->txnSeq);
+
+        std::string const sql = boost::str (boost::format
+            ("SELECT AccountTransactions.LedgerSeq,TxnSeq,AccountTransactions.TransID%s "
+             "FROM %s WHERE Account = '%s' AND AccountTransactions.LedgerSeq BETWEEN %u AND %u %s"
+             "ORDER BY AccountTransactions.LedgerSeq %s, TxnSeq %s, AccountTransactions.TransID %s "
+             "LIMIT %u, %u;")
+                % columns
+                % tables
+                % account.humanAccountID ()
+                % minLedger
+                % maxLedger
+                % markerClause
+                % (forward ? "ASC" : "DESC")
+                % (forward ? "ASC" : "DESC")
+                % (forward ? "ASC" : "DESC")
+                % offset
+                % limit);
+
+        m_journal.trace << "AccountTxIndex query: " << sql;
+
+        return sql;
+    }
+
+    static Entry getEntry (Database* db)
+    {
+        Entry entry;
+        entry.ledgerSeq = static_cast <std::uint32_t> (db->getBigInt ("LedgerSeq"));
+        entry.txnSeq = static_cast <std::uint32_t> (db->getBigInt ("TxnSeq"));
+
+        std::string txID;
+        db->getStr ("TransID", txID);
+        entry.txID.SetHex (txID);
+
+        return entry;
+    }
+
+    void step (SqliteStatement& statement)
+    {
+        int const result = statement.step ();
+
+        if (statement.isError (result))
+            m_journal.warning << "AccountTransactions: " << statement.getError (result);
+    }
+
+    DatabaseCon& m_txnDB;
+    beast::Journal m_journal;
+};
+
+//------------------------------------------------------------------------------
+
+/*  Layout of the NodeStore index.
+
+    Every key is 32 bytes. The first byte tells the two kinds apart, and
+    unused bytes at the end are zero. Numbers are big-endian so that keys
+    sort in numeric order.
+
+    Account entry
+        0           'A'
+        1...20      Account ID
+        21...24     Ledger sequence
+        25...28     Transaction sequence within the ledger
+        Value       The 32 byte transaction ID
+
+    Ledger record
+        0           'L'
+        1...4       Ledger sequence
+        Value       The 20 byte IDs of the accounts the ledger affected
+
+    Floor record
+        0           'F'
+        Value       The 4 byte sequence of the first ledger whose entries
+                    are still used. Backends can't remove keys, so entries
+                    of older ledgers are left in place and skipped.
+*/
+class NodeStoreAccountTxIndex
+    : public AccountTxIndex
+    , public beast::LeakChecked <NodeStoreAccountTxIndex>
+{
+public:
+    enum
+    {
+        accountKind = 'A',
+        ledgerKind = 'L',
+        floorKind = 'F',
+
+        accountBytes = 20,
+        ledgerOffset = 1 + accountBytes,
+        txnOffset = ledgerOffset + 4,
+
+        // Multi-row VALUES are limited to 500 rows by SQLite
+        maxBatchRows = 250
+    };
+
+    NodeStoreAccountTxIndex (std::unique_ptr <NodeStore::Backend> backend,
+        DatabaseCon& txnDB, beast::Journal journal)
+        : m_backend (std::move (backend))
+        , m_txnDB (txnDB)
+        , m_journal (journal)
+        , m_floor (0)
+    {
+        uint256 const key;
+        if (! m_backend->visitFrom (key.begin (), true,
+                [] (NodeObject::Ptr const&) { return false; }))
+            throw std::runtime_error ("The " + m_backend->getName () +
+                " backend can not keep the account transaction index in order");
+
+        NodeObject::Ptr object;
+        if ((m_backend->fetch (floorKey ().begin (), &object) == NodeStore::ok) &&
+                object && (object->getData ().size () == 4))
+            m_floor = getNumber (&object->getData () [0]);
+    }
+
+    std::string getName () const
+    {
+        return m_backend->getName ();
+    }
+
+    void insertLedger (std::uint32_t ledgerSeq,
+        std::vector <LedgerTxn> const& txns)
+    {
+        NodeStore::Batch batch;
+        std::set <uint160> accounts;
+
+        BOOST_FOREACH (LedgerTxn const& txn, txns)
+        {
+            BOOST_FOREACH (RippleAddress const& account, txn.accounts)
+            {
+                uint160 const accountID (account.getAccountID ());
+                Blob data (txn.txID.begin (), txn.txID.end ());
+
+                batch.push_back (NodeObject::createObject (hotTRANSACTION,
+                    ledgerSeq, data, accountKey (accountID, ledgerSeq, txn.txnSeq)));
+
+                accounts.insert (accountID);
+            }
+        }
+
+        Blob data;
+        data.reserve (accounts.size () * accountBytes);
+        BOOST_FOREACH (uint160 const& accountID, accounts)
+            data.insert (data.end (), accountID.begin (), accountID.end ());
+
+        batch.push_back (NodeObject::createObject (hotTRANSACTION,
+            ledgerSeq, data, ledgerKey (ledgerSeq)));
+
+        // Backends do not allow concurrent batches
+        std::lock_guard <std::mutex> lock (m_mutex);
+        m_backend->storeBatch (batch);
+    }
+
+    std::vector <Entry> getEntries (RippleAddress const& account,
+        std::uint32_t minLedger, std::uint32_t maxLedger, bool forward,
+            Entry const* marker, std::uint32_t offset, std::uint32_t limit)
+    {
+        std::vector <Entry> entries;
+
+        minLedger = std::max <std::uint32_t> (minLedger, m_floor);
+
+        if ((limit == 0) || (minLedger > maxLedger))
+            return entries;
+
+        uint160 const accountID (account.getAccountID ());
+
+        std::uint32_t startLedger = forward ? minLedger : maxLedger;
+        std::uint32_t startTxn = forward ? 0 : std::numeric_limits <std::uint32_t>::max ();
+
+        if ((marker != nullptr) && (forward
+            ? (marker->ledgerSeq >= minLedger)
+            : (marker->ledgerSeq <= maxLedger)))
+        {
+            startLedger = marker->ledgerSeq;
+            startTxn = marker->txnSeq;
+        }
+
+        uint256 const start (accountKey (accountID, startLedger, startTxn));
+
+        m_backend->visitFrom (start.begin (), forward,
+            [&] (NodeObject::Ptr const& object)
+            {
+                unsigned char const* const key (object->getHash ().begin ());
+
+                if ((key [0] != accountKind) ||
+                    (memcmp (key + 1, accountID.begin (), accountBytes) != 0))
+                    return false;
+
+                Entry entry;
+                entry.ledgerSeq = getNumber (key + ledgerOffset);
+                entry.txnSeq = getNumber (key + txnOffset);
+
+                if (forward ? (entry.ledgerSeq > maxLedger) : (entry.ledgerSeq < minLedger))
+                    return false;
+
+                if (offset != 0)
+                {
+                    --offset;
+                    return true;
+                }
+
+                Blob const& data (object->getData ());
+
+                if (data.size () != uint256::bytes)
+                {
+                    m_journal.error << "Bad account transaction entry in ledger " << entry.ledgerSeq;
+                    return true;
+                }
+
+                entry.txID = uint256::fromVoid (&data [0]);
+                entries.push_back (entry);
+
+                return entries.size () < limit;
+            });
+
+        return entries;
+    }
+
+    // Index entries are not removed when a ledger is saved again, so an
+    // entry may name a transaction that is now in another ledger.
+    std::vector <Entry> loadTransactions (RippleAddress const& account,
+        std::uint32_t minLedger, std::uint32_t maxLedger, bool forward,
+            Entry const* marker, std::uint32_t offset, std::uint32_t limit,
+                std::function <void (Database*)> const& onRow)
+    {
+        std::vector <Entry> loaded;
+        Entry next;
+        bool afterMarker = false;
+
+        while (loaded.size () < limit)
+        {
+            // Markers are inclusive, so after the first batch ask for one more
+            std::uint32_t const wanted = limit - loaded.size () + (afterMarker ? 1 : 0);
+
+            std::vector <Entry> entries (getEntries (account,
+                minLedger, maxLedger, forward, marker, offset, wanted));
+
+            offset = 0;
+
+            bool const more = entries.size () == wanted;
+
+            if (afterMarker && !entries.empty () && isSameEntry (entries.front (), next))
+                entries.erase (entries.begin ());
+
+            if (more)
+                next = entries.back ();
+
+            for (std::size_t i = 0; i < entries.size (); i += maxBatchRows)
+                loadBatch (entries, i, std::min <std::size_t> (entries.size (), i + maxBatchRows),
+                    loaded, onRow);
+
+            if (!more)
+                break;
+
+            marker = &next;
+            afterMarker = true;
+        }
+
+        return loaded;
+    }
+
+    std::vector <RippleAddress> getAffectedAccounts (std::uint32_t ledgerSeq)
+    {
+        std::vector <RippleAddress> accounts;
+
+        if (ledgerSeq < m_floor)
+            return accounts;
+
+        uint256 const key (ledgerKey (ledgerSeq));
+        NodeObject::Ptr object;
+
+        if ((m_backend->fetch (key.begin (), &object) != NodeStore::ok) || ! object)
+            return accounts;
+
+        Blob const& data (object->getData ());
+        accounts.reserve (data.size () / accountBytes);
+
+        for (std::size_t i = 0; (i + accountBytes) <= data.size (); i += accountBytes)
+        {
+            uint160 accountID;
+            memcpy (accountID.begin (), &data [i], accountBytes);
+
+            RippleAddress account;
+            account.setAccountID (accountID);
+            accounts.push_back (account);
+        }
+
+        return accounts;
+    }
+
+    void deleteBefore (std::uint32_t ledgerSeq)
+    {
+        if (ledgerSeq <= m_floor)
+            return;
+
+        Blob data (4);
+        putNumber (&data [0], ledgerSeq);
+
+        NodeStore::Batch batch;
+        batch.push_back (NodeObject::createObject (hotTRANSACTION,
+            ledgerSeq, data, floorKey ()));
+
+        std::lock_guard <std::mutex> lock (m_mutex);
+        m_backend->storeBatch (batch);
+        m_floor = ledgerSeq;
+    }
+
+private:
+    static bool isSameEntry (Entry const& lhs, Entry const& rhs)
+    {
+        return (lhs.ledgerSeq == rhs.ledgerSeq) && (lhs.txnSeq == rhs.txnSeq) &&
+            (lhs.txID == rhs.txID);
+    }
+
+    // Reads the transactions of entries [first, last) with one query,
+    // skipping those whose transaction is no longer in the entry's ledger
+    void loadBatch (std::vector <Entry> const& entries, std::size_t first, std::size_t last,
+        std::vector <Entry>& loaded, std::function <void (Database*)> const& onRow)
+    {
+        std::string sql ("WITH Page (Pos, TransID, LedgerSeq) AS (VALUES ");
+
+        for (std::size_t i = first; i < last; ++i)
+        {
+            if (i != first)
+                sql += ",";
+
+            sql += boost::str (boost::format ("(%u,'%s',%u)")
+                % i
+                % entries [i].txID.GetHex ()
+                % entries [i].ledgerSeq);
+        }
+
+        sql += ") SELECT Pos,Transactions.LedgerSeq,Status,RawTxn,TxnMeta FROM Page "
+            "INNER JOIN Transactions ON Transactions.TransID = Page.TransID "
+            "AND Transactions.LedgerSeq = Page.LedgerSeq ORDER BY Pos;";
+
+        Database* db = m_txnDB.getDB ();
+        DeprecatedScopedLock sl (m_txnDB.getDBLock ());
+
+        SQL_FOREACH (db, sql)
+        {
+            loaded.push_back (entries [db->getInt ("Pos")]);
+            onRow (db);
+        }
+    }
+
+    static void putNumber (unsigned char* p, std::uint32_t n)
+    {
+        p [0] = static_cast <unsigned char> (n >> 24);
+        p [1] = static_cast <unsigned char> (n >> 16);
+        p [2] = static_cast <unsigned char> (n >> 8);
+        p [3] = static_cast <unsigned char> (n);
+    }
+
+    static std::uint32_t getNumber (unsigned char const* p)
+    {
+        return (std::uint32_t (p [0]) << 24) | (std::uint32_t (p [1]) << 16) |
+            (std::uint32_t (p [2]) << 8) | std::uint32_t (p [3]);
+    }
+
+    static uint256 accountKey (uint160 const& accountID,
+        std::uint32_t ledgerSeq, std::uint32_t txnSeq)
+    {
+        uint256 key;
+        key.begin () [0] = accountKind;
+        memcpy (key.begin () + 1, accountID.begin (), accountBytes);
+        putNumber (key.begin () + ledgerOffset, ledgerSeq);
+        putNumber (key.begin () + txnOffset, txnSeq);
+        return key;
+    }
+
+    static uint256 ledgerKey (std::uint32_t ledgerSeq)
+    {
+        uint256 key;
+        key.begin () [0] = ledgerKind;
+        putNumber (key.begin () + 1, ledgerSeq);
+        return key;
+    }
+
+    static uint256 floorKey ()
+    {
+        uint256 key;
+        key.begin () [0] = floorKind;
+        return key;
+    }
+
+    std::unique_ptr <NodeStore::Backend> m_backend;
+    DatabaseCon& m_txnDB;
+    beast::Journal m_journal;
+    std::mutex m_mutex;
+    std::atomic <std::uint32_t> m_floor;
+};
+
+//------------------------------------------------------------------------------
+
+std::unique_ptr <AccountTxIndex> make_SqliteAccountTxIndex (
+    DatabaseCon& txnDB, beast::Journal journal)
+{
+    return std::make_unique <SqliteAccountTxIndex> (txnDB, journal);
+}
+
+std::unique_ptr <AccountTxIndex> make_NodeStoreAccountTxIndex (
+    std::unique_ptr <NodeStore::Backend> backend, DatabaseCon& txnDB,
+        beast::Journal journal)
+{
+    return std::make_unique <NodeStoreAccountTxIndex> (
+        std::move (backend), txnDB, journal);
+}
+
+std::unique_ptr <AccountTxIndex> make_AccountTxIndex (
+    NodeStore::Parameters const& parameters, DatabaseCon& txnDB,
+        NodeStore::Manager& manager, NodeStore::Scheduler& scheduler,
+            beast::Journal journal)
+{
+    if (parameters.size () == 0)
+        return make_SqliteAccountTxIndex (txnDB, journal);
+
+    return make_NodeStoreAccountTxIndex (
+        manager.make_Backend (parameters, scheduler, journal), txnDB, journal);
+}
+
+//------------------------------------------------------------------------------
+
+class AccountTxIndex_test : public beast::unit_test::suite
+{
+public:
+    static RippleAddress makeAccount (int n)
+    {
+        RippleAddress account;
+        account.setAccountID (uint160 (n));
+        return account;
+    }
+
+    static uint256 makeTxID (std::uint32_t ledgerSeq, std::uint32_t txnSeq)
+    {
+        return uint256 ((std::uint64_t (ledgerSeq) << 32) | txnSeq);
+    }
+
+
+    // Each ledger has four transactions. Account 1 is in every one,
+    // account 2 only in the even ones, account 3 is never affected.
+    void populate (AccountTxIndex& index)
+    {
+        for (std::uint32_t ledgerSeq = 10; ledgerSeq < 20; ++ledgerSeq)
+        {
+            std::vector <AccountTxIndex::LedgerTxn> txns (4);
+
+            for (std::uint32_t txnSeq = 0; txnSeq < txns.size (); ++txnSeq)
+            {
+                AccountTxIndex::LedgerTxn& txn (txns [txnSeq]);
+                txn.txID = makeTxID (ledgerSeq, txnSeq);
+                txn.txnSeq = txnSeq;
+                txn.accounts.push_back (makeAccount (1));
+                if ((txnSeq % 2) == 0)
+                    txn.accounts.push_back (makeAccount (2));
+            }
+
+            index.insertLedger (ledgerSeq, txns);
+        }
+    }
+
+    bool isEntry (AccountTxIndex::Entry const& entry,
+        std::uint32_t ledgerSeq, std::uint32_t txnSeq)
+    {
+        return (entry.ledgerSeq == ledgerSeq) && (entry.txnSeq == txnSeq) &&
+            (entry.txID == makeTxID (ledgerSeq, txnSeq));
+    }
+
+    void testPaging (AccountTxIndex& index)
+    {
+        testcase ("paging");
+
+        RippleAddress const account (makeAccount (1));
+
+        std::vector <AccountTxIndex::Entry> entries (
+            index.getEntries (account, 0, 100, true, nullptr, 0, 1000));
+        expect (entries.size () == 40, "All entries");
+        expect (isEntry (entries.front (), 10, 0) && isEntry (entries.back (), 19, 3), "Ascending");
+
+        entries = index.getEntries (account, 0, 100, false, nullptr, 0, 1000);
+        expect (entries.size () == 40, "All entries backwards");
+        expect (isEntry (entries.front (), 19, 3) && isEntry (entries.back (), 10, 0), "Descending");
+
+        // Follow markers through the history, a page at a time
+        for (int direction = 0; direction < 2; ++direction)
+        {
+            bool const forward = direction == 0;
+            std::size_t seen = 0;
+            AccountTxIndex::Entry marker;
+            bool haveMarker = false;
+
+            for (;;)
+            {
+                entries = index.getEntries (account, 12, 17, forward,
+                    haveMarker ? &marker : nullptr, 0, 7);
+
+                seen += std::min <std::size_t> (entries.size (), 6);
+
+                if (entries.size () < 7)
+                    break;
+
+                marker = entries.back ();
+                haveMarker = true;
+            }
+
+            expect (seen == 24, "Pages cover the range");
+        }
+
+        entries = index.getEntries (account, 0, 100, true, nullptr, 5, 2);
+        expect (entries.size () == 2 && isEntry (entries [0], 11, 1), "Offset");
+
+        AccountTxIndex::Entry marker;
+        marker.ledgerSeq = 15;
+        marker.txnSeq = 2;
+        entries = index.getEntries (account, 0, 100, false, &marker, 0, 3);
+        expect (entries.size () == 3 && isEntry (entries [0], 15, 2) &&
+            isEntry (entries [2], 15, 0), "Backwards from a marker");
+
+        entries = index.getEntries (makeAccount (2), 0, 100, true, nullptr, 0, 1000);
+        expect (entries.size () == 20, "Second account");
+
+        entries = index.getEntries (makeAccount (3), 0, 100, true, nullptr, 0, 1000);
+        expect (entries.empty (), "Unaffected account");
+    }
+
+    void testAffected (AccountTxIndex& index)
+    {
+        testcase ("affected accounts");
+
+        std::vector <RippleAddress> accounts (index.getAffectedAccounts (12));
+        expect (accounts.size () == 2, "Affected accounts");
+        expect (index.getAffectedAccounts (30).empty (), "Unknown ledger");
+    }
+
+    // Every transaction of the populated ledgers, except that transaction 2
+    // of ledger 10 was saved again in ledger 12
+    void saveTransactions (DatabaseCon& txnDB)
+    {
+        Database* db = txnDB.getDB ();
+        DeprecatedScopedLock sl (txnDB.getDBLock ());
+
+        for (std::uint32_t ledgerSeq = 10; ledgerSeq < 20; ++ledgerSeq)
+        {
+            for (std::uint32_t txnSeq = 0; txnSeq < 4; ++txnSeq)
+            {
+                std::uint32_t const savedSeq = ((ledgerSeq == 10) && (txnSeq == 2)) ? 12 : ledgerSeq;
+
+                db->executeSQL (boost::str (boost::format (
+                    "INSERT INTO Transactions (TransID, LedgerSeq, Status, RawTxn, TxnMeta) "
+                    "VALUES ('%s', %u, 'V', X'00', X'00');")
+                        % makeTxID (ledgerSeq, txnSeq).GetHex ()
+                        % savedSeq));
+            }
+        }
+    }
+
+    void testLoad (AccountTxIndex& index, DatabaseCon& txnDB)
+    {
+        testcase ("load transactions");
+
+        saveTransactions (txnDB);
+
+        RippleAddress const account (makeAccount (1));
+        std::vector <std::uint32_t> rows;
+
+        auto const onRow = [&rows] (Database* db)
+        {
+            rows.push_back (static_cast <std::uint32_t> (db->getBigInt ("LedgerSeq")));
+        };
+
+        std::vector <AccountTxIndex::Entry> loaded (index.loadTransactions (
+            account, 0, 100, true, nullptr, 0, 5, onRow));
+        expect (loaded.size () == 5 && rows.size () == 5, "Full page");
+        expect (isEntry (loaded [1], 10, 1) && isEntry (loaded [2], 10, 3) &&
+            isEntry (loaded [4], 11, 1), "Moved transaction skipped");
+        expect (rows.back () == 11, "Rows follow the entries");
+
+        AccountTxIndex::Entry marker;
+        marker.ledgerSeq = 11;
+        marker.txnSeq = 1;
+        rows.clear ();
+        loaded = index.loadTransactions (account, 0, 100, false, &marker, 0, 4, onRow);
+        expect (loaded.size () == 4 && rows.size () == 4 &&
+            isEntry (loaded [0], 11, 1) && isEntry (loaded [2], 10, 3) &&
+                isEntry (loaded [3], 10, 1), "Backwards from a marker");
+
+        rows.clear ();
+        loaded = index.loadTransactions (account, 0, 10, true, nullptr, 2, 10, onRow);
+        expect (loaded.size () == 1 && rows.size () == 1 &&
+            isEntry (loaded [0], 10, 3), "Short at the end of the range");
+    }
+
+    void testDeleteBefore (AccountTxIndex& index)
+    {
+        testcase ("delete before");
+
+        index.deleteBefore (15);
+
+        std::vector <AccountTxIndex::Entry> entries (index.getEntries (
+            makeAccount (1), 0, 100, true, nullptr, 0, 1000));
+        expect (entries.size () == 20, "Later entries");
+        expect (isEntry (entries.front (), 15, 0), "First kept entry");
+
+        entries = index.getEntries (makeAccount (1), 0, 14, false, nullptr, 0, 1000);
+        expect (entries.empty (), "Deleted range");
+
+        expect (index.getAffectedAccounts (12).empty (), "Deleted ledger");
+        expect (index.getAffectedAccounts (17).size () == 2, "Kept ledger");
+    }
+
+    void testIndex (AccountTxIndex& index, DatabaseCon& txnDB)
+    {
+        log << "Index: " << index.getName ();
+
+        populate (index);
+        testPaging (index);
+        testAffected (index);
+        testLoad (index, txnDB);
+        testDeleteBefore (index);
+    }
+
+    void run ()
+    {
+        beast::Journal journal;
+
+        {
+            DatabaseCon txnDB (DatabaseCon::InMemory (), TxnDBInit, TxnDBCount);
+
+            std::unique_ptr <AccountTxIndex> index (make_SqliteAccountTxIndex (txnDB, journal));
+            testIndex (*index, txnDB);
+        }
+
+        {
+            DatabaseCon txnDB (DatabaseCon::InMemory (), TxnDBInit, TxnDBCount);
+
+            std::unique_ptr <NodeStore::Manager> manager (NodeStore::make_Manager ());
+            NodeStore::DummyScheduler scheduler;
+
+            NodeStore::Parameters parameters;
+            parameters.set ("type", "memory");
+
+            std::unique_ptr <AccountTxIndex> index (make_NodeStoreAccountTxIndex (
+                manager->make_Backend (parameters, scheduler, journal), txnDB, journal));
+            testIndex (*index, txnDB);
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(AccountTxIndex,ripple_app,ripple);
+
+}
@@ -0,0 +1,127 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_ACCOUNTTXINDEX_H_INCLUDED
+#define RIPPLE_ACCOUNTTXINDEX_H_INCLUDED
+
+namespace ripple {
+
+/** An index of the transactions which affected each account.
+
+    Entries are ordered by account, then by ledger sequence and position
+    within the ledger. A page of history is found by starting at a marker,
+    so following pages costs the same however deep the history goes.
+
+    The index is kept in the transaction database's AccountTransactions
+    table, or in a NodeStore backend which keeps its keys in order.
+*/
+class AccountTxIndex
+{
+public:
+    /** An account's reference to one of its transactions. */
+    struct Entry
+    {
+        std::uint32_t ledgerSeq;
+        std::uint32_t txnSeq;
+        uint256 txID;
+    };
+
+    /** A transaction in a ledger and the accounts it affected. */
+    struct LedgerTxn
+    {
+        uint256 txID;
+        std::uint32_t txnSeq;
+        std::vector <RippleAddress> accounts;
+    };
+
+    virtual ~AccountTxIndex () = 0;
+
+    /** Returns a name for diagnostic output. */
+    virtual std::string getName () const = 0;
+
+    /** Add the transactions of a validated ledger.
+        All of the ledger's entries are written as one batch. This is called
+        with the transaction database locked, inside the database
+        transaction which saves the ledger's transactions.
+    */
+    virtual void insertLedger (std::uint32_t ledgerSeq,
+        std::vector <LedgerTxn> const& txns) = 0;
+
+    /** Returns a page of an account's entries.
+        @param minLedger The first ledger of the range, inclusive.
+        @param maxLedger The last ledger of the range, inclusive.
+        @param forward `true` for oldest first, `false` for newest first.
+        @param marker If not null, the page starts at this entry, or at the
+                      next entry in order if this one is not present.
+        @param offset The number of entries to skip before the page.
+        @param limit The most entries to return.
+    */
+    virtual std::vector <Entry> getEntries (RippleAddress const& account,
+        std::uint32_t minLedger, std::uint32_t maxLedger, bool forward,
+            Entry const* marker, std::uint32_t offset, std::uint32_t limit) = 0;
+
+    /** Reads the transactions of a page of an account's entries.
+        The page is chosen as for getEntries. For each entry, in order,
+        `onRow` is called with the transaction database positioned on the
+        entry's row of the Transactions table, joined with the entry.
+        Entries whose transaction has since been saved in another ledger
+        are skipped, and more entries are read to make up for them, so the
+        page is only short at the end of the range.
+        @return The entries whose transactions were read.
+    */
+    virtual std::vector <Entry> loadTransactions (RippleAddress const& account,
+        std::uint32_t minLedger, std::uint32_t maxLedger, bool forward,
+            Entry const* marker, std::uint32_t offset, std::uint32_t limit,
+                std::function <void (Database*)> const& onRow) = 0;
+
+    /** Returns the accounts affected by the transactions of a ledger. */
+    virtual std::vector <RippleAddress> getAffectedAccounts (
+        std::uint32_t ledgerSeq) = 0;
+
+    /** Forget the entries of ledgers before the given ledger.
+        Used when old history is deleted. Afterwards the entries of
+        those ledgers are no longer returned.
+    */
+    virtual void deleteBefore (std::uint32_t ledgerSeq) = 0;
+};
+
+/** Create an index in the transaction database's AccountTransactions table. */
+std::unique_ptr <AccountTxIndex> make_SqliteAccountTxIndex (
+    DatabaseCon& txnDB, beast::Journal journal);
+
+/** Create an index in a NodeStore backend.
+    The backend must support ordered visits. Transactions are still read
+    from the transaction database.
+*/
+std::unique_ptr <AccountTxIndex> make_NodeStoreAccountTxIndex (
+    std::unique_ptr <NodeStore::Backend> backend, DatabaseCon& txnDB,
+        beast::Journal journal);
+
+/** Create the index described by the configuration.
+    With no parameters the index is kept in the transaction database,
+    otherwise they describe the NodeStore backend to use.
+*/
+std::unique_ptr <AccountTxIndex> make_AccountTxIndex (
+    NodeStore::Parameters const& parameters, DatabaseCon& txnDB,
+        NodeStore::Manager& manager, NodeStore::Scheduler& scheduler,
+            beast::Journal journal);
+
+}
+
+#endif
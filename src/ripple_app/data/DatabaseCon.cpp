@@ -30,7 +30,17 @@ DatabaseCon::DatabaseCon (const std::string& strName, const char* initStrings[],
                                       ? ""                                // Use temporary files.
                                       : (getConfig ().DATA_DIR / strName);       // Use regular db files.
 
-    mDatabase = new SqliteDatabase (pPath.string ().c_str ());
+    open (pPath.string (), initStrings, initCount);
+}
+
+DatabaseCon::DatabaseCon (InMemory, const char* initStrings[], int initCount)
+{
+    open (":memory:", initStrings, initCount);
+}
+
+void DatabaseCon::open (std::string const& path, const char* initStrings[], int initCount)
+{
+    mDatabase = new SqliteDatabase (path.c_str ());
     mDatabase->connect ();
 
     for (int i = 0; i < initCount; ++i)
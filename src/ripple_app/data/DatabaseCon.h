@@ -28,6 +28,11 @@ class DatabaseCon : beast::LeakChecked <DatabaseCon>
 {
 public:
     DatabaseCon (const std::string& name, const char* initString[], int countInit);
+
+    /** Selects a database kept in memory, which is gone once closed. */
+    struct InMemory { };
+
+    DatabaseCon (InMemory, const char* initString[], int countInit);
     ~DatabaseCon ();
     Database* getDB ()
     {
@@ -40,6 +45,8 @@ public:
 
     // VFALCO TODO change "protected" to "private" throughout the code
 private:
+    void open (std::string const& path, const char* initString[], int countInit);
+
     Database*               mDatabase;
     DeprecatedRecursiveMutex  mLock;
 };
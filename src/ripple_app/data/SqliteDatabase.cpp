@@ -17,11 +17,15 @@
 */
 //==============================================================================
 
+#include "../../beast/modules/beast_core/maths/Random.h"
+#include "../../beast/beast/unit_test/suite.h"
+
 namespace ripple {
 
 SETUP_LOG (SqliteDatabase)
 
 SqliteStatement::SqliteStatement (SqliteDatabase* db, const char* sql, bool aux)
+    : mDatabase (aux ? nullptr : db)
 {
     assert (db);
 
@@ -33,6 +37,7 @@ SqliteStatement::SqliteStatement (SqliteDatabase* db, const char* sql, bool aux)
 }
 
 SqliteStatement::SqliteStatement (SqliteDatabase* db, const std::string& sql, bool aux)
+    : mDatabase (aux ? nullptr : db)
 {
     assert (db);
 
@@ -55,6 +60,11 @@ SqliteDatabase::SqliteDatabase (const char* host)
     , Thread ("sqlitedb")
     , mWalQ (nullptr)
     , walRunning (false)
+    , mWalCheckpointPages (1000)
+    , mGroupedWrites (0)
+    , mGroupedWriteLimit (1)
+    , mGroupOpen (false)
+    , mGroupActive (false)
 {
     startThread ();
 
@@ -109,6 +119,9 @@ sqlite3* SqliteDatabase::getAuxConnection ()
 
 void SqliteDatabase::disconnect ()
 {
+    flushGroupedWrites ();
+    mStatements.clear ();
+
     sqlite3_finalize (mCurrentStmt);
     sqlite3_close (mConnection);
 
@@ -142,6 +155,8 @@ bool SqliteDatabase::executeSQL (const char* sql, bool fail_ok)
         return false;
     }
 
+    beforeStatement ();
+
     rc = sqlite3_step (mCurrentStmt);
 
     if (rc == SQLITE_ROW)
@@ -305,7 +320,7 @@ bool SqliteDatabase::setupCheckpointing (JobQueue* q)
 
 void SqliteDatabase::doHook (const char* db, int pages)
 {
-    if (pages < 1000)
+    if (pages < mWalCheckpointPages)
         return;
 
     {
@@ -327,6 +342,86 @@ void SqliteDatabase::doHook (const char* db, int pages)
     }
 }
 
+void SqliteDatabase::setWalCheckpointPages (int pages)
+{
+    mWalCheckpointPages = pages;
+}
+
+SqliteStatement& SqliteDatabase::getStatement (std::string const& sql)
+{
+    std::unique_ptr <SqliteStatement>& statement (mStatements [sql]);
+
+    if (statement == nullptr)
+    {
+        statement.reset (new SqliteStatement (this, sql));
+    }
+    else
+    {
+        statement->reset ();
+        statement->clearBindings ();
+    }
+
+    return *statement;
+}
+
+void SqliteDatabase::beginGroupedWrite ()
+{
+    mGroupActive = true;
+
+    if (!mGroupOpen)
+    {
+        executeSQL ("BEGIN TRANSACTION;", false);
+        mGroupOpen = true;
+    }
+}
+
+bool SqliteDatabase::endGroupedWrite (bool flush)
+{
+    mGroupActive = false;
+
+    if (flush || (++mGroupedWrites >= mGroupedWriteLimit))
+    {
+        commitGroupedWrites ();
+        return true;
+    }
+
+    return false;
+}
+
+void SqliteDatabase::flushGroupedWrites ()
+{
+    if (mGroupOpen)
+        commitGroupedWrites ();
+}
+
+void SqliteDatabase::beforeStatement ()
+{
+    // Writes from elsewhere must not wait on the group to be durable
+    if (mGroupOpen && !mGroupActive)
+        commitGroupedWrites ();
+}
+
+void SqliteDatabase::commitGroupedWrites ()
+{
+    mGroupOpen = false;
+    mGroupedWrites = 0;
+
+    // Not executeSQL, which would finalize a statement about to be stepped
+    int const rc = sqlite3_exec (mConnection, "COMMIT TRANSACTION;",
+        nullptr, nullptr, nullptr);
+
+    if (rc != SQLITE_OK)
+    {
+        WriteLog (lsWARNING, SqliteDatabase) << "Committing grouped writes to " <<
+            mHost << ": " << sqlite3_errmsg (mConnection);
+    }
+}
+
+void SqliteDatabase::setGroupedWriteLimit (int writes)
+{
+    mGroupedWriteLimit = writes;
+}
+
 void SqliteDatabase::run ()
 {
     // Simple thread loop runs Wal every time it wakes up via
@@ -402,6 +497,11 @@ int SqliteStatement::bind (int position)
     return sqlite3_bind_null (statement, position);
 }
 
+int SqliteStatement::clearBindings ()
+{
+    return sqlite3_clear_bindings (statement);
+}
+
 int SqliteStatement::size (int column)
 {
     return sqlite3_column_bytes (statement, column);
@@ -442,6 +542,9 @@ std::int64_t SqliteStatement::getInt64 (int column)
 
 int SqliteStatement::step ()
 {
+    if (mDatabase != nullptr)
+        mDatabase->beforeStatement ();
+
     return sqlite3_step (statement);
 }
 
@@ -484,4 +587,213 @@ std::string SqliteStatement::getError (int j)
     return sqlite3_errstr (j);
 }
 
+//------------------------------------------------------------------------------
+
+// Measures ingesting ledgers of history into the transaction database,
+// using the statements the server used to build as text and the prepared
+// statements which replaced them.
+class SqliteDatabase_timing_test : public beast::unit_test::suite
+{
+public:
+    enum
+    {
+        ledgerCount = 500,
+        txnsPerLedger = 50,
+        accountsPerTxn = 2,
+        rawTxnBytes = 180,
+        rawMetaBytes = 500
+    };
+
+    typedef std::chrono::steady_clock clock_type;
+
+    struct Txn
+    {
+        uint256 txID;
+        std::string accounts [accountsPerTxn];
+        Blob rawTxn;
+        Blob rawMeta;
+    };
+
+    static Blob makeBlob (beast::Random& r, int bytes)
+    {
+        Blob blob (bytes);
+        r.fillBitsRandomly (&blob.front (), blob.size ());
+        return blob;
+    }
+
+    static std::vector <Txn> makeLedger (beast::Random& r)
+    {
+        std::vector <Txn> txns (txnsPerLedger);
+
+        BOOST_FOREACH (Txn& txn, txns)
+        {
+            r.fillBitsRandomly (txn.txID.begin (), txn.txID.size ());
+            for (int i = 0; i < accountsPerTxn; ++i)
+                txn.accounts [i] = "r" + uint160 (r.nextInt64 ()).GetHex ().substr (0, 33);
+            txn.rawTxn = makeBlob (r, rawTxnBytes);
+            txn.rawMeta = makeBlob (r, rawMetaBytes);
+        }
+
+        return txns;
+    }
+
+    static void writeText (SqliteDatabase& db, std::uint32_t seq, std::vector <Txn> const& txns)
+    {
+        static boost::format deleteTrans ("DELETE FROM Transactions WHERE LedgerSeq = %u;");
+        static boost::format deleteAcctLedger ("DELETE FROM AccountTransactions WHERE LedgerSeq = %u;");
+        static boost::format deleteAcctTrans ("DELETE FROM AccountTransactions WHERE TransID = '%s';");
+        static boost::format insertTrans ("INSERT OR REPLACE INTO Transactions "
+            "(TransID, TransType, FromAcct, FromSeq, LedgerSeq, Status, RawTxn, TxnMeta) "
+            "VALUES ('%s', 'Payment', '%s', '%d', '%d', 'V', %s, %s);");
+
+        db.executeSQL ("BEGIN TRANSACTION;", false);
+        db.executeSQL (boost::str (boost::format (deleteTrans) % seq).c_str (), false);
+        db.executeSQL (boost::str (boost::format (deleteAcctLedger) % seq).c_str (), false);
+
+        BOOST_FOREACH (Txn const& txn, txns)
+        {
+            std::string const txID (txn.txID.GetHex ());
+
+            db.executeSQL (boost::str (boost::format (deleteAcctTrans) % txID).c_str (), false);
+
+            std::string sql = "INSERT INTO AccountTransactions (TransID, Account, LedgerSeq, TxnSeq) VALUES ";
+            for (int i = 0; i < accountsPerTxn; ++i)
+            {
+                sql += (i == 0) ? "('" : ", ('";
+                sql += txID + "','" + txn.accounts [i] + "'," +
+                    beast::lexicalCastThrow <std::string> (seq) + ",0)";
+            }
+            sql += ";";
+            db.executeSQL (sql.c_str (), false);
+
+            db.executeSQL (boost::str (boost::format (insertTrans) % txID % txn.accounts [0] %
+                seq % seq % sqlEscape (txn.rawTxn) % sqlEscape (txn.rawMeta)).c_str (), false);
+        }
+
+        db.executeSQL ("COMMIT TRANSACTION;", false);
+    }
+
+    static void writePrepared (SqliteDatabase& db, std::uint32_t seq, std::vector <Txn> const& txns)
+    {
+        static std::string const deleteTrans ("DELETE FROM Transactions WHERE LedgerSeq = ?;");
+        static std::string const deleteAcctLedger ("DELETE FROM AccountTransactions WHERE LedgerSeq = ?;");
+        static std::string const deleteAcctTrans ("DELETE FROM AccountTransactions WHERE TransID = ?;");
+        static std::string const insertAcctTrans ("INSERT INTO AccountTransactions "
+            "(TransID, Account, LedgerSeq, TxnSeq) VALUES (?, ?, ?, ?);");
+        static std::string const insertTrans ("INSERT OR REPLACE INTO Transactions "
+            "(TransID, TransType, FromAcct, FromSeq, LedgerSeq, Status, RawTxn, TxnMeta) "
+            "VALUES (?, 'Payment', ?, ?, ?, 'V', ?, ?);");
+
+        db.beginGroupedWrite ();
+
+        {
+            SqliteStatement& statement (db.getStatement (deleteTrans));
+            statement.bind (1, seq);
+            statement.step ();
+        }
+
+        {
+            SqliteStatement& statement (db.getStatement (deleteAcctLedger));
+            statement.bind (1, seq);
+            statement.step ();
+        }
+
+        BOOST_FOREACH (Txn const& txn, txns)
+        {
+            std::string const txID (txn.txID.GetHex ());
+
+            {
+                SqliteStatement& statement (db.getStatement (deleteAcctTrans));
+                statement.bindStatic (1, txID);
+                statement.step ();
+            }
+
+            for (int i = 0; i < accountsPerTxn; ++i)
+            {
+                SqliteStatement& statement (db.getStatement (insertAcctTrans));
+                statement.bindStatic (1, txID);
+                statement.bindStatic (2, txn.accounts [i]);
+                statement.bind (3, seq);
+                statement.bind (4, std::uint32_t (0));
+                statement.step ();
+            }
+
+            SqliteStatement& statement (db.getStatement (insertTrans));
+            statement.bindStatic (1, txID);
+            statement.bindStatic (2, txn.accounts [0]);
+            statement.bind (3, seq);
+            statement.bind (4, seq);
+            statement.bindStatic (5, txn.rawTxn);
+            statement.bindStatic (6, txn.rawMeta);
+            statement.step ();
+        }
+
+        db.endGroupedWrite (false);
+    }
+
+    void measure (std::string const& name, std::vector <std::vector <Txn> > const& ledgers,
+        bool prepared, int groupSize, int walPages)
+    {
+        beast::File const file (beast::File::createTempFile ("txn_db"));
+        std::string const path (file.getFullPathName ().toStdString ());
+
+        double seconds;
+        {
+            SqliteDatabase db (path.c_str ());
+            db.connect ();
+            for (int i = 0; i < TxnDBCount; ++i)
+                db.executeSQL (TxnDBInit [i], true);
+            db.setupCheckpointing (nullptr);
+            db.setWalCheckpointPages (walPages);
+            db.setGroupedWriteLimit (groupSize);
+
+            clock_type::time_point const start (clock_type::now ());
+            for (std::size_t i = 0; i < ledgers.size (); ++i)
+            {
+                if (prepared)
+                    writePrepared (db, i + 1, ledgers [i]);
+                else
+                    writeText (db, i + 1, ledgers [i]);
+            }
+            db.flushGroupedWrites ();
+            seconds = std::chrono::duration_cast <std::chrono::duration <double> > (
+                clock_type::now () - start).count ();
+
+            db.executeSQL ("SELECT COUNT(*) FROM AccountTransactions;", false);
+            expect (db.getBigInt (0) == std::uint64_t (ledgers.size ()) * txnsPerLedger * accountsPerTxn,
+                "All entries written");
+            db.endIterRows ();
+            db.disconnect ();
+        }
+
+        file.deleteFile ();
+        beast::File (file.getFullPathName () + "-wal").deleteFile ();
+        beast::File (file.getFullPathName () + "-shm").deleteFile ();
+
+        std::stringstream ss;
+        ss << name << ": " << static_cast <std::int64_t> (ledgers.size () / seconds) <<
+            " ledgers/sec, " << static_cast <std::int64_t> (
+                (double (ledgers.size ()) * txnsPerLedger) / seconds) << " txns/sec";
+        log << ss.str ();
+    }
+
+    void run ()
+    {
+        beast::Random r (42);
+        std::vector <std::vector <Txn> > ledgers;
+        ledgers.reserve (ledgerCount);
+        for (int i = 0; i < ledgerCount; ++i)
+            ledgers.push_back (makeLedger (r));
+
+        testcase ("ingest " + std::to_string (int (ledgerCount)) + " ledgers");
+        measure ("text", ledgers, false, 1, 1000);
+        measure ("prepared", ledgers, true, 1, 1000);
+        measure ("prepared, 16 ledgers per commit", ledgers, true, 16, 1000);
+        measure ("prepared, 64 ledgers per commit", ledgers, true, 64, 1000);
+        measure ("prepared, 64 ledgers per commit, checkpoint at 8000 pages", ledgers, true, 64, 8000);
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(SqliteDatabase_timing,ripple_app,ripple);
+
 } // ripple
@@ -24,6 +24,8 @@
 
 namespace ripple {
 
+class SqliteStatement;
+
 class SqliteDatabase
     : public Database
     , private beast::Thread
@@ -73,10 +75,53 @@ public:
 
     void doHook (const char* db, int walSize);
 
+    /** Set the size of the write-ahead log which triggers a checkpoint.
+        Larger values let bulk writes run longer before the log is copied
+        into the database.
+    */
+    void setWalCheckpointPages (int pages);
+
+    /** Returns a prepared statement for the SQL text.
+        The statement is prepared the first time the text is seen and kept
+        until the database is disconnected. It is returned reset with its
+        bindings cleared. Call this with the database lock held, and finish
+        with the statement before releasing it.
+    */
+    SqliteStatement& getStatement (std::string const& sql);
+
+    /** Start a write which may share a transaction with the writes after it.
+        Each beginGroupedWrite must be matched by an endGroupedWrite.
+
+        Between grouped writes the transaction stays open, so their rows are
+        not durable until it commits. Any other statement run on the
+        connection commits the open group first, so writes made outside the
+        group never join it and become durable as soon as they finish.
+    */
+    void beginGroupedWrite ();
+
+    /** Finish a grouped write.
+        The open transaction is committed if `flush` is true, or if it holds
+        the most writes allowed in one group.
+        @return `true` if the transaction was committed.
+    */
+    bool endGroupedWrite (bool flush);
+
+    /** Commit any grouped writes which are still open. */
+    void flushGroupedWrites ();
+
+    /** Set the most writes which may share one transaction. */
+    void setGroupedWriteLimit (int writes);
+
     int getKBUsedDB ();
     int getKBUsedAll ();
 
 private:
+    friend class SqliteStatement;
+
+    // Commits an open group before a statement which is not part of it
+    void beforeStatement ();
+    void commitGroupedWrites ();
+
     void run ();
     void runWal ();
 
@@ -92,6 +137,19 @@ private:
 
     JobQueue*               mWalQ;
     bool                    walRunning;
+    int                     mWalCheckpointPages;
+
+    typedef std::map <std::string, std::unique_ptr <SqliteStatement> > StatementMap;
+    StatementMap            mStatements;
+
+    int                     mGroupedWrites;
+    int                     mGroupedWriteLimit;
+
+    // A grouped transaction is open
+    bool                    mGroupOpen;
+
+    // A grouped write is between its begin and end
+    bool                    mGroupActive;
 };
 
 //------------------------------------------------------------------------------
@@ -105,6 +163,10 @@ private:
 protected:
     sqlite3_stmt* statement;
 
+    // The database whose grouped writes this statement must not join,
+    // or nullptr for statements on the aux connection
+    SqliteDatabase* mDatabase;
+
 public:
     // VFALCO TODO This is quite a convoluted interface. A mysterious "aux" connection? 
     //             Why not just have two SqliteDatabase objects?
@@ -126,6 +188,9 @@ public:
     int bind (int position, std::uint32_t value);
     int bind (int position);
 
+    // clear all bindings
+    int clearBindings ();
+
     // columns start at 0
     int size (int column);
 
@@ -0,0 +1,369 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include "../../beast/beast/unit_test/suite.h"
+
+namespace ripple {
+
+AcquirePipeline::PeerState::PeerState ()
+    : window (startWindow)
+    , minRtt (clock_type::duration::zero ())
+    , gap (clock_type::duration::zero ())
+{
+}
+
+AcquirePipeline::AcquirePipeline ()
+{
+}
+
+void AcquirePipeline::sent (PeerId peer, std::vector <SHAMapNode> const& nodes,
+    clock_type::time_point now)
+{
+    PeerState& state (m_peers [peer]);
+    state.sent.push_back (Outstanding ());
+    state.sent.back ().time = now;
+    state.sent.back ().nodes.insert (nodes.begin (), nodes.end ());
+}
+
+bool AcquirePipeline::received (PeerId peer, SHAMapNode const& first,
+    clock_type::time_point now)
+{
+    std::map <PeerId, PeerState>::iterator const iter (m_peers.find (peer));
+
+    if (iter == m_peers.end ())
+        return false;
+
+    PeerState& state (iter->second);
+    std::deque <Outstanding>::iterator request (state.sent.begin ());
+
+    while ((request != state.sent.end ()) && (request->nodes.count (first) == 0))
+        ++request;
+
+    // An answer to a request sent outside the pipeline
+    if (request == state.sent.end ())
+        return false;
+
+    clock_type::time_point const sentTime (request->time);
+    state.sent.erase (request);
+
+    clock_type::duration const rtt (now - sentTime);
+
+    if ((state.minRtt == clock_type::duration::zero ()) || (rtt < state.minRtt))
+        state.minRtt = rtt;
+
+    // When this request went out before the previous answer came back,
+    // the time between the two answers is how long the peer took to
+    // work through it.
+    if (state.lastReply > sentTime)
+    {
+        clock_type::duration const gap (now - state.lastReply);
+
+        if (state.gap == clock_type::duration::zero ())
+            state.gap = gap;
+        else
+            state.gap = (state.gap * 3 + gap) / 4;
+    }
+
+    state.lastReply = now;
+
+    if (state.gap.count () > 0)
+    {
+        // Enough requests to cover a round trip at the rate the
+        // peer answers them, plus one waiting at the peer.
+        clock_type::duration::rep const cover (
+            (state.minRtt.count () + state.gap.count () - 1) / state.gap.count ());
+
+        state.window = static_cast <int> (std::max <clock_type::duration::rep> (
+            minWindow, std::min <clock_type::duration::rep> (maxWindow, cover + 1)));
+    }
+
+    return true;
+}
+
+void AcquirePipeline::expire (clock_type::time_point cutoff)
+{
+    for (std::map <PeerId, PeerState>::iterator iter = m_peers.begin ();
+        iter != m_peers.end (); ++iter)
+    {
+        PeerState& state (iter->second);
+        std::size_t const before (state.sent.size ());
+
+        while (! state.sent.empty () && (state.sent.front ().time < cutoff))
+            state.sent.pop_front ();
+
+        if (state.sent.size () != before)
+            state.window = std::max <int> (minWindow, state.window / 2);
+    }
+}
+
+int AcquirePipeline::available (PeerId peer) const
+{
+    std::map <PeerId, PeerState>::const_iterator const iter (m_peers.find (peer));
+
+    if (iter == m_peers.end ())
+        return startWindow;
+
+    return std::max <int> (0,
+        iter->second.window - static_cast <int> (iter->second.sent.size ()));
+}
+
+std::vector <AcquirePipeline::Request> AcquirePipeline::assign (
+    std::vector <SHAMapNode> const& nodes,
+        std::vector <std::pair <PeerId, int> > peers)
+{
+    std::vector <Request> requests;
+
+    if (peers.empty ())
+        return requests;
+
+    // Sorted so each branch stays with the same peer from round to round
+    std::sort (peers.begin (), peers.end ());
+
+    std::vector <std::vector <std::size_t> > shares (peers.size ());
+    std::vector <std::size_t> overflow;
+
+    for (std::size_t i = 0; i < nodes.size (); ++i)
+    {
+        std::size_t const home (branchOf (nodes [i]) % peers.size ());
+
+        if (shares [home].size () < (peers [home].second * nodesPerRequest))
+            shares [home].push_back (i);
+        else
+            overflow.push_back (i);
+    }
+
+    // Nodes whose peer is full go to whichever peers have room
+    std::size_t next (0);
+
+    BOOST_FOREACH (std::size_t i, overflow)
+    {
+        for (std::size_t tried = 0; tried < peers.size (); ++tried)
+        {
+            std::size_t const p (next);
+            next = (next + 1) % peers.size ();
+
+            if (shares [p].size () < (peers [p].second * nodesPerRequest))
+            {
+                shares [p].push_back (i);
+                break;
+            }
+        }
+    }
+
+    for (std::size_t p = 0; p < peers.size (); ++p)
+    {
+        std::vector <std::size_t> const& share (shares [p]);
+
+        for (std::size_t start = 0; start < share.size (); start += nodesPerRequest)
+        {
+            std::size_t const end (std::min <std::size_t> (
+                share.size (), start + nodesPerRequest));
+
+            requests.push_back (Request (peers [p].first,
+                std::vector <std::size_t> (share.begin () + start, share.begin () + end)));
+        }
+    }
+
+    return requests;
+}
+
+Json::Value AcquirePipeline::getJson () const
+{
+    Json::Value ret (Json::objectValue);
+
+    for (std::map <PeerId, PeerState>::const_iterator iter = m_peers.begin ();
+        iter != m_peers.end (); ++iter)
+    {
+        PeerState const& state (iter->second);
+        Json::Value& entry (ret [beast::lexicalCastThrow <std::string> (iter->first)]);
+
+        entry ["in_flight"] = static_cast <Json::UInt> (state.sent.size ());
+        entry ["window"] = state.window;
+        entry ["rtt_ms"] = static_cast <Json::UInt> (std::chrono::duration_cast <
+            std::chrono::milliseconds> (state.minRtt).count ());
+        entry ["gap_ms"] = static_cast <Json::UInt> (std::chrono::duration_cast <
+            std::chrono::milliseconds> (state.gap).count ());
+    }
+
+    return ret;
+}
+
+int AcquirePipeline::branchOf (SHAMapNode const& node)
+{
+    if (node.isRoot ())
+        return 0;
+
+    return node.getNodeID ().begin () [0] >> 4;
+}
+
+//------------------------------------------------------------------------------
+
+class AcquirePipeline_test : public beast::unit_test::suite
+{
+public:
+    typedef AcquirePipeline::clock_type clock_type;
+
+    // A distinct deep node under the given branch of the root
+    static SHAMapNode makeNode (int branch, int n)
+    {
+        uint256 id (n);
+        id.begin () [0] = static_cast <unsigned char> (branch << 4);
+        return SHAMapNode (64, id);
+    }
+
+    // A request for a run of nodes from one branch
+    static std::vector <SHAMapNode> makeRequest (int branch, int first, int count)
+    {
+        std::vector <SHAMapNode> nodes;
+        for (int i = first; i < (first + count); ++i)
+            nodes.push_back (makeNode (branch, i));
+        return nodes;
+    }
+
+    void testWindow ()
+    {
+        testcase ("window");
+
+        clock_type::time_point const start (clock_type::now ());
+        AcquirePipeline pipeline;
+
+        expect (pipeline.available (1) == AcquirePipeline::startWindow);
+
+        // A fast peer on a long link: 100ms away, 10ms per request
+        pipeline.sent (1, makeRequest (0, 0, 4), start);
+        pipeline.sent (1, makeRequest (0, 4, 4), start);
+        expect (pipeline.available (1) == 0);
+        expect (pipeline.received (1, makeNode (0, 0), start + std::chrono::milliseconds (100)));
+        expect (pipeline.received (1, makeNode (0, 4), start + std::chrono::milliseconds (110)));
+        expect (pipeline.available (1) == AcquirePipeline::maxWindow);
+
+        // A slow peer: 100ms away, 100ms per request
+        pipeline.sent (2, makeRequest (1, 0, 4), start);
+        pipeline.sent (2, makeRequest (1, 4, 4), start);
+        pipeline.received (2, makeNode (1, 0), start + std::chrono::milliseconds (100));
+        pipeline.received (2, makeNode (1, 4), start + std::chrono::milliseconds (200));
+        expect (pipeline.available (2) == 2);
+
+        // Answers to requests we didn't track change nothing
+        expect (!pipeline.received (3, makeNode (0, 0), start));
+        expect (pipeline.available (3) == AcquirePipeline::startWindow);
+    }
+
+    void testMatch ()
+    {
+        testcase ("match");
+
+        clock_type::time_point const start (clock_type::now ());
+        AcquirePipeline pipeline;
+
+        pipeline.sent (1, makeRequest (0, 0, 4), start);
+        pipeline.sent (1, makeRequest (0, 4, 4), start);
+
+        // Base data or an answer to another request leaves both in flight
+        expect (!pipeline.received (1, SHAMapNode (), start + std::chrono::milliseconds (1)));
+        expect (!pipeline.received (1, makeNode (2, 0), start + std::chrono::milliseconds (2)));
+        expect (pipeline.available (1) == 0);
+
+        // An answer that leaves out the first node asked for still counts,
+        // as does one that overtakes an earlier request
+        expect (pipeline.received (1, makeNode (0, 6), start + std::chrono::milliseconds (100)));
+        expect (pipeline.available (1) == 1);
+        expect (!pipeline.received (1, makeNode (0, 6), start + std::chrono::milliseconds (101)));
+        expect (pipeline.received (1, makeNode (0, 1), start + std::chrono::milliseconds (102)));
+        expect (pipeline.available (1) == AcquirePipeline::maxWindow);
+    }
+
+    void testExpire ()
+    {
+        testcase ("expire");
+
+        clock_type::time_point const start (clock_type::now ());
+        AcquirePipeline pipeline;
+
+        pipeline.sent (1, makeRequest (0, 0, 4), start);
+        pipeline.sent (1, makeRequest (0, 4, 4), start + std::chrono::seconds (5));
+        pipeline.expire (start + std::chrono::seconds (1));
+
+        // One request dropped and the window halved to one
+        expect (pipeline.available (1) == 0);
+
+        pipeline.expire (start + std::chrono::seconds (10));
+        expect (pipeline.available (1) == AcquirePipeline::minWindow);
+    }
+
+    void testAssign ()
+    {
+        testcase ("assign");
+
+        std::vector <SHAMapNode> nodes;
+        for (int i = 0; i < 64; ++i)
+            nodes.push_back (makeNode (i % 16, i));
+
+        std::vector <std::pair <AcquirePipeline::PeerId, int> > peers;
+        peers.push_back (std::make_pair (7, 1));
+        peers.push_back (std::make_pair (3, 1));
+
+        // Even branches go to the lower peer id, odd ones to the other
+        std::vector <AcquirePipeline::Request> requests (
+            AcquirePipeline::assign (nodes, peers));
+        expect (requests.size () == 2);
+
+        std::size_t total (0);
+        BOOST_FOREACH (AcquirePipeline::Request const& request, requests)
+        {
+            int const parity (request.first == 3 ? 0 : 1);
+            BOOST_FOREACH (std::size_t i, request.second)
+            {
+                expect (((nodes [i].getNodeID ().begin () [0] >> 4) % 2) == parity,
+                    "branch kept with its peer");
+            }
+            total += request.second.size ();
+        }
+        expect (total == nodes.size ());
+
+        // A full peer's branches spill over to the others
+        peers [0].second = 0;
+        peers [1].second = 3;
+        requests = AcquirePipeline::assign (nodes, peers);
+        expect (requests.size () == 1);
+        expect (requests [0].first == 3);
+        expect (requests [0].second.size () == nodes.size ());
+
+        // Large shares are cut into requests of bounded size
+        nodes.clear ();
+        for (int i = 0; i < 300; ++i)
+            nodes.push_back (makeNode (0, i));
+        requests = AcquirePipeline::assign (nodes, peers);
+        expect (requests.size () == 3);
+        expect (requests [0].second.size () == AcquirePipeline::nodesPerRequest);
+        expect (requests [2].second.size () == 300 - 2 * AcquirePipeline::nodesPerRequest);
+    }
+
+    void run ()
+    {
+        testWindow ();
+        testMatch ();
+        testExpire ();
+        testAssign ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(AcquirePipeline,ripple_app,ripple);
+
+}
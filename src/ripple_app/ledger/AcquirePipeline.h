@@ -0,0 +1,114 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_ACQUIREPIPELINE_H_INCLUDED
+#define RIPPLE_ACQUIREPIPELINE_H_INCLUDED
+
+namespace ripple {
+
+/** Schedules node requests for a ledger acquisition across peers.
+
+    Each peer may have several requests in flight. How many depends on
+    the smallest round trip we have seen to it and on how quickly it
+    answers requests queued back to back, so a fast peer at the end of a
+    long link is kept busy without burying a slow one.
+
+    Missing nodes are dealt out by the branch of the tree they are under,
+    so the peers work on different parts of the tree instead of all
+    sending the same nodes.
+*/
+class AcquirePipeline
+{
+public:
+    typedef std::chrono::steady_clock clock_type;
+    typedef Peer::ShortId PeerId;
+
+    enum
+    {
+        // Nodes asked for in one request
+        nodesPerRequest = 128,
+
+        // Limits on the requests in flight to one peer
+        minWindow = 1,
+        startWindow = 2,
+        maxWindow = 8
+    };
+
+    /** A request to send: the peer, and indexes into the missing nodes. */
+    typedef std::pair <PeerId, std::vector <std::size_t> > Request;
+
+    AcquirePipeline ();
+
+    /** Note that a request for nodes went out to a peer. */
+    void sent (PeerId peer, std::vector <SHAMapNode> const& nodes,
+        clock_type::time_point now);
+
+    /** Note that a peer sent us nodes.
+        Only an answer to a request sent through the pipeline is counted.
+        It is recognized by its first node, which the request asked for,
+        so base data and answers to other requests are ignored.
+        @return `true` if this answered a request sent through the pipeline.
+    */
+    bool received (PeerId peer, SHAMapNode const& first,
+        clock_type::time_point now);
+
+    /** Forget requests sent before the cutoff.
+        A peer which left requests unanswered has its window halved.
+    */
+    void expire (clock_type::time_point cutoff);
+
+    /** Return how many more requests a peer may be sent now. */
+    int available (PeerId peer) const;
+
+    /** Split missing nodes into requests.
+
+        @param nodes The missing nodes.
+        @param peers Each peer with the number of requests it can take.
+    */
+    static std::vector <Request> assign (std::vector <SHAMapNode> const& nodes,
+        std::vector <std::pair <PeerId, int> > peers);
+
+    Json::Value getJson () const;
+
+private:
+    struct Outstanding
+    {
+        clock_type::time_point time;
+        std::set <SHAMapNode> nodes;
+    };
+
+    struct PeerState
+    {
+        PeerState ();
+
+        std::deque <Outstanding> sent;
+        clock_type::time_point lastReply;
+        int window;
+        clock_type::duration minRtt;    // Zero until measured
+        clock_type::duration gap;       // Zero until measured
+    };
+
+    static int branchOf (SHAMapNode const& node);
+
+    std::map <PeerId, PeerState> m_peers;
+};
+
+}
+
+#endif
@@ -0,0 +1,352 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include "../../beast/beast/unit_test/suite.h"
+
+namespace ripple {
+
+FetchPackCache::FetchPackCache (clock_type& clock,
+    beast::insight::Collector::ptr const& collector,
+        beast::Journal journal)
+    : m_journal (journal)
+    , m_cache ("fetch_pack", 2048, 600, clock,
+        LogPartition::getJournal <TaggedCacheLog> (), collector)
+{
+}
+
+void FetchPackCache::getNodes (Ledger::ref have, Ledger::ref want,
+    Callback const& func)
+{
+    NodeListPtr nodes (m_cache.fetch (have->getHash ()));
+
+    if (nodes)
+    {
+        std::vector <NodeObject::pointer> objects;
+        objects.reserve (nodes->size ());
+
+        BOOST_FOREACH (uint256 const& hash, *nodes)
+        {
+            NodeObject::pointer object (getApp().getNodeStore ().fetch (hash));
+
+            if (! object)
+                break;
+
+            objects.push_back (object);
+        }
+
+        if (objects.size () == nodes->size ())
+        {
+            BOOST_FOREACH (NodeObject::ref object, objects)
+                func (object->getHash (), object->getData ());
+
+            return;
+        }
+
+        // Not everything has been written out yet, go back to the maps
+        m_journal.debug << "Fetch pack nodes for " << want->getLedgerSeq () <<
+            " missing from the node store";
+
+        m_cache.del (have->getHash (), false);
+    }
+
+    build (have, want, func);
+}
+
+void FetchPackCache::prepare (Ledger::ref have, Ledger::ref want)
+{
+    if (! m_cache.refreshIfPresent (have->getHash ()))
+        build (have, want, [] (uint256 const&, Blob const&) { });
+}
+
+float FetchPackCache::getHitRate ()
+{
+    return m_cache.getHitRate ();
+}
+
+void FetchPackCache::sweep ()
+{
+    m_cache.sweep ();
+}
+
+void FetchPackCache::build (Ledger::ref have, Ledger::ref want,
+    Callback const& func)
+{
+    NodeListPtr nodes (boost::make_shared <NodeList> ());
+    int stateNodes = 0;
+
+    want->peekAccountStateMap ()->getFetchPack (
+        have->peekAccountStateMap ().get (), true, maxStateNodes,
+        [&] (uint256 const& hash, Blob const& data)
+        {
+            nodes->push_back (hash);
+            ++stateNodes;
+            func (hash, data);
+        });
+
+    if (want->getTransHash ().isNonZero ())
+    {
+        want->peekTransactionMap ()->getFetchPack (
+            nullptr, true, maxTxNodes,
+            [&] (uint256 const& hash, Blob const& data)
+            {
+                nodes->push_back (hash);
+                func (hash, data);
+            });
+    }
+
+    // The state map walk gives up quietly when it can't lock the
+    // map we compare against, so don't remember a short list.
+    if ((stateNodes != 0) ||
+        (want->getAccountHash () == have->getAccountHash ()))
+    {
+        m_cache.canonicalize (have->getHash (), nodes);
+    }
+}
+
+//------------------------------------------------------------------------------
+
+FetchPackWriter::FetchPackWriter (protocol::TMGetObjectByHash const& reply,
+    std::size_t maxBytes, Send const& send)
+    : m_reply (reply)
+    , m_maxBytes (maxBytes)
+    , m_send (send)
+    , m_bytes (0)
+    , m_count (0)
+{
+    m_reply.clear_objects ();
+}
+
+void FetchPackWriter::add (std::uint32_t ledgerSeq, uint256 const& hash,
+    Blob const& data)
+{
+    protocol::TMIndexedObject& object = *m_reply.add_objects ();
+    object.set_ledgerseq (ledgerSeq);
+    object.set_hash (hash.begin (), hash.size ());
+    object.set_data (&data[0], data.size ());
+
+    ++m_count;
+    m_bytes += data.size () + hash.size () + sizeof (ledgerSeq);
+
+    if (m_bytes >= m_maxBytes)
+        flush ();
+}
+
+void FetchPackWriter::flush ()
+{
+    if (m_reply.objects_size () != 0)
+    {
+        m_send (m_reply);
+        m_reply.clear_objects ();
+    }
+
+    m_bytes = 0;
+}
+
+//------------------------------------------------------------------------------
+
+class FetchPackCache_test : public beast::unit_test::suite
+{
+public:
+    typedef std::map <uint256, Blob> NodeMap;
+
+    enum
+    {
+        maxBytes = 256 * 1024
+    };
+
+    static SLE::pointer makeAccountRoot (std::string const& passphrase, std::uint64_t balance)
+    {
+        uint160 const account (LedgerTest::make_account_id (passphrase));
+
+        SLE::pointer sle (boost::make_shared <SLE> (ltACCOUNT_ROOT,
+            Ledger::getAccountRootIndex (account)));
+        sle->setFieldAccount (sfAccount, account);
+        sle->setFieldAmount (sfBalance, STAmount (balance));
+        return sle;
+    }
+
+    // A ledger and its child that changes a few of its accounts. The
+    // name keeps the nodes apart from those of other tests.
+    static void makeLedgers (std::string const& name,
+        Ledger::pointer& want, Ledger::pointer& have)
+    {
+        want = LedgerTest::make_next (LedgerTest::make_genesis ());
+
+        for (int i = 0; i < 16; ++i)
+            want->writeBack (lepCREATE, makeAccountRoot (
+                name + std::to_string (i), 1000 + i));
+
+        have = LedgerTest::make_next (want);
+        have->writeBack (lepNONE, makeAccountRoot (name + "0", 1));
+        have->writeBack (lepCREATE, makeAccountRoot (name + "new", 1));
+    }
+
+    static NodeMap getNodes (FetchPackCache& cache, Ledger::ref have, Ledger::ref want)
+    {
+        NodeMap nodes;
+
+        cache.getNodes (have, want,
+            [&nodes] (uint256 const& hash, Blob const& data)
+            {
+                nodes [hash] = data;
+            });
+
+        return nodes;
+    }
+
+    static void store (NodeMap const& nodes, std::uint32_t ledgerSeq)
+    {
+        BOOST_FOREACH (NodeMap::value_type const& node, nodes)
+        {
+            Blob data (node.second);
+            getApp().getNodeStore ().store (hotACCOUNT_NODE, ledgerSeq,
+                data, node.first);
+        }
+    }
+
+    void testHit ()
+    {
+        testcase ("hit");
+
+        FetchPackCache cache (get_seconds_clock (),
+            beast::insight::NullCollector::New (), beast::Journal ());
+
+        Ledger::pointer want, have;
+        makeLedgers ("fetch pack hit ", want, have);
+
+        NodeMap const built (getNodes (cache, have, want));
+        expect (! built.empty (), "no nodes");
+        expect (cache.getHitRate () == 0);
+
+        store (built, want->getLedgerSeq ());
+
+        // Walking two identical maps finds nothing, so these nodes can
+        // only come from the remembered list and the node store
+        NodeMap const cached (getNodes (cache, have, have));
+        expect (cached == built, "cached nodes differ");
+        expect (cache.getHitRate () > 0);
+    }
+
+    void testFallback ()
+    {
+        testcase ("fallback");
+
+        FetchPackCache cache (get_seconds_clock (),
+            beast::insight::NullCollector::New (), beast::Journal ());
+
+        Ledger::pointer want, have;
+        makeLedgers ("fetch pack fallback ", want, have);
+
+        NodeMap const built (getNodes (cache, have, want));
+        expect (! built.empty (), "no nodes");
+
+        // The list is remembered but the nodes aren't in the node
+        // store, so the maps are walked again
+        NodeMap const walked (getNodes (cache, have, want));
+        expect (walked == built, "fallback nodes differ");
+
+        // The list was made again and is used once the nodes are stored
+        store (built, want->getLedgerSeq ());
+        expect (getNodes (cache, have, have) == built, "list not remembered");
+    }
+
+    void testChunks ()
+    {
+        testcase ("chunks");
+
+        protocol::TMGetObjectByHash reply;
+        reply.set_query (false);
+        reply.set_seq (7);
+        reply.set_ledgerhash (std::string (32, 'x'));
+        reply.set_type (protocol::TMGetObjectByHash::otFETCH_PACK);
+
+        std::vector <protocol::TMGetObjectByHash> messages;
+        FetchPackWriter writer (reply, maxBytes,
+            [&messages] (protocol::TMGetObjectByHash const& message)
+            {
+                messages.push_back (message);
+            });
+
+        int const objects (1000);
+        std::size_t const objectBytes (1000);
+        std::size_t const overhead (256 / 8 + sizeof (std::uint32_t));
+
+        for (int i = 0; i < objects; ++i)
+        {
+            uint256 hash;
+            hash = i;
+            writer.add (i, hash, Blob (objectBytes, i & 0xff));
+        }
+
+        writer.flush ();
+        writer.flush ();
+
+        expect (writer.getCount () == objects);
+        expect (messages.size () == 4, "wrong number of messages");
+
+        int next (0);
+
+        for (std::size_t i = 0; i < messages.size (); ++i)
+        {
+            protocol::TMGetObjectByHash const& message (messages [i]);
+
+            expect (message.type () == protocol::TMGetObjectByHash::otFETCH_PACK);
+            expect (! message.query ());
+            expect (message.seq () == 7);
+            expect (message.ledgerhash () == reply.ledgerhash ());
+
+            std::size_t bytes (0);
+
+            for (int j = 0; j < message.objects_size (); ++j)
+            {
+                protocol::TMIndexedObject const& object (message.objects (j));
+
+                if (object.ledgerseq () != next)
+                    fail ("objects out of order");
+
+                bytes += object.data ().size () + object.hash ().size () +
+                    sizeof (std::uint32_t);
+                ++next;
+            }
+
+            if ((i + 1) < messages.size ())
+            {
+                expect (bytes >= maxBytes, "message too small");
+                expect (bytes < (maxBytes + objectBytes + overhead), "message too large");
+            }
+            else
+            {
+                expect (bytes < maxBytes, "last message too large");
+            }
+        }
+
+        expect (next == objects, "objects lost");
+    }
+
+    void run ()
+    {
+        testHit ();
+        testFallback ();
+        testChunks ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(FetchPackCache,ripple_app,ripple);
+
+}
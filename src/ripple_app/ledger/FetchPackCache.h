@@ -0,0 +1,114 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_FETCHPACKCACHE_H_INCLUDED
+#define RIPPLE_FETCHPACKCACHE_H_INCLUDED
+
+namespace ripple {
+
+/** Remembers which nodes go into the fetch packs we send to peers.
+
+    A fetch pack for a peer holding one ledger carries the ledger before
+    it, along with the nodes of that ledger the peer is missing. That set
+    is the same for every peer, so it is worked out once per ledger and
+    kept as a list of node hashes. The node data itself stays in the node
+    store and is read back when a pack is sent.
+*/
+class FetchPackCache
+{
+public:
+    typedef beast::abstract_clock <std::chrono::seconds> clock_type;
+
+    /** Called with each node of a pack. */
+    typedef std::function <void (uint256 const&, Blob const&)> Callback;
+
+    FetchPackCache (clock_type& clock,
+        beast::insight::Collector::ptr const& collector,
+            beast::Journal journal);
+
+    /** Produce the nodes a peer holding `have` needs to build `want`.
+        `want` must be the parent of `have`. The header of `want` is not
+        included.
+    */
+    void getNodes (Ledger::ref have, Ledger::ref want, Callback const& func);
+
+    /** Remember the nodes for a ledger ahead of any request for them. */
+    void prepare (Ledger::ref have, Ledger::ref want);
+
+    float getHitRate ();
+
+    void sweep ();
+
+private:
+    typedef std::vector <uint256> NodeList;
+    typedef boost::shared_ptr <NodeList> NodeListPtr;
+
+    enum
+    {
+        // Limits on the nodes sent from each map, per ledger
+        maxStateNodes = 1024,
+        maxTxNodes = 256
+    };
+
+    // Walk the maps, sending each node to func, and remember the list
+    void build (Ledger::ref have, Ledger::ref want, Callback const& func);
+
+    beast::Journal m_journal;
+    TaggedCache <uint256, NodeList> m_cache;
+};
+
+//------------------------------------------------------------------------------
+
+/** Cuts the objects of a fetch pack into messages of bounded size.
+
+    Each message carries the fields of the reply it was made from. A
+    message is sent once its objects reach the size limit, so no message
+    goes over the limit by more than one object.
+*/
+class FetchPackWriter
+{
+public:
+    /** Called with each message as it fills. */
+    typedef std::function <void (protocol::TMGetObjectByHash const&)> Send;
+
+    FetchPackWriter (protocol::TMGetObjectByHash const& reply,
+        std::size_t maxBytes, Send const& send);
+
+    void add (std::uint32_t ledgerSeq, uint256 const& hash, Blob const& data);
+
+    /** Send the objects added since the last message. */
+    void flush ();
+
+    /** Returns the number of objects added. */
+    int getCount () const
+    {
+        return m_count;
+    }
+
+private:
+    protocol::TMGetObjectByHash m_reply;
+    std::size_t m_maxBytes;
+    Send m_send;
+    std::size_t m_bytes;
+    int m_count;
+};
+
+}
+
+#endif
@@ -69,10 +69,10 @@ InboundLedger::~InboundLedger ()
 {
     // Save any received AS data not processed. It could be useful
     // for populating a different ledger
-    BOOST_FOREACH (PeerDataPairType& entry, mReceivedData)
+    BOOST_FOREACH (ReceivedData& entry, mReceivedData)
     {
-        if (entry.second->type () == protocol::liAS_NODE)
-            getApp().getInboundLedgers().gotStaleData(entry.second);
+        if (entry.packet->type () == protocol::liAS_NODE)
+            getApp().getInboundLedgers().gotStaleData(entry.packet);
     }
 
 }
@@ -225,6 +225,10 @@ void InboundLedger::onTimer (bool wasProgress, ScopedLockType&)
     mRecentTXNodes.clear ();
     mRecentASNodes.clear ();
 
+    // Requests this old are not going to be answered
+    mPipeline.expire (AcquirePipeline::clock_type::now () -
+        std::chrono::milliseconds (ledgerAcquireTimeoutMillis));
+
     if (isDone())
     {
         if (m_journal.info) m_journal.info <<
@@ -359,6 +363,24 @@ static void LADispatch (
         trig[i] (la);
 }
 
+NodeStore::ReadPriority InboundLedger::getReadPriority () const
+{
+    switch (mReason)
+    {
+    case fcHISTORY:
+        return NodeStore::readHistory;
+
+    case fcGENERIC:
+        return NodeStore::readNormal;
+
+    default:
+        // Validation, consensus and current ledgers are time critical
+        break;
+    }
+
+    return NodeStore::readUrgent;
+}
+
 void InboundLedger::done ()
 {
     if (mSignaled)
@@ -559,7 +581,7 @@ void InboundLedger::trigger (Peer::ref peer)
             // Release the lock while we process the large state map
             sl.unlock();
             mLedger->peekAccountStateMap ()->getMissingNodes (
-                nodeIDs, nodeHashes, 256, &filter);
+                nodeIDs, nodeHashes, 256, &filter, getReadPriority ());
             sl.lock();
 
             // Make sure nothing happened while we released the lock
@@ -631,7 +653,7 @@ void InboundLedger::trigger (Peer::ref peer)
             nodeHashes.reserve (256);
             TransactionStateSF filter (mSeq);
             mLedger->peekTransactionMap ()->getMissingNodes (
-                nodeIDs, nodeHashes, 256, &filter);
+                nodeIDs, nodeHashes, 256, &filter, getReadPriority ());
 
             if (nodeIDs.empty ())
             {
@@ -754,6 +776,124 @@ void InboundLedger::filterNodes (std::vector<SHAMapNode>& nodeIDs,
     }
 }
 
+void InboundLedger::fillPipeline (Peer::ref peer)
+{
+    ScopedLockType sl (mLock);
+
+    if (isDone ())
+        return;
+
+    bool const wantState (mHaveBase && !mHaveState);
+    SHAMap::pointer map;
+
+    if (wantState)
+        map = mLedger->peekAccountStateMap ();
+    else if (mHaveBase && !mHaveTransactions)
+        map = mLedger->peekTransactionMap ();
+
+    // The base and the map roots come one request at a time
+    if (!map || map->getHash ().isZero ())
+    {
+        trigger (peer);
+        return;
+    }
+
+    std::vector <std::pair <AcquirePipeline::PeerId, int> > room;
+    int slots = 0;
+
+    for (auto const& p : mPeers)
+    {
+        if (getApp().getPeers ().findPeerByShortID (p.first))
+        {
+            int const available (mPipeline.available (p.first));
+            room.push_back (std::make_pair (p.first, available));
+            slots += available;
+        }
+    }
+
+    if (slots == 0)
+        return;
+
+    int const max (slots * AcquirePipeline::nodesPerRequest);
+    std::vector<SHAMapNode> nodeIDs;
+    std::vector<uint256> nodeHashes;
+    nodeIDs.reserve (max);
+    nodeHashes.reserve (max);
+
+    // Release the lock while we process the large state map
+    sl.unlock ();
+    if (wantState)
+    {
+        AccountStateSF filter (mSeq);
+        map->getMissingNodes (nodeIDs, nodeHashes, max, &filter,
+            getReadPriority ());
+    }
+    else
+    {
+        TransactionStateSF filter (mSeq);
+        map->getMissingNodes (nodeIDs, nodeHashes, max, &filter,
+            getReadPriority ());
+    }
+    sl.lock ();
+
+    // Make sure nothing happened while we released the lock
+    if (isDone () || (wantState ? mHaveState : mHaveTransactions))
+        return;
+
+    if (nodeIDs.empty ())
+    {
+        // The map may be complete, let trigger sort it out
+        trigger (peer);
+        return;
+    }
+
+    filterNodes (nodeIDs, nodeHashes,
+        wantState ? mRecentASNodes : mRecentTXNodes, max, false);
+
+    // Everything missing has already been asked for
+    if (nodeIDs.empty ())
+        return;
+
+    protocol::TMGetLedger tmGL;
+    tmGL.set_ledgerhash (mHash.begin (), mHash.size ());
+    tmGL.set_ledgerseq (mLedger->getLedgerSeq ());
+    tmGL.set_itype (wantState ? protocol::liAS_NODE : protocol::liTX_NODE);
+
+    if (getTimeouts () != 0)
+        tmGL.set_querytype (protocol::qtINDIRECT);
+
+    std::vector <AcquirePipeline::Request> const requests (
+        AcquirePipeline::assign (nodeIDs, room));
+    AcquirePipeline::clock_type::time_point const now (
+        AcquirePipeline::clock_type::now ());
+
+    BOOST_FOREACH (AcquirePipeline::Request const& request, requests)
+    {
+        Peer::pointer target (
+            getApp().getPeers ().findPeerByShortID (request.first));
+
+        if (!target)
+            continue;
+
+        std::vector <SHAMapNode> sentIDs;
+        sentIDs.reserve (request.second.size ());
+
+        tmGL.clear_nodeids ();
+        BOOST_FOREACH (std::size_t i, request.second)
+        {
+            * (tmGL.add_nodeids ()) = nodeIDs[i].getRawString ();
+            sentIDs.push_back (nodeIDs[i]);
+        }
+
+        sendRequest (tmGL, target);
+        mPipeline.sent (request.first, sentIDs, now);
+    }
+
+    if (m_journal.trace) m_journal.trace <<
+        "Pipelined " << nodeIDs.size () << (wantState ? " AS" : " TX") <<
+            " nodes in " << requests.size () << " requests";
+}
+
 /** Take ledger base data
     Call with a lock
 */
@@ -805,8 +945,8 @@ bool InboundLedger::takeBase (const std::string& data)
 /** Process TX data received from a peer
     Call with a lock
 */
-bool InboundLedger::takeTxNode (const std::list<SHAMapNode>& nodeIDs,
-    const std::list< Blob >& data, SHAMapAddNode& san)
+bool InboundLedger::takeTxNode (std::vector <ReceivedNode> const& nodes,
+    SHAMapAddNode& san)
 {
     if (!mHaveBase)
     {
@@ -822,29 +962,24 @@ bool InboundLedger::takeTxNode (const std::list<SHAMapNode>& nodeIDs,
         return true;
     }
 
-    std::list<SHAMapNode>::const_iterator nodeIDit = nodeIDs.begin ();
-    std::list< Blob >::const_iterator nodeDatait = data.begin ();
     TransactionStateSF tFilter (mLedger->getLedgerSeq ());
 
-    while (nodeIDit != nodeIDs.end ())
+    BOOST_FOREACH (ReceivedNode const& node, nodes)
     {
-        if (nodeIDit->isRoot ())
+        if (node.id.isRoot ())
         {
             san += mLedger->peekTransactionMap ()->addRootNode (
-                mLedger->getTransHash (), *nodeDatait, snfWIRE, &tFilter);
+                mLedger->getTransHash (), node.data, snfWIRE, &tFilter);
             if (!san.isGood())
                 return false;
         }
         else
         {
             san +=  mLedger->peekTransactionMap ()->addKnownNode (
-                *nodeIDit, *nodeDatait, &tFilter);
+                node.id, node.node, &tFilter);
             if (!san.isGood())
                 return false;
         }
-
-        ++nodeIDit;
-        ++nodeDatait;
     }
 
     if (!mLedger->peekTransactionMap ()->isSynching ())
@@ -865,13 +1000,13 @@ bool InboundLedger::takeTxNode (const std::list<SHAMapNode>& nodeIDs,
 /** Process AS data received from a peer
     Call with a lock
 */
-bool InboundLedger::takeAsNode (const std::list<SHAMapNode>& nodeIDs,
-    const std::list< Blob >& data, SHAMapAddNode& san)
+bool InboundLedger::takeAsNode (std::vector <ReceivedNode> const& nodes,
+    SHAMapAddNode& san)
 {
     if (m_journal.trace) m_journal.trace <<
-        "got ASdata (" << nodeIDs.size () << ") acquiring ledger " << mHash;
-    if (nodeIDs.size () == 1 && m_journal.trace) m_journal.trace <<
-        "got AS node: " << nodeIDs.front ();
+        "got ASdata (" << nodes.size () << ") acquiring ledger " << mHash;
+    if (nodes.size () == 1 && m_journal.trace) m_journal.trace <<
+        "got AS node: " << nodes.front ().id;
 
     ScopedLockType sl (mLock);
 
@@ -889,16 +1024,14 @@ bool InboundLedger::takeAsNode (const std::list<SHAMapNode>& nodeIDs,
         return true;
     }
 
-    std::list<SHAMapNode>::const_iterator nodeIDit = nodeIDs.begin ();
-    std::list< Blob >::const_iterator nodeDatait = data.begin ();
     AccountStateSF tFilter (mLedger->getLedgerSeq ());
 
-    while (nodeIDit != nodeIDs.end ())
+    BOOST_FOREACH (ReceivedNode const& node, nodes)
     {
-        if (nodeIDit->isRoot ())
+        if (node.id.isRoot ())
         {
             san += mLedger->peekAccountStateMap ()->addRootNode (
-                mLedger->getAccountHash (), *nodeDatait, snfWIRE, &tFilter);
+                mLedger->getAccountHash (), node.data, snfWIRE, &tFilter);
             if (!san.isGood ())
             {
                 if (m_journal.warning) m_journal.warning <<
@@ -909,7 +1042,7 @@ bool InboundLedger::takeAsNode (const std::list<SHAMapNode>& nodeIDs,
         else
         {
             san += mLedger->peekAccountStateMap ()->addKnownNode (
-                *nodeIDit, *nodeDatait, &tFilter);
+                node.id, node.node, &tFilter);
             if (!san.isGood ())
             {
                 if (m_journal.warning) m_journal.warning <<
@@ -917,9 +1050,6 @@ bool InboundLedger::takeAsNode (const std::list<SHAMapNode>& nodeIDs,
                 return false;
             }
         }
-
-        ++nodeIDit;
-        ++nodeDatait;
     }
 
     if (!mLedger->peekAccountStateMap ()->isSynching ())
@@ -1025,6 +1155,47 @@ std::vector<InboundLedger::neededHash_t> InboundLedger::getNeededHashes ()
     return ret;
 }
 
+/** Parse and hash the nodes a peer sent
+    Returns 'false' if any of them is malformed
+*/
+static bool prepareNodes (protocol::TMLedgerData const& packet,
+    std::vector <InboundLedger::ReceivedNode>& nodes)
+{
+    uint256 const uZero;
+
+    nodes.reserve (packet.nodes_size ());
+
+    try
+    {
+        for (int i = 0; i < packet.nodes_size (); ++i)
+        {
+            const protocol::TMLedgerNode& node = packet.nodes (i);
+
+            if (!node.has_nodeid () || !node.has_nodedata ())
+                return false;
+
+            InboundLedger::ReceivedNode received;
+            received.id = SHAMapNode (node.nodeid ().data (),
+                node.nodeid ().size ());
+            Blob data (node.nodedata ().begin (), node.nodedata ().end ());
+
+            if (received.id.isRoot ())
+                received.data.swap (data);
+            else
+                received.node = boost::make_shared <SHAMapTreeNode> (
+                    received.id, data, 0, snfWIRE, uZero, false);
+
+            nodes.push_back (received);
+        }
+    }
+    catch (...)
+    {
+        return false;
+    }
+
+    return true;
+}
+
 /** Stash a TMLedgerData received from a peer for later processing
     Returns 'true' if we need to dispatch
 */
@@ -1032,9 +1203,20 @@ std::vector<InboundLedger::neededHash_t> InboundLedger::getNeededHashes ()
 bool InboundLedger::gotData (boost::weak_ptr<Peer> peer,
     boost::shared_ptr<protocol::TMLedgerData> data)
 {
+    ReceivedData received;
+    received.peer = peer;
+    received.packet = data;
+    received.valid = true;
+
+    if ((data->type () == protocol::liTX_NODE) ||
+        (data->type () == protocol::liAS_NODE))
+    {
+        received.valid = prepareNodes (*data, received.nodes);
+    }
+
     ScopedLockType sl (mReceivedDataLock);
 
-    mReceivedData.push_back (PeerDataPairType (peer, data));
+    mReceivedData.push_back (std::move (received));
 
     if (mReceiveDispatched)
         return false;
@@ -1052,8 +1234,10 @@ bool InboundLedger::gotData (boost::weak_ptr<Peer> peer,
 //        TODO Change peer to Consumer
 //
 int InboundLedger::processData (boost::shared_ptr<Peer> peer,
-    protocol::TMLedgerData& packet)
+    ReceivedData& data)
 {
+    protocol::TMLedgerData& packet (*data.packet);
+
     ScopedLockType sl (mLock);
 
     if (packet.type () == protocol::liBASE)
@@ -1108,9 +1292,6 @@ int InboundLedger::processData (boost::shared_ptr<Peer> peer,
     if ((packet.type () == protocol::liTX_NODE) || (
         packet.type () == protocol::liAS_NODE))
     {
-        std::list<SHAMapNode> nodeIDs;
-        std::list< Blob > nodeData;
-
         if (packet.nodes ().size () == 0)
         {
             if (m_journal.info) m_journal.info <<
@@ -1119,35 +1300,29 @@ int InboundLedger::processData (boost::shared_ptr<Peer> peer,
             return -1;
         }
 
-        for (int i = 0; i < packet.nodes ().size (); ++i)
+        // The nodes were parsed and hashed when the data arrived
+        if (!data.valid)
         {
-            const protocol::TMLedgerNode& node = packet.nodes (i);
-
-            if (!node.has_nodeid () || !node.has_nodedata ())
-            {
-                if (m_journal.warning) m_journal.warning <<
-                    "Got bad node";
-                peer->charge (Resource::feeInvalidRequest);
-                return -1;
-            }
-
-            nodeIDs.push_back (SHAMapNode (node.nodeid ().data (),
-                node.nodeid ().size ()));
-            nodeData.push_back (Blob (node.nodedata ().begin (),
-                node.nodedata ().end ()));
+            if (m_journal.warning) m_journal.warning <<
+                "Got bad node";
+            peer->charge (Resource::feeInvalidRequest);
+            return -1;
         }
 
+        mPipeline.received (peer->getShortId (), data.nodes.front ().id,
+            AcquirePipeline::clock_type::now ());
+
         SHAMapAddNode ret;
 
         if (packet.type () == protocol::liTX_NODE)
         {
-            takeTxNode (nodeIDs, nodeData, ret);
+            takeTxNode (data.nodes, ret);
             if (m_journal.debug) m_journal.debug <<
                 "Ledger TX node stats: " << ret.get();
         }
         else
         {
-            takeAsNode (nodeIDs, nodeData, ret);
+            takeAsNode (data.nodes, ret);
             if (m_journal.debug) m_journal.debug <<
                 "Ledger AS node stats: " << ret.get();
         }
@@ -1172,7 +1347,7 @@ void InboundLedger::runData ()
     boost::shared_ptr<Peer> chosenPeer;
     int chosenPeerCount = -1;
 
-    std::vector <PeerDataPairType> data;
+    std::vector <ReceivedData> data;
     do
     {
         data.clear();
@@ -1189,12 +1364,12 @@ void InboundLedger::runData ()
 
         // Select the peer that gives us the most nodes that are useful,
         // breaking ties in favor of the peer that responded first.
-        BOOST_FOREACH (PeerDataPairType& entry, data)
+        BOOST_FOREACH (ReceivedData& entry, data)
         {
-            Peer::pointer peer = entry.first.lock();
+            Peer::pointer peer = entry.peer.lock();
             if (peer)
             {
-                int count = processData (peer, *(entry.second));
+                int count = processData (peer, entry);
                 if (count > chosenPeerCount)
                 {
                     chosenPeer = peer;
@@ -1205,8 +1380,10 @@ void InboundLedger::runData ()
 
     } while (1);
 
+    // Rather than one request to the best peer, keep
+    // requests going to all of them.
     if (chosenPeer)
-        trigger (chosenPeer);
+        fillPipeline (chosenPeer);
 }
 
 Json::Value InboundLedger::getJson (int)
@@ -1239,6 +1416,9 @@ Json::Value InboundLedger::getJson (int)
 
     ret["timeouts"] = getTimeouts ();
 
+    if (!mComplete && !mFailed)
+        ret["pipeline"] = mPipeline.getJson ();
+
     if (mHaveBase && !mHaveState)
     {
         Json::Value hv (Json::arrayValue);
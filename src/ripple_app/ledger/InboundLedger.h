@@ -33,7 +33,23 @@ public:
     static char const* getCountedObjectName () { return "InboundLedger"; }
 
     typedef boost::shared_ptr <InboundLedger> pointer;
-    typedef std::pair < boost::weak_ptr<Peer>, boost::shared_ptr<protocol::TMLedgerData> > PeerDataPairType;
+
+    // A node from a peer, parsed and hashed before any locks are taken
+    struct ReceivedNode
+    {
+        SHAMapNode id;
+        Blob data;                      // Only kept for a root node
+        SHAMapTreeNode::pointer node;   // Built for every other node
+    };
+
+    // Data from a peer waiting to be added to the ledger
+    struct ReceivedData
+    {
+        boost::weak_ptr <Peer> peer;
+        boost::shared_ptr <protocol::TMLedgerData> packet;
+        std::vector <ReceivedNode> nodes;
+        bool valid;
+    };
 
     // These are the reasons we might acquire a ledger
     enum fcReason
@@ -88,6 +104,11 @@ public:
     bool checkLocal ();
     void init (ScopedLockType& collectionLock);
 
+    /** Stash data received from a peer.
+        Any nodes are parsed and hashed first, without holding a lock,
+        so the data from many peers can be worked on at once.
+        @return `true` if runData needs to be dispatched.
+    */
     bool gotData (boost::weak_ptr<Peer>, boost::shared_ptr<protocol::TMLedgerData>);
 
     typedef std::pair <protocol::TMGetObjectByHash::ObjectType, uint256> neededHash_t;
@@ -113,19 +134,25 @@ private:
 
     boost::weak_ptr <PeerSet> pmDowncast ();
 
-    int processData (boost::shared_ptr<Peer> peer, protocol::TMLedgerData& data);
+    /** Returns the node store read priority for this acquisition. */
+    NodeStore::ReadPriority getReadPriority () const;
+
+    int processData (boost::shared_ptr<Peer> peer, ReceivedData& data);
+
+    /** Keep every peer's pipeline of node requests full.
+        Until the maps can be walked, just ask the given peer.
+    */
+    void fillPipeline (Peer::ref peer);
 
     bool takeBase (const std::string& data);
-    bool takeTxNode (const std::list<SHAMapNode>& IDs, const std::list<Blob >& data,
-                     SHAMapAddNode&);
+    bool takeTxNode (std::vector <ReceivedNode> const& nodes, SHAMapAddNode&);
     bool takeTxRootNode (Blob const& data, SHAMapAddNode&);
 
     // VFALCO TODO Rename to receiveAccountStateNode
     //             Don't use acronyms, but if we are going to use them at least
     //             capitalize them correctly.
     //
-    bool takeAsNode (const std::list<SHAMapNode>& IDs, const std::list<Blob >& data,
-                     SHAMapAddNode&);
+    bool takeAsNode (std::vector <ReceivedNode> const& nodes, SHAMapAddNode&);
     bool takeAsRootNode (Blob const& data, SHAMapAddNode&);
 
 private:
@@ -142,10 +169,12 @@ private:
     std::set <SHAMapNode> mRecentTXNodes;
     std::set <SHAMapNode> mRecentASNodes;
 
+    // Node requests in flight to each peer
+    AcquirePipeline mPipeline;
 
     // Data we have received from peers
     PeerSet::LockType mReceivedDataLock;
-    std::vector <PeerDataPairType> mReceivedData;
+    std::vector <ReceivedData> mReceivedData;
     bool mReceiveDispatched;
 
     std::vector <std::function <void (InboundLedger::pointer)> > mOnComplete;
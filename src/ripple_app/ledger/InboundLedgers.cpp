@@ -177,12 +177,32 @@ public:
             return false;
         }
 
+        // Hash the nodes off the I/O thread. Many of these can run at
+        // once, only adding them to the ledger's maps is serialized.
+        getApp().getJobQueue().addJob (jtLEDGER_VERIFY, "prepareLedgerData",
+            BIND_TYPE (&InboundLedgersImp::doPrepareData, this, P_1, hash,
+                boost::weak_ptr<Peer> (peer), packet_ptr));
+
+        return true;
+    }
+
+    void doPrepareData (Job&, LedgerHash hash, boost::weak_ptr<Peer> peer,
+        boost::shared_ptr<protocol::TMLedgerData> packet_ptr)
+    {
+        InboundLedger::pointer ledger = find (hash);
+
+        if (!ledger)
+        {
+            if (packet_ptr->type () == protocol::liAS_NODE)
+                gotStaleData (packet_ptr);
+
+            return;
+        }
+
         // Stash the data for later processing and see if we need to dispatch
-        if (ledger->gotData(boost::weak_ptr<Peer>(peer), packet_ptr))
+        if (ledger->gotData (peer, packet_ptr))
             getApp().getJobQueue().addJob (jtLEDGER_DATA, "processLedgerData",
                 BIND_TYPE (&InboundLedgers::doLedgerData, this, P_1, hash));
-
-        return true;
     }
 
     int getFetchCount (int& timeoutCount)
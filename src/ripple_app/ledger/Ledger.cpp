@@ -556,9 +556,8 @@ bool Ledger::saveValidatedLedger (bool current)
 {
     WriteLog (lsTRACE, Ledger) << "saveValidatedLedger " << (current ? "" : "fromAcquire ") << getLedgerSeq ();
     static boost::format deleteLedger ("DELETE FROM Ledgers WHERE LedgerSeq = %u;");
-    static boost::format deleteTrans1 ("DELETE FROM Transactions WHERE LedgerSeq = %u;");
-    static boost::format deleteTrans2 ("DELETE FROM AccountTransactions WHERE LedgerSeq = %u;");
-    static boost::format deleteAcctTrans ("DELETE FROM AccountTransactions WHERE TransID = '%s';");
+    static std::string const deleteTrans ("DELETE FROM Transactions WHERE LedgerSeq = ?;");
+    static std::string const insertTrans (SerializedTransaction::getMetaSQLInsertReplaceStatement ());
     static boost::format transExists ("SELECT Status FROM Transactions WHERE TransID = '%s';");
     static boost::format
     updateTx ("UPDATE Transactions SET LedgerSeq = %u, Status = '%c', TxnMeta = %s WHERE TransID = '%s';");
@@ -602,6 +601,19 @@ bool Ledger::saveValidatedLedger (bool current)
             StaticScopedLockType sl (sPendingSaveLock);
             sPendingSaves.erase(getLedgerSeq());
         }
+
+        // This may have been the save the grouped write was waiting for
+        UnflushedSaves saves;
+        {
+            DeprecatedScopedLock dbLock (getApp().getTxnDB ()->getDBLock ());
+
+            if (!otherSavesPending ())
+            {
+                getApp().getTxnDB ()->getDB ()->getSqliteDB ()->flushGroupedWrites ();
+                saves.swap (sUnflushedSaves);
+            }
+        }
+        recordSaves (*getApp().getLedgerDB (), saves);
         return false;
     }
 
@@ -610,75 +622,135 @@ bool Ledger::saveValidatedLedger (bool current)
         getApp().getLedgerDB ()->getDB ()->executeSQL (boost::str (deleteLedger % mLedgerSeq));
     }
 
+    UnflushedSaves saves;
     {
-        Database* db = getApp().getTxnDB ()->getDB ();
+        SqliteDatabase* db = getApp().getTxnDB ()->getDB ()->getSqliteDB ();
         DeprecatedScopedLock dbLock (getApp().getTxnDB ()->getDBLock ());
-        db->executeSQL ("BEGIN TRANSACTION;");
+        db->beginGroupedWrite ();
+
+        {
+            SqliteStatement& statement (db->getStatement (deleteTrans));
+            statement.bind (1, mLedgerSeq);
+
+            int const result = statement.step ();
+
+            if (statement.isError (result))
+            {
+                WriteLog (lsWARNING, Ledger) << "Deleting transactions in ledger " << mLedgerSeq <<
+                    ": " << statement.getError (result);
+            }
+        }
+
+        Serializer rawTxn (2048);
 
-        db->executeSQL (boost::str (deleteTrans1 % mLedgerSeq));
-        db->executeSQL (boost::str (deleteTrans2 % mLedgerSeq));
+        std::vector <AccountTxIndex::LedgerTxn> txns;
+        txns.reserve (aLedger->getMap ().size ());
 
         BOOST_FOREACH (const AcceptedLedger::value_type & vt, aLedger->getMap ())
         {
             uint256 txID = vt.second->getTransactionID ();
             getApp().getMasterTransaction ().inLedger (txID, mLedgerSeq);
 
-            db->executeSQL (boost::str (deleteAcctTrans % txID.GetHex ()));
+            txns.push_back (AccountTxIndex::LedgerTxn ());
+            txns.back ().txID = txID;
+            txns.back ().txnSeq = vt.second->getTxnSeq ();
+            txns.back ().accounts = vt.second->getAffected ();
 
-            const std::vector<RippleAddress>& accts = vt.second->getAffected ();
-
-            if (!accts.empty ())
+            if (txns.back ().accounts.empty ())
             {
-                std::string sql = "INSERT INTO AccountTransactions (TransID, Account, LedgerSeq, TxnSeq) VALUES ";
-                bool first = true;
+                WriteLog (lsWARNING, Ledger) << "Transaction in ledger " << mLedgerSeq << " affects no accounts";
+            }
 
-                for (std::vector<RippleAddress>::const_iterator it = accts.begin (), end = accts.end (); it != end; ++it)
-                {
-                    if (!first)
-                        sql += ", ('";
-                    else
-                    {
-                        sql += "('";
-                        first = false;
-                    }
-
-                    sql += txID.GetHex ();
-                    sql += "','";
-                    sql += it->humanAccountID ();
-                    sql += "',";
-                    sql += beast::lexicalCastThrow <std::string> (getLedgerSeq ());
-                    sql += ",";
-                    sql += beast::lexicalCastThrow <std::string> (vt.second->getTxnSeq ());
-                    sql += ")";
-                }
+            assert (!vt.second->getRawMeta ().empty ());
 
-                sql += ";";
-                WriteLog (lsTRACE, Ledger) << "ActTx: " << sql;
-                db->executeSQL (sql);
-            }
-            else
-                WriteLog (lsWARNING, Ledger) << "Transaction in ledger " << mLedgerSeq << " affects no accounts";
+            rawTxn.erase ();
+            vt.second->getTxn ()->add (rawTxn);
+
+            SqliteStatement& statement (db->getStatement (insertTrans));
+            vt.second->getTxn ()->bindMetaSQL (statement, rawTxn, getLedgerSeq (),
+                TXN_SQL_VALIDATED, vt.second->getRawMeta ());
 
-            db->executeSQL (SerializedTransaction::getMetaSQLInsertReplaceHeader () +
-                            vt.second->getTxn ()->getMetaSQL (getLedgerSeq (), vt.second->getEscMeta ()) + ";");
+            int const result = statement.step ();
+
+            if (statement.isError (result))
+            {
+                WriteLog (lsWARNING, Ledger) << "Saving " << txID << " in ledger " << mLedgerSeq <<
+                    ": " << statement.getError (result);
+            }
         }
-        db->executeSQL ("COMMIT TRANSACTION;");
-    }
 
-    {
-        DeprecatedScopedLock sl (getApp().getLedgerDB ()->getDBLock ());
+        getApp().getAccountTxIndex ().insertLedger (mLedgerSeq, txns);
 
-        getApp().getLedgerDB ()->getDB ()->executeSQL (boost::str (addLedger %
+        saves = endSave (*db, mLedgerSeq, boost::str (addLedger %
                 getHash ().GetHex () % mLedgerSeq % mParentHash.GetHex () %
                 beast::lexicalCastThrow <std::string> (mTotCoins) % mCloseTime % mParentCloseTime %
-                mCloseResolution % mCloseFlags % mAccountHash.GetHex () % mTransHash.GetHex ()));
+                mCloseResolution % mCloseFlags % mAccountHash.GetHex () % mTransHash.GetHex ()),
+            current);
     }
 
-    { // Clients can now trust the database for information about this ledger sequence
+    recordSaves (*getApp().getLedgerDB (), saves);
+    return true;
+}
+
+/** Finish the grouped write of a ledger's transactions.
+    While other saves are waiting, they share the write. The ledger is
+    recorded with `sql` once its transactions are committed. Called with
+    the transaction database lock held.
+    @return The saves the caller must record, once the lock is released.
+*/
+Ledger::UnflushedSaves Ledger::endSave (SqliteDatabase& txnDB, std::uint32_t ledgerSeq,
+    std::string const& sql, bool flush)
+{
+    UnflushedSaves saves;
+
+    sUnflushedSaves.push_back (std::make_pair (ledgerSeq, sql));
+
+    if (txnDB.endGroupedWrite (flush || !otherSavesPending ()))
+        saves.swap (sUnflushedSaves);
+
+    return saves;
+}
+
+void Ledger::flushSaves (DatabaseCon& txnDB, DatabaseCon& ledgerDB)
+{
+    UnflushedSaves saves;
+    {
+        DeprecatedScopedLock dbLock (txnDB.getDBLock ());
+        txnDB.getDB ()->getSqliteDB ()->flushGroupedWrites ();
+        saves.swap (sUnflushedSaves);
+    }
+    recordSaves (ledgerDB, saves);
+}
+
+/** Returns true if ledgers other than those in the grouped write are waiting
+    to be saved. Called with the transaction database lock held.
+*/
+bool Ledger::otherSavesPending ()
+{
+    StaticScopedLockType sl (sPendingSaveLock);
+    return sPendingSaves.size () > sUnflushedSaves.size ();
+}
+
+/** Record ledgers whose transactions have been committed. */
+void Ledger::recordSaves (DatabaseCon& ledgerDB, UnflushedSaves const& saves)
+{
+    if (saves.empty ())
+        return;
+
+    {
+        DeprecatedScopedLock sl (ledgerDB.getDBLock ());
+        Database* db = ledgerDB.getDB ();
+
+        BOOST_FOREACH (UnflushedSaves::value_type const& save, saves)
+            db->executeSQL (save.second);
+    }
+
+    { // Clients can now trust the database for information about these ledger sequences
         StaticScopedLockType sl (sPendingSaveLock);
-        sPendingSaves.erase(getLedgerSeq());
+
+        BOOST_FOREACH (UnflushedSaves::value_type const& save, saves)
+            sPendingSaves.erase (save.first);
     }
-    return true;
 }
 
 #ifndef NO_SQLITE3_PREPARE
@@ -2048,12 +2120,86 @@ std::vector<uint256> Ledger::getNeededAccountStateHashes (int max, SHAMapSyncFil
 class Ledger_test : public beast::unit_test::suite
 {
 public:
+    static bool hasLedger (DatabaseCon& ledgerDB, std::uint32_t ledgerSeq)
+    {
+        Database* db = ledgerDB.getDB ();
+        DeprecatedScopedLock sl (ledgerDB.getDBLock ());
+
+        bool const exists = SQL_EXISTS (db, boost::str (boost::format (
+            "SELECT LedgerHash FROM Ledgers WHERE LedgerSeq = %u;") % ledgerSeq));
+        db->endIterRows ();
+        return exists;
+    }
+
+    static std::string addLedger (std::uint32_t ledgerSeq)
+    {
+        return boost::str (boost::format (
+            "INSERT OR REPLACE INTO Ledgers (LedgerHash, LedgerSeq) VALUES ('%s', %u);")
+                % uint256 (ledgerSeq).GetHex () % ledgerSeq);
+    }
+
+    void testDeferredSave ()
+    {
+        testcase ("deferred save");
+
+        DatabaseCon txnDB (DatabaseCon::InMemory (), TxnDBInit, TxnDBCount);
+        DatabaseCon ledgerDB (DatabaseCon::InMemory (), LedgerDBInit, LedgerDBCount);
+        SqliteDatabase* db = txnDB.getDB ()->getSqliteDB ();
+        db->setGroupedWriteLimit (64);
+
+        {
+            Ledger::StaticScopedLockType sl (Ledger::sPendingSaveLock);
+            Ledger::sPendingSaves.insert (5);
+            Ledger::sPendingSaves.insert (6);
+        }
+
+        // Ledger 6 is still waiting, so the write of ledger 5 stays open
+        Ledger::UnflushedSaves saves;
+        {
+            DeprecatedScopedLock sl (txnDB.getDBLock ());
+            db->beginGroupedWrite ();
+            saves = Ledger::endSave (*db, 5, addLedger (5), false);
+        }
+        Ledger::recordSaves (ledgerDB, saves);
+
+        expect (!hasLedger (ledgerDB, 5), "Not recorded before the commit");
+        expect (Ledger::getPendingSaves ().count (5) == 1, "Still pending");
+        expect (sqlite3_get_autocommit (db->peekConnection ()) == 0, "Group open");
+
+        // Any other statement commits the group before it runs
+        {
+            DeprecatedScopedLock sl (txnDB.getDBLock ());
+            db->executeSQL ("SELECT COUNT(*) FROM Transactions;", false);
+            db->endIterRows ();
+        }
+        expect (sqlite3_get_autocommit (db->peekConnection ()) != 0, "Group committed");
+        expect (!hasLedger (ledgerDB, 5), "Recorded with the next save");
+
+        Ledger::flushSaves (txnDB, ledgerDB);
+
+        expect (hasLedger (ledgerDB, 5), "Recorded after the commit");
+        expect (Ledger::getPendingSaves ().count (5) == 0, "No longer pending");
+
+        // A save which nothing else waits for commits at once
+        {
+            DeprecatedScopedLock sl (txnDB.getDBLock ());
+            db->beginGroupedWrite ();
+            saves = Ledger::endSave (*db, 6, addLedger (6), false);
+        }
+        Ledger::recordSaves (ledgerDB, saves);
+
+        expect (hasLedger (ledgerDB, 6), "Last pending save recorded");
+        expect (Ledger::getPendingSaves ().empty ());
+    }
+
     void run ()
     {
         uint256 uBig ("D2DC44E5DC189318DB36EF87D2104CDF0A0FE3A4B698BEEE55038D7EA4C68000");
 
         // VFALCO NOTE This fails in the original version as well.
         expect (6125895493223874560 == Ledger::getQuality (uBig));
+
+        testDeferredSave ();
     }
 };
 
@@ -2061,5 +2207,6 @@ BEAST_DEFINE_TESTSUITE(Ledger,ripple_app,ripple);
 
 Ledger::StaticLockType Ledger::sPendingSaveLock;
 std::set<std::uint32_t> Ledger::sPendingSaves;
+Ledger::UnflushedSaves Ledger::sUnflushedSaves;
 
 } // ripple
@@ -464,6 +464,12 @@ public:
 
     static std::set<std::uint32_t> getPendingSaves();
 
+    /** Commit the grouped write of older ledgers' transactions, if one is
+        open, and record those ledgers. Call before the transaction
+        database is closed.
+    */
+    static void flushSaves (DatabaseCon& txnDB, DatabaseCon& ledgerDB);
+
     Json::Value getJson (int options);
     void addJson (Json::Value&, int options);
 
@@ -485,8 +491,17 @@ protected:
     void updateFees ();
 
 private:
+    friend class Ledger_test;
+
     void initializeFees ();
 
+    typedef std::vector <std::pair <std::uint32_t, std::string> > UnflushedSaves;
+
+    static bool otherSavesPending ();
+    static UnflushedSaves endSave (SqliteDatabase& txnDB, std::uint32_t ledgerSeq,
+        std::string const& sql, bool flush);
+    static void recordSaves (DatabaseCon& ledgerDB, UnflushedSaves const& saves);
+
 private:
     // The basic Ledger structure, can be opened, closed, or synching
     uint256       mHash;
@@ -514,6 +529,11 @@ private:
     static StaticLockType sPendingSaveLock;
 
     static std::set<std::uint32_t>  sPendingSaves;
+
+    // ledgers whose transactions are in an uncommitted grouped write, with
+    // the SQL to record the ledger once they are committed.
+    // Protected by the transaction database lock.
+    static UnflushedSaves sUnflushedSaves;
 };
 
 inline LedgerStateParms operator| (const LedgerStateParms& l1, const LedgerStateParms& l2)
@@ -17,6 +17,11 @@
 */
 //==============================================================================
 
+#include "../../beast/beast/unit_test/suite.h"
+
+#include <chrono>
+#include <sstream>
+
 namespace ripple {
 
 SETUP_LOG (LedgerEntrySet)
@@ -71,22 +76,28 @@ void LedgerEntrySet::swapWith (LedgerEntrySet& e)
 // This is basically: copy-on-read.
 SLE::pointer LedgerEntrySet::getEntry (uint256 const& index, LedgerEntryAction& action)
 {
-    std::map<uint256, LedgerEntrySetEntry>::iterator it = mEntries.find (index);
+    // Look up through a const reference so entries shared with
+    // another set are only copied when this one has to change them
+    EntryMap const& entries (mEntries);
+    const_iterator found = entries.find (index);
 
-    if (it == mEntries.end ())
+    if (found == entries.end ())
     {
         action = taaNONE;
         return SLE::pointer ();
     }
 
-    if (it->second.mSeq != mSeq)
-    {
-        assert (it->second.mSeq < mSeq);
-        it->second.mEntry = boost::make_shared<SerializedLedgerEntry> (*it->second.mEntry);
-        it->second.mSeq = mSeq;
-    }
+    action = found->second.mAction;
+
+    if (found->second.mSeq == mSeq)
+        return found->second.mEntry;
+
+    iterator it = mEntries.find (index);
+
+    assert (it->second.mSeq < mSeq);
+    it->second.mEntry = boost::make_shared<SerializedLedgerEntry> (*it->second.mEntry);
+    it->second.mSeq = mSeq;
 
-    action = it->second.mAction;
     return it->second.mEntry;
 }
 
@@ -125,7 +136,7 @@ SLE::pointer LedgerEntrySet::entryCache (LedgerEntryType letType, uint256 const&
 
 LedgerEntryAction LedgerEntrySet::hasEntry (uint256 const& index) const
 {
-    std::map<uint256, LedgerEntrySetEntry>::const_iterator it = mEntries.find (index);
+    const_iterator it = mEntries.find (index);
 
     if (it == mEntries.end ())
         return taaNONE;
@@ -137,7 +148,7 @@ void LedgerEntrySet::entryCache (SLE::ref sle)
 {
     assert (mLedger);
     assert (sle->isMutable () || mImmutable); // Don't put an immutable SLE in a mutable LES
-    std::map<uint256, LedgerEntrySetEntry>::iterator it = mEntries.find (sle->getIndex ());
+    iterator it = mEntries.find (sle->getIndex ());
 
     if (it == mEntries.end ())
     {
@@ -162,7 +173,7 @@ void LedgerEntrySet::entryCreate (SLE::ref sle)
 {
     assert (mLedger && !mImmutable);
     assert (sle->isMutable ());
-    std::map<uint256, LedgerEntrySetEntry>::iterator it = mEntries.find (sle->getIndex ());
+    iterator it = mEntries.find (sle->getIndex ());
 
     if (it == mEntries.end ())
     {
@@ -200,7 +211,7 @@ void LedgerEntrySet::entryModify (SLE::ref sle)
 {
     assert (sle->isMutable () && !mImmutable);
     assert (mLedger);
-    std::map<uint256, LedgerEntrySetEntry>::iterator it = mEntries.find (sle->getIndex ());
+    iterator it = mEntries.find (sle->getIndex ());
 
     if (it == mEntries.end ())
     {
@@ -236,7 +247,7 @@ void LedgerEntrySet::entryDelete (SLE::ref sle)
 {
     assert (sle->isMutable () && !mImmutable);
     assert (mLedger);
-    std::map<uint256, LedgerEntrySetEntry>::iterator it = mEntries.find (sle->getIndex ());
+    iterator it = mEntries.find (sle->getIndex ());
 
     if (it == mEntries.end ())
     {
@@ -271,11 +282,11 @@ void LedgerEntrySet::entryDelete (SLE::ref sle)
 
 bool LedgerEntrySet::hasChanges ()
 {
-    typedef std::map<uint256, LedgerEntrySetEntry>::value_type u256_LES_pair;
-    BOOST_FOREACH (u256_LES_pair & it, mEntries)
+    EntryMap const& entries (mEntries);
 
-    if (it.second.mAction != taaCACHED)
-        return true;
+    for (const_iterator it = entries.begin (); it != entries.end (); ++it)
+        if (it->second.mAction != taaCACHED)
+            return true;
 
     return false;
 }
@@ -286,7 +297,7 @@ Json::Value LedgerEntrySet::getJson (int) const
 
     Json::Value nodes (Json::arrayValue);
 
-    for (std::map<uint256, LedgerEntrySetEntry>::const_iterator it = mEntries.begin (),
+    for (const_iterator it = mEntries.begin (),
             end = mEntries.end (); it != end; ++it)
     {
         Json::Value entry (Json::objectValue);
@@ -361,7 +372,7 @@ Json::Value LedgerEntrySet::getJson (int) const
 SLE::pointer LedgerEntrySet::getForMod (uint256 const& node, Ledger::ref ledger,
                                         boost::unordered_map<uint256, SLE::pointer>& newMods)
 {
-    std::map<uint256, LedgerEntrySetEntry>::iterator it = mEntries.find (node);
+    iterator it = mEntries.find (node);
 
     if (it != mEntries.end ())
     {
@@ -468,7 +479,7 @@ void LedgerEntrySet::calcRawMeta (Serializer& s, TER result, std::uint32_t index
     // Entries modified only as a result of building the transaction metadata
     boost::unordered_map<uint256, SLE::pointer> newMod;
 
-    typedef std::map<uint256, LedgerEntrySetEntry>::value_type u256_LES_pair;
+    typedef LedgerEntrySet::value_type u256_LES_pair;
     BOOST_FOREACH (u256_LES_pair & it, mEntries)
     {
         SField::ptr type = &sfGeneric;
@@ -1012,17 +1023,18 @@ uint256 LedgerEntrySet::getNextLedgerIndex (uint256 const& uHash)
 {
     // find next node in ledger that isn't deleted by LES
     uint256 ledgerNext = uHash;
-    std::map<uint256, LedgerEntrySetEntry>::const_iterator it;
+    EntryMap const& entries (mEntries);
+    const_iterator it;
 
     do
     {
         ledgerNext = mLedger->getNextLedgerIndex (ledgerNext);
-        it  = mEntries.find (ledgerNext);
+        it  = entries.find (ledgerNext);
     }
-    while ((it != mEntries.end ()) && (it->second.mAction == taaDELETE));
+    while ((it != entries.end ()) && (it->second.mAction == taaDELETE));
 
     // find next node in LES that isn't deleted
-    for (it = mEntries.upper_bound (uHash); it != mEntries.end (); ++it)
+    for (it = entries.upper_bound (uHash); it != entries.end (); ++it)
     {
         // node found in LES, node found in ledger, return earliest
         if (it->second.mAction != taaDELETE)
@@ -1682,5 +1694,167 @@ TER LedgerEntrySet::accountSend (const uint160& uSenderID, const uint160& uRecei
     return terResult;
 }
 
-} // ripple
+//------------------------------------------------------------------------------
+
+// Compares the entry storage of a LedgerEntrySet before and after it
+// became a shared flat map, by replaying the entry traffic of multi-hop
+// payments: every path works on a duplicate of the active set, entries are
+// copied on read and modified, and the best path is swapped back in.
+//
+class LedgerEntrySet_timing_test : public beast::unit_test::suite
+{
+public:
+    enum
+    {
+        transactions = 2000,
+        passes = 3,         // RippleCalc passes per payment
+        paths = 4,          // alternative paths per pass
+        hops = 6,           // hops per path
+        entriesPerHop = 4   // lines, offers and directories per hop
+    };
+
+    typedef std::chrono::steady_clock clock_type;
+
+    // Counts every allocation made through it
+    template <class T>
+    struct CountingAllocator : std::allocator <T>
+    {
+        template <class U>
+        struct rebind
+        {
+            typedef CountingAllocator <U> other;
+        };
+
+        explicit CountingAllocator (std::size_t* count_)
+            : count (count_)
+        {
+        }
+
+        template <class U>
+        CountingAllocator (CountingAllocator <U> const& other)
+            : count (other.count)
+        {
+        }
+
+        T* allocate (std::size_t n, void const* = 0)
+        {
+            ++*count;
+            return std::allocator <T>::allocate (n);
+        }
+
+        std::size_t* count;
+    };
+
+    typedef std::map <uint256, LedgerEntrySetEntry, std::less <uint256>,
+        CountingAllocator <std::pair <uint256 const, LedgerEntrySetEntry>>>
+            TreeMap;
+
+    typedef SharedFlatMap <uint256, LedgerEntrySetEntry, std::less <uint256>,
+        CountingAllocator <std::pair <uint256, LedgerEntrySetEntry>>>
+            FlatMap;
+
+    // Same access pattern as LedgerEntrySet::getEntry and entryModify
+    template <class Map>
+    static void touch (Map& map, uint256 const& index, int seq)
+    {
+        Map const& view (map);
+        typename Map::const_iterator const found (view.find (index));
+
+        if (found == view.end ())
+        {
+            map.insert (typename Map::value_type (index,
+                LedgerEntrySetEntry (SLE::pointer (), taaCACHED, seq)));
+        }
+        else if (found->second.mSeq != seq)
+        {
+            typename Map::iterator const iter (map.find (index));
+            iter->second.mSeq = seq;
+            iter->second.mAction = taaMODIFY;
+        }
+    }
+
+    template <class Map>
+    static std::size_t replay (Map& active,
+        std::vector <uint256> const& indexes)
+    {
+        int seq (0);
+
+        // The source and destination accounts are always present
+        touch (active, indexes [0], seq);
+        touch (active, indexes [1], seq);
+
+        for (int pass = 0; pass < passes; ++pass)
+        {
+            Map best (active);
+
+            for (int path = 0; path < paths; ++path)
+            {
+                Map current (active);
+                ++seq;
+
+                for (int hop = 0; hop < hops; ++hop)
+                    for (int entry = 0; entry < entriesPerHop; ++entry)
+                        touch (current, indexes [2 + entry +
+                            entriesPerHop * (hop + hops * path)], seq);
+
+                if (path == (pass % paths))
+                    best.swap (current);
+            }
+
+            active.swap (best);
+        }
 
+        return active.size ();
+    }
+
+    template <class Map>
+    void measure (std::string const& name,
+        std::vector <std::vector <uint256>> const& payments)
+    {
+        std::size_t allocations (0);
+        std::size_t entries (0);
+        CountingAllocator <typename Map::value_type> alloc (&allocations);
+
+        clock_type::time_point const start (clock_type::now ());
+        for (std::size_t i = 0; i < payments.size (); ++i)
+        {
+            Map active (std::less <uint256> (), alloc);
+            entries += replay (active, payments [i]);
+        }
+        double const elapsed (std::chrono::duration_cast <
+            std::chrono::duration <double>> (clock_type::now () - start).count ());
+
+        std::stringstream ss;
+        ss << name << ": " <<
+            (allocations / payments.size ()) << " allocations/tx, " <<
+            (elapsed * 1000000 / payments.size ()) << "us/tx, " <<
+            (entries / payments.size ()) << " entries/tx";
+        log << ss.str ();
+    }
+
+    void run ()
+    {
+        std::vector <std::vector <uint256>> payments (transactions);
+
+        // Hashed like real ledger indexes, so inserts land anywhere
+        std::uint32_t seed (0);
+        for (std::size_t i = 0; i < payments.size (); ++i)
+        {
+            std::vector <uint256>& indexes (payments [i]);
+            indexes.resize (2 + paths * hops * entriesPerHop);
+            for (std::size_t j = 0; j < indexes.size (); ++j, ++seed)
+                indexes [j] = Serializer::getSHA512Half (
+                    reinterpret_cast <unsigned char const*> (&seed),
+                        sizeof (seed));
+        }
+
+        testcase ("multi-hop payments");
+        measure <TreeMap> ("std::map", payments);
+        measure <FlatMap> ("SharedFlatMap", payments);
+        pass ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(LedgerEntrySet_timing,ripple_app,ripple);
+
+} // ripple
@@ -63,6 +63,26 @@ public:
         , mSeq (s)
     {
     }
+
+    LedgerEntrySetEntry (LedgerEntrySetEntry const&) = default;
+    LedgerEntrySetEntry& operator= (LedgerEntrySetEntry const&) = default;
+
+    // Entries are shifted within the set's sorted storage on every insert
+    // and erase, so moving them avoids touching the reference counts.
+    LedgerEntrySetEntry (LedgerEntrySetEntry&& other) noexcept
+        : mEntry (std::move (other.mEntry))
+        , mAction (other.mAction)
+        , mSeq (other.mSeq)
+    {
+    }
+
+    LedgerEntrySetEntry& operator= (LedgerEntrySetEntry&& other) noexcept
+    {
+        mEntry = std::move (other.mEntry);
+        mAction = other.mAction;
+        mSeq = other.mSeq;
+        return *this;
+    }
 };
 
 /** An LES is a LedgerEntrySet.
@@ -226,25 +246,27 @@ public:
     void calcRawMeta (Serializer&, TER result, std::uint32_t index);
 
     // iterator functions
-    typedef std::map<uint256, LedgerEntrySetEntry>::iterator                iterator;
-    typedef std::map<uint256, LedgerEntrySetEntry>::const_iterator          const_iterator;
+    typedef SharedFlatMap <uint256, LedgerEntrySetEntry>    EntryMap;
+    typedef EntryMap::value_type                            value_type;
+    typedef EntryMap::iterator                              iterator;
+    typedef EntryMap::const_iterator                        const_iterator;
     bool isEmpty () const
     {
         return mEntries.empty ();
     }
-    std::map<uint256, LedgerEntrySetEntry>::const_iterator begin () const
+    const_iterator begin () const
     {
         return mEntries.begin ();
     }
-    std::map<uint256, LedgerEntrySetEntry>::const_iterator end () const
+    const_iterator end () const
     {
         return mEntries.end ();
     }
-    std::map<uint256, LedgerEntrySetEntry>::iterator begin ()
+    iterator begin ()
     {
         return mEntries.begin ();
     }
-    std::map<uint256, LedgerEntrySetEntry>::iterator end ()
+    iterator end ()
     {
         return mEntries.end ();
     }
@@ -256,13 +278,13 @@ public:
 
 private:
     Ledger::pointer mLedger;
-    std::map<uint256, LedgerEntrySetEntry>  mEntries; // cannot be unordered!
+    EntryMap mEntries; // cannot be unordered! Shared with duplicates until written
     TransactionMetaSet mSet;
     TransactionEngineParams mParams;
     int mSeq;
     bool mImmutable;
 
-    LedgerEntrySet (Ledger::ref ledger, const std::map<uint256, LedgerEntrySetEntry>& e,
+    LedgerEntrySet (Ledger::ref ledger, const EntryMap& e,
                     const TransactionMetaSet & s, int m) :
         mLedger (ledger), mEntries (e), mSet (s), mParams (tapNONE), mSeq (m), mImmutable (false)
     {
@@ -49,7 +49,7 @@ public:
     LedgerHolder mCurrentLedger;        // The ledger we are currently processiong
     LedgerHolder mClosedLedger;         // The ledger that most recently closed
     LedgerHolder mValidLedger;          // The highest-sequence ledger we have fully accepted
-    Ledger::pointer mPubLedger;         // The last ledger we have published
+    LedgerHolder mPubLedger;            // The last ledger we have published
     Ledger::pointer mPathLedger;        // The last ledger we did pathfinding against
 
     LedgerHistory mLedgerHistory;
@@ -180,7 +180,7 @@ public:
 
     void setPubLedger(Ledger::ref l)
     {
-        mPubLedger = l;
+        mPubLedger.set (l);
         mPubLedgerClose = l->getCloseTimeNC();
         mPubLedgerSeq = l->getLedgerSeq();
     }
@@ -365,6 +365,12 @@ public:
         return mCompleteLedgers.clearValue (seq);
     }
 
+    void clearPriorLedgers (std::uint32_t seq)
+    {
+        ScopedLockType sl (mCompleteLock);
+        mCompleteLedgers.clearPrior (seq);
+    }
+
     // returns Ledgers we have all the nodes for
     bool getFullValidatedRange (std::uint32_t& minVal, std::uint32_t& maxVal)
     {
@@ -605,7 +611,7 @@ public:
 
             if (ledger->getLedgerSeq() > mValidLedgerSeq)
                 setValidLedger(ledger);
-            if (!mPubLedger)
+            if (mPubLedger.empty ())
             {
                 setPubLedger(ledger);
                 getApp().getOrderBookDB().setup(ledger);
@@ -708,7 +714,7 @@ public:
         ledger->setValidated();
         ledger->setFull();
         setValidLedger(ledger);
-        if (!mPubLedger)
+        if (mPubLedger.empty ())
         {
             ledger->pendSaveValidated(true, true);
             setPubLedger(ledger);
@@ -766,7 +772,7 @@ public:
                     std::uint32_t missing;
                     {
                         ScopedLockType sl (mCompleteLock);
-                        missing = mCompleteLedgers.prevMissing(mPubLedger->getLedgerSeq());
+                        missing = mCompleteLedgers.prevMissing(mPubLedger.get ()->getLedgerSeq());
                     }
                     WriteLog (lsTRACE, LedgerMaster) << "tryAdvance discovered missing " << missing;
                     if ((missing != RangeSet::absent) && (missing > 0) &&
@@ -884,7 +890,7 @@ public:
         std::list<Ledger::pointer> ret;
 
         WriteLog (lsTRACE, LedgerMaster) << "findNewLedgersToPublish<";
-        if (!mPubLedger)
+        if (mPubLedger.empty ())
         {
             WriteLog (lsINFO, LedgerMaster) << "First published ledger will be " << mValidLedgerSeq;
             ret.push_back (mValidLedger.get ());
@@ -1144,9 +1150,9 @@ public:
     }
 
     // This is the last ledger we published to clients and can lag the validated ledger
-    Ledger::ref getPublishedLedger ()
+    Ledger::pointer getPublishedLedger ()
     {
-        return mPubLedger;
+        return mPubLedger.get ();
     }
 
     int getMinValidations ()
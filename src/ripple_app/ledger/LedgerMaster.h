@@ -50,6 +50,10 @@ public:
     virtual LedgerIndex getCurrentLedgerIndex () = 0;
     virtual LedgerIndex getValidLedgerIndex () = 0;
 
+    /** The open ledger lock.
+        Held while transactions are applied to the open ledger. Readers
+        never need it; the ledgers returned below are immutable snapshots.
+    */
     virtual LockType& peekMutex () = 0;
 
     // The current ledger is the ledger we believe new transactions should go in
@@ -62,7 +66,7 @@ public:
     virtual Ledger::pointer getValidatedLedger () = 0;
 
     // This is the last ledger we published to clients and can lag the validated ledger
-    virtual Ledger::ref getPublishedLedger () = 0;
+    virtual Ledger::pointer getPublishedLedger () = 0;
 
     virtual int getPublishedLedgerAge () = 0;
     virtual int getValidatedLedgerAge () = 0;
@@ -118,6 +122,8 @@ public:
     virtual bool haveLedgerRange (std::uint32_t from, std::uint32_t to) = 0;
     virtual bool haveLedger (std::uint32_t seq) = 0;
     virtual void clearLedger (std::uint32_t seq) = 0;
+    /** Forget that we have any ledger before the given sequence. */
+    virtual void clearPriorLedgers (std::uint32_t seq) = 0;
     virtual bool getValidatedRange (std::uint32_t& minVal, std::uint32_t& maxVal) = 0;
     virtual bool getFullValidatedRange (std::uint32_t& minVal, std::uint32_t& maxVal) = 0;
 
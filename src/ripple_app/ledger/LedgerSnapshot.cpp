@@ -0,0 +1,452 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <fstream>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include "../../beast/beast/unit_test/suite.h"
+
+namespace ripple {
+
+LedgerSnapshot::Header::Header ()
+    : seq (0)
+    , count (0)
+{
+}
+
+LedgerSnapshot::LedgerSnapshot (boost::filesystem::path const& path,
+    std::uint32_t interval, beast::Journal journal)
+    : m_path (path)
+    , m_interval (interval)
+    , m_journal (journal)
+    , m_lastSeq (0)
+    , m_writing (false)
+{
+}
+
+std::size_t LedgerSnapshot::load ()
+{
+    boost::system::error_code ec;
+
+    if (!boost::filesystem::exists (m_path, ec))
+        return 0;
+
+    clock_type::time_point const start (clock_type::now ());
+
+    Header header;
+    std::vector <SHAMapTreeNode::pointer> nodes;
+
+    if (!read (m_path, header, [&nodes] (SHAMapTreeNode::pointer const& node)
+        {
+            nodes.push_back (node);
+        }))
+    {
+        m_journal.warning <<
+            "Ledger snapshot " << m_path.string () << " is damaged, ignoring it";
+        return 0;
+    }
+
+    BOOST_FOREACH (SHAMapTreeNode::pointer& node, nodes)
+    {
+        SHAMap::canonicalize (node->getNodeHash (), node);
+    }
+
+    std::size_t const count (nodes.size ());
+
+    {
+        std::lock_guard <std::mutex> lock (m_mutex);
+        m_pinned.swap (nodes);
+        m_loaded = clock_type::now ();
+    }
+
+    // Don't write a snapshot of a ledger we just loaded
+    m_lastSeq = header.seq;
+
+    m_journal.info << "Loaded " << count << " nodes of ledger " <<
+        header.seq << " from snapshot in " <<
+            std::chrono::duration_cast <std::chrono::milliseconds> (
+                clock_type::now () - start).count () << "ms";
+
+    return count;
+}
+
+void LedgerSnapshot::sweep ()
+{
+    std::vector <SHAMapTreeNode::pointer> release;
+
+    {
+        std::lock_guard <std::mutex> lock (m_mutex);
+
+        if (!m_pinned.empty () &&
+            ((getApp().getOPs ().getOperatingMode () == NetworkOPs::omFULL) ||
+             (clock_type::now () - m_loaded > std::chrono::minutes (pinMinutes))))
+        {
+            release.swap (m_pinned);
+        }
+    }
+
+    if (!release.empty ())
+        m_journal.debug << "Releasing " << release.size () << " snapshot nodes";
+
+    if (m_interval == 0)
+        return;
+
+    Ledger::pointer ledger (getApp().getLedgerMaster ().getValidatedLedger ());
+
+    if (!ledger || (ledger->getLedgerSeq () < (m_lastSeq + m_interval)))
+        return;
+
+    if (m_writing.exchange (true))
+        return;
+
+    getApp().getJobQueue ().addJob (jtSNAPSHOT, "writeSnapshot",
+        BIND_TYPE (&LedgerSnapshot::doWrite, this, P_1, ledger));
+}
+
+void LedgerSnapshot::doWrite (Job& job, Ledger::pointer ledger)
+{
+    clock_type::time_point const start (clock_type::now ());
+
+    Header header;
+    header.seq = ledger->getLedgerSeq ();
+    header.ledgerHash = ledger->getHash ();
+    header.accountHash = ledger->getAccountHash ();
+
+    bool written = false;
+
+    try
+    {
+        written = write (m_path, header, *ledger->peekAccountStateMap (),
+            [&job] () { return job.shouldCancel (); });
+    }
+    catch (SHAMapMissingNode& mn)
+    {
+        m_journal.info << "Ledger snapshot of " << header.seq <<
+            " skipped: " << mn;
+    }
+
+    if (written)
+    {
+        m_lastSeq = header.seq;
+
+        m_journal.info << "Wrote snapshot of ledger " << header.seq <<
+            " with " << header.count << " nodes in " <<
+                std::chrono::duration_cast <std::chrono::milliseconds> (
+                    clock_type::now () - start).count () << "ms";
+    }
+
+    m_writing = false;
+}
+
+bool LedgerSnapshot::write (boost::filesystem::path const& path,
+    Header& header, SHAMap& stateMap, std::function <bool ()> const& shouldStop)
+{
+    boost::filesystem::path temp (path);
+    temp += ".tmp";
+
+    std::ofstream out (temp.string ().c_str (),
+        std::ios::out | std::ios::binary | std::ios::trunc);
+
+    if (!out)
+        return false;
+
+    // The count is written again once it is known
+    header.count = 0;
+
+    Serializer s (headerBytes);
+    s.add32 (fileMagic);
+    s.add32 (fileVersion);
+    s.add32 (header.seq);
+    s.add256 (header.ledgerHash);
+    s.add256 (header.accountHash);
+    s.add64 (header.count);
+    out.write (static_cast <char const*> (s.getDataPtr ()), s.getDataLength ());
+
+    bool stopped = false;
+    Serializer data (1024);
+    Serializer record (1024);
+
+    stateMap.walkNodes ([&] (SHAMapTreeNode& node) -> bool
+    {
+        if (((header.count % 1024) == 0) && shouldStop ())
+        {
+            stopped = true;
+            return false;
+        }
+
+        data.erase ();
+        node.addRaw (data, snfPREFIX);
+
+        record.erase ();
+        node.addIDRaw (record);
+        record.add256 (node.getNodeHash ());
+        record.add32 (data.getDataLength ());
+        record.addRaw (data);
+
+        out.write (static_cast <char const*> (record.getDataPtr ()),
+            record.getDataLength ());
+
+        ++header.count;
+        return out.good ();
+    });
+
+    if (!stopped)
+    {
+        s.erase ();
+        s.add64 (header.count);
+        out.seekp (headerBytes - 8);
+        out.write (static_cast <char const*> (s.getDataPtr ()), s.getDataLength ());
+    }
+
+    out.close ();
+
+    boost::system::error_code ec;
+
+    if (stopped || out.fail ())
+    {
+        boost::filesystem::remove (temp, ec);
+        return false;
+    }
+
+    boost::filesystem::rename (temp, path, ec);
+
+    return !ec;
+}
+
+bool LedgerSnapshot::read (boost::filesystem::path const& path,
+    Header& header, Callback const& func)
+{
+    namespace ipc = boost::interprocess;
+
+    try
+    {
+        ipc::file_mapping file (path.string ().c_str (), ipc::read_only);
+        ipc::mapped_region region (file, ipc::read_only);
+
+        // We go through the file once, front to back
+        region.advise (ipc::mapped_region::advice_sequential);
+
+        unsigned char const* p (static_cast <unsigned char const*> (
+            region.get_address ()));
+        unsigned char const* const end (p + region.get_size ());
+
+        if ((end - p) < headerBytes)
+            return false;
+
+        Serializer s (Blob (p, p + headerBytes));
+        std::uint32_t magic, version;
+        std::uint64_t count;
+
+        if (!s.get32 (magic, 0) || (magic != fileMagic) ||
+            !s.get32 (version, 4) || (version != fileVersion) ||
+            !s.get32 (header.seq, 8) ||
+            !s.get256 (header.ledgerHash, 12) ||
+            !s.get256 (header.accountHash, 44) ||
+            !s.get64 (count, 76))
+        {
+            return false;
+        }
+
+        p += headerBytes;
+
+        header.count = 0;
+
+        // Every node must be one that its parent refers to, so the
+        // whole file is checked against the account hash.
+        std::map <SHAMapNode, uint256> wanted;
+        wanted[SHAMapNode ()] = header.accountHash;
+
+        while (header.count < count)
+        {
+            if ((end - p) < recordBytes)
+                return false;
+
+            SHAMapNode const id (p, 33);
+            uint256 hash;
+            memcpy (hash.begin (), p + 33, 32);
+            std::uint32_t const size ((std::uint32_t (p[65]) << 24) |
+                (std::uint32_t (p[66]) << 16) | (std::uint32_t (p[67]) << 8) |
+                    std::uint32_t (p[68]));
+            p += recordBytes;
+
+            if (std::uint64_t (end - p) < size)
+                return false;
+
+            std::map <SHAMapNode, uint256>::iterator const it (wanted.find (id));
+
+            if ((it == wanted.end ()) || (it->second != hash))
+                return false;
+
+            wanted.erase (it);
+
+            // The hash is worked out again from the data, not trusted
+            SHAMapTreeNode::pointer node (boost::make_shared <SHAMapTreeNode> (
+                id, Blob (p, p + size), 0, snfPREFIX, uint256 (), false));
+            p += size;
+
+            if (node->getNodeHash () != hash)
+                return false;
+
+            if (node->isInner ())
+            {
+                for (int i = 0; i < 16; ++i)
+                {
+                    if (!node->isEmptyBranch (i))
+                        wanted[node->getChildNodeID (i)] = node->getChildHash (i);
+                }
+            }
+
+            func (node);
+            ++header.count;
+        }
+
+        return (p == end) && wanted.empty ();
+    }
+    catch (std::exception const&)
+    {
+        // Covers failure to map the file, and nodes that don't parse
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+
+class LedgerSnapshot_test : public beast::unit_test::suite
+{
+public:
+    typedef std::map <uint256, Blob> NodeMap;
+
+    static SHAMapItem::pointer makeItem (int i)
+    {
+        Serializer s;
+        s.add32 (i);
+        s.add32 (i * 7919);
+
+        return boost::make_shared<SHAMapItem> (s.getSHA512Half (), s.peekData ());
+    }
+
+    // Read a snapshot and remember the nodes found in it
+    static bool readNodes (boost::filesystem::path const& path,
+        LedgerSnapshot::Header& header, NodeMap& nodes)
+    {
+        nodes.clear ();
+
+        return LedgerSnapshot::read (path, header,
+            [&nodes] (SHAMapTreeNode::pointer const& node)
+            {
+                Serializer s;
+                node->addRaw (s, snfPREFIX);
+                nodes[node->getNodeHash ()] = s.peekData ();
+            });
+    }
+
+    static void corrupt (boost::filesystem::path const& path,
+        std::streamoff offset)
+    {
+        std::fstream file (path.string ().c_str (),
+            std::ios::in | std::ios::out | std::ios::binary);
+        file.seekg (offset);
+        char c (file.get ());
+        file.seekp (offset);
+        file.put (c ^ 0x01);
+    }
+
+    void run ()
+    {
+        FullBelowCache fullBelowCache ("test.full_below",
+            get_seconds_clock ());
+
+        SHAMap map (smtFREE, fullBelowCache);
+
+        for (int i = 0; i < 2000; ++i)
+            map.addItem (*makeItem (i), false, false);
+
+        NodeMap expected;
+        map.walkNodes ([&expected] (SHAMapTreeNode& node) -> bool
+        {
+            Serializer s;
+            node.addRaw (s, snfPREFIX);
+            expected[node.getNodeHash ()] = s.peekData ();
+            return true;
+        });
+
+        boost::filesystem::path const path (
+            boost::filesystem::temp_directory_path () /
+                boost::filesystem::unique_path ());
+
+        testcase ("round trip");
+        {
+            LedgerSnapshot::Header header;
+            header.seq = 12345;
+            header.ledgerHash = makeItem (-1)->getTag ();
+            header.accountHash = map.getHash ();
+
+            expect (LedgerSnapshot::write (path, header, map,
+                [] () { return false; }));
+            expect (header.count == expected.size ());
+
+            LedgerSnapshot::Header loaded;
+            NodeMap nodes;
+            expect (readNodes (path, loaded, nodes));
+            expect (loaded.seq == header.seq);
+            expect (loaded.ledgerHash == header.ledgerHash);
+            expect (loaded.accountHash == header.accountHash);
+            expect (loaded.count == header.count);
+            expect (nodes == expected);
+        }
+
+        testcase ("damage");
+        {
+            LedgerSnapshot::Header header;
+            NodeMap nodes;
+
+            std::uintmax_t const size (boost::filesystem::file_size (path));
+
+            // A flipped bit in the middle of the nodes
+            corrupt (path, size / 2);
+            expect (!readNodes (path, header, nodes));
+            corrupt (path, size / 2);
+            expect (readNodes (path, header, nodes));
+
+            // A file cut short
+            boost::filesystem::resize_file (path, size - 1);
+            expect (!readNodes (path, header, nodes));
+
+            boost::filesystem::remove (path);
+            expect (!readNodes (path, header, nodes));
+        }
+
+        testcase ("stop");
+        {
+            LedgerSnapshot::Header header;
+            header.accountHash = map.getHash ();
+
+            expect (!LedgerSnapshot::write (path, header, map,
+                [] () { return true; }));
+            expect (!boost::filesystem::exists (path));
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(LedgerSnapshot,ripple_app,ripple);
+
+}
@@ -0,0 +1,130 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_LEDGERSNAPSHOT_H_INCLUDED
+#define RIPPLE_LEDGERSNAPSHOT_H_INCLUDED
+
+namespace ripple {
+
+/** A copy of the state tree of a validated ledger, for a fast restart.
+
+    After a restart the state tree is otherwise read from the node store
+    one node at a time, as each is first needed. The snapshot holds every
+    node of the tree in one file, parents before children, so it can be
+    read in a single sequential pass. Each node is stored with its ID and
+    hash, and the hash is checked when the node is loaded.
+
+    A snapshot is written from the validated ledger every so many ledgers
+    by a background job. At startup the file is memory mapped and its
+    nodes put in the tree node cache.
+*/
+class LedgerSnapshot
+{
+public:
+    typedef std::chrono::steady_clock clock_type;
+
+    enum
+    {
+        // Ledgers between snapshots when not configured
+        defaultInterval = 256
+    };
+
+    /** Describes the ledger a snapshot came from. */
+    struct Header
+    {
+        Header ();
+
+        std::uint32_t seq;
+        uint256 ledgerHash;
+        uint256 accountHash;
+        std::uint64_t count;
+    };
+
+    /** Called with each node read from a snapshot. */
+    typedef std::function <void (SHAMapTreeNode::pointer const&)> Callback;
+
+    /** Create the snapshot manager.
+        An interval of zero disables writing snapshots.
+    */
+    LedgerSnapshot (boost::filesystem::path const& path,
+        std::uint32_t interval, beast::Journal journal);
+
+    /** Put the nodes of the last snapshot in the tree node cache.
+        The nodes are kept in memory until the server is in sync with the
+        network, or for a few minutes, so they are still there when the
+        ledger they belong to is built. Returns the number of nodes loaded.
+    */
+    std::size_t load ();
+
+    /** Start writing a snapshot of the validated ledger if one is due.
+        Also lets go of loaded nodes that are no longer needed.
+    */
+    void sweep ();
+
+    /** Write the state map of a ledger to a file.
+        The header's count is set to the number of nodes written. The
+        file is replaced only once it is complete. Returns false if the
+        file could not be written or the walk was stopped.
+        Throws SHAMapMissingNode if part of the map is not available.
+    */
+    static bool write (boost::filesystem::path const& path, Header& header,
+        SHAMap& stateMap, std::function <bool ()> const& shouldStop);
+
+    /** Read a snapshot, calling the function for every node.
+        Returns false if the file is missing or damaged, or if it does not
+        hold exactly the tree with the header's account hash. The function
+        may have been called for some nodes before a problem is found.
+    */
+    static bool read (boost::filesystem::path const& path, Header& header,
+        Callback const& func);
+
+private:
+    enum
+    {
+        // How long loaded nodes are held if we don't get in sync
+        pinMinutes = 10,
+
+        // "RSNP"
+        fileMagic = 0x52534e50,
+        fileVersion = 1,
+
+        // Magic, version, sequence, ledger hash, account hash, count
+        headerBytes = 4 + 4 + 4 + 32 + 32 + 8,
+
+        // Node ID, hash, length of the node data that follows
+        recordBytes = 33 + 32 + 4
+    };
+
+    void doWrite (Job& job, Ledger::pointer ledger);
+
+    boost::filesystem::path const m_path;
+    std::uint32_t const m_interval;
+    beast::Journal m_journal;
+
+    std::atomic <std::uint32_t> m_lastSeq;
+    std::atomic <bool> m_writing;
+
+    std::mutex m_mutex;
+    std::vector <SHAMapTreeNode::pointer> m_pinned;
+    clock_type::time_point m_loaded;
+};
+
+}
+
+#endif
@@ -0,0 +1,45 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+namespace ripple {
+namespace LedgerTest {
+
+uint160 make_account_id (std::string const& passphrase)
+{
+    RippleAddress seed      = RippleAddress::createSeedGeneric (passphrase);
+    RippleAddress generator = RippleAddress::createGeneratorPublic (seed);
+    return RippleAddress::createAccountPublic (generator, 0).getAccountID ();
+}
+
+Ledger::pointer make_genesis ()
+{
+    RippleAddress rootSeedMaster      = RippleAddress::createSeedGeneric ("masterpassphrase");
+    RippleAddress rootGeneratorMaster = RippleAddress::createGeneratorPublic (rootSeedMaster);
+    RippleAddress rootAddress         = RippleAddress::createAccountPublic (rootGeneratorMaster, 0);
+
+    return boost::make_shared <Ledger> (rootAddress, SYSTEM_CURRENCY_START);
+}
+
+Ledger::pointer make_next (Ledger::ref parent)
+{
+    return boost::make_shared <Ledger> (false, boost::ref (*parent));
+}
+
+}
+}
@@ -0,0 +1,42 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_LEDGERTEST_H_INCLUDED
+#define RIPPLE_LEDGERTEST_H_INCLUDED
+
+namespace ripple {
+namespace LedgerTest {
+
+// Utility functions for unit tests that build ledgers
+
+/** Returns the account ID made from a passphrase, like wallet_propose. */
+uint160 make_account_id (std::string const& passphrase);
+
+/** Returns a new genesis ledger.
+    All the currency belongs to the "masterpassphrase" account.
+*/
+Ledger::pointer make_genesis ();
+
+/** Returns a new open ledger that follows the parent. */
+Ledger::pointer make_next (Ledger::ref parent);
+
+}
+}
+
+#endif
@@ -0,0 +1,484 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include <fstream>
+
+namespace ripple {
+
+std::uint32_t OnlineDelete::getInterval (NodeStore::Parameters const& parameters)
+{
+    return std::max (0, parameters ["online_delete"].getIntValue ());
+}
+
+OnlineDelete::OnlineDelete (NodeStore::Parameters const& parameters,
+    NodeStore::Manager& manager, NodeStore::Scheduler& scheduler,
+        beast::Journal journal)
+    : m_parameters (parameters)
+    , m_manager (manager)
+    , m_scheduler (scheduler)
+    , m_journal (journal)
+    , m_interval (getInterval (parameters))
+    , m_path (parameters ["path"].toStdString ())
+    , m_statePath (m_path.string () + ".generations")
+    , m_database (nullptr)
+    , m_copyFrom (0)
+    , m_trimBound (0)
+    , m_working (false)
+{
+    if (m_path.empty ())
+        throw std::runtime_error (
+            "online_delete requires a path in the [node_db] section");
+
+    // Only these backends can remove their files when a generation is dropped
+    if ((parameters ["type"].compareIgnoreCase ("leveldb") != 0) &&
+        (parameters ["type"].compareIgnoreCase ("rocksdb") != 0))
+        throw std::runtime_error (
+            "online_delete requires the LevelDB or RocksDB [node_db] type");
+
+    if (m_interval < getConfig ().LEDGER_HISTORY)
+        throw std::runtime_error (
+            "online_delete must be at least as large as ledger_history");
+
+    loadState ();
+}
+
+std::unique_ptr <NodeStore::Database> OnlineDelete::makeDatabase (
+    std::string const& name, int readThreads)
+{
+    std::vector <std::unique_ptr <NodeStore::Backend>> backends;
+
+    BOOST_FOREACH (Generation const& generation, m_generations)
+        backends.push_back (makeBackend (generation.number));
+
+    std::unique_ptr <NodeStore::DatabaseRotating> database (
+        m_manager.make_DatabaseRotating (name, m_scheduler, m_journal,
+            readThreads, std::move (backends)));
+
+    m_database = database.get ();
+
+    return std::move (database);
+}
+
+void OnlineDelete::sweep ()
+{
+    if (m_working)
+        return;
+
+    // Ledgers must be arriving for a rotation to finish
+    if (getApp().getOPs ().getOperatingMode () != NetworkOPs::omFULL)
+        return;
+
+    Ledger::pointer ledger (getApp().getLedgerMaster ().getValidatedLedger ());
+
+    if (!ledger)
+        return;
+
+    std::uint32_t const seq (ledger->getLedgerSeq ());
+
+    std::lock_guard <std::mutex> lock (m_mutex);
+
+    if (m_trimBound != 0)
+    {
+        // Finish deleting history which a restart interrupted
+        m_working = true;
+        getApp().getJobQueue ().addJob (jtROTATE, "trimHistory",
+            BIND_TYPE (&OnlineDelete::doTrim, this, P_1, m_trimBound));
+        m_trimBound = 0;
+        return;
+    }
+
+    Generation& newest (m_generations.front ());
+
+    if (newest.seq != 0)
+    {
+        if (seq >= (newest.seq + m_interval))
+        {
+            m_working = true;
+            getApp().getJobQueue ().addJob (jtROTATE, "rotateNodeStore",
+                BIND_TYPE (&OnlineDelete::doRotate, this, P_1));
+        }
+    }
+    else if (m_generations.size () == 1)
+    {
+        // Everything we have is in the only generation
+        newest.seq = seq;
+        saveState ();
+    }
+    else if (m_copyFrom == 0)
+    {
+        // Every ledger closed from now on writes to the newest generation
+        m_copyFrom = getApp().getLedgerMaster ().getCurrentLedgerIndex ();
+    }
+    else if (seq >= m_copyFrom)
+    {
+        m_working = true;
+        getApp().getJobQueue ().addJob (jtROTATE, "copyLedger",
+            BIND_TYPE (&OnlineDelete::doCopy, this, P_1, ledger));
+    }
+}
+
+//------------------------------------------------------------------------------
+
+boost::filesystem::path OnlineDelete::getPath (std::uint32_t number) const
+{
+    if (number == 0)
+        return m_path;
+
+    return boost::filesystem::path (
+        m_path.string () + "." + std::to_string (number));
+}
+
+std::unique_ptr <NodeStore::Backend> OnlineDelete::makeBackend (
+    std::uint32_t number)
+{
+    NodeStore::Parameters parameters (m_parameters);
+    parameters.set ("path", getPath (number).string ());
+
+    return m_manager.make_Backend (parameters, m_scheduler, m_journal);
+}
+
+void OnlineDelete::loadState ()
+{
+    {
+        std::ifstream in (m_statePath.string ().c_str ());
+        Generation generation;
+
+        while (in >> generation.number >> generation.seq)
+            m_generations.push_back (generation);
+    }
+
+    // Find the generation directories next to the configured path
+    std::vector <std::uint32_t> found;
+    {
+        std::string const prefix (m_path.filename ().string () + ".");
+        boost::filesystem::path const parent (m_path.has_parent_path ()
+            ? m_path.parent_path () : boost::filesystem::path ("."));
+
+        boost::system::error_code ec;
+        boost::filesystem::directory_iterator iter (parent, ec);
+
+        for (; !ec && (iter != boost::filesystem::directory_iterator ());
+            iter.increment (ec))
+        {
+            std::string const name (iter->path ().filename ().string ());
+
+            if ((name.size () <= prefix.size ()) ||
+                (name.size () > (prefix.size () + 9)) ||
+                (name.compare (0, prefix.size (), prefix) != 0) ||
+                (name [prefix.size ()] == '0') ||
+                (name.find_first_not_of ("0123456789", prefix.size ()) != std::string::npos))
+                continue;
+
+            found.push_back (static_cast <std::uint32_t> (
+                std::stoul (name.substr (prefix.size ()))));
+        }
+    }
+
+    std::uint32_t next (1);
+    BOOST_FOREACH (std::uint32_t number, found)
+        next = std::max (next, number + 1);
+
+    boost::system::error_code ec;
+
+    if (m_generations.empty ())
+    {
+        // Nothing recorded, so use whatever is there
+        std::sort (found.rbegin (), found.rend ());
+
+        BOOST_FOREACH (std::uint32_t number, found)
+        {
+            Generation generation;
+            generation.number = number;
+            generation.seq = 0;
+            m_generations.push_back (generation);
+        }
+
+        // History kept before online deletion was turned on
+        if (boost::filesystem::exists (m_path, ec))
+        {
+            Generation generation;
+            generation.number = 0;
+            generation.seq = 0;
+            m_generations.push_back (generation);
+        }
+    }
+    else
+    {
+        // Finish dropping generations a restart interrupted
+        BOOST_FOREACH (std::uint32_t number, found)
+        {
+            if (std::none_of (m_generations.begin (), m_generations.end (),
+                [number] (Generation const& generation)
+                {
+                    return generation.number == number;
+                }))
+            {
+                m_journal.info << "Removing " << getPath (number).string ();
+                boost::filesystem::remove_all (getPath (number), ec);
+            }
+        }
+    }
+
+    // The plain path is never written to
+    if (m_generations.empty () || (m_generations.front ().number == 0))
+    {
+        Generation generation;
+        generation.number = next;
+        generation.seq = 0;
+        m_generations.insert (m_generations.begin (), generation);
+    }
+
+    m_trimBound = m_generations.back ().seq;
+
+    saveState ();
+}
+
+void OnlineDelete::saveState ()
+{
+    boost::filesystem::path temp (m_statePath);
+    temp += ".tmp";
+
+    {
+        std::ofstream out (temp.string ().c_str (),
+            std::ios::out | std::ios::trunc);
+
+        BOOST_FOREACH (Generation const& generation, m_generations)
+            out << generation.number << " " << generation.seq << "\n";
+
+        out.flush ();
+
+        if (!out)
+        {
+            m_journal.error << "Unable to write " << temp.string ();
+            return;
+        }
+    }
+
+    boost::system::error_code ec;
+    boost::filesystem::rename (temp, m_statePath, ec);
+
+    if (ec)
+        m_journal.error << "Unable to replace " << m_statePath.string () <<
+            ": " << ec.message ();
+}
+
+//------------------------------------------------------------------------------
+
+void OnlineDelete::doRotate (Job&)
+{
+    std::uint32_t number;
+    {
+        std::lock_guard <std::mutex> lock (m_mutex);
+        number = m_generations.front ().number + 1;
+    }
+
+    std::unique_ptr <NodeStore::Backend> backend;
+
+    try
+    {
+        backend = makeBackend (number);
+    }
+    catch (std::exception const& e)
+    {
+        m_journal.error << "Unable to start node store generation " <<
+            number << ": " << e.what ();
+        m_working = false;
+        return;
+    }
+
+    {
+        std::lock_guard <std::mutex> lock (m_mutex);
+
+        m_database->rotate (std::move (backend));
+
+        Generation generation;
+        generation.number = number;
+        generation.seq = 0;
+        m_generations.insert (m_generations.begin (), generation);
+
+        m_copyFrom = getApp().getLedgerMaster ().getCurrentLedgerIndex ();
+
+        saveState ();
+    }
+
+    m_journal.info << "Started node store generation " << number;
+
+    m_working = false;
+}
+
+void OnlineDelete::doCopy (Job& job, Ledger::pointer ledger)
+{
+    std::uint32_t const seq (ledger->getLedgerSeq ());
+    bool copied = false;
+
+    try
+    {
+        copied = copyMap (job, *ledger->peekAccountStateMap ()) &&
+            copyMap (job, *ledger->peekTransactionMap ()) &&
+                m_database->copyForward (ledger->getHash ());
+    }
+    catch (SHAMapMissingNode& mn)
+    {
+        m_journal.info << "Copy of ledger " << seq << " stopped: " << mn;
+    }
+
+    // A later ledger will be tried
+    if (!copied)
+    {
+        m_working = false;
+        return;
+    }
+
+    // The copies must be on disk before the oldest generation goes
+    while ((m_database->getWriteLoad () > 0) && !job.shouldCancel ())
+        std::this_thread::sleep_for (std::chrono::milliseconds (100));
+
+    if (job.shouldCancel ())
+    {
+        m_working = false;
+        return;
+    }
+
+    // Before the drop is recorded, so a crash cannot lose both copies
+    m_database->syncNewest ();
+
+    std::size_t dropped (0);
+    std::uint32_t bound;
+    {
+        std::lock_guard <std::mutex> lock (m_mutex);
+
+        m_generations.front ().seq = seq;
+
+        // Ledgers from the previous copy on are served by the two newest
+        while (m_generations.size () > 2)
+        {
+            m_generations.pop_back ();
+            ++dropped;
+        }
+
+        // Recorded first, so a restart finishes an interrupted drop
+        saveState ();
+
+        bound = m_generations.back ().seq;
+    }
+
+    for (std::size_t i = 0; i < dropped; ++i)
+        m_database->dropOldest ();
+
+    // Cached nodes and full below marks may refer to dropped objects
+    if (dropped != 0)
+    {
+        getApp().getFullBelowCache ().clear ();
+        SHAMap::clearTreeCache ();
+    }
+
+    m_journal.info << "Copied ledger " << seq << " forward, dropped " <<
+        dropped << " node store generations";
+
+    if ((dropped != 0) && (bound != 0))
+        trimHistory (job, bound);
+
+    m_working = false;
+}
+
+void OnlineDelete::doTrim (Job& job, std::uint32_t bound)
+{
+    trimHistory (job, bound);
+
+    m_working = false;
+}
+
+bool OnlineDelete::copyMap (Job& job, SHAMap& map)
+{
+    bool complete = true;
+
+    map.walkNodes ([&] (SHAMapTreeNode& node)
+        {
+            // An empty map's root is never stored
+            if (node.getNodeHash ().isZero ())
+                return true;
+
+            if (job.shouldCancel () ||
+                    !m_database->copyForward (node.getNodeHash ()))
+                complete = false;
+
+            return complete;
+        });
+
+    return complete;
+}
+
+void OnlineDelete::trimHistory (Job& job, std::uint32_t bound)
+{
+    getApp().getLedgerMaster ().clearPriorLedgers (bound);
+
+    DatabaseCon& ledgerDB (*getApp().getLedgerDB ());
+    DatabaseCon& txnDB (*getApp().getTxnDB ());
+
+    std::uint32_t seq (std::min (getFirstLedger (ledgerDB, "Ledgers", bound),
+        getFirstLedger (txnDB, "Transactions", bound)));
+
+    if (seq >= bound)
+        return;
+
+    m_journal.info << "Deleting history of ledgers " << seq <<
+        " through " << (bound - 1);
+
+    // A little at a time, so saving new ledgers isn't held up
+    while ((seq < bound) && !job.shouldCancel ())
+    {
+        seq = std::min <std::uint32_t> (bound, seq + deleteBatchLedgers);
+
+        deleteBefore (ledgerDB, "Ledgers", seq);
+        deleteBefore (txnDB, "Transactions", seq);
+        getApp().getAccountTxIndex ().deleteBefore (seq);
+    }
+}
+
+std::uint32_t OnlineDelete::getFirstLedger (DatabaseCon& con,
+    char const* table, std::uint32_t bound)
+{
+    std::string const sql (boost::str (boost::format (
+        "SELECT LedgerSeq FROM %s ORDER BY LedgerSeq ASC LIMIT 1;") % table));
+
+    std::uint32_t first (bound);
+
+    Database* db = con.getDB ();
+    DeprecatedScopedLock sl (con.getDBLock ());
+
+    SQL_FOREACH (db, sql)
+    {
+        first = std::min (first,
+            static_cast <std::uint32_t> (db->getBigInt ("LedgerSeq")));
+    }
+
+    return first;
+}
+
+void OnlineDelete::deleteBefore (DatabaseCon& con,
+    char const* table, std::uint32_t seq)
+{
+    std::string const sql (boost::str (boost::format (
+        "DELETE FROM %s WHERE LedgerSeq < %u;") % table % seq));
+
+    DeprecatedScopedLock sl (con.getDBLock ());
+    con.getDB ()->executeSQL (sql);
+}
+
+}
@@ -0,0 +1,121 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_ONLINEDELETE_H_INCLUDED
+#define RIPPLE_ONLINEDELETE_H_INCLUDED
+
+namespace ripple {
+
+/** Deletes history older than a configured number of ledgers.
+
+    The node store is kept in generations, each a database in its own
+    directory next to the configured path. Every `online_delete` ledgers
+    a new generation is started and takes all new writes. Once a ledger
+    closed after that is validated, every node of its trees is copied into
+    the new generation. From then on no ledger from that one forward needs
+    anything written before the previous rotation, so the oldest
+    generation is deleted along with the SQL history of the ledgers
+    which only it could serve.
+
+    Which generations exist, and the ledger copied into each, is kept in
+    a small file next to them so a restart picks up where it left off.
+*/
+class OnlineDelete
+{
+public:
+    /** Return the number of ledgers to keep, or zero to keep everything. */
+    static std::uint32_t getInterval (NodeStore::Parameters const& parameters);
+
+    /** Prepare the generations described by the [node_db] parameters.
+        Throws if online deletion is not possible with them.
+    */
+    OnlineDelete (NodeStore::Parameters const& parameters,
+        NodeStore::Manager& manager, NodeStore::Scheduler& scheduler,
+            beast::Journal journal);
+
+    /** Open the node store made of the generations. */
+    std::unique_ptr <NodeStore::Database> makeDatabase (
+        std::string const& name, int readThreads);
+
+    /** Start the next step of a rotation if one is due. */
+    void sweep ();
+
+private:
+    enum
+    {
+        // Ledgers of SQL history deleted at a time
+        deleteBatchLedgers = 1000
+    };
+
+    struct Generation
+    {
+        // Zero for the plain configured path
+        std::uint32_t number;
+
+        // The ledger whose trees were copied in, or zero if none was
+        std::uint32_t seq;
+    };
+
+    boost::filesystem::path getPath (std::uint32_t number) const;
+    std::unique_ptr <NodeStore::Backend> makeBackend (std::uint32_t number);
+
+    void loadState ();
+    void saveState ();
+
+    void doRotate (Job& job);
+    void doCopy (Job& job, Ledger::pointer ledger);
+    void doTrim (Job& job, std::uint32_t bound);
+
+    bool copyMap (Job& job, SHAMap& map);
+    void trimHistory (Job& job, std::uint32_t bound);
+
+    static std::uint32_t getFirstLedger (DatabaseCon& con,
+        char const* table, std::uint32_t bound);
+    static void deleteBefore (DatabaseCon& con,
+        char const* table, std::uint32_t seq);
+
+    NodeStore::Parameters m_parameters;
+    NodeStore::Manager& m_manager;
+    NodeStore::Scheduler& m_scheduler;
+    beast::Journal m_journal;
+
+    std::uint32_t const m_interval;
+    boost::filesystem::path const m_path;
+    boost::filesystem::path const m_statePath;
+
+    // Owned by the application
+    NodeStore::DatabaseRotating* m_database;
+
+    std::mutex m_mutex;
+
+    // Newest first
+    std::vector <Generation> m_generations;
+
+    // A ledger at least this new may be copied into the newest generation
+    std::uint32_t m_copyFrom;
+
+    // History before this ledger is yet to be deleted
+    std::uint32_t m_trimBound;
+
+    std::atomic <bool> m_working;
+};
+
+}
+
+#endif
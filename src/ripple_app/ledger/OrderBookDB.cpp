@@ -17,6 +17,8 @@
 */
 //==============================================================================
 
+#include "../../beast/beast/unit_test/suite.h"
+
 namespace ripple {
 
 SETUP_LOG (OrderBookDB)
@@ -24,6 +26,7 @@ SETUP_LOG (OrderBookDB)
 OrderBookDB::OrderBookDB (Stoppable& parent)
     : Stoppable ("OrderBookDB", parent)
     , mSeq (0)
+    , mScanSeq (0)
 {
 
 }
@@ -39,22 +42,27 @@ void OrderBookDB::setup (Ledger::ref ledger)
     {
         ScopedLockType sl (mLock);
 
-        // Do a full update every 256 ledgers
+        // Published ledgers keep the books current, so a full scan is only
+        // needed to start, or to recover from a jump in the ledger sequence
+        if (mScanSeq != 0)
+            return;
+
         if (mSeq != 0)
         {
-            if (ledger->getLedgerSeq () == mSeq)
-                return;
-            if ((ledger->getLedgerSeq () > mSeq) && ((ledger->getLedgerSeq () - mSeq) < 256))
-                return;
-            if ((ledger->getLedgerSeq () < mSeq) && ((mSeq - ledger->getLedgerSeq ()) < 16))
+            if ((ledger->getLedgerSeq () <= (mSeq + 1)) && ((ledger->getLedgerSeq () + 16) > mSeq))
                 return;
         }
 
         WriteLog (lsDEBUG, OrderBookDB) << "Advancing from " << mSeq << " to " << ledger->getLedgerSeq();
 
-        mSeq = ledger->getLedgerSeq ();
+        mScanSeq = ledger->getLedgerSeq ();
     }
 
+    scan (ledger);
+}
+
+void OrderBookDB::scan (Ledger::ref ledger)
+{
     if (getConfig().RUN_STANDALONE)
         update(ledger);
     else
@@ -116,6 +124,8 @@ void OrderBookDB::update (Ledger::pointer ledger)
         WriteLog (lsINFO, OrderBookDB) << "OrderBookDB::update encountered a missing node";
         ScopedLockType sl (mLock);
         mSeq = 0;
+        mScanSeq = 0;
+        mPending.clear ();
         return;
     }
 
@@ -123,13 +133,173 @@ void OrderBookDB::update (Ledger::pointer ledger)
     {
         ScopedLockType sl (mLock);
 
+        if (mSeq == ledger->getLedgerSeq ())
+        {
+            // The incremental books were current for this ledger, check them
+            int current = 0;
+
+            typedef boost::unordered_map< RippleAsset, std::vector<OrderBook::pointer> >::value_type u_asset_books;
+            BOOST_FOREACH (u_asset_books const& it, mSourceMap)
+                current += it.second.size ();
+
+            if (current != books)
+            {
+                WriteLog (lsINFO, OrderBookDB) << "OrderBookDB::update incremental books " <<
+                    current << " differ from the " << books << " found";
+            }
+        }
+
         mXRPBooks.swap(XRPBooks);
         mSourceMap.swap(sourceMap);
         mDestMap.swap(destMap);
+        mSeq = ledger->getLedgerSeq ();
+        mScanSeq = 0;
+
+        // Catch up with the ledgers published during the scan
+        std::vector <Changes> pending;
+        pending.swap (mPending);
+
+        BOOST_FOREACH (Changes const& changes, pending)
+        {
+            std::uint32_t const seq = changes.ledger->getLedgerSeq ();
+
+            if (seq == (mSeq + 1))
+            {
+                applyChanges (changes);
+                mSeq = seq;
+            }
+            else if (seq > mSeq)
+            {
+                // A hole, the next published ledger will start a new scan
+                mSeq = 0;
+                break;
+            }
+        }
     }
     getApp().getLedgerMaster().newOrderBookDB();
 }
 
+void OrderBookDB::applyLedger (AcceptedLedger::pointer const& accepted)
+{
+    std::vector <TransactionMetaSet::pointer> meta;
+    meta.reserve (accepted->getTxnCount ());
+
+    BOOST_FOREACH (AcceptedLedger::value_type const& vt, accepted->getMap ())
+    {
+        if (vt.second->getMeta ())
+            meta.push_back (vt.second->getMeta ());
+    }
+
+    applyLedger (accepted->getLedger (), meta);
+}
+
+void OrderBookDB::applyLedger (Ledger::ref ledger,
+    std::vector <TransactionMetaSet::pointer> const& meta)
+{
+    std::uint32_t const seq = ledger->getLedgerSeq ();
+
+    Changes changes;
+    changes.ledger = ledger;
+    changes.meta = meta;
+
+    {
+        ScopedLockType sl (mLock);
+
+        if (mScanSeq != 0)
+        {
+            if (seq > mScanSeq)
+                mPending.push_back (changes);
+            return;
+        }
+
+        if ((mSeq != 0) && (seq <= mSeq))
+            return;
+
+        if ((mSeq != 0) && (seq == (mSeq + 1)))
+        {
+            applyChanges (changes);
+            mSeq = seq;
+
+            if ((seq % verifyInterval) != 0)
+                return;
+
+            WriteLog (lsDEBUG, OrderBookDB) << "Verifying books at " << seq;
+        }
+        else
+        {
+            WriteLog (lsDEBUG, OrderBookDB) << "Jumping from " << mSeq << " to " << seq;
+        }
+
+        mScanSeq = seq;
+    }
+
+    scan (ledger);
+}
+
+static uint160 getBookField (STObject const& fields, SField::ref field)
+{
+    // Default values, like the XRP currency, are left out of metadata
+    return fields.isFieldPresent (field) ? fields.getFieldH160 (field) : uint160 ();
+}
+
+void OrderBookDB::applyChanges (Changes const& changes)
+{
+    Ledger::ref ledger = changes.ledger;
+    int added = 0;
+    int removed = 0;
+
+    BOOST_FOREACH (TransactionMetaSet::ref meta, changes.meta)
+    {
+        BOOST_FOREACH (STObject const& node, meta->getNodes ())
+        {
+            // Only the first page of a quality directory marks an order book
+            if (node.getFieldU16 (sfLedgerEntryType) != ltDIR_NODE)
+                continue;
+
+            bool const created = (node.getFName () == sfCreatedNode);
+
+            if (!created && (node.getFName () != sfDeletedNode))
+                continue;
+
+            const STObject* fields = dynamic_cast<const STObject*> (
+                node.peekAtPField (created ? sfNewFields : sfFinalFields));
+
+            if (!fields || !fields->isFieldPresent (sfExchangeRate) ||
+                !fields->isFieldPresent (sfRootIndex) ||
+                (fields->getFieldH256 (sfRootIndex) != node.getFieldH256 (sfLedgerIndex)))
+                continue;
+
+            uint160 const ci = getBookField (*fields, sfTakerPaysCurrency);
+            uint160 const co = getBookField (*fields, sfTakerGetsCurrency);
+            uint160 const ii = getBookField (*fields, sfTakerPaysIssuer);
+            uint160 const io = getBookField (*fields, sfTakerGetsIssuer);
+
+            if (created)
+            {
+                addOrderBook (ci, co, ii, io);
+                ++added;
+            }
+            else
+            {
+                // The book remains while any of its other qualities do
+                uint256 const base = Ledger::getBookBase (ci, ii, co, io);
+
+                if (ledger->getNextLedgerIndex (base, Ledger::getQualityNext (base)).isZero ())
+                {
+                    removeOrderBook (ci, co, ii, io);
+                    ++removed;
+                }
+            }
+        }
+    }
+
+    if (added || removed)
+    {
+        WriteLog (lsDEBUG, OrderBookDB) << "Ledger " << ledger->getLedgerSeq () <<
+            ": " << added << " book directories added, " << removed << " books removed";
+    }
+}
+
 void OrderBookDB::addOrderBook(const uint160& ci, const uint160& co,
     const uint160& ii, const uint160& io)
 {
@@ -163,6 +333,44 @@ void OrderBookDB::addOrderBook(const uint160& ci, const uint160& co,
         mXRPBooks.insert(RippleAssetRef (ci, ii));
 }
 
+static void eraseBook (boost::unordered_map< RippleAsset, std::vector<OrderBook::pointer> >& map,
+    RippleAsset const& asset, uint256 const& index)
+{
+    boost::unordered_map< RippleAsset, std::vector<OrderBook::pointer> >::iterator it = map.find (asset);
+
+    if (it == map.end ())
+        return;
+
+    std::vector<OrderBook::pointer>& books = it->second;
+
+    for (std::vector<OrderBook::pointer>::iterator book = books.begin (); book != books.end (); ++book)
+    {
+        if ((*book)->getBookBase () == index)
+        {
+            books.erase (book);
+            break;
+        }
+    }
+
+    if (books.empty ())
+        map.erase (it);
+}
+
+void OrderBookDB::removeOrderBook(const uint160& ci, const uint160& co,
+    const uint160& ii, const uint160& io)
+{
+    ScopedLockType sl (mLock);
+
+    uint256 index = Ledger::getBookBase(ci, ii, co, io);
+
+    eraseBook (mSourceMap, RippleAssetRef (ci, ii), index);
+    eraseBook (mDestMap, RippleAssetRef (co, io), index);
+
+    // Only one book from an asset can be to XRP
+    if (co.isZero())
+        mXRPBooks.erase(RippleAssetRef (ci, ii));
+}
+
 // return list of all orderbooks that want this issuerID and currencyID
 void OrderBookDB::getBooksByTakerPays (RippleIssuer const& issuerID, RippleCurrency const& currencyID,
                                        std::vector<OrderBook::pointer>& bookRet)
@@ -235,7 +443,8 @@ BookListeners::pointer OrderBookDB::getBookListeners (RippleCurrency const& curr
 
 // Based on the meta, send the meta to the streams that are listening
 // We need to determine which streams a given meta effects
-void OrderBookDB::processTxn (Ledger::ref ledger, const AcceptedLedgerTx& alTx, Json::Value const& jvObj)
+void OrderBookDB::processTxn (Ledger::ref ledger, const AcceptedLedgerTx& alTx,
+    InfoSub::Message::pointer const& message)
 {
     ScopedLockType sl (mLock);
 
@@ -284,7 +493,7 @@ void OrderBookDB::processTxn (Ledger::ref ledger, const AcceptedLedgerTx& alTx,
                                 getBookListeners (currencyPays, currencyGets, issuerPays, issuerGets);
 
                             if (book)
-                                book->publish (jvObj);
+                                book->publish (message);
                         }
                     }
                 }
@@ -315,11 +524,8 @@ void BookListeners::removeSubscriber (std::uint64_t seq)
     mListeners.erase (seq);
 }
 
-void BookListeners::publish (Json::Value const& jvObj)
+void BookListeners::publish (InfoSub::Message::pointer const& message)
 {
-    Json::FastWriter jfwWriter;
-    std::string sObj = jfwWriter.write (jvObj);
-
     ScopedLockType sl (mLock);
     NetworkOPs::SubMapType::const_iterator it = mListeners.begin ();
 
@@ -329,7 +535,7 @@ void BookListeners::publish (Json::Value const& jvObj)
 
         if (p)
         {
-            p->send (jvObj, sObj, true);
+            p->send (message, true);
             ++it;
         }
         else
@@ -337,4 +543,252 @@ void BookListeners::publish (Json::Value const& jvObj)
     }
 }
 
+//------------------------------------------------------------------------------
+
+class OrderBookDB_test : public beast::unit_test::suite
+{
+public:
+    // Holds a full scan until the test finishes it
+    class TestBooks : public OrderBookDB
+    {
+    public:
+        explicit TestBooks (Stoppable& parent)
+            : OrderBookDB (parent)
+        {
+        }
+
+        // Finish the scan that was started, returns false if there was none
+        bool finishScan ()
+        {
+            Ledger::pointer ledger;
+            ledger.swap (scanned);
+
+            if (!ledger)
+                return false;
+
+            update (ledger);
+            return true;
+        }
+
+        Ledger::pointer scanned;
+
+    private:
+        void scan (Ledger::ref ledger)
+        {
+            scanned = ledger;
+        }
+    };
+
+    struct Book
+    {
+        Book (uint160 const& ci_, uint160 const& ii_, uint160 const& co_, uint160 const& io_)
+            : ci (ci_), ii (ii_), co (co_), io (io_)
+        {
+        }
+
+        uint160 ci, ii, co, io;
+    };
+
+    typedef std::vector <TransactionMetaSet::pointer> MetaList;
+
+    // The first page of one of the book's quality directories
+    static SLE::pointer makeQualityDir (Book const& book, std::uint64_t rate)
+    {
+        uint256 const index (Ledger::getQualityIndex (
+            Ledger::getBookBase (book.ci, book.ii, book.co, book.io), rate));
+
+        SLE::pointer sle (boost::make_shared <SLE> (ltDIR_NODE, index));
+        sle->setFieldH256 (sfRootIndex, index);
+        sle->setFieldH160 (sfTakerPaysCurrency, book.ci);
+        sle->setFieldH160 (sfTakerPaysIssuer, book.ii);
+        sle->setFieldH160 (sfTakerGetsCurrency, book.co);
+        sle->setFieldH160 (sfTakerGetsIssuer, book.io);
+        sle->setFieldU64 (sfExchangeRate, rate);
+        return sle;
+    }
+
+    // Put the directory page in the ledger and describe it the way a
+    // transaction's metadata does
+    static TransactionMetaSet::pointer create (Ledger::ref ledger, SLE::ref sle)
+    {
+        ledger->writeBack (lepCREATE, sle);
+
+        TransactionMetaSet::pointer meta (boost::make_shared <TransactionMetaSet> (
+            sle->getIndex (), ledger->getLedgerSeq (), 0));
+        meta->setAffectedNode (sle->getIndex (), sfCreatedNode, ltDIR_NODE);
+
+        STObject news (sfNewFields);
+        BOOST_FOREACH (SerializedType const& obj, *sle)
+        {
+            if (!obj.isDefault () && obj.getFName ().shouldMeta (SField::sMD_Create | SField::sMD_Always))
+                news.addObject (obj);
+        }
+        meta->getAffectedNode (sle->getIndex ()).addObject (news);
+
+        return meta;
+    }
+
+    static TransactionMetaSet::pointer remove (Ledger::ref ledger, SLE::ref sle)
+    {
+        ledger->peekAccountStateMap ()->delItem (sle->getIndex ());
+
+        TransactionMetaSet::pointer meta (boost::make_shared <TransactionMetaSet> (
+            sle->getIndex (), ledger->getLedgerSeq (), 0));
+        meta->setAffectedNode (sle->getIndex (), sfDeletedNode, ltDIR_NODE);
+
+        STObject finals (sfFinalFields);
+        BOOST_FOREACH (SerializedType const& obj, *sle)
+        {
+            if (obj.getFName ().shouldMeta (SField::sMD_Always | SField::sMD_DeleteFinal))
+                finals.addObject (obj);
+        }
+        meta->getAffectedNode (sle->getIndex ()).addObject (finals);
+
+        return meta;
+    }
+
+    static MetaList metaList (TransactionMetaSet::ref meta)
+    {
+        return MetaList (1, meta);
+    }
+
+    static bool hasBook (OrderBookDB& books, Book const& book)
+    {
+        std::vector <OrderBook::pointer> found;
+        books.getBooksByTakerPays (book.ii, book.ci, found);
+
+        BOOST_FOREACH (OrderBook::ref ob, found)
+        {
+            if ((ob->getCurrencyOut () == book.co) && (ob->getIssuerOut () == book.io))
+                return true;
+        }
+
+        return false;
+    }
+
+    void testCreateAndDelete (Ledger::ref genesis, Book const& book)
+    {
+        testcase ("create and delete");
+
+        beast::RootStoppable root ("test");
+        TestBooks books (root);
+
+        Ledger::pointer ledger (LedgerTest::make_next (genesis));
+        books.applyLedger (ledger, MetaList ());
+        expect (books.finishScan (), "first ledger is scanned");
+
+        // A created quality root adds the book
+        SLE::pointer const low (makeQualityDir (book, 0x5500000000000000ull));
+        ledger = LedgerTest::make_next (ledger);
+        books.applyLedger (ledger, metaList (create (ledger, low)));
+        expect (!books.scanned, "next ledger is applied incrementally");
+        expect (hasBook (books, book), "book added");
+
+        // A later page of a directory doesn't
+        Book const other (book.co, book.io, book.ci, book.ii);
+        SLE::pointer const page (makeQualityDir (other, 0x5500000000000000ull));
+        page->setIndex (Ledger::getDirNodeIndex (page->getIndex (), 1));
+        ledger = LedgerTest::make_next (ledger);
+        books.applyLedger (ledger, metaList (create (ledger, page)));
+        expect (!hasBook (books, other), "only root pages add books");
+
+        SLE::pointer const high (makeQualityDir (book, 0x5600000000000000ull));
+        ledger = LedgerTest::make_next (ledger);
+        books.applyLedger (ledger, metaList (create (ledger, high)));
+        expect (hasBook (books, book));
+
+        // Deleting one quality leaves the book while another remains
+        ledger = LedgerTest::make_next (ledger);
+        books.applyLedger (ledger, metaList (remove (ledger, low)));
+        expect (hasBook (books, book), "book kept while a quality remains");
+
+        ledger = LedgerTest::make_next (ledger);
+        books.applyLedger (ledger, metaList (remove (ledger, high)));
+        expect (!hasBook (books, book), "book removed with its last quality");
+
+        expect (!books.scanned);
+    }
+
+    void testPending (Ledger::ref genesis, Book const& book, Book const& other)
+    {
+        testcase ("pending");
+
+        beast::RootStoppable root ("test");
+        TestBooks books (root);
+
+        Ledger::pointer const base (LedgerTest::make_next (genesis));
+        books.applyLedger (base, MetaList ());
+        expect (books.scanned == base);
+
+        // Both books appear, then one goes away, while the scan runs
+        SLE::pointer const dir (makeQualityDir (book, 0x5500000000000000ull));
+        Ledger::pointer const first (LedgerTest::make_next (base));
+        MetaList meta (metaList (create (first, dir)));
+        meta.push_back (create (first, makeQualityDir (other, 0x5500000000000000ull)));
+        books.applyLedger (first, meta);
+
+        Ledger::pointer const second (LedgerTest::make_next (first));
+        books.applyLedger (second, metaList (remove (second, dir)));
+
+        // Ledgers the scan already covers are ignored
+        books.applyLedger (base, MetaList ());
+
+        expect (books.finishScan ());
+        expect (!hasBook (books, book), "deleted after it was created");
+        expect (hasBook (books, other), "created book kept");
+
+        // The books are current for the second ledger
+        books.applyLedger (LedgerTest::make_next (second), MetaList ());
+        expect (!books.scanned, "caught up with the pending ledgers");
+    }
+
+    void testGap (Ledger::ref genesis, Book const& book, Book const& other)
+    {
+        testcase ("gap");
+
+        beast::RootStoppable root ("test");
+        TestBooks books (root);
+
+        Ledger::pointer const base (LedgerTest::make_next (genesis));
+        books.applyLedger (base, MetaList ());
+
+        Ledger::pointer const first (LedgerTest::make_next (base));
+        books.applyLedger (first, metaList (create (first,
+            makeQualityDir (book, 0x5500000000000000ull))));
+
+        // The ledger after the first is never published
+        Ledger::pointer const skipped (LedgerTest::make_next (first));
+        Ledger::pointer const third (LedgerTest::make_next (skipped));
+        books.applyLedger (third, metaList (create (third,
+            makeQualityDir (other, 0x5500000000000000ull))));
+
+        expect (books.finishScan ());
+        expect (hasBook (books, book), "applied up to the gap");
+        expect (!hasBook (books, other), "stopped at the gap");
+
+        // The next ledger starts a new scan
+        Ledger::pointer const fourth (LedgerTest::make_next (third));
+        books.applyLedger (fourth, MetaList ());
+        expect (books.scanned == fourth, "gap forces a scan");
+    }
+
+    void run ()
+    {
+        Ledger::pointer const genesis (LedgerTest::make_genesis ());
+
+        uint160 const usd (1);
+        uint160 const eur (2);
+        uint160 const gateway (3);
+
+        Book const toXRP (usd, gateway, uint160 (), uint160 ());
+        Book const toEUR (usd, gateway, eur, gateway);
+
+        testCreateAndDelete (genesis, toEUR);
+        testPending (genesis, toEUR, toXRP);
+        testGap (genesis, toEUR, toXRP);
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(OrderBookDB,ripple_app,ripple);
+
 } // ripple
@@ -31,7 +31,7 @@ public:
     BookListeners ();
     void addSubscriber (InfoSub::ref sub);
     void removeSubscriber (std::uint64_t sub);
-    void publish (Json::Value const& jvObj);
+    void publish (InfoSub::Message::pointer const& message);
 
 private:
     typedef RippleRecursiveMutex LockType;
@@ -57,6 +57,20 @@ public:
     void update (Ledger::pointer ledger);
     void invalidate ();
 
+    /** Bring the books up to date with a newly published ledger.
+        Books are added and removed using the ledger's metadata. If the
+        ledger does not follow the last one applied, a full scan of the
+        ledger is started instead.
+    */
+    void applyLedger (AcceptedLedger::pointer const& accepted);
+
+    /** Bring the books up to date with a ledger's transaction metadata.
+        @param ledger The ledger the transactions were applied to.
+        @param meta The metadata of the ledger's transactions, in order.
+    */
+    void applyLedger (Ledger::ref ledger,
+        std::vector <TransactionMetaSet::pointer> const& meta);
+
     void addOrderBook(const uint160& takerPaysCurrency, const uint160& takerGetsCurrency,
         const uint160& takerPaysIssuer, const uint160& takerGetsIssuer);
 
@@ -75,9 +89,33 @@ public:
             RippleIssuer const& issuerPays, RippleIssuer const& issuerGets);
 
     // see if this txn effects any orderbook
-    void processTxn (Ledger::ref ledger, const AcceptedLedgerTx& alTx, Json::Value const& jvObj);
+    void processTxn (Ledger::ref ledger, const AcceptedLedgerTx& alTx,
+        InfoSub::Message::pointer const& message);
+
+protected:
+    /** Start a full scan of a ledger's books, which ends by calling update.
+        The scan runs on the job queue unless the server is standalone.
+    */
+    virtual void scan (Ledger::ref ledger);
 
 private:
+    enum
+    {
+        // Ledgers between full scans that check the incremental books
+        verifyInterval = 4096
+    };
+
+    // A published ledger and the metadata of its transactions
+    struct Changes
+    {
+        Ledger::pointer ledger;
+        std::vector <TransactionMetaSet::pointer> meta;
+    };
+
+    void applyChanges (Changes const& changes);
+    void removeOrderBook (const uint160& takerPaysCurrency, const uint160& takerGetsCurrency,
+        const uint160& takerPaysIssuer, const uint160& takerGetsIssuer);
+
     // by ci/ii
     boost::unordered_map <RippleAsset,
         std::vector <OrderBook::pointer>> mSourceMap;
@@ -97,8 +135,12 @@ private:
 
     MapType mListeners;
 
+    // The ledger the books are current for, zero if they need a full scan
     std::uint32_t mSeq;
 
+    // The ledger being scanned, and the ledgers published during the scan
+    std::uint32_t mScanSeq;
+    std::vector <Changes> mPending;
 };
 
 } // ripple
@@ -132,9 +132,11 @@ public:
     std::unique_ptr <UniqueNodeList> m_deprecatedUNL;
     std::unique_ptr <RPCHTTPServer> m_rpcHTTPServer;
     RPCServerHandler m_rpcServerHandler;
+    std::unique_ptr <OnlineDelete> m_onlineDelete;
     std::unique_ptr <NodeStore::Database> m_nodeStore;
     std::unique_ptr <SNTPClient> m_sntpClient;
     std::unique_ptr <TxQueue> m_txQueue;
+    std::unique_ptr <TxVerifier> m_txVerifier;
     std::unique_ptr <Validators::Manager> m_validators;
     std::unique_ptr <IFeatures> mFeatures;
     std::unique_ptr <IFeeVote> mFeeVote;
@@ -150,6 +152,8 @@ public:
     std::unique_ptr <DatabaseCon> mTxnDB;
     std::unique_ptr <DatabaseCon> mLedgerDB;
     std::unique_ptr <DatabaseCon> mWalletDB;
+    std::unique_ptr <AccountTxIndex> m_accountTxIndex;
+    std::unique_ptr <LedgerSnapshot> m_ledgerSnapshot;
 
     std::unique_ptr <beast::asio::SSLContext> m_peerSSLContext;
     std::unique_ptr <beast::asio::SSLContext> m_wsSSLContext;
@@ -269,7 +273,8 @@ public:
 
         // VFALCO NOTE Does NetworkOPs depend on LedgerMaster?
         , m_networkOPs (NetworkOPs::New (get_seconds_clock (), *m_ledgerMaster,
-            *m_jobQueue, LogPartition::getJournal <NetworkOPsLog> ()))
+            *m_jobQueue, m_collectorManager->collector (),
+                LogPartition::getJournal <NetworkOPsLog> ()))
 
         // VFALCO NOTE LocalCredentials starts the deprecated UNL service
         , m_deprecatedUNL (UniqueNodeList::New (*m_jobQueue))
@@ -277,16 +282,27 @@ public:
         , m_rpcHTTPServer (RPCHTTPServer::New (*m_networkOPs,
             LogPartition::getJournal <HTTPServerLog> (), *m_jobQueue, *m_networkOPs, *m_resourceManager))
 
-        , m_rpcServerHandler (*m_networkOPs, *m_resourceManager) // passive object, not a Service
+        , m_rpcServerHandler (*m_networkOPs, *m_resourceManager, *m_jobQueue) // passive object, not a Service
 
-        , m_nodeStore (m_nodeStoreManager->make_Database ("NodeStore.main", m_nodeStoreScheduler,
-            LogPartition::getJournal <NodeObject> (), 4, // four read threads for now
-                getConfig ().nodeDatabase, getConfig ().ephemeralNodeDatabase))
+        , m_onlineDelete ((OnlineDelete::getInterval (getConfig ().nodeDatabase) != 0)
+            ? new OnlineDelete (getConfig ().nodeDatabase, *m_nodeStoreManager,
+                m_nodeStoreScheduler, LogPartition::getJournal <NodeObject> ())
+            : nullptr)
+
+        , m_nodeStore (m_onlineDelete
+            ? m_onlineDelete->makeDatabase ("NodeStore.main", 4)
+            : m_nodeStoreManager->make_Database ("NodeStore.main", m_nodeStoreScheduler,
+                LogPartition::getJournal <NodeObject> (), 4, // four read threads for now
+                    getConfig ().nodeDatabase, getConfig ().ephemeralNodeDatabase))
 
         , m_sntpClient (SNTPClient::New (*this))
 
         , m_txQueue (TxQueue::New ())
 
+        , m_txVerifier (make_TxVerifier (*m_jobQueue,
+            m_collectorManager->group ("txverify"),
+                beast::SystemStats::getNumCpus ()))
+
         , m_validators (add (Validators::Manager::New (
             *this, 
             getConfig ().getModuleDatabasePath (),
@@ -427,11 +443,21 @@ public:
         return *m_txQueue;
     }
 
+    TxVerifier& getTxVerifier ()
+    {
+        return *m_txVerifier;
+    }
+
     OrderBookDB& getOrderBookDB ()
     {
         return m_orderBookDB;
     }
 
+    AccountTxIndex& getAccountTxIndex ()
+    {
+        return *m_accountTxIndex;
+    }
+
     PathRequests& getPathRequests ()
     {
         return *m_pathRequests;
@@ -608,6 +634,14 @@ public:
         mTxnDB->getDB ()->setupCheckpointing (m_jobQueue.get());
         mLedgerDB->getDB ()->setupCheckpointing (m_jobQueue.get());
 
+        // Let a backlog of validated ledger saves share transactions
+        mTxnDB->getDB ()->getSqliteDB ()->setGroupedWriteLimit (64);
+
+        m_accountTxIndex = make_AccountTxIndex (getConfig ().accountTxDatabase,
+            *mTxnDB, *m_nodeStoreManager, m_nodeStoreScheduler, m_journal);
+
+        m_journal.info << "Account transaction index: " << m_accountTxIndex->getName ();
+
         if (!getConfig ().RUN_STANDALONE)
             updateTables ();
 
@@ -616,6 +650,24 @@ public:
 
         m_ledgerMaster->setMinValidations (getConfig ().VALIDATION_QUORUM);
 
+        {
+            beast::StringPairArray const& settings (getConfig ().ledgerSnapshot);
+            std::uint32_t interval (LedgerSnapshot::defaultInterval);
+            boost::filesystem::path path (getConfig ().DATA_DIR / "ledger.snapshot");
+
+            if (!settings ["interval"].isEmpty ())
+                interval = std::max (0, settings ["interval"].getIntValue ());
+
+            if (!settings ["path"].isEmpty ())
+                path = settings ["path"].toStdString ();
+
+            m_ledgerSnapshot.reset (new LedgerSnapshot (path, interval, m_journal));
+        }
+
+        // Warm the tree node cache before the ledger we start from is built
+        if (getConfig ().START_UP != Config::FRESH)
+            m_ledgerSnapshot->load ();
+
         if (getConfig ().START_UP == Config::FRESH)
         {
             m_journal.info << "Starting new Ledger";
@@ -943,6 +995,11 @@ public:
 
         doStop ();
 
+        // Older ledgers saved during backfill may be waiting for their
+        // grouped write to commit before they are recorded
+        if (mTxnDB != nullptr)
+            Ledger::flushSaves (*mTxnDB, *mLedgerDB);
+
         {
             // These two asssignment should no longer be necessary
             // once the WSDoor cancels its pending I/O correctly
@@ -1040,6 +1097,13 @@ public:
         logTimedCall (m_journal.warning, "NetworkOPs::sweepFetchPack", __FILE__, __LINE__, boost::bind (
             &NetworkOPs::sweepFetchPack, m_networkOPs.get ()));
 
+        logTimedCall (m_journal.warning, "LedgerSnapshot::sweep", __FILE__, __LINE__, boost::bind (
+            &LedgerSnapshot::sweep, m_ledgerSnapshot.get ()));
+
+        if (m_onlineDelete)
+            logTimedCall (m_journal.warning, "OnlineDelete::sweep", __FILE__, __LINE__, boost::bind (
+                &OnlineDelete::sweep, m_onlineDelete.get ()));
+
         // VFALCO NOTE does the call to sweep() happen on another thread?
         m_sweepTimer.setExpiration (getConfig ().getSize (siSweepInterval));
     }
@@ -44,10 +44,12 @@ class LedgerMaster;
 class LoadManager;
 class NetworkOPs;
 class OrderBookDB;
+class AccountTxIndex;
 class ProofOfWorkFactory;
 class SerializedLedgerEntry;
 class TransactionMaster;
 class TxQueue;
+class TxVerifier;
 class LocalCredentials;
 class PathRequests;
 
@@ -63,12 +65,15 @@ public:
 
         The master lock protects:
 
-        - The open ledger
         - Server global state
             * What the last closed ledger is
             * State of the consensus engine
 
         other things
+
+        The open ledger itself is guarded by LedgerMaster::peekMutex. RPC
+        commands that only read ledgers do not take the master lock; they
+        use the immutable snapshots returned by the LedgerMaster.
     */
     typedef RippleRecursiveMutex LockType;
     typedef std::unique_lock <LockType> ScopedLockType;
@@ -103,8 +108,10 @@ public:
     virtual LedgerMaster&           getLedgerMaster () = 0;
     virtual NetworkOPs&             getOPs () = 0;
     virtual OrderBookDB&            getOrderBookDB () = 0;
+    virtual AccountTxIndex&         getAccountTxIndex () = 0;
     virtual TransactionMaster&      getMasterTransaction () = 0;
     virtual TxQueue&                getTxQueue () = 0;
+    virtual TxVerifier&             getTxVerifier () = 0;
     virtual LocalCredentials&       getLocalCredentials () = 0;
     virtual Resource::Manager&      getResourceManager () = 0;
     virtual PathRequests&           getPathRequests () = 0;
@@ -45,7 +45,7 @@ public:
         , m_journal (journal)
         , m_jobQueue (jobQueue)
         , m_networkOPs (networkOPs)
-        , m_deprecatedHandler (networkOPs, resourceManager)
+        , m_deprecatedHandler (networkOPs, resourceManager, jobQueue)
         , m_server (*this, journal)
     {
         if (getConfig ().RPC_SECURE == 0)
@@ -156,8 +156,13 @@ public:
 
     void processSession (Job& job, HTTP::Session& session)
     {
-        session.write (m_deprecatedHandler.processRequest (
-            session.content(), session.remoteAddress().at_port(0)));
+        // The reply goes out to the session in chunks as it is rendered
+        m_deprecatedHandler.processRequest (session.content(),
+            session.remoteAddress().at_port(0),
+            [&session] (void const* data, std::size_t bytes)
+            {
+                session.write (data, bytes);
+            });
 
         session.close();
     }
@@ -244,10 +249,11 @@ public:
             return HTTPReply (403, "Forbidden");
         }
 
-        // This code does all the work on the io_service thread and
-        // has no rate-limiting based on source IP or anything.
-        // This is a temporary safety
-        if ((role != Config::ADMIN) && (getApp().getFeeTrack().isLoadedLocal()))
+        // Shed load when requests arrive faster than the job queue
+        // runs them. Admin requests are always accepted.
+        if ((role != Config::ADMIN) &&
+            (m_jobQueue.getJobCount (jtRPC) >=
+                RPCServerHandler::maxQueuedRequests))
         {
             return HTTPReply (503, "Unable to service at this time");
         }
@@ -39,7 +39,8 @@ public:
     // VFALCO TODO Make LedgerMaster a SharedPtr or a reference.
     //
     NetworkOPsImp (clock_type& clock, LedgerMaster& ledgerMaster,
-        Stoppable& parent, beast::Journal journal)
+        Stoppable& parent, beast::insight::Collector::ptr const& collector,
+            beast::Journal journal)
         : NetworkOPs (parent)
         , m_clock (clock)
         , m_journal (journal)
@@ -60,6 +61,8 @@ public:
         , mFetchPack ("FetchPack", 65536, 45, clock,
             LogPartition::getJournal <TaggedCacheLog> ())
         , mFetchSeq (0)
+        , mGotFetchPackQueued (false)
+        , m_packCache (clock, collector, journal)
         , mLastLoadBase (256)
         , mLastLoadFactor (256)
     {
@@ -153,6 +156,7 @@ public:
     //
     typedef std::function<void (Transaction::pointer, TER)> stCallback; // must complete immediately
     void submitTransaction (Job&, SerializedTransaction::pointer, stCallback callback = stCallback ());
+    void submitCheckedTransaction (SerializedTransaction::pointer, bool valid, stCallback callback);
     Transaction::pointer submitTransactionSync (Transaction::ref tpTrans, bool bAdmin, bool bLocal, bool bFailHard, bool bSubmit);
 
     void runTransactionQueue ();
@@ -222,7 +226,8 @@ public:
 
     // ledger proposal/close functions
     void processTrustedProposal (LedgerProposal::pointer proposal, boost::shared_ptr<protocol::TMProposeSet> set,
-                                 RippleAddress nodePublic, uint256 checkLedger, bool sigGood);
+                                 MessageBuffer::ptr const& frame, RippleAddress nodePublic,
+                                 uint256 checkLedger, bool sigGood);
     SHAMapAddNode gotTXData (const boost::shared_ptr<Peer>& peer, uint256 const& hash,
                              const std::list<SHAMapNode>& nodeIDs, const std::list< Blob >& nodeData);
     bool recvValidation (SerializedValidation::ref val, const std::string& source);
@@ -236,9 +241,13 @@ public:
     bool shouldFetchPack (std::uint32_t seq);
     void gotFetchPack (bool progress, std::uint32_t seq);
     void addFetchPack (uint256 const& hash, boost::shared_ptr< Blob >& data);
+    void addFetchPack (std::vector <std::pair <uint256, boost::shared_ptr <Blob> > >& entries);
     bool getFetchPack (uint256 const& hash, Blob& data);
     int getFetchSize ();
     void sweepFetchPack ();
+    float getFetchPackHitRate ();
+    void prepareFetchPack (Job&, Ledger::pointer ledger);
+    void doGotFetchPack (Job&);
 
     // network state machine
 
@@ -338,12 +347,6 @@ public:
         return m_localTX->size ();
     }
 
-    //Helper function to generate SQL query to get transactions
-    std::string transactionsSQL (std::string selection, const RippleAddress& account,
-                                 std::int32_t minLedger, std::int32_t maxLedger,
-                                 bool descending, std::uint32_t offset, int limit,
-                                 bool binary, bool count, bool bAdmin);
-
 
     // client information retrieval functions
     std::vector< std::pair<Transaction::pointer, TransactionMetaSet::pointer> >
@@ -432,10 +435,22 @@ private:
     Json::Value pubBootstrapAccountInfo (Ledger::ref lpAccepted, const RippleAddress& naAccountID);
 
     void pubValidatedTransaction (Ledger::ref alAccepted, const AcceptedLedgerTx& alTransaction);
-    void pubAccountTransaction (Ledger::ref lpCurrent, const AcceptedLedgerTx& alTransaction, bool isAccepted);
+    void pubAccountTransaction (const AcceptedLedgerTx& alTransaction, bool isAccepted,
+        InfoSub::Message::pointer const& message);
 
     void pubServer ();
 
+    void loadAccountTxs (const RippleAddress& account,
+        std::int32_t minLedger, std::int32_t maxLedger, bool descending,
+            std::uint32_t offset, int limit, bool binary, bool bAdmin,
+                std::function <void (Database*)> const& onRow);
+    void loadAccountTxPage (const RippleAddress& account,
+        std::int32_t minLedger, std::int32_t maxLedger, bool forward,
+            Json::Value& token, std::uint32_t numberOfResults,
+                std::function <void (Database*)> const& onRow);
+    std::pair<Transaction::pointer, TransactionMetaSet::pointer> readAccountTx (Database* db);
+    txnMetaLedgerType readAccountTxB (Database* db);
+
 private:
     clock_type& m_clock;
 
@@ -454,7 +469,7 @@ private:
 
     LockType mLock;
 
-    OperatingMode                       mMode;
+    std::atomic <OperatingMode>         mMode;
     bool                                mNeedNetworkLedger;
     bool                                mProposing, mValidating;
     bool                                mFeatureBlocked;
@@ -492,6 +507,15 @@ private:
 
     TaggedCache< uint256, Blob>                     mFetchPack;
     std::uint32_t                                       mFetchSeq;
+    std::atomic <bool>                                  mGotFetchPackQueued;
+
+    // Fetch packs we send are cut into messages of about this size
+    enum
+    {
+        maxPackChunkBytes = 256 * 1024
+    };
+
+    FetchPackCache                                      m_packCache;
 
     std::uint32_t                                       mLastLoadBase;
     std::uint32_t                                       mLastLoadFactor;
@@ -763,24 +787,29 @@ void NetworkOPsImp::submitTransaction (Job&, SerializedTransaction::pointer iTra
 
     if ((flags & SF_SIGGOOD) == 0)
     {
-        try
-        {
-            if (!passesLocalChecks (*trans) || !trans->checkSign ())
-            {
-                m_journal.warning << "Submitted transaction has bad signature";
-                getApp().getHashRouter ().setFlag (suppress, SF_BAD);
-                return;
-            }
+        getApp().getTxVerifier ().verify (trans,
+            std::bind (&NetworkOPsImp::submitCheckedTransaction, this,
+                std::placeholders::_1, std::placeholders::_2, callback));
+        return;
+    }
 
-            getApp().getHashRouter ().setFlag (suppress, SF_SIGGOOD);
-        }
-        catch (...)
-        {
-            m_journal.warning << "Exception checking transaction " << suppress;
-            return;
-        }
+    submitCheckedTransaction (trans, true, callback);
+}
+
+void NetworkOPsImp::submitCheckedTransaction (
+    SerializedTransaction::pointer trans, bool valid, stCallback callback)
+{
+    uint256 const suppress = trans->getTransactionID ();
+
+    if (!valid)
+    {
+        m_journal.warning << "Submitted transaction has bad signature";
+        getApp().getHashRouter ().setFlag (suppress, SF_BAD);
+        return;
     }
 
+    getApp().getHashRouter ().setFlag (suppress, SF_SIGGOOD);
+
     getApp().getJobQueue().addJob (jtTRANSACTION, "submitTxn",
         std::bind (&NetworkOPsImp::processTransactionCbVoid, this,
             boost::make_shared<Transaction> (trans, false), false, false, false, callback));
@@ -1506,7 +1535,8 @@ uint256 NetworkOPsImp::getConsensusLCL ()
 }
 
 void NetworkOPsImp::processTrustedProposal (LedgerProposal::pointer proposal,
-        boost::shared_ptr<protocol::TMProposeSet> set, RippleAddress nodePublic, uint256 checkLedger, bool sigGood)
+        boost::shared_ptr<protocol::TMProposeSet> set, MessageBuffer::ptr const& frame,
+            RippleAddress nodePublic, uint256 checkLedger, bool sigGood)
 {
     {
         Application::ScopedLockType lock (getApp().getMasterLock ());
@@ -1549,8 +1579,9 @@ void NetworkOPsImp::processTrustedProposal (LedgerProposal::pointer proposal,
             if (getApp().getHashRouter ().swapSet (
                 proposal->getSuppressionID (), peers, SF_RELAYED))
 	    {
+                // Relay the proposal exactly as it was received
                 getApp ().getPeers ().foreach (send_if_not (
-                    boost::make_shared<PackedMessage> (*set, protocol::mtPROPOSE_LEDGER),
+                    boost::make_shared<PackedMessage> (frame),
                     peer_in_set(peers)));
 	    }
         }
@@ -1677,8 +1708,7 @@ void NetworkOPsImp::pubServer ()
         jvObj ["load_base"]     = (mLastLoadBase = getApp().getFeeTrack ().getLoadBase ());
         jvObj ["load_factor"]   = (mLastLoadFactor = getApp().getFeeTrack ().getLoadFactor ());
 
-        Json::FastWriter w;
-        std::string sObj = w.write (jvObj);
+        InfoSub::Message::pointer const message (InfoSub::Message::New (jvObj));
 
         NetworkOPsImp::SubMapType::const_iterator it = mSubServer.begin ();
 
@@ -1690,7 +1720,7 @@ void NetworkOPsImp::pubServer ()
             //             the deletion of subscribers with the sending of JSON data.
             if (p)
             {
-                p->send (jvObj, sObj, true);
+                p->send (message, true);
 
                 ++it;
             }
@@ -1732,20 +1762,17 @@ void NetworkOPsImp::setMode (OperatingMode om)
 }
 
 
-std::string
-NetworkOPsImp::transactionsSQL (std::string selection, const RippleAddress& account,
-                             std::int32_t minLedger, std::int32_t maxLedger, bool descending,
-                             std::uint32_t offset, int limit,
-                             bool binary, bool count, bool bAdmin)
+void NetworkOPsImp::loadAccountTxs (const RippleAddress& account,
+                                    std::int32_t minLedger, std::int32_t maxLedger, bool descending,
+                                    std::uint32_t offset, int limit, bool binary, bool bAdmin,
+                                    std::function <void (Database*)> const& onRow)
 {
     std::uint32_t NONBINARY_PAGE_LENGTH = 200;
     std::uint32_t BINARY_PAGE_LENGTH = 500;
 
     std::uint32_t numberOfResults;
 
-    if (count)
-        numberOfResults = 1000000000;
-    else if (limit < 0)
+    if (limit < 0)
         numberOfResults = binary ? BINARY_PAGE_LENGTH : NONBINARY_PAGE_LENGTH;
     else if (!bAdmin)
         numberOfResults = std::min (binary ? BINARY_PAGE_LENGTH
@@ -1753,46 +1780,60 @@ NetworkOPsImp::transactionsSQL (std::string selection, const RippleAddress& acco
     else
         numberOfResults = limit;
 
-    std::string maxClause = "";
-    std::string minClause = "";
+    getApp().getAccountTxIndex ().loadTransactions (account,
+        (minLedger == -1) ? 0 : static_cast<std::uint32_t> (minLedger),
+        (maxLedger == -1) ? std::numeric_limits<std::uint32_t>::max () : static_cast<std::uint32_t> (maxLedger),
+        !descending, nullptr, offset, numberOfResults, onRow);
+}
 
-    if (maxLedger != -1)
-        maxClause = boost::str (boost::format ("AND AccountTransactions.LedgerSeq <= '%u'") % maxLedger);
+// Reads the page of transactions which follows the resume token, updating
+// the token to point at the page after it.
+void NetworkOPsImp::loadAccountTxPage (const RippleAddress& account,
+                                       std::int32_t minLedger, std::int32_t maxLedger, bool forward,
+                                       Json::Value& token, std::uint32_t numberOfResults,
+                                       std::function <void (Database*)> const& onRow)
+{
+    AccountTxIndex::Entry resume;
+    bool const foundResume = token.isNull() || !token.isObject();
 
-    if (minLedger != -1)
-        minClause = boost::str (boost::format ("AND AccountTransactions.LedgerSeq >= '%u'") % minLedger);
+    if (!foundResume)
+    {
+        try
+        {
+            if (!token.isMember("ledger") || !token.isMember("seq"))
+                return;
+            resume.ledgerSeq = token["ledger"].asUInt();
+            resume.txnSeq = token["seq"].asUInt();
+        }
+        catch (...)
+        {
+            return;
+        }
+    }
 
-    std::string sql;
+    // ST NOTE We're using the token reference both for passing inputs and
+    //         outputs, so we need to clear it in between.
+    token = Json::nullValue;
 
-    if (count)
-        sql =
-            boost::str (boost::format ("SELECT %s FROM AccountTransactions WHERE Account = '%s' %s %s LIMIT %u, %u;")
-		    % selection
-		    % account.humanAccountID ()
-		    % maxClause
-		    % minClause
-		    % beast::lexicalCastThrow <std::string> (offset)
-		    % beast::lexicalCastThrow <std::string> (numberOfResults)
-		);
-    else
-        sql =
-            boost::str (boost::format ("SELECT %s FROM "
-                                       "AccountTransactions INNER JOIN Transactions ON Transactions.TransID = AccountTransactions.TransID "
-                                       "WHERE Account = '%s' %s %s "
-                                       "ORDER BY AccountTransactions.LedgerSeq %s, AccountTransactions.TxnSeq %s, AccountTransactions.TransID %s "
-                                       "LIMIT %u, %u;")
-                    % selection
-                    % account.humanAccountID ()
-                    % maxClause
-                    % minClause
-                    % (descending ? "DESC" : "ASC")
-                    % (descending ? "DESC" : "ASC")
-                    % (descending ? "DESC" : "ASC")
-                    % beast::lexicalCastThrow <std::string> (offset)
-                    % beast::lexicalCastThrow <std::string> (numberOfResults)
-                   );
-    m_journal.trace << "txSQL query: " << sql;
-    return sql;
+    // The transaction after the page is read to find the next token
+    std::uint32_t rows = 0;
+
+    std::vector <AccountTxIndex::Entry> const loaded (
+        getApp().getAccountTxIndex ().loadTransactions (account,
+            std::max (minLedger, 0), static_cast<std::uint32_t> (maxLedger),
+            forward, foundResume ? nullptr : &resume, 0, numberOfResults + 1,
+            [&] (Database* db)
+            {
+                if (++rows <= numberOfResults)
+                    onRow (db);
+            }));
+
+    if (loaded.size () > numberOfResults)
+    {
+        token = Json::objectValue;
+        token["ledger"] = loaded.back ().ledgerSeq;
+        token["seq"] = loaded.back ().txnSeq;
+    }
 }
 
 std::vector< std::pair<Transaction::pointer, TransactionMetaSet::pointer> >
@@ -1803,45 +1844,12 @@ NetworkOPsImp::getAccountTxs (const RippleAddress& account, std::int32_t minLedg
     // can be called with no locks
     std::vector< std::pair<Transaction::pointer, TransactionMetaSet::pointer> > ret;
 
-    std::string sql = NetworkOPsImp::transactionsSQL ("AccountTransactions.LedgerSeq,Status,RawTxn,TxnMeta", account,
-                      minLedger, maxLedger, descending, offset, limit, false, false, bAdmin);
-
-    {
-        Database* db = getApp().getTxnDB ()->getDB ();
-        DeprecatedScopedLock sl (getApp().getTxnDB ()->getDBLock ());
-
-        SQL_FOREACH (db, sql)
+    loadAccountTxs (account, minLedger, maxLedger,
+        descending, offset, limit, false, bAdmin,
+        [&] (Database* db)
         {
-            Transaction::pointer txn = Transaction::transactionFromSQL (db, false);
-
-            Serializer rawMeta;
-            int metaSize = 2048;
-            rawMeta.resize (metaSize);
-            metaSize = db->getBinary ("TxnMeta", &*rawMeta.begin (), rawMeta.getLength ());
-
-            if (metaSize > rawMeta.getLength ())
-            {
-                rawMeta.resize (metaSize);
-                db->getBinary ("TxnMeta", &*rawMeta.begin (), rawMeta.getLength ());
-            }
-            else
-                rawMeta.resize (metaSize);
-
-            if (rawMeta.getLength() == 0)
-            { // Work around a bug that could leave the metadata missing
-                std::uint32_t seq = static_cast<std::uint32_t>(db->getBigInt("LedgerSeq"));
-                m_journal.warning << "Recovering ledger " << seq << ", txn " << txn->getID();
-                Ledger::pointer ledger = getLedgerBySeq(seq);
-                if (ledger)
-                    ledger->pendSaveValidated(false, false);
-            }
-
-            TransactionMetaSet::pointer meta = boost::make_shared<TransactionMetaSet> (txn->getID (), txn->getLedger (), rawMeta.getData ());
-
-            // VFALCO NOTE Use emplace instead.
-            ret.push_back (std::pair<Transaction::ref, TransactionMetaSet::ref> (txn, meta));
-        }
-    }
+            ret.push_back (readAccountTx (db));
+        });
 
     return ret;
 }
@@ -1853,46 +1861,12 @@ std::vector<NetworkOPsImp::txnMetaLedgerType> NetworkOPsImp::getAccountTxsB (
     // can be called with no locks
     std::vector< txnMetaLedgerType> ret;
 
-    std::string sql = NetworkOPsImp::transactionsSQL ("AccountTransactions.LedgerSeq,Status,RawTxn,TxnMeta", account,
-                      minLedger, maxLedger, descending, offset, limit, true/*binary*/, false, bAdmin);
-
-    {
-        Database* db = getApp().getTxnDB ()->getDB ();
-        DeprecatedScopedLock sl (getApp().getTxnDB ()->getDBLock ());
-
-        SQL_FOREACH (db, sql)
+    loadAccountTxs (account, minLedger, maxLedger,
+        descending, offset, limit, true/*binary*/, bAdmin,
+        [&] (Database* db)
         {
-            int txnSize = 2048;
-            Blob rawTxn (txnSize);
-            txnSize = db->getBinary ("RawTxn", &rawTxn[0], rawTxn.size ());
-
-            if (txnSize > rawTxn.size ())
-            {
-                rawTxn.resize (txnSize);
-                db->getBinary ("RawTxn", &*rawTxn.begin (), rawTxn.size ());
-            }
-            else
-                rawTxn.resize (txnSize);
-
-            int metaSize = 2048;
-            Blob rawMeta (metaSize);
-            metaSize = db->getBinary ("TxnMeta", &rawMeta[0], rawMeta.size ());
-
-            if (metaSize > rawMeta.size ())
-            {
-                rawMeta.resize (metaSize);
-                db->getBinary ("TxnMeta", &*rawMeta.begin (), rawMeta.size ());
-            }
-            else
-                rawMeta.resize (metaSize);
-
-            // VFALCO TODO Change the container's type to be std::tuple so
-            //             we can use std::forward_as_tuple here
-            //
-            ret.push_back (boost::make_tuple (
-                strHex (rawTxn), strHex (rawMeta), db->getInt ("LedgerSeq")));
-        }
-    }
+            ret.push_back (readAccountTxB (db));
+        });
 
     return ret;
 }
@@ -1906,104 +1880,21 @@ NetworkOPsImp::getTxsAccount (const RippleAddress& account, std::int32_t minLedg
     std::vector< std::pair<Transaction::pointer, TransactionMetaSet::pointer> > ret;
 
     std::uint32_t NONBINARY_PAGE_LENGTH = 200;
-    std::uint32_t EXTRA_LENGTH = 20;
-
-    bool foundResume = token.isNull() || !token.isObject();
 
-    std::uint32_t numberOfResults, queryLimit;
+    std::uint32_t numberOfResults;
     if (limit <= 0)
         numberOfResults = NONBINARY_PAGE_LENGTH;
     else if (!bAdmin && (limit > NONBINARY_PAGE_LENGTH))
         numberOfResults = NONBINARY_PAGE_LENGTH;
     else
         numberOfResults = limit;
-    queryLimit = numberOfResults + 1 + (foundResume ? 0 : EXTRA_LENGTH);
 
-    std::uint32_t findLedger = 0, findSeq = 0;
-    if (!foundResume)
-    {
-        try
+    loadAccountTxPage (account, minLedger, maxLedger,
+        forward, token, numberOfResults,
+        [&] (Database* db)
         {
-            if (!token.isMember("ledger") || !token.isMember("seq"))
-                return ret;
-            findLedger = token["ledger"].asInt();
-            findSeq = token["seq"].asInt();
-        }
-        catch (...)
-        {
-            return ret;
-        }
-    }
-
-    // ST NOTE We're using the token reference both for passing inputs and
-    //         outputs, so we need to clear it in between.
-    token = Json::nullValue;
-
-    std::string sql = boost::str (boost::format
-        ("SELECT AccountTransactions.LedgerSeq,AccountTransactions.TxnSeq,Status,RawTxn,TxnMeta "
-         "FROM AccountTransactions INNER JOIN Transactions ON Transactions.TransID = AccountTransactions.TransID "
-         "WHERE AccountTransactions.Account = '%s' AND AccountTransactions.LedgerSeq BETWEEN '%u' AND '%u' "
-         "ORDER BY AccountTransactions.LedgerSeq %s, AccountTransactions.TxnSeq %s, AccountTransactions.TransID %s "
-         "LIMIT %u;")
-             % account.humanAccountID()
-             % ((forward && (findLedger != 0)) ? findLedger : minLedger)
-             % ((!forward && (findLedger != 0)) ? findLedger: maxLedger)
-             % (forward ? "ASC" : "DESC")
-             % (forward ? "ASC" : "DESC")
-             % (forward ? "ASC" : "DESC")
-             % queryLimit);
-    {
-        Database* db = getApp().getTxnDB ()->getDB ();
-        DeprecatedScopedLock sl (getApp().getTxnDB ()->getDBLock ());
-
-        SQL_FOREACH (db, sql)
-        {
-            if (!foundResume)
-            {
-                if ((findLedger == db->getInt("LedgerSeq")) && (findSeq == db->getInt("TxnSeq")))
-                    foundResume = true;
-            }
-            else if (numberOfResults == 0)
-            {
-                token = Json::objectValue;
-                token["ledger"] = db->getInt("LedgerSeq");
-                token["seq"] = db->getInt("TxnSeq");
-                break;
-            }
-
-            if (foundResume)
-            {
-                Transaction::pointer txn = Transaction::transactionFromSQL (db, false);
-
-                Serializer rawMeta;
-                int metaSize = 2048;
-                rawMeta.resize (metaSize);
-                metaSize = db->getBinary ("TxnMeta", &*rawMeta.begin (), rawMeta.getLength ());
-
-                if (metaSize > rawMeta.getLength ())
-                {
-                    rawMeta.resize (metaSize);
-                    db->getBinary ("TxnMeta", &*rawMeta.begin (), rawMeta.getLength ());
-                }
-                else
-                    rawMeta.resize (metaSize);
-
-                if (rawMeta.getLength() == 0)
-                { // Work around a bug that could leave the metadata missing
-                    std::uint32_t seq = static_cast<std::uint32_t>(db->getBigInt("LedgerSeq"));
-                    m_journal.warning << "Recovering ledger " << seq << ", txn " << txn->getID();
-                    Ledger::pointer ledger = getLedgerBySeq(seq);
-                    if (ledger)
-                        ledger->pendSaveValidated(false, false);
-                }
-
-                --numberOfResults;
-                TransactionMetaSet::pointer meta = boost::make_shared<TransactionMetaSet> (txn->getID (), txn->getLedger (), rawMeta.getData ());
-
-                ret.push_back (std::pair<Transaction::ref, TransactionMetaSet::ref> (txn, meta));
-            }
-        }
-    }
+            ret.push_back (readAccountTx (db));
+        });
 
     return ret;
 }
@@ -2016,124 +1907,96 @@ NetworkOPsImp::getTxsAccountB (const RippleAddress& account, std::int32_t minLed
     std::vector<txnMetaLedgerType> ret;
 
     std::uint32_t BINARY_PAGE_LENGTH = 500;
-    std::uint32_t EXTRA_LENGTH = 20;
-
-    bool foundResume = token.isNull() || !token.isObject();
 
-    std::uint32_t numberOfResults, queryLimit;
+    std::uint32_t numberOfResults;
     if (limit <= 0)
         numberOfResults = BINARY_PAGE_LENGTH;
     else if (!bAdmin && (limit > BINARY_PAGE_LENGTH))
         numberOfResults = BINARY_PAGE_LENGTH;
     else
         numberOfResults = limit;
-    queryLimit = numberOfResults + 1 + (foundResume ? 0 : EXTRA_LENGTH);
 
-    std::uint32_t findLedger = 0, findSeq = 0;
-    if (!foundResume)
-    {
-        try
+    loadAccountTxPage (account, minLedger, maxLedger,
+        forward, token, numberOfResults,
+        [&] (Database* db)
         {
-            if (!token.isMember("ledger") || !token.isMember("seq"))
-                return ret;
-            findLedger = token["ledger"].asInt();
-            findSeq = token["seq"].asInt();
-        }
-        catch (...)
-        {
-            return ret;
-        }
+            ret.push_back (readAccountTxB (db));
+        });
+
+    return ret;
+}
+
+std::pair<Transaction::pointer, TransactionMetaSet::pointer>
+NetworkOPsImp::readAccountTx (Database* db)
+{
+    Transaction::pointer txn = Transaction::transactionFromSQL (db, false);
+
+    Serializer rawMeta;
+    int metaSize = 2048;
+    rawMeta.resize (metaSize);
+    metaSize = db->getBinary ("TxnMeta", &*rawMeta.begin (), rawMeta.getLength ());
+
+    if (metaSize > rawMeta.getLength ())
+    {
+        rawMeta.resize (metaSize);
+        db->getBinary ("TxnMeta", &*rawMeta.begin (), rawMeta.getLength ());
     }
+    else
+        rawMeta.resize (metaSize);
 
-    token = Json::nullValue;
+    if (rawMeta.getLength() == 0)
+    { // Work around a bug that could leave the metadata missing
+        std::uint32_t seq = static_cast<std::uint32_t>(db->getBigInt("LedgerSeq"));
+        m_journal.warning << "Recovering ledger " << seq << ", txn " << txn->getID();
+        Ledger::pointer ledger = getLedgerBySeq(seq);
+        if (ledger)
+            ledger->pendSaveValidated(false, false);
+    }
 
-    std::string sql = boost::str (boost::format
-        ("SELECT AccountTransactions.LedgerSeq,AccountTransactions.TxnSeq,Status,RawTxn,TxnMeta "
-         "FROM AccountTransactions INNER JOIN Transactions ON Transactions.TransID = AccountTransactions.TransID "
-         "WHERE AccountTransactions.Account = '%s' AND AccountTransactions.LedgerSeq BETWEEN '%u' AND '%u' "
-         "ORDER BY AccountTransactions.LedgerSeq %s, AccountTransactions.TxnSeq %s, AccountTransactions.TransID %s "
-         "LIMIT %u;")
-             % account.humanAccountID()
-             % ((forward && (findLedger != 0)) ? findLedger : minLedger)
-             % ((!forward && (findLedger != 0)) ? findLedger: maxLedger)
-             % (forward ? "ASC" : "DESC")
-             % (forward ? "ASC" : "DESC")
-             % (forward ? "ASC" : "DESC")
-             % queryLimit);
-    {
-        Database* db = getApp().getTxnDB ()->getDB ();
-        DeprecatedScopedLock sl (getApp().getTxnDB ()->getDBLock ());
-
-        SQL_FOREACH (db, sql)
-        {
-            if (!foundResume)
-            {
-                if ((findLedger == db->getInt("LedgerSeq")) && (findSeq == db->getInt("TxnSeq")))
-                    foundResume = true;
-            }
-            else if (numberOfResults == 0)
-            {
-                token = Json::objectValue;
-                token["ledger"] = db->getInt("LedgerSeq");
-                token["seq"] = db->getInt("TxnSeq");
-                break;
-            }
+    TransactionMetaSet::pointer meta = boost::make_shared<TransactionMetaSet> (txn->getID (), txn->getLedger (), rawMeta.getData ());
 
-            if (foundResume)
-            {
-                int txnSize = 2048;
-                Blob rawTxn (txnSize);
-                txnSize = db->getBinary ("RawTxn", &rawTxn[0], rawTxn.size ());
+    return std::make_pair (txn, meta);
+}
 
-                if (txnSize > rawTxn.size ())
-                {
-                    rawTxn.resize (txnSize);
-                    db->getBinary ("RawTxn", &*rawTxn.begin (), rawTxn.size ());
-                }
-                else
-                    rawTxn.resize (txnSize);
+NetworkOPsImp::txnMetaLedgerType
+NetworkOPsImp::readAccountTxB (Database* db)
+{
+    int txnSize = 2048;
+    Blob rawTxn (txnSize);
+    txnSize = db->getBinary ("RawTxn", &rawTxn[0], rawTxn.size ());
 
-                int metaSize = 2048;
-                Blob rawMeta (metaSize);
-                metaSize = db->getBinary ("TxnMeta", &rawMeta[0], rawMeta.size ());
+    if (txnSize > rawTxn.size ())
+    {
+        rawTxn.resize (txnSize);
+        db->getBinary ("RawTxn", &*rawTxn.begin (), rawTxn.size ());
+    }
+    else
+        rawTxn.resize (txnSize);
 
-                if (metaSize > rawMeta.size ())
-                {
-                    rawMeta.resize (metaSize);
-                    db->getBinary ("TxnMeta", &*rawMeta.begin (), rawMeta.size ());
-                }
-                else
-                    rawMeta.resize (metaSize);
+    int metaSize = 2048;
+    Blob rawMeta (metaSize);
+    metaSize = db->getBinary ("TxnMeta", &rawMeta[0], rawMeta.size ());
 
-                ret.push_back (boost::make_tuple (
-                    strHex (rawTxn), strHex (rawMeta), db->getInt ("LedgerSeq")));
-                --numberOfResults;
-            }
-        }
+    if (metaSize > rawMeta.size ())
+    {
+        rawMeta.resize (metaSize);
+        db->getBinary ("TxnMeta", &*rawMeta.begin (), rawMeta.size ());
     }
+    else
+        rawMeta.resize (metaSize);
 
-    return ret;
+    // VFALCO TODO Change the container's type to be std::tuple so
+    //             we can use std::forward_as_tuple here
+    //
+    return boost::make_tuple (
+        strHex (rawTxn), strHex (rawMeta), db->getInt ("LedgerSeq"));
 }
 
 
 std::vector<RippleAddress>
 NetworkOPsImp::getLedgerAffectedAccounts (std::uint32_t ledgerSeq)
 {
-    std::vector<RippleAddress> accounts;
-    std::string sql = str (boost::format
-                           ("SELECT DISTINCT Account FROM AccountTransactions INDEXED BY AcctLgrIndex WHERE LedgerSeq = '%u';")
-                           % ledgerSeq);
-    RippleAddress acct;
-    {
-        Database* db = getApp().getTxnDB ()->getDB ();
-        DeprecatedScopedLock sl (getApp().getTxnDB ()->getDBLock ());
-        SQL_FOREACH (db, sql)
-        {
-            if (acct.setAccountID (db->getStrBinary ("Account")))
-                accounts.push_back (acct);
-        }
-    }
-    return accounts;
+    return getApp().getAccountTxIndex ().getAffectedAccounts (ledgerSeq);
 }
 
 bool NetworkOPsImp::recvValidation (SerializedValidation::ref val, const std::string& source)
@@ -2336,7 +2199,9 @@ Json::Value NetworkOPsImp::pubBootstrapAccountInfo (Ledger::ref lpAccepted, cons
 
 void NetworkOPsImp::pubProposedTransaction (Ledger::ref lpCurrent, SerializedTransaction::ref stTxn, TER terResult)
 {
-    Json::Value jvObj   = transJson (*stTxn, terResult, false, lpCurrent);
+    // Rendered once for the transaction and account streams
+    InfoSub::Message::pointer const message (InfoSub::Message::New (
+        transJson (*stTxn, terResult, false, lpCurrent)));
 
     {
         ScopedLockType sl (mLock);
@@ -2348,7 +2213,7 @@ void NetworkOPsImp::pubProposedTransaction (Ledger::ref lpCurrent, SerializedTra
 
             if (p)
             {
-                p->send (jvObj, true);
+                p->send (message, true);
                 ++it;
             }
             else
@@ -2357,7 +2222,7 @@ void NetworkOPsImp::pubProposedTransaction (Ledger::ref lpCurrent, SerializedTra
     }
     AcceptedLedgerTx alt (stTxn, terResult);
     m_journal.trace << "pubProposed: " << alt.getJson ();
-    pubAccountTransaction (lpCurrent, alt, false);
+    pubAccountTransaction (alt, false, message);
 }
 
 void NetworkOPsImp::pubLedger (Ledger::ref accepted)
@@ -2368,6 +2233,12 @@ void NetworkOPsImp::pubLedger (Ledger::ref accepted)
     AcceptedLedger::pointer alpAccepted = AcceptedLedger::makeAcceptedLedger (accepted);
     Ledger::ref lpAccepted = alpAccepted->getLedger ();
 
+    // Order books follow the published ledgers through their metadata
+    getApp().getOrderBookDB ().applyLedger (alpAccepted);
+
+    getApp().getJobQueue ().addJob (jtPACK_PREPARE, "prepareFetchPack",
+        BIND_TYPE (&NetworkOPsImp::prepareFetchPack, this, P_1, lpAccepted));
+
     {
         ScopedLockType sl (mLock);
 
@@ -2390,6 +2261,8 @@ void NetworkOPsImp::pubLedger (Ledger::ref accepted)
             if (mMode >= omSYNCING)
                 jvObj["validated_ledgers"]  = getApp().getLedgerMaster ().getCompleteLedgers ();
 
+            InfoSub::Message::pointer const message (InfoSub::Message::New (jvObj));
+
             NetworkOPsImp::SubMapType::const_iterator it = mSubLedger.begin ();
 
             while (it != mSubLedger.end ())
@@ -2398,7 +2271,7 @@ void NetworkOPsImp::pubLedger (Ledger::ref accepted)
 
                 if (p)
                 {
-                    p->send (jvObj, true);
+                    p->send (message, true);
                     ++it;
                 }
                 else
@@ -2466,8 +2339,8 @@ void NetworkOPsImp::pubValidatedTransaction (Ledger::ref alAccepted, const Accep
     Json::Value jvObj   = transJson (*alTx.getTxn (), alTx.getResult (), true, alAccepted);
     jvObj["meta"] = alTx.getMeta ()->getJson (0);
 
-    Json::FastWriter w;
-    std::string sObj = w.write (jvObj);
+    // Rendered once for the transaction, book and account streams
+    InfoSub::Message::pointer const message (InfoSub::Message::New (jvObj));
 
     {
         ScopedLockType sl (mLock);
@@ -2480,7 +2353,7 @@ void NetworkOPsImp::pubValidatedTransaction (Ledger::ref alAccepted, const Accep
 
             if (p)
             {
-                p->send (jvObj, sObj, true);
+                p->send (message, true);
                 ++it;
             }
             else
@@ -2495,18 +2368,19 @@ void NetworkOPsImp::pubValidatedTransaction (Ledger::ref alAccepted, const Accep
 
             if (p)
             {
-                p->send (jvObj, sObj, true);
+                p->send (message, true);
                 ++it;
             }
             else
                 it = mSubRTTransactions.erase (it);
         }
     }
-    getApp().getOrderBookDB ().processTxn (alAccepted, alTx, jvObj);
-    pubAccountTransaction (alAccepted, alTx, true);
+    getApp().getOrderBookDB ().processTxn (alAccepted, alTx, message);
+    pubAccountTransaction (alTx, true, message);
 }
 
-void NetworkOPsImp::pubAccountTransaction (Ledger::ref lpCurrent, const AcceptedLedgerTx& alTx, bool bAccepted)
+void NetworkOPsImp::pubAccountTransaction (const AcceptedLedgerTx& alTx, bool bAccepted,
+    InfoSub::Message::pointer const& message)
 {
     boost::unordered_set<InfoSub::pointer>  notify;
     int                             iProposed   = 0;
@@ -2572,17 +2446,10 @@ void NetworkOPsImp::pubAccountTransaction (Ledger::ref lpCurrent, const Accepted
 
     if (!notify.empty ())
     {
-        Json::Value jvObj   = transJson (*alTx.getTxn (), alTx.getResult (), bAccepted, lpCurrent);
-
-        if (alTx.isApplied ())
-            jvObj["meta"] = alTx.getMeta ()->getJson (0);
-
-        Json::FastWriter w;
-        std::string sObj = w.write (jvObj);
-
+        // The account streams carry the same message as the transaction streams
         BOOST_FOREACH (InfoSub::ref isrListener, notify)
         {
-            isrListener->send (jvObj, sObj, true);
+            isrListener->send (message, true);
         }
     }
 }
@@ -3144,15 +3011,6 @@ void NetworkOPsImp::getBookPage (Ledger::pointer lpLedger, const uint160& uTaker
 
 #endif
 
-static void fpAppender (protocol::TMGetObjectByHash* reply, std::uint32_t ledgerSeq,
-                        const uint256& hash, const Blob& blob)
-{
-    protocol::TMIndexedObject& newObj = * (reply->add_objects ());
-    newObj.set_ledgerseq (ledgerSeq);
-    newObj.set_hash (hash.begin (), 256 / 8);
-    newObj.set_data (&blob[0], blob.size ());
-}
-
 void NetworkOPsImp::makeFetchPack (Job&, boost::weak_ptr<Peer> wPeer,
                                 boost::shared_ptr<protocol::TMGetObjectByHash> request,
                                 Ledger::pointer wantLedger, Ledger::pointer haveLedger,
@@ -3186,26 +3044,29 @@ void NetworkOPsImp::makeFetchPack (Job&, boost::weak_ptr<Peer> wPeer,
         reply.set_ledgerhash (request->ledgerhash ());
         reply.set_type (protocol::TMGetObjectByHash::otFETCH_PACK);
 
+        FetchPackWriter writer (reply, maxPackChunkBytes,
+            [&] (protocol::TMGetObjectByHash const& message)
+            {
+                peer->sendPacket (boost::make_shared<PackedMessage> (
+                    message, protocol::mtGET_OBJECTS), false);
+            });
+
         do
         {
             std::uint32_t lSeq = wantLedger->getLedgerSeq ();
 
-            protocol::TMIndexedObject& newObj = *reply.add_objects ();
-            newObj.set_hash (wantLedger->getHash ().begin (), 256 / 8);
             Serializer s (256);
             s.add32 (HashPrefix::ledgerMaster);
             wantLedger->addRaw (s);
-            newObj.set_data (s.getDataPtr (), s.getLength ());
-            newObj.set_ledgerseq (lSeq);
-
-            wantLedger->peekAccountStateMap ()->getFetchPack (haveLedger->peekAccountStateMap ().get (), true, 1024,
-                    BIND_TYPE (fpAppender, &reply, lSeq, P_1, P_2));
+            writer.add (lSeq, wantLedger->getHash (), s.peekData ());
 
-            if (wantLedger->getTransHash ().isNonZero ())
-                wantLedger->peekTransactionMap ()->getFetchPack (nullptr, true, 256,
-                        BIND_TYPE (fpAppender, &reply, lSeq, P_1, P_2));
+            m_packCache.getNodes (haveLedger, wantLedger,
+                [&] (uint256 const& hash, Blob const& blob)
+                {
+                    writer.add (lSeq, hash, blob);
+                });
 
-            if (reply.objects ().size () >= 256)
+            if (writer.getCount () >= 256)
                 break;
 
             // VFALCO NOTE Why use move?
@@ -3214,9 +3075,9 @@ void NetworkOPsImp::makeFetchPack (Job&, boost::weak_ptr<Peer> wPeer,
         }
         while (wantLedger && (UptimeTimer::getInstance ().getElapsedSeconds () <= (uUptime + 1)));
 
-        m_journal.info << "Built fetch pack with " << reply.objects ().size () << " nodes";
-        PackedMessage::pointer msg = boost::make_shared<PackedMessage> (reply, protocol::mtGET_OBJECTS);
-        peer->sendPacket (msg, false);
+        writer.flush ();
+
+        m_journal.info << "Built fetch pack with " << writer.getCount () << " nodes";
     }
     catch (...)
     {
@@ -3227,6 +3088,25 @@ void NetworkOPsImp::makeFetchPack (Job&, boost::weak_ptr<Peer> wPeer,
 void NetworkOPsImp::sweepFetchPack ()
 {
     mFetchPack.sweep ();
+    m_packCache.sweep ();
+}
+
+float NetworkOPsImp::getFetchPackHitRate ()
+{
+    return m_packCache.getHitRate ();
+}
+
+// Peers catching up ask for the ledgers behind the ones they have, so
+// work out what they'll need from each new ledger before they ask.
+void NetworkOPsImp::prepareFetchPack (Job&, Ledger::pointer ledger)
+{
+    if (getApp().getFeeTrack ().isLoadedLocal ())
+        return;
+
+    Ledger::pointer parent = getLedgerByHash (ledger->getParentHash ());
+
+    if (parent)
+        m_packCache.prepare (ledger, parent);
 }
 
 void NetworkOPsImp::addFetchPack (uint256 const& hash, boost::shared_ptr< Blob >& data)
@@ -3234,6 +3114,34 @@ void NetworkOPsImp::addFetchPack (uint256 const& hash, boost::shared_ptr< Blob >
     mFetchPack.canonicalize (hash, data);
 }
 
+void NetworkOPsImp::addFetchPack (
+    std::vector <std::pair <uint256, boost::shared_ptr <Blob> > >& entries)
+{
+    SHA512Batch batch;
+    batch.reserve (entries.size ());
+
+    for (auto const& entry : entries)
+    {
+        Blob const& data (*entry.second);
+        batch.add (data.empty () ? nullptr : &data.front (), data.size ());
+    }
+
+    std::vector <uint256> hashes;
+    batch.finish (hashes);
+
+    int bad (0);
+    for (std::size_t i = 0; i < entries.size (); ++i)
+    {
+        if (hashes[i] == entries[i].first)
+            mFetchPack.canonicalize (entries[i].first, entries[i].second);
+        else
+            ++bad;
+    }
+
+    if (bad != 0)
+        m_journal.warning << bad << " bad entries in fetch pack";
+}
+
 bool NetworkOPsImp::getFetchPack (uint256 const& hash, Blob& data)
 {
     bool ret = mFetchPack.retrieve (hash, data);
@@ -3243,12 +3151,7 @@ bool NetworkOPsImp::getFetchPack (uint256 const& hash, Blob& data)
 
     mFetchPack.del (hash, false);
 
-    if (hash != Serializer::getSHA512Half (data))
-    {
-        m_journal.warning << "Bad entry in fetch pack";
-        return false;
-    }
-
+    // Entries were verified when they were added
     return true;
 }
 
@@ -3267,13 +3170,21 @@ int NetworkOPsImp::getFetchSize ()
 
 void NetworkOPsImp::gotFetchPack (bool progress, std::uint32_t seq)
 {
+    // Packs arrive in several messages, only one pass over the
+    // inbound ledgers needs to be waiting at a time.
+    if (! mGotFetchPackQueued.exchange (true))
+    {
+        getApp().getJobQueue ().addJob (jtLEDGER_DATA, "gotFetchPack",
+                                       BIND_TYPE (&NetworkOPsImp::doGotFetchPack, this, P_1));
+    }
+}
 
-    // FIXME: Calling this function more than once will result in
-    // InboundLedgers::gotFetchPack being called more than once
-    // which is expensive. A flag should track whether we've already dispatched
+void NetworkOPsImp::doGotFetchPack (Job& job)
+{
+    // Cleared first so data arriving during the pass queues another
+    mGotFetchPackQueued = false;
 
-    getApp().getJobQueue ().addJob (jtLEDGER_DATA, "gotFetchPack",
-                                   BIND_TYPE (&InboundLedgers::gotFetchPack, &getApp().getInboundLedgers (), P_1));
+    getApp().getInboundLedgers ().gotFetchPack (job);
 }
 
 void NetworkOPsImp::missingNodeInLedger (std::uint32_t seq)
@@ -3304,9 +3215,10 @@ NetworkOPs::~NetworkOPs ()
 //------------------------------------------------------------------------------
 
 NetworkOPs* NetworkOPs::New (clock_type& clock, LedgerMaster& ledgerMaster,
-    Stoppable& parent, beast::Journal journal)
+    Stoppable& parent, beast::insight::Collector::ptr const& collector,
+        beast::Journal journal)
 {
-    return new NetworkOPsImp (clock, ledgerMaster, parent, journal);
+    return new NetworkOPsImp (clock, ledgerMaster, parent, collector, journal);
 }
 
 } // ripple
@@ -85,7 +85,8 @@ public:
     // VFALCO TODO Make LedgerMaster a SharedPtr or a reference.
     //
     static NetworkOPs* New (clock_type& clock, LedgerMaster& ledgerMaster,
-        Stoppable& parent, beast::Journal journal);
+        Stoppable& parent, beast::insight::Collector::ptr const& collector,
+            beast::Journal journal);
 
     virtual ~NetworkOPs () = 0;
 
@@ -202,8 +203,9 @@ public:
 
     // ledger proposal/close functions
     virtual void processTrustedProposal (LedgerProposal::pointer proposal,
-        boost::shared_ptr<protocol::TMProposeSet> set, RippleAddress nodePublic,
-            uint256 checkLedger, bool sigGood) = 0;
+        boost::shared_ptr<protocol::TMProposeSet> set,
+            MessageBuffer::ptr const& frame, RippleAddress nodePublic,
+                uint256 checkLedger, bool sigGood) = 0;
 
     virtual SHAMapAddNode gotTXData (const boost::shared_ptr<Peer>& peer,
         uint256 const& hash, const std::list<SHAMapNode>& nodeIDs,
@@ -231,10 +233,20 @@ public:
     virtual bool shouldFetchPack (std::uint32_t seq) = 0;
     virtual void gotFetchPack (bool progress, std::uint32_t seq) = 0;
     virtual void addFetchPack (uint256 const& hash, boost::shared_ptr< Blob >& data) = 0;
+
+    /** Stash fetch pack entries received from a peer.
+        The entries are hashed together and any whose data does not match
+        its hash are discarded.
+    */
+    virtual void addFetchPack (
+        std::vector <std::pair <uint256, boost::shared_ptr <Blob> > >& entries) = 0;
     virtual bool getFetchPack (uint256 const& hash, Blob& data) = 0;
     virtual int getFetchSize () = 0;
     virtual void sweepFetchPack () = 0;
 
+    /** Percentage of fetch packs we sent using remembered node lists. */
+    virtual float getFetchPackHitRate () = 0;
+
     // network state machine
     virtual void endConsensus (bool correctLCL) = 0;
     virtual void setStandAlone () = 0;
@@ -277,12 +289,6 @@ public:
     virtual void addLocalTx (Ledger::ref openLedger, SerializedTransaction::ref txn) = 0;
     virtual std::size_t getLocalTxCount () = 0;
 
-    //Helper function to generate SQL query to get transactions
-    virtual std::string transactionsSQL (std::string selection,
-        const RippleAddress& account, std::int32_t minLedger, std::int32_t maxLedger,
-        bool descending, std::uint32_t offset, int limit, bool binary,
-            bool count, bool bAdmin) = 0;
-
     // client information retrieval functions
     typedef std::vector< std::pair<Transaction::pointer, TransactionMetaSet::pointer> > AccountTxs;
     virtual AccountTxs getAccountTxs (const RippleAddress& account,
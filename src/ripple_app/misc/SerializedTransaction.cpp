@@ -312,6 +312,24 @@ std::string SerializedTransaction::getMetaSQL (Serializer rawTxn, std::uint32_t
                 % getSequence () % inLedger % status % rTxn % escapedMetaData);
 }
 
+std::string SerializedTransaction::getMetaSQLInsertReplaceStatement ()
+{
+    return getMetaSQLInsertReplaceHeader () + "(?, ?, ?, ?, ?, ?, ?, ?);";
+}
+
+void SerializedTransaction::bindMetaSQL (SqliteStatement& statement, Serializer const& rawTxn,
+        std::uint32_t inLedger, char status, Blob const& rawMeta) const
+{
+    statement.bind (1, getTransactionID ().GetHex ());
+    statement.bind (2, getTransactionType ());
+    statement.bind (3, getSourceAccount ().humanAccountID ());
+    statement.bind (4, getSequence ());
+    statement.bind (5, inLedger);
+    statement.bind (6, std::string (1, status));
+    statement.bindStatic (7, rawTxn.getDataPtr (), rawTxn.getDataLength ());
+    statement.bindStatic (8, rawMeta.data (), rawMeta.size ());
+}
+
 //------------------------------------------------------------------------------
 
 bool isMemoOkay (STObject const& st)
@@ -140,6 +140,11 @@ public:
     std::string getMetaSQL (std::uint32_t inLedger, const std::string & escapedMetaData) const;
     std::string getMetaSQL (Serializer rawTxn, std::uint32_t inLedger, char status, const std::string & escapedMetaData) const;
 
+    // Prepared statement with metadata, the blobs are bound without escaping
+    static std::string getMetaSQLInsertReplaceStatement ();
+    void bindMetaSQL (SqliteStatement& statement, Serializer const& rawTxn,
+        std::uint32_t inLedger, char status, Blob const& rawMeta) const;
+
 private:
     TxType mType;
     TxFormats::Item const* mFormat;
@@ -109,6 +109,25 @@ public:
         return result;
     }
 
+    std::vector <NodeStore::Status> fetchBatch (
+        std::vector <uint256 const*> const& hashes,
+            std::vector <NodeObject::Ptr>& objects)
+    {
+        std::vector <NodeStore::Status> status;
+        status.reserve (hashes.size ());
+        objects.resize (hashes.size ());
+
+        for (std::size_t i = 0; i < hashes.size (); ++i)
+        {
+            status.push_back (fetch (hashes [i]->cbegin (), &objects [i]));
+
+            if (status.back () != NodeStore::ok)
+                objects [i].reset ();
+        }
+
+        return status;
+    }
+
     void store (NodeObject::ref object)
     {
         NodeStore::Batch batch;
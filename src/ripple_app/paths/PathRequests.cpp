@@ -17,6 +17,8 @@
 */
 //==============================================================================
 
+#include "../../beast/beast/unit_test/suite.h"
+
 namespace ripple {
 
 /** Get the current RippleLineCache, updating it if necessary.
@@ -34,8 +36,33 @@ RippleLineCache::pointer PathRequests::getLineCache (Ledger::pointer& ledger, bo
          (authoritative && ((lgrSeq + 8)  < lineSeq)) ||   // we jumped way back for some reason
          (lgrSeq > (lineSeq + 8)))                         // we jumped way forward for some reason
     {
+        RippleLineCache::pointer previous (mLineCache);
+        Ledger::pointer closed (ledger);
+
         ledger = boost::make_shared<Ledger>(*ledger, false); // Take a snapshot of the ledger
-        mLineCache = boost::make_shared<RippleLineCache> (ledger);
+
+        if (previous && authoritative && closed->isClosed () &&
+            (lgrSeq == (lineSeq + 1)) &&
+            (closed->getParentHash () == mLineHash))
+        {
+            // The next ledger: keep the lines its transactions didn't touch
+            mLineCache = boost::make_shared<RippleLineCache> (ledger,
+                boost::ref (*previous),
+                boost::cref (*AcceptedLedger::makeAcceptedLedger (closed)));
+
+            mJournal.debug << "Line cache for " << lgrSeq << " carried " <<
+                mLineCache->getCarriedCount () << " accounts";
+        }
+        else
+        {
+            mLineCache = boost::make_shared<RippleLineCache> (ledger);
+        }
+
+        // Don't hash an open ledger, it can still change
+        if (closed->isClosed ())
+            mLineHash = closed->getHash ();
+        else
+            mLineHash.zero ();
     }
     else
     {
@@ -203,4 +230,74 @@ Json::Value PathRequests::makePathRequest(
     return result;
 }
 
+//------------------------------------------------------------------------------
+
+class PathRequests_test : public beast::unit_test::suite
+{
+public:
+    static Ledger::pointer makeClosed (Ledger::ref parent)
+    {
+        Ledger::pointer ledger (LedgerTest::make_next (parent));
+        ledger->setClosed ();
+        return ledger;
+    }
+
+    void testLineCache ()
+    {
+        testcase ("line cache");
+
+        PathRequests requests (beast::Journal (),
+            beast::insight::NullCollector::New ());
+
+        uint160 const alice (LedgerTest::make_account_id ("alice"));
+        uint160 const bob (LedgerTest::make_account_id ("bob"));
+
+        Ledger::pointer genesis (LedgerTest::make_genesis ());
+        Ledger::pointer parent (makeClosed (genesis));
+
+        Ledger::pointer ledger (parent);
+        RippleLineCache::pointer first (requests.getLineCache (ledger, true));
+        expect (first->getCarriedCount () == 0);
+        AccountItems& aliceLines (first->getRippleLines (alice));
+        first->getRippleLines (bob);
+
+        // The next ledger keeps the lines its empty transaction set didn't touch
+        Ledger::pointer child (makeClosed (parent));
+        ledger = child;
+        RippleLineCache::pointer second (requests.getLineCache (ledger, true));
+        expect (second != first);
+        expect (second->getCarriedCount () == 2, "child should carry lines over");
+        expect (&second->getRippleLines (alice) == &aliceLines);
+
+        // A ledger with the next sequence on another branch starts empty
+        Ledger::pointer branch (makeClosed (genesis));
+        SLE::pointer root (boost::make_shared <SLE> (ltACCOUNT_ROOT,
+            Ledger::getAccountRootIndex (bob)));
+        root->setFieldAccount (sfAccount, bob);
+        branch->writeBack (lepCREATE, root);
+        Ledger::pointer fork (makeClosed (makeClosed (branch)));
+        expect (fork->getLedgerSeq () == child->getLedgerSeq () + 1);
+        second->getRippleLines (alice);
+        ledger = fork;
+        RippleLineCache::pointer third (requests.getLineCache (ledger, true));
+        expect (third != second);
+        expect (third->getCarriedCount () == 0, "fork should start empty");
+        expect (&third->getRippleLines (alice) != &aliceLines);
+
+        // So does a ledger that skips a sequence
+        Ledger::pointer jump (makeClosed (makeClosed (fork)));
+        ledger = jump;
+        RippleLineCache::pointer fourth (requests.getLineCache (ledger, true));
+        expect (fourth != third);
+        expect (fourth->getCarriedCount () == 0, "jump should start empty");
+    }
+
+    void run ()
+    {
+        testLineCache ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(PathRequests,ripple_app,ripple);
+
 } // ripple
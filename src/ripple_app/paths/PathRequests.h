@@ -64,6 +64,10 @@ private:
     // Use a RippleLineCache
     RippleLineCache::pointer         mLineCache;
 
+    // Hash of the closed ledger the line cache was made from, the
+    // cache itself holds an immutable snapshot that hashes differently
+    uint256                          mLineHash;
+
     beast::Atomic<int>               mLastIdentifier;
 
     typedef RippleRecursiveMutex     LockType;
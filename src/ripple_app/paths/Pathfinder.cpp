@@ -726,7 +726,7 @@ void Pathfinder::addLink(
     { // add order books
         if (addFlags & afOB_XRP)
         { // to XRP only
-            if (!bOnXRP && getApp().getOrderBookDB().isBookToXRP(uEndIssuer, uEndCurrency))
+            if (!bOnXRP && mRLCache->isBookToXRP(uEndIssuer, uEndCurrency))
             {
                 incompletePaths.assembleAdd(currentPath, STPathElement(STPathElement::typeCurrency, ACCOUNT_XRP, CURRENCY_XRP, ACCOUNT_XRP));
             }
@@ -734,8 +734,8 @@ void Pathfinder::addLink(
         else
         {
             bool bDestOnly = (addFlags & afOB_LAST) != 0;
-            std::vector<OrderBook::pointer> books;
-            getApp().getOrderBookDB().getBooksByTakerPays(uEndIssuer, uEndCurrency, books);
+            std::vector<OrderBook::pointer> const& books (
+                mRLCache->getBooksByTakerPays(uEndIssuer, uEndCurrency));
             WriteLog (lsTRACE, Pathfinder) << books.size() << " books found from this currency/issuer";
             BOOST_FOREACH(OrderBook::ref book, books)
             {
@@ -17,11 +17,64 @@
 */
 //==============================================================================
 
+#include "../../beast/beast/unit_test/suite.h"
+
 namespace ripple {
 
 RippleLineCache::RippleLineCache (Ledger::ref l)
     : mLedger (l)
+    , mCarried (0)
+{
+}
+
+RippleLineCache::RippleLineCache (Ledger::ref l, RippleLineCache& previous,
+    AcceptedLedger const& changes)
+    : mLedger (l)
+    , mCarried (0)
+{
+    // Every account mentioned by a changed trust line is in the affected
+    // set, since the metadata carries the low and high limits
+    boost::unordered_set <uint160> affected;
+
+    BOOST_FOREACH (AcceptedLedger::value_type const& vt, changes.getMap ())
+    {
+        BOOST_FOREACH (RippleAddress const& ra, vt.second->getAffected ())
+            affected.insert (ra.getAccountID ());
+    }
+
+    carry (previous, affected);
+}
+
+RippleLineCache::RippleLineCache (Ledger::ref l, RippleLineCache& previous,
+    std::vector <TransactionMetaSet::pointer> const& meta)
+    : mLedger (l)
+    , mCarried (0)
+{
+    boost::unordered_set <uint160> affected;
+
+    BOOST_FOREACH (TransactionMetaSet::ref m, meta)
+    {
+        BOOST_FOREACH (RippleAddress const& ra, m->getAffectedAccounts ())
+            affected.insert (ra.getAccountID ());
+    }
+
+    carry (previous, affected);
+}
+
+void RippleLineCache::carry (RippleLineCache& previous,
+    boost::unordered_set <uint160> const& affected)
 {
+    ScopedLockType sl (previous.mLock);
+
+    for (boost::unordered_map <uint160, AccountItems::pointer>::const_iterator
+        it = previous.mRLMap.begin (); it != previous.mRLMap.end (); ++it)
+    {
+        if (affected.find (it->first) == affected.end ())
+        {
+            mRLMap.insert (*it);
+            ++mCarried;
+        }
+    }
 }
 
 AccountItems& RippleLineCache::getRippleLines (const uint160& accountID)
@@ -37,4 +90,123 @@ AccountItems& RippleLineCache::getRippleLines (const uint160& accountID)
     return *it->second;
 }
 
+std::vector <OrderBook::pointer> const& RippleLineCache::getBooksByTakerPays (
+    const uint160& issuerID, const uint160& currencyID)
+{
+    ScopedLockType sl (mLock);
+
+    RippleAsset const asset (currencyID, issuerID);
+
+    boost::unordered_map <RippleAsset, std::vector <OrderBook::pointer>>::iterator
+        it = mBooks.find (asset);
+
+    if (it == mBooks.end ())
+    {
+        it = mBooks.insert (std::make_pair (asset,
+            std::vector <OrderBook::pointer> ())).first;
+        getApp().getOrderBookDB ().getBooksByTakerPays (
+            issuerID, currencyID, it->second);
+    }
+
+    return it->second;
+}
+
+bool RippleLineCache::isBookToXRP (const uint160& issuerID, const uint160& currencyID)
+{
+    ScopedLockType sl (mLock);
+
+    RippleAsset const asset (currencyID, issuerID);
+
+    boost::unordered_map <RippleAsset, bool>::iterator it = mXRPBooks.find (asset);
+
+    if (it == mXRPBooks.end ())
+        it = mXRPBooks.insert (std::make_pair (asset,
+            getApp().getOrderBookDB ().isBookToXRP (issuerID, currencyID))).first;
+
+    return it->second;
+}
+
+//------------------------------------------------------------------------------
+
+class RippleLineCache_test : public beast::unit_test::suite
+{
+public:
+    static uint256 makeTrustLine (Ledger::ref ledger,
+        uint160 const& low, uint160 const& high, uint160 const& currency)
+    {
+        uint256 const index (Ledger::getRippleStateIndex (low, high, currency));
+
+        SLE::pointer sle (boost::make_shared <SLE> (ltRIPPLE_STATE, index));
+        sle->setFieldAmount (sfBalance, STAmount (currency, ACCOUNT_ONE));
+        sle->setFieldAmount (sfLowLimit, STAmount (sfLowLimit, currency, low, 100));
+        sle->setFieldAmount (sfHighLimit, STAmount (sfHighLimit, currency, high, 0));
+        ledger->writeBack (lepCREATE, sle);
+
+        return index;
+    }
+
+    // Change the balance of the trust line the way a payment would
+    // and return the transaction's metadata
+    static TransactionMetaSet::pointer makePayment (Ledger::ref ledger,
+        uint256 const& line, uint160 const& currency)
+    {
+        uint256 const txID (Serializer::getSHA512Half (line.begin (), line.size ()));
+
+        LedgerEntrySet les (ledger, tapNONE);
+        les.init (ledger, txID, ledger->getLedgerSeq (), tapNONE);
+
+        SLE::pointer sle (les.entryCache (ltRIPPLE_STATE, line));
+        sle->setFieldAmount (sfBalance, STAmount (currency, ACCOUNT_ONE, 10));
+        les.entryModify (sle);
+
+        Serializer s;
+        les.calcRawMeta (s, tesSUCCESS, 0);
+
+        return boost::make_shared <TransactionMetaSet> (
+            txID, ledger->getLedgerSeq (), s.peekData ());
+    }
+
+    void testCarry ()
+    {
+        testcase ("carry");
+
+        uint160 const alice (LedgerTest::make_account_id ("alice"));
+        uint160 const bob (LedgerTest::make_account_id ("bob"));
+        uint160 const carol (LedgerTest::make_account_id ("carol"));
+
+        uint160 usd;
+        STAmount::currencyFromString (usd, "USD");
+
+        Ledger::pointer parent (LedgerTest::make_next (LedgerTest::make_genesis ()));
+        uint256 const line (makeTrustLine (parent, alice, bob, usd));
+
+        RippleLineCache first (parent);
+        AccountItems& aliceLines (first.getRippleLines (alice));
+        first.getRippleLines (bob);
+        AccountItems& carolLines (first.getRippleLines (carol));
+
+        expect (first.getCarriedCount () == 0);
+
+        Ledger::pointer child (LedgerTest::make_next (parent));
+        std::vector <TransactionMetaSet::pointer> meta;
+        meta.push_back (makePayment (child, line, usd));
+
+        RippleLineCache second (child, first, meta);
+
+        // Alice and bob are on the changed line, only carol is carried
+        expect (second.getCarriedCount () == 1);
+        expect (&second.getRippleLines (carol) == &carolLines,
+            "untouched account should be carried over");
+        expect (&second.getRippleLines (alice) != &aliceLines,
+            "touched account should be reloaded");
+    }
+
+    void run ()
+    {
+        testCarry ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(RippleLineCache,ripple_app,ripple);
+
 } // ripple
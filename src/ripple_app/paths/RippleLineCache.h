@@ -23,6 +23,11 @@
 namespace ripple {
 
 // Used by Pathfinder
+//
+// One cache is shared by every path request working on the same ledger.
+// When the next ledger closes, the trust lines of accounts its transactions
+// did not affect are carried over, so only the changed accounts are read
+// from the state map again.
 class RippleLineCache
 {
 public:
@@ -31,6 +36,18 @@ public:
 
     explicit RippleLineCache (Ledger::ref l);
 
+    /** Create a cache for the ledger that follows another cache's ledger.
+        @param changes The transactions that produced the new ledger.
+    */
+    RippleLineCache (Ledger::ref l, RippleLineCache& previous,
+        AcceptedLedger const& changes);
+
+    /** Create a cache for the ledger that follows another cache's ledger.
+        @param meta The metadata of the transactions that produced the new ledger.
+    */
+    RippleLineCache (Ledger::ref l, RippleLineCache& previous,
+        std::vector <TransactionMetaSet::pointer> const& meta);
+
     Ledger::ref getLedger () // VFALCO TODO const?
     {
         return mLedger;
@@ -38,7 +55,23 @@ public:
 
     AccountItems& getRippleLines (const uint160& accountID);
 
+    /** Order books that take the given currency and issuer.
+        The books are looked up once per ledger and shared by all users.
+    */
+    std::vector <OrderBook::pointer> const& getBooksByTakerPays (
+        const uint160& issuerID, const uint160& currencyID);
+
+    bool isBookToXRP (const uint160& issuerID, const uint160& currencyID);
+
+    /** Returns the number of accounts whose lines came from the previous cache. */
+    std::size_t getCarriedCount () const
+    {
+        return mCarried;
+    }
+
 private:
+    void carry (RippleLineCache& previous, boost::unordered_set <uint160> const& affected);
+
     typedef RippleMutex LockType;
     typedef std::lock_guard <LockType> ScopedLockType;
     LockType mLock;
@@ -46,6 +79,11 @@ private:
     Ledger::pointer mLedger;
     
     boost::unordered_map <uint160, AccountItems::pointer> mRLMap;
+
+    boost::unordered_map <RippleAsset, std::vector <OrderBook::pointer>> mBooks;
+    boost::unordered_map <RippleAsset, bool> mXRPBooks;
+
+    std::size_t mCarried;
 };
 
 } // ripple
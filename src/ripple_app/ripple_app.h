@@ -61,6 +61,8 @@
 
 #include "../../ripple/common/KeyCache.h"
 #include "../../ripple/common/TaggedCache.h"
+#include "../../ripple/common/ShardedTaggedCache.h"
+#include "../../ripple/common/SharedFlatMap.h"
 
 #include "../../ripple_overlay/ripple_overlay.h"
 
@@ -68,6 +70,7 @@
 #include "data/DatabaseCon.h"
 #include "data/SqliteDatabase.h"
 #include "data/DBInit.h"
+#include "data/AccountTxIndex.h"
 #include "shamap/SHAMapItem.h"
 #include "shamap/SHAMapNode.h"
 #include "shamap/SHAMapTreeNode.h"
@@ -79,6 +82,7 @@
 #include "misc/SerializedLedger.h"
 #include "tx/TransactionMeta.h"
 #include "tx/Transaction.h"
+#include "tx/TxVerifier.h"
 #include "misc/AccountState.h"
 #include "misc/NicknameState.h"
 #include "ledger/Ledger.h"
@@ -93,6 +97,7 @@
 #include "peers/UniqueNodeList.h"
 #include "misc/Validations.h"
 #include "peers/PeerSet.h"
+#include "ledger/AcquirePipeline.h"
 #include "ledger/InboundLedger.h"
 #include "ledger/InboundLedgers.h"
 #include "misc/AccountItem.h"
@@ -107,6 +112,8 @@
 #include "ledger/LedgerHolder.h"
 #include "ledger/LedgerHistory.h"
 #include "ledger/LedgerCleaner.h"
+#include "ledger/LedgerSnapshot.h"
+#include "ledger/OnlineDelete.h"
 #include "ledger/LedgerMaster.h"
 #include "ledger/LedgerProposal.h"
 #include "misc/NetworkOPs.h"
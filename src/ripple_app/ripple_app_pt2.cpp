@@ -33,13 +33,17 @@
 #include "ledger/LedgerProposal.cpp"
 #include "main/LoadManager.cpp"
 #include "misc/NicknameState.cpp"
+# include "ledger/LedgerTest.h"
+#include "ledger/LedgerTest.cpp"
 #include "ledger/OrderBookDB.cpp"
 
 #include "data/Database.cpp"
 #include "data/DatabaseCon.cpp"
 #include "data/SqliteDatabase.cpp"
 #include "data/DBInit.cpp"
+#include "data/AccountTxIndex.cpp"
 
 # include "shamap/RadixMapTest.h"
 #include "shamap/RadixMapTest.cpp"
 #include "shamap/FetchPackTests.cpp"
+#include "shamap/SHAMapTreeNodeTests.cpp"
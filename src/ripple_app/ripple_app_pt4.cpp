@@ -31,9 +31,11 @@
 
 #include "paths/RippleState.cpp"
 #include "peers/UniqueNodeList.cpp"
+#include "ledger/AcquirePipeline.cpp"
 #include "ledger/InboundLedger.cpp"
 #include "tx/TransactionCheck.cpp"
 #include "tx/TransactionMaster.cpp"
 #include "tx/Transaction.cpp"
 #include "tx/TransactionEngine.cpp"
 #include "tx/TransactionMeta.cpp"
+#include "tx/TxVerifier.cpp"
@@ -27,6 +27,8 @@
 #include "ledger/AcceptedLedger.cpp"
 #include "ledger/DirectoryEntryIterator.cpp"
 #include "ledger/OrderBookIterator.cpp"
+#include "ledger/LedgerSnapshot.cpp"
+#include "ledger/OnlineDelete.cpp"
 #include "consensus/DisputedTx.cpp"
 #include "misc/HashRouter.cpp"
 #include "misc/Offer.cpp"
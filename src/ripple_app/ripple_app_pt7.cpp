@@ -33,4 +33,7 @@
 # include "tx/TxQueueEntry.h"
 # include "tx/TxQueue.h"
 # include "tx/LocalTxs.cpp"
+# include "ledger/FetchPackCache.h"
+# include "ledger/LedgerTest.h"
+#include "ledger/FetchPackCache.cpp"
 #include "misc/NetworkOPs.cpp"
@@ -28,6 +28,7 @@
 
 #include "../ripple_rpc/api/ErrorCodes.h"
 
+# include "ledger/LedgerTest.h"
 #include "paths/PathRequest.cpp"
 #include "paths/PathRequests.cpp"
 #include "paths/RippleCalc.cpp"
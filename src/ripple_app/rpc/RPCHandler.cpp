@@ -715,7 +715,6 @@ Json::Value RPCHandler::accountFromString (Ledger::ref lrLedger, RippleAddress&
 
 Json::Value RPCHandler::doAccountCurrencies (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
     // Get the current ledger
     Ledger::pointer lpLedger;
     Json::Value jvResult (lookupLedger (params, lpLedger));
@@ -785,8 +784,6 @@ Json::Value RPCHandler::doAccountCurrencies (Json::Value params, Resource::Charg
 // }
 Json::Value RPCHandler::doAccountInfo (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
-
     Ledger::pointer     lpLedger;
     Json::Value         jvResult    = lookupLedger (params, lpLedger);
 
@@ -828,7 +825,6 @@ Json::Value RPCHandler::doAccountInfo (Json::Value params, Resource::Charge& loa
 
 Json::Value RPCHandler::doBlackList (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock();
     if (params.isMember("threshold"))
         return getApp().getResourceManager().getJson(params["threshold"].asInt());
     else
@@ -1027,8 +1023,6 @@ Json::Value RPCHandler::doPing (Json::Value, Resource::Charge& loadType, Applica
 
 Json::Value RPCHandler::doPrint (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
-
     JsonPropertyStream stream;
     if (params.isObject() && params["params"].isArray() && params["params"][0u].isString ())
         getApp().write (stream, params["params"][0u].asString());
@@ -1137,7 +1131,6 @@ Json::Value RPCHandler::doProfile (Json::Value params, Resource::Charge& loadTyp
 // }
 Json::Value RPCHandler::doProofCreate (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
     // XXX: Add ability to create proof with arbitrary time
 
     Json::Value     jvResult (Json::objectValue);
@@ -1182,8 +1175,6 @@ Json::Value RPCHandler::doProofCreate (Json::Value params, Resource::Charge& loa
 // }
 Json::Value RPCHandler::doProofSolve (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
-
     Json::Value         jvResult;
 
     if (!params.isMember ("token"))
@@ -1212,7 +1203,6 @@ Json::Value RPCHandler::doProofSolve (Json::Value params, Resource::Charge& load
 // }
 Json::Value RPCHandler::doProofVerify (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
     // XXX Add ability to check proof against arbitrary time
 
     Json::Value         jvResult;
@@ -1282,8 +1272,6 @@ Json::Value RPCHandler::doProofVerify (Json::Value params, Resource::Charge& loa
 // }
 Json::Value RPCHandler::doAccountLines (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
-
     Ledger::pointer     lpLedger;
     Json::Value         jvResult    = lookupLedger (params, lpLedger);
 
@@ -1393,8 +1381,6 @@ static void offerAdder (Json::Value& jvLines, SLE::ref offer)
 // }
 Json::Value RPCHandler::doAccountOffers (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
-
     Ledger::pointer     lpLedger;
     Json::Value         jvResult    = lookupLedger (params, lpLedger);
 
@@ -1472,8 +1458,6 @@ inline uint160 const& neutral_issuer ()
 // }
 Json::Value RPCHandler::doBookOffers (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
-
     // VFALCO TODO Here is a terrible place for this kind of business
     //             logic. It needs to be moved elsewhere and documented,
     //             and encapsulated into a function.
@@ -1643,7 +1627,6 @@ Json::Value RPCHandler::doBookOffers (Json::Value params, Resource::Charge& load
 // }
 Json::Value RPCHandler::doRandom (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
     uint256         uRandom;
 
     try
@@ -1665,7 +1648,6 @@ Json::Value RPCHandler::doRandom (Json::Value params, Resource::Charge& loadType
 Json::Value RPCHandler::doPathFind (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
     Ledger::pointer lpLedger = mNetOps->getClosedLedger();
-    masterLockHolder.unlock();
 
     if (!params.isMember ("subcommand") || !params["subcommand"].isString ())
         return rpcError (rpcINVALID_PARAMS);
@@ -1709,8 +1691,6 @@ Json::Value RPCHandler::doPathFind (Json::Value params, Resource::Charge& loadTy
 // This interface is deprecated.
 Json::Value RPCHandler::doRipplePathFind (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
-
     LegacyPathFind lpf (mRole == Config::ADMIN);
     if (!lpf.isOkay ())
         return rpcError (rpcTOO_BUSY);
@@ -1988,8 +1968,6 @@ Json::Value RPCHandler::doRipplePathFind (Json::Value params, Resource::Charge&
 // }
 Json::Value RPCHandler::doSign (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
-
     loadType = Resource::feeHighBurdenRPC;
     bool bFailHard = params.isMember ("fail_hard") && params["fail_hard"].asBool ();
     return transactionSign (params, false, bFailHard, masterLockHolder);
@@ -2001,8 +1979,6 @@ Json::Value RPCHandler::doSign (Json::Value params, Resource::Charge& loadType,
 // }
 Json::Value RPCHandler::doSubmit (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
-
     loadType = Resource::feeMediumBurdenRPC;
 
     if (!params.isMember ("tx_blob"))
@@ -2102,8 +2078,6 @@ Json::Value RPCHandler::doConsensusInfo (Json::Value, Resource::Charge& loadType
 
 Json::Value RPCHandler::doFetchInfo (Json::Value jvParams, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
-
     Json::Value ret (Json::objectValue);
 
     if (jvParams.isMember("clear") && jvParams["clear"].asBool())
@@ -2140,7 +2114,6 @@ Json::Value RPCHandler::doServerState (Json::Value, Resource::Charge& loadType,
 // }
 Json::Value RPCHandler::doTxHistory (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
     loadType = Resource::feeMediumBurdenRPC;
 
     if (!params.isMember ("start"))
@@ -2182,8 +2155,6 @@ Json::Value RPCHandler::doTxHistory (Json::Value params, Resource::Charge& loadT
 // }
 Json::Value RPCHandler::doTx (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
-
     if (!params.isMember ("transaction"))
         return rpcError (rpcINVALID_PARAMS);
 
@@ -2250,7 +2221,6 @@ Json::Value RPCHandler::doTx (Json::Value params, Resource::Charge& loadType, Ap
 
 Json::Value RPCHandler::doLedgerClosed (Json::Value, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
     Json::Value jvResult;
 
     uint256 uLedger = mNetOps->getClosedLedgerHash ();
@@ -2264,7 +2234,6 @@ Json::Value RPCHandler::doLedgerClosed (Json::Value, Resource::Charge& loadType,
 
 Json::Value RPCHandler::doLedgerCurrent (Json::Value, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
     Json::Value jvResult;
 
     jvResult["ledger_current_index"]    = mNetOps->getCurrentLedgerID ();
@@ -2284,8 +2253,6 @@ Json::Value RPCHandler::doLedgerCurrent (Json::Value, Resource::Charge& loadType
 //     marker:       resume point, if any
 Json::Value RPCHandler::doLedgerData (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
-
     int const BINARY_PAGE_LENGTH = 256;
     int const JSON_PAGE_LENGTH = 2048;
 
@@ -2375,7 +2342,6 @@ Json::Value RPCHandler::doLedgerData (Json::Value params, Resource::Charge& load
 // }
 Json::Value RPCHandler::doLedger (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
     if (!params.isMember ("ledger") && !params.isMember ("ledger_hash") && !params.isMember ("ledger_index"))
     {
         Json::Value ret (Json::objectValue), current (Json::objectValue), closed (Json::objectValue);
@@ -2450,8 +2416,6 @@ Json::Value RPCHandler::doAccountTxSwitch (Json::Value params, Resource::Charge&
 // }
 Json::Value RPCHandler::doAccountTxOld (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
-
     RippleAddress   raAccount;
     std::uint32_t   offset      = params.isMember ("offset") ? params["offset"].asUInt () : 0;
     int             limit       = params.isMember ("limit") ? params["limit"].asUInt () : -1;
@@ -2611,8 +2575,6 @@ Json::Value RPCHandler::doAccountTxOld (Json::Value params, Resource::Charge& lo
 // }
 Json::Value RPCHandler::doAccountTx (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
-
     RippleAddress   raAccount;
     int             limit       = params.isMember ("limit") ? params["limit"].asUInt () : -1;
     bool            bBinary     = params.isMember ("binary") && params["binary"].asBool ();
@@ -2886,7 +2848,6 @@ Json::Value RPCHandler::doWalletAccounts (Json::Value params, Resource::Charge&
 
 Json::Value RPCHandler::doLogRotate (Json::Value, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
     return LogSink::get()->rotateLog ();
 }
 
@@ -2895,8 +2856,6 @@ Json::Value RPCHandler::doLogRotate (Json::Value, Resource::Charge& loadType, Ap
 // }
 Json::Value RPCHandler::doWalletPropose (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
-
     RippleAddress   naSeed;
     RippleAddress   naAccount;
 
@@ -3074,6 +3033,7 @@ Json::Value RPCHandler::doGetCounts (Json::Value params, Resource::Charge& loadT
     ret["node_hit_rate"] = getApp().getNodeStore ().getCacheHitRate ();
     ret["ledger_hit_rate"] = getApp().getLedgerMaster ().getCacheHitRate ();
     ret["AL_hit_rate"] = AcceptedLedger::getCacheHitRate ();
+    ret["fetch_pack_hit_rate"] = getApp().getOPs ().getFetchPackHitRate ();
 
     ret["fullbelow_size"] = int(getApp().getFullBelowCache().size());
     ret["treenode_size"] = SHAMap::getTreeNodeSize ();
@@ -3237,7 +3197,6 @@ Json::Value RPCHandler::doUnlScore (Json::Value, Resource::Charge& loadType, App
 
 Json::Value RPCHandler::doSMS (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
     if (!params.isMember ("text"))
         return rpcError (rpcINVALID_PARAMS);
 
@@ -3272,7 +3231,6 @@ Json::Value RPCHandler::doLedgerAccept (Json::Value, Resource::Charge& loadType,
 
 Json::Value RPCHandler::doLedgerCleaner (Json::Value parameters, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock();
     getApp().getLedgerMaster().doLedgerCleaner (parameters);
     return "Cleaner configured";
 }
@@ -3284,8 +3242,6 @@ Json::Value RPCHandler::doLedgerCleaner (Json::Value parameters, Resource::Charg
 // XXX In this case, not specify either ledger does not mean ledger current. It means any ledger.
 Json::Value RPCHandler::doTransactionEntry (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
-
     Ledger::pointer     lpLedger;
     Json::Value         jvResult    = lookupLedger (params, lpLedger);
 
@@ -3492,8 +3448,6 @@ Json::Value RPCHandler::lookupLedger (Json::Value const& params, Ledger::pointer
 // }
 Json::Value RPCHandler::doLedgerEntry (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
-
     Ledger::pointer     lpLedger;
     Json::Value         jvResult    = lookupLedger (params, lpLedger);
 
@@ -3697,8 +3651,6 @@ Json::Value RPCHandler::doLedgerEntry (Json::Value params, Resource::Charge& loa
 // }
 Json::Value RPCHandler::doLedgerHeader (Json::Value params, Resource::Charge& loadType, Application::ScopedLockType& masterLockHolder)
 {
-    masterLockHolder.unlock ();
-
     Ledger::pointer     lpLedger;
     Json::Value         jvResult    = lookupLedger (params, lpLedger);
 
@@ -4311,77 +4263,81 @@ Json::Value RPCHandler::doCommand (const Json::Value& params, int iRole, Resourc
         doFuncPtr       dfpFunc;
         bool            bAdminRequired;
         unsigned int    iOptions;
+        bool            bMasterLock;
     } commandsA[] =
     {
+        // Commands that only read ledgers run without the master lock,
+        // using the immutable ledger snapshots held by the LedgerMaster.
+        //
         // Request-response methods
-        {   "account_info",         &RPCHandler::doAccountInfo,         false,  optCurrent  },
-        {   "account_currencies",   &RPCHandler::doAccountCurrencies,   false,  optCurrent  },
-        {   "account_lines",        &RPCHandler::doAccountLines,        false,  optCurrent  },
-        {   "account_offers",       &RPCHandler::doAccountOffers,       false,  optCurrent  },
-        {   "account_tx",           &RPCHandler::doAccountTxSwitch,     false,  optNetwork  },
-        {   "blacklist",            &RPCHandler::doBlackList,           true,   optNone     },
-        {   "book_offers",          &RPCHandler::doBookOffers,          false,  optCurrent  },
-        {   "connect",              &RPCHandler::doConnect,             true,   optNone     },
-        {   "consensus_info",       &RPCHandler::doConsensusInfo,       true,   optNone     },
-        {   "get_counts",           &RPCHandler::doGetCounts,           true,   optNone     },
-        {   "internal",             &RPCHandler::doInternal,            true,   optNone     },
-        {   "feature",              &RPCHandler::doFeature,             true,   optNone     },
-        {   "fetch_info",           &RPCHandler::doFetchInfo,           true,   optNone     },
-        {   "ledger",               &RPCHandler::doLedger,              false,  optNetwork  },
-        {   "ledger_accept",        &RPCHandler::doLedgerAccept,        true,   optCurrent  },
-        {   "ledger_cleaner",       &RPCHandler::doLedgerCleaner,       true,   optNetwork  },
-        {   "ledger_closed",        &RPCHandler::doLedgerClosed,        false,  optClosed   },
-        {   "ledger_current",       &RPCHandler::doLedgerCurrent,       false,  optCurrent  },
-        {   "ledger_data",          &RPCHandler::doLedgerData,          false,  optCurrent  },
-        {   "ledger_entry",         &RPCHandler::doLedgerEntry,         false,  optCurrent  },
-        {   "ledger_header",        &RPCHandler::doLedgerHeader,        false,  optCurrent  },
-        {   "log_level",            &RPCHandler::doLogLevel,            true,   optNone     },
-        {   "logrotate",            &RPCHandler::doLogRotate,           true,   optNone     },
-//      {   "nickname_info",        &RPCHandler::doNicknameInfo,        false,  optCurrent  },
-        {   "owner_info",           &RPCHandler::doOwnerInfo,           false,  optCurrent  },
-        {   "peers",                &RPCHandler::doPeers,               true,   optNone     },
-        {   "path_find",            &RPCHandler::doPathFind,            false,  optCurrent  },
-        {   "ping",                 &RPCHandler::doPing,                false,  optNone     },
-        {   "print",                &RPCHandler::doPrint,               true,   optNone     },
-//      {   "profile",              &RPCHandler::doProfile,             false,  optCurrent  },
-        {   "proof_create",         &RPCHandler::doProofCreate,         true,   optNone     },
-        {   "proof_solve",          &RPCHandler::doProofSolve,          true,   optNone     },
-        {   "proof_verify",         &RPCHandler::doProofVerify,         true,   optNone     },
-        {   "random",               &RPCHandler::doRandom,              false,  optNone     },
-        {   "ripple_path_find",     &RPCHandler::doRipplePathFind,      false,  optCurrent  },
-        {   "sign",                 &RPCHandler::doSign,                false,  optNone     },
-        {   "submit",               &RPCHandler::doSubmit,              false,  optCurrent  },
-        {   "server_info",          &RPCHandler::doServerInfo,          false,  optNone     },
-        {   "server_state",         &RPCHandler::doServerState,         false,  optNone     },
-        {   "sms",                  &RPCHandler::doSMS,                 true,   optNone     },
-        {   "stop",                 &RPCHandler::doStop,                true,   optNone     },
-        {   "transaction_entry",    &RPCHandler::doTransactionEntry,    false,  optCurrent  },
-        {   "tx",                   &RPCHandler::doTx,                  false,  optNetwork  },
-        {   "tx_history",           &RPCHandler::doTxHistory,           false,  optNone     },
-        {   "unl_add",              &RPCHandler::doUnlAdd,              true,   optNone     },
-        {   "unl_delete",           &RPCHandler::doUnlDelete,           true,   optNone     },
-        {   "unl_list",             &RPCHandler::doUnlList,             true,   optNone     },
-        {   "unl_load",             &RPCHandler::doUnlLoad,             true,   optNone     },
-        {   "unl_network",          &RPCHandler::doUnlNetwork,          true,   optNone     },
-        {   "unl_reset",            &RPCHandler::doUnlReset,            true,   optNone     },
-        {   "unl_score",            &RPCHandler::doUnlScore,            true,   optNone     },
-        {   "validation_create",    &RPCHandler::doValidationCreate,    true,   optNone     },
-        {   "validation_seed",      &RPCHandler::doValidationSeed,      true,   optNone     },
-        {   "wallet_accounts",      &RPCHandler::doWalletAccounts,      false,  optCurrent  },
-        {   "wallet_propose",       &RPCHandler::doWalletPropose,       true,   optNone     },
-        {   "wallet_seed",          &RPCHandler::doWalletSeed,          true,   optNone     },
+        {   "account_info",         &RPCHandler::doAccountInfo,         false,  optCurrent,     false  },
+        {   "account_currencies",   &RPCHandler::doAccountCurrencies,   false,  optCurrent,     false  },
+        {   "account_lines",        &RPCHandler::doAccountLines,        false,  optCurrent,     false  },
+        {   "account_offers",       &RPCHandler::doAccountOffers,       false,  optCurrent,     false  },
+        {   "account_tx",           &RPCHandler::doAccountTxSwitch,     false,  optNetwork,     false  },
+        {   "blacklist",            &RPCHandler::doBlackList,           true,   optNone,        false  },
+        {   "book_offers",          &RPCHandler::doBookOffers,          false,  optCurrent,     false  },
+        {   "connect",              &RPCHandler::doConnect,             true,   optNone,        true   },
+        {   "consensus_info",       &RPCHandler::doConsensusInfo,       true,   optNone,        true   },
+        {   "get_counts",           &RPCHandler::doGetCounts,           true,   optNone,        true   },
+        {   "internal",             &RPCHandler::doInternal,            true,   optNone,        true   },
+        {   "feature",              &RPCHandler::doFeature,             true,   optNone,        true   },
+        {   "fetch_info",           &RPCHandler::doFetchInfo,           true,   optNone,        false  },
+        {   "ledger",               &RPCHandler::doLedger,              false,  optNetwork,     false  },
+        {   "ledger_accept",        &RPCHandler::doLedgerAccept,        true,   optCurrent,     true   },
+        {   "ledger_cleaner",       &RPCHandler::doLedgerCleaner,       true,   optNetwork,     false  },
+        {   "ledger_closed",        &RPCHandler::doLedgerClosed,        false,  optClosed,      false  },
+        {   "ledger_current",       &RPCHandler::doLedgerCurrent,       false,  optCurrent,     false  },
+        {   "ledger_data",          &RPCHandler::doLedgerData,          false,  optCurrent,     false  },
+        {   "ledger_entry",         &RPCHandler::doLedgerEntry,         false,  optCurrent,     false  },
+        {   "ledger_header",        &RPCHandler::doLedgerHeader,        false,  optCurrent,     false  },
+        {   "log_level",            &RPCHandler::doLogLevel,            true,   optNone,        true   },
+        {   "logrotate",            &RPCHandler::doLogRotate,           true,   optNone,        false  },
+//      {   "nickname_info",        &RPCHandler::doNicknameInfo,        false,  optCurrent,     true   },
+        {   "owner_info",           &RPCHandler::doOwnerInfo,           false,  optCurrent,     false  },
+        {   "peers",                &RPCHandler::doPeers,               true,   optNone,        true   },
+        {   "path_find",            &RPCHandler::doPathFind,            false,  optCurrent,     false  },
+        {   "ping",                 &RPCHandler::doPing,                false,  optNone,        false  },
+        {   "print",                &RPCHandler::doPrint,               true,   optNone,        false  },
+//      {   "profile",              &RPCHandler::doProfile,             false,  optCurrent,     true   },
+        {   "proof_create",         &RPCHandler::doProofCreate,         true,   optNone,        false  },
+        {   "proof_solve",          &RPCHandler::doProofSolve,          true,   optNone,        false  },
+        {   "proof_verify",         &RPCHandler::doProofVerify,         true,   optNone,        false  },
+        {   "random",               &RPCHandler::doRandom,              false,  optNone,        false  },
+        {   "ripple_path_find",     &RPCHandler::doRipplePathFind,      false,  optCurrent,     false  },
+        {   "sign",                 &RPCHandler::doSign,                false,  optNone,        false  },
+        {   "submit",               &RPCHandler::doSubmit,              false,  optCurrent,     false  },
+        {   "server_info",          &RPCHandler::doServerInfo,          false,  optNone,        true   },
+        {   "server_state",         &RPCHandler::doServerState,         false,  optNone,        true   },
+        {   "sms",                  &RPCHandler::doSMS,                 true,   optNone,        false  },
+        {   "stop",                 &RPCHandler::doStop,                true,   optNone,        true   },
+        {   "transaction_entry",    &RPCHandler::doTransactionEntry,    false,  optCurrent,     false  },
+        {   "tx",                   &RPCHandler::doTx,                  false,  optNetwork,     false  },
+        {   "tx_history",           &RPCHandler::doTxHistory,           false,  optNone,        false  },
+        {   "unl_add",              &RPCHandler::doUnlAdd,              true,   optNone,        true   },
+        {   "unl_delete",           &RPCHandler::doUnlDelete,           true,   optNone,        true   },
+        {   "unl_list",             &RPCHandler::doUnlList,             true,   optNone,        true   },
+        {   "unl_load",             &RPCHandler::doUnlLoad,             true,   optNone,        true   },
+        {   "unl_network",          &RPCHandler::doUnlNetwork,          true,   optNone,        true   },
+        {   "unl_reset",            &RPCHandler::doUnlReset,            true,   optNone,        true   },
+        {   "unl_score",            &RPCHandler::doUnlScore,            true,   optNone,        true   },
+        {   "validation_create",    &RPCHandler::doValidationCreate,    true,   optNone,        true   },
+        {   "validation_seed",      &RPCHandler::doValidationSeed,      true,   optNone,        true   },
+        {   "wallet_accounts",      &RPCHandler::doWalletAccounts,      false,  optCurrent,     false  },
+        {   "wallet_propose",       &RPCHandler::doWalletPropose,       true,   optNone,        false  },
+        {   "wallet_seed",          &RPCHandler::doWalletSeed,          true,   optNone,        true   },
 
 #if ENABLE_INSECURE
         // XXX Unnecessary commands which should be removed.
-        {   "login",                &RPCHandler::doLogin,               true,   optNone     },
-        {   "data_delete",          &RPCHandler::doDataDelete,          true,   optNone     },
-        {   "data_fetch",           &RPCHandler::doDataFetch,           true,   optNone     },
-        {   "data_store",           &RPCHandler::doDataStore,           true,   optNone     },
+        {   "login",                &RPCHandler::doLogin,               true,   optNone,        true   },
+        {   "data_delete",          &RPCHandler::doDataDelete,          true,   optNone,        true   },
+        {   "data_fetch",           &RPCHandler::doDataFetch,           true,   optNone,        true   },
+        {   "data_store",           &RPCHandler::doDataStore,           true,   optNone,        true   },
 #endif
 
         // Evented methods
-        {   "subscribe",            &RPCHandler::doSubscribe,           false,  optNone     },
-        {   "unsubscribe",          &RPCHandler::doUnsubscribe,         false,  optNone     },
+        {   "subscribe",            &RPCHandler::doSubscribe,           false,  optNone,        true   },
+        {   "unsubscribe",          &RPCHandler::doUnsubscribe,         false,  optNone,        true   },
     };
 
     int     i = NUMBER (commandsA);
@@ -4399,7 +4355,10 @@ Json::Value RPCHandler::doCommand (const Json::Value& params, int iRole, Resourc
     }
 
     {
-        Application::ScopedLockType lock (getApp().getMasterLock ());
+        Application::ScopedLockType lock (getApp().getMasterLock (), std::defer_lock);
+
+        if (commandsA[i].bMasterLock)
+            lock.lock ();
 
         if ((commandsA[i].iOptions & optNetwork) && (mNetOps->getOperatingMode () < NetworkOPs::omSYNCING))
         {
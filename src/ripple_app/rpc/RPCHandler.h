@@ -46,6 +46,8 @@ public:
     Json::Value doRpcCommand    (const std::string& strCommand, Json::Value const& jvParams, int iRole, Resource::Charge& loadType);
 
 private:
+    // The lock holder only owns the master lock for commands that
+    // are marked as needing it in the command table.
     typedef Json::Value (RPCHandler::*doFuncPtr) (
         Json::Value params,
         Resource::Charge& loadType,
@@ -17,11 +17,15 @@
 */
 //==============================================================================
 
+#include "../../beast/beast/unit_test/suite.h"
+
 namespace ripple {
 
-RPCServerHandler::RPCServerHandler (NetworkOPs& networkOPs, Resource::Manager& resourceManager)
+RPCServerHandler::RPCServerHandler (NetworkOPs& networkOPs, Resource::Manager& resourceManager,
+                                    JobQueue& jobQueue)
     : m_networkOPs (networkOPs)
     , m_resourceManager (resourceManager)
+    , m_jobQueue (jobQueue)
 {
 }
 
@@ -40,6 +44,59 @@ bool RPCServerHandler::isAuthorized (
 
 std::string RPCServerHandler::processRequest (std::string const& request,
                                               beast::IP::Endpoint const& remoteIPAddress)
+{
+    std::string reply;
+
+    processRequest (request, remoteIPAddress,
+        [&reply] (void const* data, std::size_t bytes)
+        {
+            reply.append (static_cast <char const*> (data), bytes);
+        });
+
+    return reply;
+}
+
+void RPCServerHandler::processRequest (std::string const& request,
+                                       beast::IP::Endpoint const& remoteIPAddress,
+                                       JsonStreamWriter::Output const& output)
+{
+    Command command;
+    std::string reply;
+
+    if (! prepare (request, remoteIPAddress, command, reply))
+        return output (reply.data (), reply.size ());
+
+    execute (command, output);
+}
+
+void RPCServerHandler::processRequestAsync (std::string const& request,
+                                            beast::IP::Endpoint const& remoteIPAddress,
+                                            Completion const& complete)
+{
+    std::shared_ptr <Command> const command (std::make_shared <Command> ());
+    std::string reply;
+
+    if (! prepare (request, remoteIPAddress, *command, reply))
+        return complete (reply);
+
+    m_jobQueue.addJob (jtRPC, "RPC",
+        [this, command, complete] (Job&)
+        {
+            std::string reply;
+
+            execute (*command,
+                [&reply] (void const* data, std::size_t bytes)
+                {
+                    reply.append (static_cast <char const*> (data), bytes);
+                });
+
+            complete (reply);
+        });
+}
+
+bool RPCServerHandler::prepare (std::string const& request,
+                                beast::IP::Endpoint const& remoteIPAddress,
+                                Command& command, std::string& reply)
 {
     Json::Value jsonRequest;
     {
@@ -50,7 +107,8 @@ std::string RPCServerHandler::processRequest (std::string const& request,
             jsonRequest.isNull () ||
             ! jsonRequest.isObject ())
         {
-            return createResponse (400, "Unable to parse request");
+            reply = createResponse (400, "Unable to parse request");
+            return false;
         }
     }
     
@@ -64,23 +122,22 @@ std::string RPCServerHandler::processRequest (std::string const& request,
         usage = m_resourceManager.newInboundEndpoint (remoteIPAddress);
 
     if (usage.disconnect ())
-        return createResponse (503, "Server is overloaded");
-
-    // Parse id now so errors from here on will have the id
-    //
-    // VFALCO NOTE Except that "id" isn't included in the following errors...
-    //
-    Json::Value const& id = jsonRequest ["id"];
+    {
+        reply = createResponse (503, "Server is overloaded");
+        return false;
+    }
 
     Json::Value const& method = jsonRequest ["method"];
 
     if (method.isNull ())
     {
-        return createResponse (400, "Null method");
+        reply = createResponse (400, "Null method");
+        return false;
     }
     else if (! method.isString ())
     {
-        return createResponse (400, "method is not string");
+        reply = createResponse (400, "method is not string");
+        return false;
     }
 
     std::string strMethod = method.asString ();
@@ -92,7 +149,10 @@ std::string RPCServerHandler::processRequest (std::string const& request,
     Json::Value& params = jsonRequest ["params"];
 
     if (!params.isArray ())
-        return HTTPReply (400, "params unparseable");
+    {
+        reply = HTTPReply (400, "params unparseable");
+        return false;
+    }
 
     // VFALCO TODO Shouldn't we handle this earlier?
     //
@@ -101,26 +161,44 @@ std::string RPCServerHandler::processRequest (std::string const& request,
         // VFALCO TODO Needs implementing
         // FIXME Needs implementing
         // XXX This needs rate limiting to prevent brute forcing password.
-        return HTTPReply (403, "Forbidden");
+        reply = HTTPReply (403, "Forbidden");
+        return false;
     }
 
-    // This code does all the work on the io_service thread and
-    // has no rate-limiting based on source IP or anything.
-    // This is a temporary safety
-    if ((role != Config::ADMIN) && (getApp().getFeeTrack().isLoadedLocal()))
+    // Shed load when requests arrive faster than the job queue
+    // runs them. Admin requests are always accepted.
+    if ((role != Config::ADMIN) &&
+        (m_jobQueue.getJobCount (jtRPC) >= maxQueuedRequests))
     {
-        return HTTPReply (503, "Unable to service at this time");
+        reply = HTTPReply (503, "Unable to service at this time");
+        return false;
     }
 
-    std::string response;
-   
     WriteLog (lsDEBUG, RPCServer) << "Query: " << strMethod << params;
 
+    command.method = strMethod;
+    command.params = params;
+    command.role = role;
+    command.usage = usage;
+
+    return true;
+}
+
+void RPCServerHandler::execute (Command& command,
+                                JsonStreamWriter::Output const& output)
+{
+    std::string const& strMethod (command.method);
+    Json::Value& params (command.params);
+    Resource::Consumer& usage (command.usage);
+
     {
         Json::Value ripple_params (params.size()
             ? params [0u] : Json::Value (Json::objectValue));
         if (!ripple_params.isObject())
-            return HTTPReply (400, "params must be an object");
+        {
+            std::string const reply (HTTPReply (400, "params must be an object"));
+            return output (reply.data (), reply.size ());
+        }
 
         ripple_params ["command"] = strMethod;
         RPC::Request req (LogPartition::getJournal <RPCServer> (),
@@ -131,8 +209,7 @@ std::string RPCServerHandler::processRequest (std::string const& request,
         {
             usage.charge (req.fee);
             WriteLog (lsDEBUG, RPCServer) << "Reply: " << req.result;
-            return createResponse (200,
-                JSONRPCReply (req.result, Json::Value (), id));
+            return HTTPReplyStream (req.result, output);
         }
     }
 
@@ -140,15 +217,125 @@ std::string RPCServerHandler::processRequest (std::string const& request,
     Resource::Charge fee (Resource::feeReferenceRPC);
     RPCHandler rpcHandler (&m_networkOPs);
     Json::Value const result = rpcHandler.doRpcCommand (
-        strMethod, params, role, fee);
+        strMethod, params, command.role, fee);
 
     usage.charge (fee);
 
     WriteLog (lsDEBUG, RPCServer) << "Reply: " << result;
 
-    response = JSONRPCReply (result, Json::Value (), id);
-
-    return createResponse (200, response);
+    HTTPReplyStream (result, output);
 }
 
+//------------------------------------------------------------------------------
+
+class RPCServerHandler_test : public beast::unit_test::suite
+{
+public:
+    // Collects replies, which may arrive on a job thread
+    class Replies
+    {
+    public:
+        RPCServer::Handler::Completion add ()
+        {
+            return [this] (std::string const& reply)
+            {
+                std::lock_guard <std::mutex> lock (m_mutex);
+                m_replies.push_back (reply);
+                m_cond.notify_all ();
+            };
+        }
+
+        std::size_t size ()
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+            return m_replies.size ();
+        }
+
+        std::string at (std::size_t index)
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+            return m_replies [index];
+        }
+
+        bool wait (std::size_t count)
+        {
+            std::unique_lock <std::mutex> lock (m_mutex);
+            return m_cond.wait_for (lock, std::chrono::seconds (10),
+                [&] { return m_replies.size () >= count; });
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_cond;
+        std::vector <std::string> m_replies;
+    };
+
+    void testShed ()
+    {
+        testcase ("shed");
+
+        beast::RootStoppable root ("test");
+        std::unique_ptr <JobQueue> queue (make_JobQueue (
+            beast::insight::NullCollector::New (), root, beast::Journal ()));
+        queue->setThreadCount (1, false);
+
+        std::unique_ptr <Resource::Manager> resources (Resource::make_Manager (
+            beast::insight::NullCollector::New (), beast::Journal ()));
+
+        RPCServerHandler handler (getApp().getOPs (), *resources, *queue);
+
+        // Occupy the only thread so the RPC jobs stay waiting
+        std::mutex mutex;
+        std::condition_variable cond;
+        bool blocked (true);
+
+        queue->addJob (jtADMIN, "block", [&] (Job&)
+        {
+            std::unique_lock <std::mutex> lock (mutex);
+            cond.wait (lock, [&] { return ! blocked; });
+        });
+
+        for (int i = 1; i < RPCServerHandler::maxQueuedRequests; ++i)
+            queue->addJob (jtRPC, "test", [] (Job&) { });
+
+        std::string const request ("{\"method\":\"ping\"}");
+        beast::IP::Endpoint const guest (beast::IP::Endpoint::from_string ("192.0.2.1"));
+        beast::IP::Endpoint const admin (beast::IP::Endpoint::from_string ("127.0.0.1"));
+        Replies replies;
+
+        // One slot left, the request is queued
+        handler.processRequestAsync (request, guest, replies.add ());
+        expect (replies.size () == 0, "request answered early");
+        expect (queue->getJobCount (jtRPC) == RPCServerHandler::maxQueuedRequests);
+
+        // The queue is full, the request is refused immediately
+        handler.processRequestAsync (request, guest, replies.add ());
+        expect (replies.size () == 1, "request not refused");
+        if (replies.size () == 1)
+            expect (replies.at (0) == HTTPReply (503, "Unable to service at this time"));
+
+        // Admin requests are always accepted
+        handler.processRequestAsync (request, admin, replies.add ());
+        expect (replies.size () == 1, "admin request refused");
+        expect (queue->getJobCount (jtRPC) == RPCServerHandler::maxQueuedRequests + 1);
+
+        {
+            std::lock_guard <std::mutex> lock (mutex);
+            blocked = false;
+            cond.notify_all ();
+        }
+
+        expect (replies.wait (3), "queued requests not answered");
+        expect (replies.at (1).find ("200 OK") != std::string::npos);
+        expect (replies.at (2).find ("200 OK") != std::string::npos);
+    }
+
+    void run ()
+    {
+        testShed ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(RPCServerHandler,ripple_app,ripple);
+
 }
@@ -29,7 +29,14 @@ class NetworkOPs;
 class RPCServerHandler : public RPCServer::Handler
 {
 public:
-    explicit RPCServerHandler (NetworkOPs& networkOPs, Resource::Manager& resourceManager);
+    enum
+    {
+        // Non-admin requests are refused while this many RPC jobs wait
+        maxQueuedRequests = 500
+    };
+
+    RPCServerHandler (NetworkOPs& networkOPs, Resource::Manager& resourceManager,
+                      JobQueue& jobQueue);
 
     std::string createResponse (int statusCode, std::string const& description);
 
@@ -38,9 +45,43 @@ public:
     std::string processRequest (std::string const& request,
                                 beast::IP::Endpoint const& remoteIPAddress);
 
+    /** Process a request, writing the HTTP reply to output in pieces.
+        A successful result is written out as it is rendered instead of
+        being converted to a string first.
+    */
+    void processRequest (std::string const& request,
+                         beast::IP::Endpoint const& remoteIPAddress,
+                         JsonStreamWriter::Output const& output);
+
+    /** Check a request here, then run it on the job queue.
+        Malformed, forbidden and shed requests are answered immediately.
+    */
+    void processRequestAsync (std::string const& request,
+                              beast::IP::Endpoint const& remoteIPAddress,
+                              Completion const& complete);
+
 private:
+    // A request which passed the checks and is ready to run
+    struct Command
+    {
+        std::string method;
+        Json::Value params;
+        Config::Role role;
+        Resource::Consumer usage;
+    };
+
+    /** Parse and check a request.
+        @return `false` if the request was answered, with the reply set.
+    */
+    bool prepare (std::string const& request,
+                  beast::IP::Endpoint const& remoteIPAddress,
+                  Command& command, std::string& reply);
+
+    void execute (Command& command, JsonStreamWriter::Output const& output);
+
     NetworkOPs& m_networkOPs;
     Resource::Manager& m_resourceManager;
+    JobQueue& m_jobQueue;
 };
 
 }
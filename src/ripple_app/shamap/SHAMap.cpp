@@ -18,11 +18,106 @@
 //==============================================================================
 
 #include "../../beast/beast/unit_test/suite.h"
+#include "../../beast/modules/beast_core/thread/Workers.h"
+#include "../../beast/modules/beast_core/system/SystemStats.h"
+
+#include <condition_variable>
+#include <mutex>
 
 namespace ripple {
 
 SETUP_LOG (SHAMap)
 
+//------------------------------------------------------------------------------
+
+/** A pool of threads used to hash independent subtrees in parallel.
+    The calling thread works on the batch too, so a batch always completes
+    even when the pool threads are slow to start.
+*/
+class SHAMapHashWorkers : private beast::Workers::Callback
+{
+public:
+    typedef std::function <void (std::size_t)> Function;
+
+    static SHAMapHashWorkers& getInstance ()
+    {
+        static SHAMapHashWorkers instance;
+
+        return instance;
+    }
+
+    /** Call a function for each index in [0, count) and wait for them all. */
+    void run (std::size_t count, Function const& function)
+    {
+        std::lock_guard <std::mutex> batch (m_batchMutex);
+
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+            m_function = &function;
+            m_next = 0;
+            m_count = count;
+            m_remaining = count;
+        }
+
+        // One index is left for the calling thread
+        for (std::size_t i = 1; i < count; ++i)
+            m_workers.addTask ();
+
+        work ();
+
+        std::unique_lock <std::mutex> lock (m_mutex);
+        while (m_remaining != 0)
+            m_cond.wait (lock);
+        m_function = nullptr;
+    }
+
+private:
+    SHAMapHashWorkers ()
+        : m_workers (*this, "SHAMapHash",
+            std::max (std::min (beast::SystemStats::getNumCpus (), 16) - 1, 0))
+        , m_function (nullptr)
+        , m_next (0)
+        , m_count (0)
+        , m_remaining (0)
+    {
+    }
+
+    void processTask ()
+    {
+        work ();
+    }
+
+    void work ()
+    {
+        std::unique_lock <std::mutex> lock (m_mutex);
+
+        // Tasks left over from an earlier batch find nothing to do
+        while ((m_function != nullptr) && (m_next < m_count))
+        {
+            Function const& function (*m_function);
+            std::size_t const index (m_next++);
+
+            lock.unlock ();
+            function (index);
+            lock.lock ();
+
+            if (--m_remaining == 0)
+                m_cond.notify_all ();
+        }
+    }
+
+    std::mutex m_batchMutex;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    beast::Workers m_workers;
+    Function const* m_function;
+    std::size_t m_next;
+    std::size_t m_count;
+    std::size_t m_remaining;
+};
+
+//------------------------------------------------------------------------------
+
 void SHAMap::DefaultMissingNodeHandler::operator() (std::uint32_t refNUm)
 {
     getApp().getOPs ().missingNodeInLedger (refNUm);
@@ -38,6 +133,7 @@ SHAMap::SHAMap (SHAMapType t, FullBelowCache& fullBelowCache, std::uint32_t seq,
     , mState (smsModifying)
     , mType (t)
     , mTXMap (false)
+    , mDeferHashes (false)
     , m_missing_node_handler (missing_node_handler)
 {
     assert (mSeq != 0);
@@ -57,6 +153,7 @@ SHAMap::SHAMap (SHAMapType t, uint256 const& hash, FullBelowCache& fullBelowCach
     , mState (smsSynching)
     , mType (t)
     , mTXMap (false)
+    , mDeferHashes (false)
     , m_missing_node_handler (missing_node_handler)
 {
     if (t == smtSTATE)
@@ -67,7 +164,7 @@ SHAMap::SHAMap (SHAMapType t, uint256 const& hash, FullBelowCache& fullBelowCach
     mTNByID.replace(*root, root);
 }
 
-TaggedCache <uint256, SHAMapTreeNode>
+ShardedTaggedCache <uint256, SHAMapTreeNode>
     SHAMap::treeNodeCache ("TreeNodeCache", 65536, 60,
         get_seconds_clock (),
             LogPartition::getJournal <TaggedCacheLog> ());
@@ -124,6 +221,10 @@ SHAMap::pointer SHAMap::snapShot (bool isMutable)
     // Initially most nodes are shared and CoW is forced where needed
     {
         ScopedReadLockType sl (mLock);
+
+        // The snapshot shares our nodes, so they must all be hashed
+        updateHashes (sl);
+
         newMap.mSeq = mSeq;
         newMap.mTNByID = mTNByID;
         newMap.root = root;
@@ -204,7 +305,7 @@ void SHAMap::dirtyUp (std::stack<SHAMapTreeNode::pointer>& stack, uint256 const&
 
         returnNode (node, true);
 
-        if (!node->setChildHash (branch, prevHash))
+        if (!setChildHash (*node, branch, prevHash))
         {
             WriteLog (lsFATAL, SHAMap) << "dirtyUp terminates early";
             assert (false);
@@ -219,6 +320,176 @@ void SHAMap::dirtyUp (std::stack<SHAMapTreeNode::pointer>& stack, uint256 const&
     }
 }
 
+bool SHAMap::setChildHash (SHAMapTreeNode& node, int branch, uint256 const& hash)
+{
+    if (mDeferHashes)
+    {
+        // The child may itself be waiting to be rehashed, so an
+        // unchanged hash does not mean the node is unchanged.
+        node.setChildHashDeferred (branch, hash);
+        return true;
+    }
+
+    return node.setChildHash (branch, hash);
+}
+
+SHAMapTreeNode* SHAMap::getStaleChild (SHAMapTreeNode& node, int branch)
+{
+    if (node.isEmptyBranch (branch))
+        return nullptr;
+
+    // Modified nodes are always in memory. This only reads the map, so
+    // it is safe to call from several threads at once.
+    NodeMap::iterator const it (
+        mTNByID.peekMap ().find (node.getChildNodeID (branch)));
+
+    if ((it == mTNByID.peekMap ().end ()) || !it->second->isHashStale ())
+        return nullptr;
+
+    return it->second.get ();
+}
+
+void SHAMap::updateHashes (SHAMapTreeNode& node)
+{
+    // A stale node and where it hangs from its stale parent
+    struct Stale
+    {
+        SHAMapTreeNode* node;
+        SHAMapTreeNode* parent;
+        int branch;
+    };
+
+    // Each inner node's hash covers its prefix and child hashes
+    struct InnerData
+    {
+        uint256 hashes[16];
+    };
+
+    // Gather the stale nodes a level at a time. Each level only depends
+    // on the one below it, so a whole level can be hashed in one batch.
+    std::vector <std::vector <Stale>> levels;
+    levels.emplace_back (1, Stale { &node, nullptr, 0 });
+
+    for (;;)
+    {
+        std::vector <Stale> next;
+
+        for (Stale const& stale : levels.back ())
+        {
+            for (int branch = 0; branch < 16; ++branch)
+            {
+                SHAMapTreeNode* const child = getStaleChild (*stale.node, branch);
+
+                if (child != nullptr)
+                    next.push_back (Stale { child, stale.node, branch });
+            }
+        }
+
+        if (next.empty ())
+            break;
+
+        levels.push_back (std::move (next));
+    }
+
+    SHA512Batch batch;
+    std::vector <InnerData> data;
+    std::vector <SHAMapTreeNode*> batched;
+    std::vector <uint256> hashes;
+
+    for (auto level = levels.rbegin (); level != levels.rend (); ++level)
+    {
+        data.resize (level->size ());
+        batched.clear ();
+
+        for (Stale const& stale : *level)
+        {
+            if (stale.node->getBranchCount () == 0)
+            {
+                stale.node->updateHash ();
+            }
+            else
+            {
+                InnerData& d (data[batched.size ()]);
+                stale.node->getChildHashes (d.hashes);
+                batch.add (HashPrefix::innerNode, d.hashes, sizeof (d.hashes));
+                batched.push_back (stale.node);
+            }
+        }
+
+        batch.finish (hashes);
+
+        for (std::size_t i = 0; i < batched.size (); ++i)
+            batched[i]->setStaleHash (hashes[i]);
+
+        for (Stale const& stale : *level)
+        {
+            if (stale.parent != nullptr)
+                stale.parent->setChildHashDeferred (stale.branch,
+                    stale.node->getNodeHash ());
+        }
+    }
+}
+
+void SHAMap::updateHashes ()
+{
+    // Hash the stale subtrees below the root in parallel, then the root
+    std::vector <std::pair <int, SHAMapTreeNode*>> stale;
+
+    for (int branch = 0; branch < 16; ++branch)
+    {
+        SHAMapTreeNode* const child = getStaleChild (*root, branch);
+
+        if (child != nullptr)
+            stale.emplace_back (branch, child);
+    }
+
+    if (stale.size () > 1)
+    {
+        SHAMapHashWorkers::getInstance ().run (stale.size (),
+            [this, &stale] (std::size_t i)
+            {
+                updateHashes (*stale[i].second);
+            });
+    }
+    else if (!stale.empty ())
+    {
+        updateHashes (*stale.front ().second);
+    }
+
+    for (auto const& entry : stale)
+        root->setChildHashDeferred (entry.first, entry.second->getNodeHash ());
+
+    root->updateHash ();
+}
+
+void SHAMap::updateHashes (ScopedReadLockType& sl)
+{
+    // Stale hashes are rewritten under the write lock. Another thread may
+    // update them, or modify the map again, while we wait for it.
+    while (root->isHashStale ())
+    {
+        sl.unlock ();
+
+        {
+            ScopedWriteLockType wl (mLock);
+
+            if (root->isHashStale ())
+                updateHashes ();
+        }
+
+        sl.lock ();
+    }
+}
+
+uint256 SHAMap::getHash ()
+{
+    ScopedReadLockType sl (mLock);
+
+    updateHashes (sl);
+
+    return root->getNodeHash ();
+}
+
 SHAMapTreeNode::pointer SHAMap::checkCacheNode (const SHAMapNode& iNode)
 {
     SHAMapTreeNode::pointer ret = mTNByID.retrieve(iNode);
@@ -710,7 +981,7 @@ bool SHAMap::delItem (uint256 const& id)
         returnNode (node, true);
         assert (node->isInner ());
 
-        if (!node->setChildHash (node->selectBranch (id), prevHash))
+        if (!setChildHash (*node, node->selectBranch (id), prevHash))
         {
             assert (false);
             return true;
@@ -797,7 +1068,7 @@ bool SHAMap::addGiveItem (SHAMapItem::ref item, bool isTransaction, bool hasMeta
         }
 
         trackNewNode (newNode);
-        node->setChildHash (branch, newNode->getNodeHash ());
+        setChildHash (*node, branch, newNode->getNodeHash ());
     }
     else
     {
@@ -910,6 +1181,8 @@ SHAMapTreeNode* SHAMap::getNodeAsync (
     const SHAMapNode& id,
     uint256 const& hash,
     SHAMapSyncFilter *filter,
+    NodeStore::PendingReads& reads,
+    NodeStore::ReadPriority priority,
     bool& pending)
 {
     pending = false;
@@ -947,7 +1220,7 @@ SHAMapTreeNode* SHAMap::getNodeAsync (
 
             NodeObject::pointer obj;
 
-            if (!getApp().getNodeStore().asyncFetch (hash, obj))
+            if (!reads.asyncFetch (getApp().getNodeStore(), hash, obj, priority))
             { // We would have to block
                 pending = true;
                 assert (!obj);
@@ -1097,6 +1370,7 @@ int SHAMap::armDirty ()
 {
     // begin saving dirty nodes
     mDirtyNodes = boost::make_shared< boost::unordered_map<SHAMapNode, SHAMapTreeNode::pointer> > ();
+    mDeferHashes = true;
     return ++mSeq;
 }
 
@@ -1138,6 +1412,23 @@ boost::shared_ptr<SHAMap::NodeMap> SHAMap::disarmDirty ()
     // stop saving dirty nodes
     ScopedWriteLockType sl (mLock);
 
+    // The dirty nodes are about to be written, bring their hashes up to date
+    if (root->isHashStale ())
+        updateHashes ();
+    mDeferHashes = false;
+
+    if (mDirtyNodes)
+    {
+        // Nodes that were unlinked from the tree are never rehashed
+        for (NodeMap::iterator it = mDirtyNodes->begin (); it != mDirtyNodes->end (); )
+        {
+            if (it->second->isHashStale ())
+                it = mDirtyNodes->erase (it);
+            else
+                ++it;
+        }
+    }
+
     boost::shared_ptr<NodeMap> ret;
     ret.swap (mDirtyNodes);
     return ret;
@@ -1383,6 +1674,65 @@ public:
         unexpected (sMap.getHash () == mapHash, "bad snapshot");
 
         unexpected (map2->getHash () != mapHash, "bad snapshot");
+
+        testDeferredHashing ();
+    }
+
+    static uint256 makeKey (int i)
+    {
+        Serializer s;
+        s.add32 (i);
+        return s.getSHA512Half ();
+    }
+
+    // Builds the same map with and without deferred hashing
+    void testDeferredHashing ()
+    {
+        testcase ("deferred hashing");
+
+        FullBelowCache fullBelowCache ("test.full_below",
+            get_seconds_clock ());
+
+        SHAMap eager (smtFREE, fullBelowCache);
+        SHAMap lazy (smtFREE, fullBelowCache);
+        lazy.armDirty ();
+
+        for (int i = 0; i < 2000; ++i)
+        {
+            SHAMapItem const item (makeKey (i), IntToVUC (i));
+            eager.addItem (item, false, false);
+            lazy.addItem (item, false, false);
+        }
+
+        expect (lazy.getHash () == eager.getHash (), "hash after adding");
+
+        // Keep modifying after the hashes were brought up to date
+        for (int i = 0; i < 2000; i += 3)
+        {
+            SHAMapItem const item (makeKey (i), IntToVUC (i + 1));
+            eager.updateItem (item, false, false);
+            lazy.updateItem (item, false, false);
+        }
+
+        for (int i = 1; i < 2000; i += 7)
+        {
+            eager.delItem (makeKey (i));
+            lazy.delItem (makeKey (i));
+        }
+
+        boost::shared_ptr <SHAMap::NodeMap> const dirty (lazy.disarmDirty ());
+        expect (lazy.getHash () == eager.getHash (), "hash after changes");
+
+        bool ok (true);
+        BOOST_FOREACH (SHAMap::NodeMap::value_type const& entry, *dirty)
+        {
+            Serializer s;
+            entry.second->addRaw (s, snfPREFIX);
+            if (entry.second->isHashStale () ||
+                (s.getSHA512Half () != entry.second->getNodeHash ()))
+                ok = false;
+        }
+        expect (ok, "dirty nodes must be hashed");
     }
 };
 
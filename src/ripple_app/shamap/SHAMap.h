@@ -128,14 +128,7 @@ public:
     bool addItem (const SHAMapItem & i, bool isTransaction, bool hasMeta);
     bool updateItem (const SHAMapItem & i, bool isTransaction, bool hasMeta);
     SHAMapItem getItem (uint256 const & id);
-    uint256 getHash () const
-    {
-        return root->getNodeHash ();
-    }
-    uint256 getHash ()
-    {
-        return root->getNodeHash ();
-    }
+    uint256 getHash ();
 
     // save a copy if you have a temporary anyway
     bool updateGiveItem (SHAMapItem::ref, bool isTransaction, bool hasMeta);
@@ -155,9 +148,13 @@ public:
     SHAMapItem::pointer peekPrevItem (uint256 const& );
     void visitLeaves(std::function<void (SHAMapItem::ref)>);
 
+    // Calls the function for every node held in memory, in no particular order
+    void visitNodes (std::function<void (SHAMapTreeNode&)> const& function);
+
     // comparison/sync functions
     void getMissingNodes (std::vector<SHAMapNode>& nodeIDs, std::vector<uint256>& hashes, int max,
-                          SHAMapSyncFilter * filter);
+                          SHAMapSyncFilter * filter,
+                          NodeStore::ReadPriority priority = NodeStore::readNormal);
     bool getNodeFat (const SHAMapNode & node, std::vector<SHAMapNode>& nodeIDs,
                      std::list<Blob >& rawNode, bool fatRoot, bool fatLeaves);
     bool getRootNode (Serializer & s, SHANodeFormat format);
@@ -169,6 +166,11 @@ public:
     SHAMapAddNode addKnownNode (const SHAMapNode & nodeID, Blob const & rawNode,
                                 SHAMapSyncFilter * filter);
 
+    // Add a node already built from wire data, so the costly hashing
+    // can be done before the map is locked
+    SHAMapAddNode addKnownNode (const SHAMapNode & nodeID, SHAMapTreeNode::ref node,
+                                SHAMapSyncFilter * filter);
+
     // status functions
     void setImmutable ()
     {
@@ -204,6 +206,12 @@ public:
     // return value: true=successfully completed, false=too different
     bool compare (SHAMap::ref otherMap, Delta & differences, int maxCount);
 
+    /** Start tracking modified nodes.
+        Until disarmDirty is called, inner nodes changed by modifications
+        are not rehashed right away. Their hashes are computed once, in
+        parallel across the top level branches, when the hash is next
+        needed. The map must only be used by one thread while armed.
+    */
     int armDirty ();
     static int flushDirty (NodeMap & dirtyMap, int maxNodes, NodeObjectType t,
                            std::uint32_t seq);
@@ -223,7 +231,7 @@ public:
     SHAMapTreeNode::pointer fetchNodeExternal (const SHAMapNode & id, uint256 const & hash); // throws
     SHAMapTreeNode::pointer fetchNodeExternalNT (const SHAMapNode & id, uint256 const & hash); // no throw
 
-    bool operator== (const SHAMap & s)
+    bool operator== (SHAMap & s)
     {
         return getHash () == s.getHash ();
     }
@@ -235,6 +243,13 @@ public:
 
     void walkMap (std::vector<SHAMapMissingNode>& missingNodes, int maxMissing);
 
+    /** Call the function for every node in the map, parents before children.
+        Nodes that are not in memory are read without adding them to the
+        map. The walk stops early if the function returns false.
+        Throws SHAMapMissingNode if a node is not available.
+    */
+    void walkNodes (std::function <bool (SHAMapTreeNode&)> const& function);
+
     bool getPath (uint256 const & index, std::vector< Blob >& nodes, SHANodeFormat format);
 
     bool deepCompare (SHAMap & other);
@@ -263,6 +278,11 @@ public:
         treeNodeCache.sweep ();
     }
 
+    static void clearTreeCache ()
+    {
+        treeNodeCache.clear ();
+    }
+
     static void setTreeCache (int size, int age)
     {
         treeNodeCache.setTargetSize (size);
@@ -277,9 +297,14 @@ public:
     typedef std::pair<uint256, SHAMapNode> TNIndex;
 
 private:
-    static TaggedCache <uint256, SHAMapTreeNode> treeNodeCache;
+    static ShardedTaggedCache <uint256, SHAMapTreeNode> treeNodeCache;
 
     void dirtyUp (std::stack<SHAMapTreeNode::pointer>& stack, uint256 const & target, uint256 prevHash);
+    bool setChildHash (SHAMapTreeNode& node, int branch, uint256 const& hash);
+    SHAMapTreeNode* getStaleChild (SHAMapTreeNode& node, int branch);
+    void updateHashes ();
+    void updateHashes (SHAMapTreeNode& node);
+    void updateHashes (ScopedReadLockType& sl);
     std::stack<SHAMapTreeNode::pointer> getStack (uint256 const & id, bool include_nonmatching_leaf);
     SHAMapTreeNode::pointer walkTo (uint256 const & id, bool modify);
     SHAMapTreeNode* walkToPointer (uint256 const & id);
@@ -299,7 +324,8 @@ private:
 
     // Non-blocking version of getNodePointerNT
     SHAMapTreeNode* getNodeAsync (
-        const SHAMapNode & id, uint256 const & hash, SHAMapSyncFilter * filter, bool& pending);
+        const SHAMapNode & id, uint256 const & hash, SHAMapSyncFilter * filter,
+        NodeStore::PendingReads& reads, NodeStore::ReadPriority priority, bool& pending);
 
     SHAMapItem::pointer onlyBelow (SHAMapTreeNode*);
     void eraseChildren (SHAMapTreeNode::pointer);
@@ -307,6 +333,10 @@ private:
     bool hasInnerNode (const SHAMapNode & nodeID, uint256 const & hash);
     bool hasLeafNode (uint256 const & tag, uint256 const & hash);
 
+    // Either the raw data or an already built node is supplied
+    SHAMapAddNode addKnownNode (const SHAMapNode & nodeID, Blob const * rawNode,
+                                SHAMapTreeNode::pointer newNode, SHAMapSyncFilter * filter);
+
     bool walkBranch (SHAMapTreeNode * node, SHAMapItem::ref otherMapItem, bool isFirstMap,
                      Delta & differences, int & maxCount);
 
@@ -328,6 +358,7 @@ private:
     SHAMapState mState;
     SHAMapType mType;
     bool mTXMap;       // Map of transactions without metadata
+    bool mDeferHashes; // Inner node hashes are computed lazily
     MissingNodeHandler m_missing_node_handler;
 };
 
@@ -142,10 +142,15 @@ bool SHAMap::compare (SHAMap::ref otherMap, Delta& differences, int maxCount)
 
     ScopedReadLockType sl (mLock);
 
-    if (getHash () == otherMap->getHash ())
+    updateHashes (sl);
+
+    uint256 const ourHash (root->getNodeHash ());
+    uint256 const otherHash (otherMap->getHash ());
+
+    if (ourHash == otherHash)
         return true;
 
-    nodeStack.push (SHAMapDeltaNode (SHAMapNode (), getHash (), otherMap->getHash ()));
+    nodeStack.push (SHAMapDeltaNode (SHAMapNode (), ourHash, otherHash));
 
     while (!nodeStack.empty ())
     {
@@ -271,4 +276,54 @@ void SHAMap::walkMap (std::vector<SHAMapMissingNode>& missingNodes, int maxMissi
     }
 }
 
+void SHAMap::walkNodes (std::function <bool (SHAMapTreeNode&)> const& function)
+{
+    // Depth first, so only a path's worth of siblings is held at once
+    std::stack<SHAMapTreeNode::pointer> nodeStack;
+
+    ScopedReadLockType sl (mLock);
+
+    nodeStack.push (root);
+
+    while (!nodeStack.empty ())
+    {
+        SHAMapTreeNode::pointer node = nodeStack.top ();
+        nodeStack.pop ();
+
+        if (!function (*node))
+            return;
+
+        if (!node->isInner ())
+            continue;
+
+        // Push in reverse so the branches come out in order
+        for (int i = 15; i >= 0; --i)
+        {
+            if (node->isEmptyBranch (i))
+                continue;
+
+            SHAMapNode const childID (node->getChildNodeID (i));
+            uint256 const& childHash (node->getChildHash (i));
+
+            SHAMapTreeNode::pointer child (mTNByID.retrieve (childID));
+
+            if (!child)
+                child = getCache (childHash, childID);
+
+            if (!child)
+            {
+                NodeObject::pointer obj (getApp ().getNodeStore ().fetch (childHash));
+
+                if (!obj)
+                    throw SHAMapMissingNode (mType, childID, childHash);
+
+                child = boost::make_shared<SHAMapTreeNode> (childID,
+                    obj->getData (), 0, snfPREFIX, childHash, true);
+            }
+
+            nodeStack.push (child);
+        }
+    }
+}
+
 } // ripple
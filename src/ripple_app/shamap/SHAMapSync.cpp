@@ -32,6 +32,14 @@ void SHAMap::visitLeaves (std::function<void (SHAMapItem::ref item)> function)
     snapShot (false)->visitLeavesInternal (function);
 }
 
+void SHAMap::visitNodes (std::function<void (SHAMapTreeNode&)> const& function)
+{
+    ScopedReadLockType sl (mLock);
+
+    for (auto const& entry : mTNByID.peekMap ())
+        function (*entry.second);
+}
+
 void SHAMap::visitLeavesInternal (std::function<void (SHAMapItem::ref item)>& function)
 {
     assert (root->isValid ());
@@ -116,7 +124,7 @@ public:
     The filter can hold alternate sources of nodes that are not permanently stored locally
 */
 void SHAMap::getMissingNodes (std::vector<SHAMapNode>& nodeIDs, std::vector<uint256>& hashes, int max,
-                              SHAMapSyncFilter* filter)
+                              SHAMapSyncFilter* filter, NodeStore::ReadPriority priority)
 {
     ScopedReadLockType sl (mLock);
 
@@ -136,7 +144,7 @@ void SHAMap::getMissingNodes (std::vector<SHAMapNode>& nodeIDs, std::vector<uint
         return;
     }
 
-    int const maxDefer = getApp().getNodeStore().getDesiredAsyncReadCount ();
+    int const maxDefer = getApp().getNodeStore().getDesiredAsyncReadCount (priority);
 
     // Track the missing hashes we have found so far
     std::set <uint256> missingHashes;
@@ -147,6 +155,10 @@ void SHAMap::getMissingNodes (std::vector<SHAMapNode>& nodeIDs, std::vector<uint
         std::vector <std::pair <SHAMapNode, uint256>> deferredReads;
         deferredReads.reserve (maxDefer + 16);
 
+        // Completion tracking for the reads deferred during this pass
+        NodeStore::PendingReads::pointer const reads (
+            NodeStore::PendingReads::New ());
+
         std::stack <GMNEntry> stack;
 
         // Traverse the map without blocking
@@ -169,7 +181,8 @@ void SHAMap::getMissingNodes (std::vector<SHAMapNode>& nodeIDs, std::vector<uint
                     {
                         SHAMapNode childID = node->getChildNodeID (branch);
                         bool pending = false;
-                        SHAMapTreeNode* d = getNodeAsync (childID, childHash, filter, pending);
+                        SHAMapTreeNode* d = getNodeAsync (childID, childHash, filter,
+                            *reads, priority, pending);
 
                         if (!d)
                         {
@@ -234,7 +247,7 @@ void SHAMap::getMissingNodes (std::vector<SHAMapNode>& nodeIDs, std::vector<uint
         if (deferredReads.empty ())
             break;
 
-        getApp().getNodeStore().waitReads();
+        reads->wait ();
 
         // Process all deferred reads
         for (auto const& node : deferredReads)
@@ -417,6 +430,17 @@ SHAMapAddNode SHAMap::addRootNode (uint256 const& hash, Blob const& rootNode, SH
 }
 
 SHAMapAddNode SHAMap::addKnownNode (const SHAMapNode& node, Blob const& rawNode, SHAMapSyncFilter* filter)
+{
+    return addKnownNode (node, &rawNode, SHAMapTreeNode::pointer (), filter);
+}
+
+SHAMapAddNode SHAMap::addKnownNode (const SHAMapNode& node, SHAMapTreeNode::ref newNode, SHAMapSyncFilter* filter)
+{
+    return addKnownNode (node, nullptr, newNode, filter);
+}
+
+SHAMapAddNode SHAMap::addKnownNode (const SHAMapNode& node, Blob const* rawNode,
+    SHAMapTreeNode::pointer newNode, SHAMapSyncFilter* filter)
 {
     ScopedWriteLockType sl (mLock);
 
@@ -461,8 +485,8 @@ SHAMapAddNode SHAMap::addKnownNode (const SHAMapNode& node, Blob const& rawNode,
                 return SHAMapAddNode::invalid ();
             }
 
-            SHAMapTreeNode::pointer newNode =
-                boost::make_shared<SHAMapTreeNode> (node, rawNode, 0, snfWIRE, uZero, false);
+            if (!newNode)
+                newNode = boost::make_shared<SHAMapTreeNode> (node, *rawNode, 0, snfWIRE, uZero, false);
 
             if (iNode->getChildHash (branch) != newNode->getNodeHash ())
             {
@@ -19,6 +19,24 @@
 
 namespace ripple {
 
+uint256 const SHAMapTreeNode::sZeroHash;
+
+// Nodes with more branches than this are dense enough that direct
+// indexing is worth the extra memory. This matches the cutoff used
+// for the compressed wire format.
+int SHAMapTreeNode::sSparseLimit = 12;
+
+int SHAMapTreeNode::setSparseLimit (int limit)
+{
+    int const previous = sSparseLimit;
+
+    // A full node looks the same in either layout, and a capacity
+    // of 16 is how the full layout is recognized.
+    sSparseLimit = std::min (limit, 15);
+
+    return previous;
+}
+
 SHAMapTreeNode::SHAMapTreeNode (std::uint32_t seq, const SHAMapNode& nodeID)
     : SHAMapNode (nodeID)
     , mHash (std::uint64_t(0))
@@ -26,22 +44,35 @@ SHAMapTreeNode::SHAMapTreeNode (std::uint32_t seq, const SHAMapNode& nodeID)
     , mAccessSeq (seq)
     , mType (tnERROR)
     , mIsBranch (0)
+    , mCapacity (0)
     , mFullBelow (false)
+    , mHashStale (false)
 {
 }
 
 SHAMapTreeNode::SHAMapTreeNode (const SHAMapTreeNode& node, std::uint32_t seq) : SHAMapNode (node),
-    mHash (node.mHash), mSeq (seq), mType (node.mType), mIsBranch (node.mIsBranch), mFullBelow (false)
+    mHash (node.mHash), mSeq (seq), mType (node.mType), mIsBranch (node.mIsBranch), mCapacity (0),
+    mFullBelow (false), mHashStale (node.mHashStale)
 {
     if (node.mItem)
         mItem = node.mItem;
-    else
-        memcpy (mHashes, node.mHashes, sizeof (mHashes));
+    else if (node.mCapacity != 0)
+    {
+        // Keep the layout of the original, but drop any unused capacity
+        mCapacity = (node.mCapacity == 16) ? 16 : countBranches (mIsBranch);
+
+        if (mCapacity != 0)
+        {
+            mHashes.reset (new uint256 [mCapacity]);
+            std::copy (node.mHashes.get (), node.mHashes.get () + mCapacity, mHashes.get ());
+        }
+    }
 }
 
 SHAMapTreeNode::SHAMapTreeNode (const SHAMapNode& node, SHAMapItem::ref item,
                                 TNType type, std::uint32_t seq) :
-    SHAMapNode (node), mItem (item), mSeq (seq), mType (type), mIsBranch (0), mFullBelow (false)
+    SHAMapNode (node), mItem (item), mSeq (seq), mType (type), mIsBranch (0), mCapacity (0),
+    mFullBelow (false), mHashStale (false)
 {
     assert (item->peekData ().size () >= 12);
     updateHash ();
@@ -49,7 +80,8 @@ SHAMapTreeNode::SHAMapTreeNode (const SHAMapNode& node, SHAMapItem::ref item,
 
 SHAMapTreeNode::SHAMapTreeNode (const SHAMapNode& id, Blob const& rawNode, std::uint32_t seq,
                                 SHANodeFormat format, uint256 const& hash, bool hashValid) :
-    SHAMapNode (id), mSeq (seq), mType (tnERROR), mIsBranch (0), mFullBelow (false)
+    SHAMapNode (id), mSeq (seq), mType (tnERROR), mIsBranch (0), mCapacity (0), mFullBelow (false),
+    mHashStale (false)
 {
     if (format == snfWIRE)
     {
@@ -94,19 +126,19 @@ SHAMapTreeNode::SHAMapTreeNode (const SHAMapNode& id, Blob const& rawNode, std::
             if (len != 512)
                 throw std::runtime_error ("invalid FI node");
 
-            for (int i = 0; i < 16; ++i)
-            {
-                s.get256 (mHashes[i], i * 32);
+            uint256 hashes[16];
 
-                if (mHashes[i].isNonZero ())
-                    mIsBranch |= (1 << i);
-            }
+            for (int i = 0; i < 16; ++i)
+                s.get256 (hashes[i], i * 32);
 
+            setChildHashes (hashes);
             mType = tnINNER;
         }
         else if (type == 3)
         {
             // compressed inner
+            uint256 hashes[16];
+
             for (int i = 0; i < (len / 33); ++i)
             {
                 int pos;
@@ -114,12 +146,10 @@ SHAMapTreeNode::SHAMapTreeNode (const SHAMapNode& id, Blob const& rawNode, std::
 
                 if ((pos < 0) || (pos >= 16)) throw std::runtime_error ("invalid CI node");
 
-                s.get256 (mHashes[pos], i * 33);
-
-                if (mHashes[pos].isNonZero ())
-                    mIsBranch |= (1 << pos);
+                s.get256 (hashes[pos], i * 33);
             }
 
+            setChildHashes (hashes);
             mType = tnINNER;
         }
         else if (type == 4)
@@ -185,14 +215,12 @@ SHAMapTreeNode::SHAMapTreeNode (const SHAMapNode& id, Blob const& rawNode, std::
             if (s.getLength () != 512)
                 throw std::runtime_error ("invalid PIN node");
 
-            for (int i = 0; i < 16; ++i)
-            {
-                s.get256 (mHashes[i], i * 32);
+            uint256 hashes[16];
 
-                if (mHashes[i].isNonZero ())
-                    mIsBranch |= (1 << i);
-            }
+            for (int i = 0; i < 16; ++i)
+                s.get256 (hashes[i], i * 32);
 
+            setChildHashes (hashes);
             mType = tnINNER;
         }
         else if (prefix == HashPrefix::txNode)
@@ -235,18 +263,30 @@ SHAMapTreeNode::SHAMapTreeNode (const SHAMapNode& id, Blob const& rawNode, std::
 bool SHAMapTreeNode::updateHash ()
 {
     uint256 nh;
+    mHashStale = false;
 
     if (mType == tnINNER)
     {
         if (mIsBranch != 0)
         {
-            nh = Serializer::getPrefixHash (HashPrefix::innerNode, reinterpret_cast<unsigned char*> (mHashes), sizeof (mHashes));
+            if (mCapacity == 16)
+            {
+                nh = Serializer::getPrefixHash (HashPrefix::innerNode,
+                    reinterpret_cast<unsigned char*> (mHashes.get ()), 16 * sizeof (uint256));
+            }
+            else
+            {
+                uint256 hashes[16];
+                getChildHashes (hashes);
+                nh = Serializer::getPrefixHash (HashPrefix::innerNode,
+                    reinterpret_cast<unsigned char*> (hashes), sizeof (hashes));
+            }
 #if RIPPLE_VERIFY_NODEOBJECT_KEYS
             Serializer s;
             s.add32 (HashPrefix::innerNode);
 
             for (int i = 0; i < 16; ++i)
-                s.add256 (mHashes[i]);
+                s.add256 (getChildHash (i));
 
             assert (nh == s.getSHA512Half ());
 #endif
@@ -304,7 +344,7 @@ void SHAMapTreeNode::addRaw (Serializer& s, SHANodeFormat format)
             s.add32 (HashPrefix::innerNode);
 
             for (int i = 0; i < 16; ++i)
-                s.add256 (mHashes[i]);
+                s.add256 (getChildHash (i));
         }
         else
         {
@@ -314,7 +354,7 @@ void SHAMapTreeNode::addRaw (Serializer& s, SHANodeFormat format)
                 for (int i = 0; i < 16; ++i)
                     if (!isEmptyBranch (i))
                     {
-                        s.add256 (mHashes[i]);
+                        s.add256 (getChildHash (i));
                         s.add8 (i);
                     }
 
@@ -323,7 +363,7 @@ void SHAMapTreeNode::addRaw (Serializer& s, SHANodeFormat format)
             else
             {
                 for (int i = 0; i < 16; ++i)
-                    s.add256 (mHashes[i]);
+                    s.add256 (getChildHash (i));
 
                 s.add8 (2);
             }
@@ -393,20 +433,15 @@ bool SHAMapTreeNode::isEmpty () const
 int SHAMapTreeNode::getBranchCount () const
 {
     assert (isInner ());
-    int count = 0;
-
-    for (int i = 0; i < 16; ++i)
-        if (!isEmptyBranch (i))
-            ++count;
-
-    return count;
+    return countBranches (mIsBranch);
 }
 
 void SHAMapTreeNode::makeInner ()
 {
     mItem.reset ();
     mIsBranch = 0;
-    memset (mHashes, 0, sizeof (mHashes));
+    mHashes.reset ();
+    mCapacity = 0;
     mType = tnINNER;
     mHash.zero ();
 }
@@ -432,7 +467,7 @@ std::string SHAMapTreeNode::getString () const
                 ret += "\nb";
                 ret += beast::lexicalCastThrow <std::string> (i);
                 ret += " = ";
-                ret += mHashes[i].GetHex ();
+                ret += getChildHash (i).GetHex ();
             }
     }
 
@@ -464,17 +499,168 @@ bool SHAMapTreeNode::setChildHash (int m, uint256 const& hash)
     assert (mType == tnINNER);
     assert (mSeq != 0);
 
-    if (mHashes[m] == hash)
+    if (getChildHash (m) == hash)
         return false;
 
-    mHashes[m] = hash;
+    replaceBranch (m, hash);
+    return updateHash ();
+}
+
+bool SHAMapTreeNode::setChildHashDeferred (int m, uint256 const& hash)
+{
+    assert ((m >= 0) && (m < 16));
+    assert (mType == tnINNER);
+    assert (mSeq != 0);
+
+    bool const changed = (getChildHash (m) != hash);
+
+    if (changed)
+        replaceBranch (m, hash);
+
+    if (mHash.isZero ())
+        updateHash ();
+
+    mHashStale = true;
+    return changed;
+}
+
+void SHAMapTreeNode::setStaleHash (uint256 const& hash)
+{
+    assert (mType == tnINNER);
+    assert (mHashStale);
+    assert (mIsBranch != 0);
+
+    mHash = hash;
+    mHashStale = false;
+
+#if RIPPLE_VERIFY_NODEOBJECT_KEYS
+    uint256 const batchHash (mHash);
+    updateHash ();
+    assert (mHash == batchHash);
+#endif
+}
+
+void SHAMapTreeNode::setChildHashes (uint256 const (&hashes)[16])
+{
+    mIsBranch = 0;
 
-    if (hash.isNonZero ())
+    for (int i = 0; i < 16; ++i)
+        if (hashes[i].isNonZero ())
+            mIsBranch |= (1 << i);
+
+    int const count = countBranches (mIsBranch);
+
+    if (count == 0)
+    {
+        mHashes.reset ();
+        mCapacity = 0;
+    }
+    else if (count > sSparseLimit)
+    {
+        mHashes.reset (new uint256 [16]);
+        mCapacity = 16;
+        std::copy (hashes, hashes + 16, mHashes.get ());
+    }
+    else
+    {
+        mHashes.reset (new uint256 [count]);
+        mCapacity = count;
+
+        for (int i = 0, j = 0; i < 16; ++i)
+            if (!isEmptyBranch (i))
+                mHashes[j++] = hashes[i];
+    }
+}
+
+void SHAMapTreeNode::getChildHashes (uint256 (&hashes)[16]) const
+{
+    if (mCapacity == 16)
+    {
+        std::copy (mHashes.get (), mHashes.get () + 16, hashes);
+    }
+    else
+    {
+        for (int i = 0, j = 0; i < 16; ++i)
+        {
+            if (!isEmptyBranch (i))
+                hashes[i] = mHashes[j++];
+            else
+                hashes[i].zero ();
+        }
+    }
+}
+
+void SHAMapTreeNode::replaceBranch (int m, uint256 const& hash)
+{
+    if (hash.isZero ())
+        removeBranch (m);
+    else if (isEmptyBranch (m))
+        addBranch (m, hash);
+    else
+        mHashes[getBranchIndex (m)] = hash;
+}
+
+void SHAMapTreeNode::addBranch (int m, uint256 const& hash)
+{
+    assert (isEmptyBranch (m) && hash.isNonZero ());
+
+    if (mCapacity == 16)
+    {
+        mHashes[m] = hash;
         mIsBranch |= (1 << m);
+        return;
+    }
+
+    int const count = countBranches (mIsBranch);
+
+    if (count >= sSparseLimit)
+    {
+        // Too many branches for the sparse layout
+        uint256 hashes[16];
+        getChildHashes (hashes);
+        hashes[m] = hash;
+        setChildHashes (hashes);
+        return;
+    }
+
+    int const index = getBranchIndex (m);
+
+    if (count == mCapacity)
+    {
+        std::unique_ptr <uint256 []> hashes (new uint256 [count + 1]);
+        std::copy (mHashes.get (), mHashes.get () + index, hashes.get ());
+        std::copy (mHashes.get () + index, mHashes.get () + count, hashes.get () + index + 1);
+        mHashes = std::move (hashes);
+        mCapacity = count + 1;
+    }
     else
-        mIsBranch &= ~ (1 << m);
+    {
+        std::copy_backward (mHashes.get () + index, mHashes.get () + count,
+            mHashes.get () + count + 1);
+    }
 
-    return updateHash ();
+    mHashes[index] = hash;
+    mIsBranch |= (1 << m);
+}
+
+void SHAMapTreeNode::removeBranch (int m)
+{
+    assert (!isEmptyBranch (m));
+
+    if (mCapacity == 16)
+    {
+        mHashes[m].zero ();
+    }
+    else
+    {
+        // Keep the capacity, the branch may well be filled again
+        int const count = countBranches (mIsBranch);
+        int const index = getBranchIndex (m);
+        std::copy (mHashes.get () + index + 1, mHashes.get () + count, mHashes.get () + index);
+        mHashes[count - 1].zero ();
+    }
+
+    mIsBranch &= ~ (1 << m);
 }
 
 } // ripple
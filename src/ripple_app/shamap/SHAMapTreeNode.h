@@ -122,6 +122,19 @@ public:
         return !mItem;
     }
     bool setChildHash (int m, uint256 const & hash);
+
+    /** Change a child hash without recomputing this node's hash.
+        The node is marked stale until its hash is next computed. A node
+        that was never hashed is hashed immediately, so that a populated
+        branch never links to a zero hash.
+        @return `true` if the child hash changed.
+    */
+    bool setChildHashDeferred (int m, uint256 const & hash);
+    bool isHashStale () const
+    {
+        return mHashStale;
+    }
+
     bool isEmptyBranch (int m) const
     {
         return (mIsBranch & (1 << m)) == 0;
@@ -132,9 +145,30 @@ public:
     uint256 const& getChildHash (int m) const
     {
         assert ((m >= 0) && (m < 16) && (mType == tnINNER));
-        return mHashes[m];
+
+        if (isEmptyBranch (m))
+            return sZeroHash;
+
+        return mHashes[getBranchIndex (m)];
     }
 
+    /** Returns the number of bytes used by this node.
+        This includes the child hashes but not the item.
+    */
+    std::size_t getMemoryUsage () const
+    {
+        return sizeof (*this) + mCapacity * sizeof (uint256);
+    }
+
+    /** Set the largest branch count stored in the sparse layout.
+        Inner nodes with more branches than this are converted to the
+        full layout, which indexes the sixteen hashes directly. A limit
+        of zero makes every inner node use the full layout.
+        This only affects nodes that change after the call.
+        @return The previous limit.
+    */
+    static int setSparseLimit (int limit);
+
     // item node function
     bool hasItem () const
     {
@@ -175,15 +209,52 @@ private:
     // VFALCO TODO remove the use of friend
     friend class SHAMap;
 
+    static uint256 const sZeroHash;
+    static int sSparseLimit;
+
+    // Inner nodes keep their child hashes in one of two layouts. When
+    // mCapacity is 16 the array holds all sixteen hashes, indexed by
+    // branch. Otherwise it holds only the populated branches, in branch
+    // order, and a branch is found by counting the bits below it in
+    // mIsBranch. Most inner nodes in a large tree have only a few
+    // branches, so this saves a lot of memory.
+    //
     uint256             mHash;
-    uint256             mHashes[16];
+    std::unique_ptr <uint256 []> mHashes;
     SHAMapItem::pointer mItem;
     std::uint32_t       mSeq, mAccessSeq;
     TNType              mType;
     int                 mIsBranch;
+    std::uint8_t        mCapacity;
     bool                mFullBelow;
+    bool                mHashStale;
 
+    static int countBranches (int mask)
+    {
+        mask = mask - ((mask >> 1) & 0x5555);
+        mask = (mask & 0x3333) + ((mask >> 2) & 0x3333);
+        mask = (mask + (mask >> 4)) & 0x0f0f;
+        return (mask + (mask >> 8)) & 0x1f;
+    }
+
+    // Returns the position of a populated branch in mHashes
+    int getBranchIndex (int m) const
+    {
+        if (mCapacity == 16)
+            return m;
+
+        return countBranches (mIsBranch & ((1 << m) - 1));
+    }
+
+    void setChildHashes (uint256 const (&hashes)[16]);
+    void getChildHashes (uint256 (&hashes)[16]) const;
+    void replaceBranch (int m, uint256 const& hash);
+    void addBranch (int m, uint256 const& hash);
+    void removeBranch (int m);
     bool updateHash ();
+
+    // Stores the hash of a stale inner node that was computed in a batch
+    void setStaleHash (uint256 const& hash);
 };
 
 } // ripple
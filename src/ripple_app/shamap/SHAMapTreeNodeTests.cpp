@@ -0,0 +1,261 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include "../../beast/beast/unit_test/suite.h"
+
+#include <chrono>
+#include <sstream>
+
+namespace ripple {
+
+// Checks that the sparse and full inner node layouts behave identically
+//
+class SHAMapTreeNode_test : public beast::unit_test::suite
+{
+public:
+    // Restores the sparse limit when it goes out of scope
+    class ScopedSparseLimit
+    {
+    public:
+        explicit ScopedSparseLimit (int limit)
+            : m_previous (SHAMapTreeNode::setSparseLimit (limit))
+        {
+        }
+
+        ~ScopedSparseLimit ()
+        {
+            SHAMapTreeNode::setSparseLimit (m_previous);
+        }
+
+    private:
+        int m_previous;
+    };
+
+    static uint256 makeHash (beast::Random& r)
+    {
+        uint256 hash;
+        r.fillBitsRandomly (hash.begin (), hash.size ());
+        return hash;
+    }
+
+    static uint256 expectedHash (uint256 const (&hashes)[16])
+    {
+        uint256 result;
+        Serializer s;
+        s.add32 (HashPrefix::innerNode);
+
+        bool empty (true);
+        for (int i = 0; i < 16; ++i)
+        {
+            s.add256 (hashes[i]);
+            if (hashes[i].isNonZero ())
+                empty = false;
+        }
+
+        if (!empty)
+            result = s.getSHA512Half ();
+
+        return result;
+    }
+
+    bool matches (SHAMapTreeNode const& node, uint256 const (&hashes)[16])
+    {
+        for (int i = 0; i < 16; ++i)
+        {
+            if (node.getChildHash (i) != hashes[i])
+                return false;
+
+            if (node.isEmptyBranch (i) != hashes[i].isZero ())
+                return false;
+        }
+
+        return node.getNodeHash () == expectedHash (hashes);
+    }
+
+    void testLayout (int limit)
+    {
+        testcase ("layout, sparse limit " + std::to_string (limit));
+
+        ScopedSparseLimit const scope (limit);
+        beast::Random r (limit);
+
+        SHAMapTreeNode node (1, SHAMapNode ());
+        node.makeInner ();
+
+        uint256 hashes[16];
+        bool ok (true);
+
+        for (int i = 0; i < 2000; ++i)
+        {
+            int const branch (r.nextInt (16));
+
+            // Favor filling so that nodes pass through every branch count
+            if (r.nextInt (3) != 0)
+                hashes[branch] = makeHash (r);
+            else
+                hashes[branch].zero ();
+
+            node.setChildHash (branch, hashes[branch]);
+
+            if (!matches (node, hashes))
+                ok = false;
+
+            SHAMapTreeNode const copy (node, 2);
+
+            if (!matches (copy, hashes))
+                ok = false;
+        }
+
+        expect (ok, "Child hashes must match the reference");
+    }
+
+    void testRoundTrip ()
+    {
+        testcase ("round trip");
+
+        beast::Random r (42);
+
+        for (int count = 1; count <= 16; ++count)
+        {
+            SHAMapTreeNode node (1, SHAMapNode ());
+            node.makeInner ();
+
+            uint256 hashes[16];
+            for (int i = 0; i < count; ++i)
+            {
+                hashes[i] = makeHash (r);
+                node.setChildHash (i, hashes[i]);
+            }
+
+            expect (node.getBranchCount () == count);
+
+            Serializer wire;
+            node.addRaw (wire, snfWIRE);
+            SHAMapTreeNode const fromWire (SHAMapNode (), wire.peekData (),
+                0, snfWIRE, uint256 (), false);
+            expect (matches (fromWire, hashes), "Wire round trip");
+
+            Serializer prefix;
+            node.addRaw (prefix, snfPREFIX);
+            SHAMapTreeNode const fromPrefix (SHAMapNode (), prefix.peekData (),
+                0, snfPREFIX, uint256 (), false);
+            expect (matches (fromPrefix, hashes), "Prefix round trip");
+        }
+    }
+
+    void run ()
+    {
+        testLayout (0);
+        testLayout (4);
+        testLayout (12);
+        testLayout (16);
+        testRoundTrip ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(SHAMapTreeNode,ripple_app,ripple);
+
+//------------------------------------------------------------------------------
+
+// Compares memory use and traversal speed of the inner node layouts
+//
+class SHAMapTreeNode_timing_test : public beast::unit_test::suite
+{
+public:
+    enum
+    {
+        tableItems = 250000,
+        traversals = 5
+    };
+
+    typedef std::chrono::steady_clock clock_type;
+
+    static double elapsed (clock_type::time_point start)
+    {
+        return std::chrono::duration_cast <std::chrono::duration <double>> (
+            clock_type::now () - start).count ();
+    }
+
+    void measure (std::string const& name, int limit)
+    {
+        using namespace RadixMap;
+
+        SHAMapTreeNode_test::ScopedSparseLimit const scope (limit);
+
+        FullBelowCache fullBelowCache ("test.full_below",
+            get_seconds_clock ());
+        Table t (smtFREE, fullBelowCache);
+
+        // The same seed builds the same tree for every layout
+        beast::Random r (1);
+        clock_type::time_point start (clock_type::now ());
+        add_random_items (tableItems, t, r);
+        uint256 const hash (t.getHash ());
+        double const buildTime (elapsed (start));
+
+        std::size_t innerNodes (0);
+        std::size_t innerBytes (0);
+        std::size_t totalBytes (0);
+        t.visitNodes ([&] (SHAMapTreeNode& node)
+        {
+            totalBytes += node.getMemoryUsage ();
+            if (node.isInner ())
+            {
+                ++innerNodes;
+                innerBytes += node.getMemoryUsage ();
+            }
+        });
+
+        start = clock_type::now ();
+        std::size_t items (0);
+        for (int i = 0; i < traversals; ++i)
+        {
+            for (SHAMapItem::pointer item (t.peekFirstItem ()); item;
+                item = t.peekNextItem (item->getTag ()))
+            {
+                ++items;
+            }
+        }
+        double const traverseTime (elapsed (start));
+
+        expect (items == tableItems * traversals);
+
+        std::stringstream ss;
+        ss << name << ": " <<
+            innerNodes << " inner nodes, " <<
+            (innerBytes / innerNodes) << " bytes/inner node, " <<
+            (totalBytes / 1024) << "KB in nodes, " <<
+            "build " << buildTime << "s, " <<
+            "traverse " << (traverseTime / traversals) << "s, " <<
+            "root " << hash.GetHex ().substr (0, 8);
+        log << ss.str ();
+    }
+
+    void run ()
+    {
+        testcase ("layouts");
+        measure ("full", 0);
+        measure ("sparse", 16);
+        measure ("default", 12);
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(SHAMapTreeNode_timing,ripple_app,ripple);
+
+}
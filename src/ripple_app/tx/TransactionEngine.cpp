@@ -28,7 +28,7 @@ SETUP_LOG (TransactionEngine)
 void TransactionEngine::txnWrite ()
 {
     // Write back the account states
-    typedef std::map<uint256, LedgerEntrySetEntry>::value_type u256_LES_pair;
+    typedef LedgerEntrySet::value_type u256_LES_pair;
     BOOST_FOREACH (u256_LES_pair & it, mNodes)
     {
         SLE::ref    sleEntry    = it.second.mEntry;
@@ -0,0 +1,272 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include "../../beast/beast/unit_test/suite.h"
+
+namespace ripple {
+
+class TxVerifierImp
+    : public TxVerifier
+    , public beast::LeakChecked <TxVerifierImp>
+{
+public:
+    typedef std::chrono::steady_clock clock_type;
+
+    // Transactions checked by one job before it yields its thread
+    static std::size_t const batchSize = 32;
+
+    struct Item
+    {
+        SerializedTransaction::pointer txn;
+        Handler handler;
+        clock_type::time_point queued;
+        bool valid;
+    };
+
+    JobQueue& m_jobQueue;
+    int const m_workers;
+
+    std::mutex m_mutex;
+    std::deque <Item> m_queue;
+    int m_active;
+
+    beast::insight::Collector::ptr m_collector;
+    beast::insight::Gauge m_depth;
+    beast::insight::Event m_waitTime;
+    beast::insight::Event m_verifyTime;
+    beast::insight::Hook m_hook;
+
+    //--------------------------------------------------------------------------
+
+    TxVerifierImp (JobQueue& jobQueue,
+        beast::insight::Collector::ptr const& collector, int workers)
+        : m_jobQueue (jobQueue)
+        , m_workers (std::max (1, workers))
+        , m_active (0)
+        , m_collector (collector)
+    {
+        m_depth = m_collector->make_gauge ("queue_depth");
+        m_waitTime = m_collector->make_event ("wait_time");
+        m_verifyTime = m_collector->make_event ("verify_time");
+        m_hook = m_collector->make_hook (std::bind (
+            &TxVerifierImp::collect_metrics, this));
+    }
+
+    ~TxVerifierImp ()
+    {
+        // Must unhook before destroying
+        m_hook = beast::insight::Hook ();
+    }
+
+    void collect_metrics ()
+    {
+        m_depth = size ();
+    }
+
+    void verify (SerializedTransaction::pointer const& txn, Handler handler)
+    {
+        Item item;
+        item.txn = txn;
+        item.handler = std::move (handler);
+        item.queued = clock_type::now ();
+        item.valid = false;
+
+        bool dispatch (false);
+
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+
+            m_queue.push_back (std::move (item));
+
+            // Add a job for every full batch not already being worked on
+            if (m_active < m_workers &&
+                m_queue.size () > std::size_t (m_active) * batchSize)
+            {
+                ++m_active;
+                dispatch = true;
+            }
+        }
+
+        if (dispatch)
+            addJob ();
+    }
+
+    std::size_t size ()
+    {
+        std::lock_guard <std::mutex> lock (m_mutex);
+        return m_queue.size ();
+    }
+
+    //--------------------------------------------------------------------------
+
+    void addJob ()
+    {
+        m_jobQueue.addJob (jtTXN_VERIFY, "TxVerifier::process",
+            std::bind (&TxVerifierImp::process, this, std::placeholders::_1));
+    }
+
+    static bool check (SerializedTransaction const& txn)
+    {
+        try
+        {
+            return passesLocalChecks (txn) && txn.checkSign ();
+        }
+        catch (...)
+        {
+            return false;
+        }
+    }
+
+    void process (Job&)
+    {
+        std::vector <Item> batch;
+        batch.reserve (batchSize);
+
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+
+            while (! m_queue.empty () && batch.size () < batchSize)
+            {
+                batch.push_back (std::move (m_queue.front ()));
+                m_queue.pop_front ();
+            }
+        }
+
+        clock_type::time_point const start (clock_type::now ());
+
+        for (auto& item : batch)
+            item.valid = check (*item.txn);
+
+        clock_type::time_point const now (clock_type::now ());
+
+        m_verifyTime.notify (now - start);
+
+        for (auto& item : batch)
+        {
+            m_waitTime.notify (start - item.queued);
+            item.handler (item.txn, item.valid);
+        }
+
+        // Requeue rather than loop so other jobs get a turn at the thread
+        bool more;
+
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+
+            more = ! m_queue.empty ();
+
+            if (! more)
+                --m_active;
+        }
+
+        if (more)
+            addJob ();
+    }
+};
+
+//------------------------------------------------------------------------------
+
+std::unique_ptr <TxVerifier> make_TxVerifier (JobQueue& jobQueue,
+    beast::insight::Collector::ptr const& collector, int workers)
+{
+    return std::make_unique <TxVerifierImp> (jobQueue, collector, workers);
+}
+
+//------------------------------------------------------------------------------
+
+class TxVerifier_test : public beast::unit_test::suite
+{
+public:
+    SerializedTransaction::pointer makeTransaction (
+        RippleAddress const& publicAcct, RippleAddress const& privateAcct,
+            std::uint32_t sequence)
+    {
+        SerializedTransaction::pointer txn (
+            boost::make_shared <SerializedTransaction> (ttACCOUNT_SET));
+        txn->setSourceAccount (publicAcct);
+        txn->setSigningPubKey (publicAcct);
+        txn->setSequence (sequence);
+        txn->sign (privateAcct);
+        return txn;
+    }
+
+    void run ()
+    {
+        RippleAddress seed;
+        seed.setSeedRandom ();
+        RippleAddress generator = RippleAddress::createGeneratorPublic (seed);
+        RippleAddress publicAcct = RippleAddress::createAccountPublic (generator, 1);
+        RippleAddress privateAcct = RippleAddress::createAccountPrivate (generator, seed, 1);
+
+        beast::RootStoppable root ("test");
+        std::unique_ptr <JobQueue> queue (make_JobQueue (
+            beast::insight::NullCollector::New (), root, beast::Journal ()));
+        queue->setThreadCount (2, false);
+
+        std::unique_ptr <TxVerifier> verifier (make_TxVerifier (
+            *queue, beast::insight::NullCollector::New (), 2));
+
+        // Every fourth transaction is damaged after signing
+        int const count (100);
+        std::vector <SerializedTransaction::pointer> txns;
+        for (int i = 0; i < count; ++i)
+        {
+            txns.push_back (makeTransaction (publicAcct, privateAcct, i + 1));
+            if (i % 4 == 0)
+                txns.back ()->setFieldU32 (sfSequence, count + i);
+        }
+
+        std::mutex mutex;
+        std::condition_variable cond;
+        std::map <SerializedTransaction::pointer, bool> results;
+
+        for (auto const& txn : txns)
+        {
+            verifier->verify (txn,
+                [&] (SerializedTransaction::pointer checked, bool valid)
+                {
+                    std::lock_guard <std::mutex> lock (mutex);
+                    results [checked] = valid;
+                    cond.notify_all ();
+                });
+        }
+
+        {
+            std::unique_lock <std::mutex> lock (mutex);
+            expect (cond.wait_for (lock, std::chrono::seconds (30),
+                [&] { return results.size () == count; }), "all checked");
+        }
+
+        int wrong (0);
+        for (int i = 0; i < count; ++i)
+        {
+            auto const iter (results.find (txns [i]));
+            if (iter == results.end () || iter->second != (i % 4 != 0))
+                ++wrong;
+        }
+        expect (wrong == 0, "results match signatures");
+        expect (verifier->size () == 0);
+
+        root.stop ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(TxVerifier,ripple_app,ripple);
+
+} // ripple
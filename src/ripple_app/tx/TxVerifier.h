@@ -0,0 +1,54 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_TXVERIFIER_H_INCLUDED
+#define RIPPLE_TXVERIFIER_H_INCLUDED
+
+namespace ripple {
+
+/** Checks transaction signatures off the receive path.
+
+    Transactions from peers and clients are queued here instead of being
+    checked where they arrive. Jobs on the JobQueue take them off the queue
+    in batches, with up to one job per processor verifying at once. The
+    handler for each transaction is then called from that job with the
+    result, and passes good transactions on to the open ledger.
+*/
+class TxVerifier
+{
+public:
+    /** Called with a transaction and whether it passed its checks. */
+    typedef std::function <void (SerializedTransaction::pointer, bool)> Handler;
+
+    virtual ~TxVerifier () { }
+
+    /** Queue a transaction for its signature and local checks. */
+    virtual void verify (SerializedTransaction::pointer const& txn,
+        Handler handler) = 0;
+
+    /** Returns the number of transactions waiting to be checked. */
+    virtual std::size_t size () = 0;
+};
+
+std::unique_ptr <TxVerifier> make_TxVerifier (JobQueue& jobQueue,
+    beast::insight::Collector::ptr const& collector, int workers);
+
+} // ripple
+
+#endif
@@ -141,6 +141,14 @@ public:
             m_serverHandler.send (ptr, sObj, broadcast);
     }
 
+    void send (Message::pointer const& message, bool broadcast)
+    {
+        connection_ptr ptr = m_connection.lock ();
+
+        if (ptr)
+            m_serverHandler.send (ptr, message, broadcast);
+    }
+
     void disconnect ()
     {
         connection_ptr ptr = m_connection.lock ();
@@ -119,6 +119,20 @@ public:
         }
     }
 
+    static void ssendm (connection_ptr cpClient, InfoSub::Message::pointer const& message, bool broadcast)
+    {
+        try
+        {
+            WriteLog (broadcast ? lsTRACE : lsDEBUG, WSServerHandlerLog) << "Ws:: Sending '" << message->getText () << "'";
+
+            cpClient->send (message->getText ());
+        }
+        catch (...)
+        {
+            cpClient->close (websocketpp::close::status::value (crTooSlow), std::string ("Client is too slow."));
+        }
+    }
+
     void send (connection_ptr cpClient, message_ptr mpMessage)
     {
         cpClient->get_strand ().post (BIND_TYPE (
@@ -131,13 +145,29 @@ public:
                                           &WSServerHandler<endpoint_type>::ssendb, cpClient, strMessage, broadcast));
     }
 
+    void send (connection_ptr cpClient, InfoSub::Message::pointer const& message, bool broadcast)
+    {
+        // The message is shared with the other subscribers, not copied
+        cpClient->get_strand ().post (BIND_TYPE (
+                                          &WSServerHandler<endpoint_type>::ssendm, cpClient, message, broadcast));
+    }
+
     void send (connection_ptr cpClient, const Json::Value& jvObj, bool broadcast)
     {
-        Json::FastWriter    jfwWriter;
+        // A websocket message is sent as a single payload, so the
+        // streaming writer only saves FastWriter's intermediate strings
+        std::string message;
+        {
+            JsonStreamWriter writer ([&message] (void const* data, std::size_t bytes)
+            {
+                message.append (static_cast <char const*> (data), bytes);
+            });
 
-        // WriteLog (lsDEBUG, WSServerHandlerLog) << "Ws:: Object '" << jfwWriter.write(jvObj) << "'";
+            writer.append (jvObj);
+        }
+        message.push_back ('\n');
 
-        send (cpClient, jfwWriter.write (jvObj), broadcast);
+        send (cpClient, message, broadcast);
     }
 
     void pingTimer (connection_ptr cpClient)
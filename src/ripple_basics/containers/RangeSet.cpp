@@ -184,6 +184,24 @@ void RangeSet::clearValue (std::uint32_t v)
     }
 }
 
+void RangeSet::clearPrior (std::uint32_t v)
+{
+    while (!mRanges.empty () && (mRanges.begin ()->first < v))
+    {
+        iterator const it (mRanges.begin ());
+        std::uint32_t const last (it->second);
+        mRanges.erase (it);
+
+        if (last >= v)
+        {
+            mRanges[v] = last;
+            break;
+        }
+    }
+
+    checkInternalConsistency();
+}
+
 std::string RangeSet::toString () const
 {
     std::string ret;
@@ -317,12 +335,35 @@ public:
         }
     }
 
+    void testClearPrior ()
+    {
+        testcase ("clearPrior");
+
+        RangeSet set = createPredefinedSet ();
+
+        // Inside a range
+        set.clearPrior (12);
+        expect (set.getFirst () == 12);
+        expect (set.hasValue (15));
+        expect (!set.hasValue (5));
+
+        // Between ranges
+        set.clearPrior (17);
+        expect (set.getFirst () == 20);
+
+        // Past the end
+        set.clearPrior (1000);
+        expect (set.getFirst () == RangeSet::absent);
+    }
+
     void run ()
     {
         testMembership ();
 
         testPrevMissing ();
 
+        testClearPrior ();
+
         // TODO: Traverse functions must be tested
     }
 };
@@ -50,6 +50,9 @@ public:
 
     void clearValue (std::uint32_t);
 
+    // Remove every number less than the given number
+    void clearPrior (std::uint32_t);
+
     std::string toString () const;
 
     /** Check invariants of the data.
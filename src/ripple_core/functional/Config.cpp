@@ -119,6 +119,7 @@ Config::Config ()
     PEER_CONNECT_LOW_WATER  = DEFAULT_PEER_CONNECT_LOW_WATER;
 
     PEER_PRIVATE            = false;
+    PEER_COMPRESSION        = true;
     PEERS_MAX               = 0;    // indicates "use default"
 
     TRANSACTION_FEE_BASE    = DEFAULT_FEE_DEFAULT;
@@ -348,6 +349,9 @@ void Config::load ()
             if (SectionSingleB (secConfig, SECTION_PEER_PRIVATE, strTemp))
                 PEER_PRIVATE        = beast::lexicalCastThrow <bool> (strTemp);
 
+            if (SectionSingleB (secConfig, SECTION_PEER_COMPRESSION, strTemp))
+                PEER_COMPRESSION    = beast::lexicalCastThrow <bool> (strTemp);
+
             if (SectionSingleB (secConfig, SECTION_PEERS_MAX, strTemp))
                 PEERS_MAX           = beast::lexicalCastThrow <int> (strTemp);
 
@@ -384,6 +388,12 @@ void Config::load ()
             importNodeDatabase = parseKeyValueSection (
                 secConfig, ConfigSection::importNodeDatabase ());
 
+            accountTxDatabase = parseKeyValueSection (
+                secConfig, ConfigSection::accountTxDatabase ());
+
+            ledgerSnapshot = parseKeyValueSection (
+                secConfig, ConfigSection::ledgerSnapshot ());
+
             if (SectionSingleB (secConfig, SECTION_PEER_PORT, strTemp))
                 peerListeningPort = beast::lexicalCastThrow <int> (strTemp);
 
@@ -339,6 +339,19 @@ public:
     bool doImport;
     beast::StringPairArray importNodeDatabase;
 
+    /** Parameters for the account transaction index.
+        If this is empty the index is kept in the transaction database,
+        otherwise it describes a NodeStore backend to hold it. The backend
+        must keep its keys in order, such as LevelDB or RocksDB.
+        The format is the same as that for @ref nodeDatabase
+    */
+    beast::StringPairArray accountTxDatabase;
+
+    /** Parameters for the snapshot of the validated ledger's state tree.
+        The keys are "interval", in ledgers, and "path".
+    */
+    beast::StringPairArray ledgerSnapshot;
+
     //
     //
     //--------------------------------------------------------------------------
@@ -406,6 +419,7 @@ public:
     int                         PEER_START_MAX;
     unsigned int                PEER_CONNECT_LOW_WATER;
     bool                        PEER_PRIVATE;           // True to ask peers not to relay current IP.
+    bool                        PEER_COMPRESSION;       // True to offer compressed ledger data to peers.
     unsigned int                PEERS_MAX;
 
     // Websocket networking parameters
@@ -33,6 +33,8 @@ struct ConfigSection
     static beast::String nodeDatabase ()                 { return "node_db"; }
     static beast::String tempNodeDatabase ()             { return "temp_db"; }
     static beast::String importNodeDatabase ()           { return "import_db"; }
+    static beast::String accountTxDatabase ()            { return "account_tx_db"; }
+    static beast::String ledgerSnapshot ()               { return "ledger_snapshot"; }
 };
 
 // VFALCO TODO Rename and replace these macros with variables.
@@ -60,6 +62,7 @@ struct ConfigSection
 #define SECTION_PATH_SEARCH             "path_search"
 #define SECTION_PATH_SEARCH_FAST        "path_search_fast"
 #define SECTION_PATH_SEARCH_MAX         "path_search_max"
+#define SECTION_PEER_COMPRESSION        "peer_compression"
 #define SECTION_PEER_CONNECT_LOW_WATER  "peer_connect_low_water"
 #define SECTION_PEER_IP                 "peer_ip"
 #define SECTION_PEER_PORT               "peer_port"
@@ -34,16 +34,21 @@ enum JobType
     // earlier jobs having lower priority than later jobs. If you wish to
     // insert a job at a specific priority, simply add it at the right location.
     
+    jtROTATE,        // Rotate the node store and delete old history
+    jtSNAPSHOT,      // Write a snapshot of a validated ledger's state
+    jtPACK_PREPARE,  // Prepare fetch packs from a validated ledger
     jtPACK,          // Make a fetch pack for a peer
     jtPUBOLDLEDGER,  // An old ledger has been accepted
     jtVALIDATION_ut, // A validation from an untrusted source
     jtPROOFWORK,     // A proof of work demand from another server
     jtTRANSACTION_l, // A local transaction
     jtPROPOSAL_ut,   // A proposal from an untrusted source
+    jtLEDGER_VERIFY, // Hash nodes received for a ledger we're acquiring
     jtLEDGER_DATA,   // Received data for a ledger we're acquiring
     jtCLIENT,        // A websocket command from the client
     jtRPC,           // A websocket command from the client
     jtUPDATE_PF,     // Update pathfinding requests
+    jtTXN_VERIFY,    // Check signatures on a batch of transactions
     jtTRANSACTION,   // A transaction received from the network
     jtUNL,           // A Score or Fetch of the UNL (DEPRECATED)
     jtADVANCE,       // Advance validated/acquired ledgers
@@ -97,7 +102,7 @@ public:
          std::string const& name,
          std::uint64_t index,
          LoadMonitor& lm,
-         std::function <void (Job&)> const& job,
+         std::function <void (Job&)> job,
          CancelCallback cancelCallback);
 
     //Job& operator= (Job const& other);
@@ -26,8 +26,16 @@
 #include "../../beast/beast/chrono/chrono_util.h"
 #include "../../beast/modules/beast_core/thread/Workers.h"
 #include "../../beast/modules/beast_core/system/SystemStats.h"
+#include "../../beast/beast/unit_test/suite.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <thread>
 
 namespace ripple {
 
@@ -36,19 +44,39 @@ class JobQueueImp
     , private beast::Workers::Callback
 {
 public:
-    typedef std::set <Job> JobSet;
     typedef std::map <JobType, JobTypeData> JobDataMap;
-    typedef beast::CriticalSection::ScopedLockType ScopedLock;
+
+    // Jobs which are ready to run. Each producing thread pushes to its
+    // own shard and idle threads take work from any shard, starting with
+    // their own, so there is no single lock shared by every thread.
+    //
+    struct Shard
+    {
+        std::mutex mutex;
+
+        // One FIFO queue per priority band
+        std::deque <Job> jobs [JobTypes::bandCount];
+
+        // Queue sizes, readable without the lock
+        std::atomic <int> size [JobTypes::bandCount];
+
+        Shard ()
+        {
+            for (auto& x : size)
+                x = 0;
+        }
+    };
+
+    typedef std::vector <std::unique_ptr <Shard>> Shards;
 
     beast::Journal m_journal;
-    beast::CriticalSection m_mutex;
-    std::uint64_t m_lastJob;
-    JobSet m_jobSet;
+    std::atomic <std::uint64_t> m_lastJob;
     JobDataMap m_jobData;
     JobTypeData m_invalidJobData;
+    Shards m_shards;
 
     // The number of jobs currently in processTask()
-    int m_processCount;
+    std::atomic <int> m_processCount;
 
     beast::Workers m_workers;
     CancelCallback m_cancelCallback;
@@ -82,20 +110,22 @@ public:
             &JobQueueImp::collect, this));
         job_count = m_collector->make_gauge ("job_count");
 
+        for (auto const& x : getJobTypes ())
         {
-            ScopedLock lock (m_mutex);
-
-            for (auto const& x : getJobTypes ())
-            {
-                JobTypeInfo const& jt = x.second;
+            JobTypeInfo const& jt = x.second;
 
-                // And create dynamic information for all jobs
-                auto const result (m_jobData.emplace (std::piecewise_construct,
-                    std::forward_as_tuple (jt.type ()),
-                    std::forward_as_tuple (jt, m_collector)));
-                assert (result.second == true);
-            }
+            // And create dynamic information for all jobs
+            auto const result (m_jobData.emplace (std::piecewise_construct,
+                std::forward_as_tuple (jt.type ()),
+                std::forward_as_tuple (jt, m_collector)));
+            assert (result.second == true);
         }
+
+        int const shards (std::max (1, beast::SystemStats::getNumCpus ()));
+
+        m_shards.reserve (shards);
+        for (int i = 0; i < shards; ++i)
+            m_shards.emplace_back (std::make_unique <Shard> ());
     }
 
     ~JobQueueImp ()
@@ -106,8 +136,7 @@ public:
 
     void collect ()
     {
-        ScopedLock lock (m_mutex);
-        job_count = m_jobSet.size ();
+        job_count = getWaitingCount ();
     }
 
     void addJob (JobType type, std::string const& name,
@@ -127,24 +156,21 @@ public:
         // do not add jobs to a queue with no threads
         assert (type == jtCLIENT || m_workers.getNumberOfThreads () > 0);
 
-        {
-            // If this goes off it means that a child didn't follow 
-            // the Stoppable API rules. A job may only be added if:
-            //
-            //  - The JobQueue has NOT stopped 
-            //          AND
-            //      * We are currently processing jobs
-            //          OR
-            //      * We have have pending jobs
-            //          OR
-            //      * Not all children are stopped
-            //  
-            ScopedLock lock (m_mutex);
-            assert (! isStopped() && (
-                m_processCount>0 ||
-                ! m_jobSet.empty () ||
-                ! areChildrenStopped()));
-        }
+        // If this goes off it means that a child didn't follow 
+        // the Stoppable API rules. A job may only be added if:
+        //
+        //  - The JobQueue has NOT stopped 
+        //          AND
+        //      * We are currently processing jobs
+        //          OR
+        //      * We have have pending jobs
+        //          OR
+        //      * Not all children are stopped
+        //  
+        assert (! isStopped() && (
+            m_processCount > 0 ||
+            getWaitingCount () > 0 ||
+            ! areChildrenStopped()));
 
         // Don't even add it to the queue if we're stopping
         // and the job type is marked for skipOnStop.
@@ -156,31 +182,21 @@ public:
             return;
         }
 
-        {
-            ScopedLock lock (m_mutex);
-
-            std::pair <std::set <Job>::iterator, bool> result (
-                m_jobSet.insert (Job (type, name, ++m_lastJob,
-                    data.load (), jobFunc, m_cancelCallback)));
-            queueJob (*result.first, lock);
-        }
+        queueJob (Job (type, name, ++m_lastJob,
+            data.load (), jobFunc, m_cancelCallback), data);
     }
 
     int getJobCount (JobType t)
     {
-        ScopedLock lock (m_mutex);
-
         JobDataMap::const_iterator c = m_jobData.find (t);
 
         return (c == m_jobData.end ()) 
             ? 0 
-            : c->second.waiting;
+            : c->second.waiting.load ();
     }
 
     int getJobCountTotal (JobType t)
     {
-        ScopedLock lock (m_mutex);
-
         JobDataMap::const_iterator c = m_jobData.find (t);
 
         return (c == m_jobData.end ())
@@ -193,8 +209,6 @@ public:
         // return the number of jobs at this priority level or greater
         int ret = 0;
 
-        ScopedLock lock (m_mutex);
-
         for (auto const& x : m_jobData)
         {
             if (x.first >= t)
@@ -288,8 +302,6 @@ public:
 
         Json::Value priorities = Json::arrayValue;
 
-        ScopedLock lock (m_mutex);
-
         for (auto& x : m_jobData)
         {
             assert (x.first != jtINVALID);
@@ -353,21 +365,40 @@ private:
 
     //--------------------------------------------------------------------------
 
+    // Returns the number of jobs added but not yet started.
+    //
+    int getWaitingCount () const
+    {
+        int count (0);
+
+        for (auto const& x : m_jobData)
+            count += x.second.waiting;
+
+        return count;
+    }
+
     // Signals the service stopped if the stopped condition is met.
     //
-    void checkStopped (ScopedLock const& lock)
+    void checkStopped ()
     {
         // We are stopped when all of the following are true:
         //
         //  1. A stop notification was received
         //  2. All Stoppable children have stopped
         //  3. There are no executing calls to processTask
-        //  4. There are no remaining Jobs in the job set
+        //  4. There are no remaining Jobs waiting
+        //
+        // processTask counts itself before it stops counting its Job as
+        // waiting, so the waiting count must be read first: a Job which
+        // is no longer waiting by then is covered by m_processCount until
+        // it finishes. Reading them the other way round could miss a Job
+        // taken between the two reads. Calling stopped more than once is
+        // harmless.
         //
         if (isStopping() &&
             areChildrenStopped() &&
-            (m_processCount == 0) &&
-            m_jobSet.empty())
+            (getWaitingCount () == 0) &&
+            (m_processCount == 0))
         {
             stopped();
         }
@@ -375,92 +406,137 @@ private:
 
     //--------------------------------------------------------------------------
     //
-    // Signals an added Job for processing.
+    // Accepts a newly added Job.
     //
     // Pre-conditions:
     //  The JobType must be valid.
-    //  The Job must exist in mJobSet.
-    //  The Job must not have previously been queued.
     //
     // Post-conditions:
     //  Count of waiting jobs of that type will be incremented.
+    //  If the type is below its limit, the Job is released to run,
+    //  otherwise it is deferred until a Job of the same type finishes.
     //  If JobQueue exists, and has at least one thread, Job will eventually run.
     //
-    // Invariants:
-    //  The calling thread owns the JobLock
-    //  
-    void queueJob (Job const& job, ScopedLock const& lock)
+    void queueJob (Job&& job, JobTypeData& data)
     {
-        JobType const type (job.getType ());
-        assert (type != jtINVALID);
-        assert (m_jobSet.find (job) != m_jobSet.end ());
+        assert (job.getType () != jtINVALID);
 
-        JobTypeData& data (getJobTypeData (type));
+        ++data.waiting;
 
-        if (data.waiting + data.running < getJobLimit (type))
+        if (data.info.limited ())
         {
-            m_workers.addTask ();
+            std::lock_guard <std::mutex> lock (data.mutex);
+
+            if (data.active >= data.info.limit ())
+            {
+                // defer the job until we go below the limit
+                //
+                data.deferred.push_back (std::move (job));
+                return;
+            }
+
+            ++data.active;
         }
-        else
+
+        releaseJob (std::move (job), data);
+    }
+
+    // Makes a Job available to the worker threads.
+    //
+    void releaseJob (Job&& job, JobTypeData& data)
+    {
+        int const band (data.info.band ());
+        Shard& shard (*m_shards [getHomeShard ()]);
+
         {
-            // defer the task until we go below the limit
-            //
-            ++data.deferred;
+            std::lock_guard <std::mutex> lock (shard.mutex);
+            shard.jobs [band].push_back (std::move (job));
+            ++shard.size [band];
         }
-        ++data.waiting;
+
+        m_workers.addTask ();
     }
 
-    //------------------------------------------------------------------------------
-    //
-    // Returns the next Job we should run now.
+    // Returns the shard which the calling thread pushes to and
+    // takes work from first.
     //
-    // RunnableJob:
-    //  A Job in the JobSet whose slots count for its type is greater than zero.
-    //
-    // Pre-conditions:
-    //  mJobSet must not be empty.
-    //  mJobSet holds at least one RunnableJob
+    std::size_t getHomeShard () const
+    {
+        return std::hash <std::thread::id> () (
+            std::this_thread::get_id ()) % m_shards.size ();
+    }
+
+    //------------------------------------------------------------------------------
     //
-    // Post-conditions:
-    //  job is a valid Job object.
-    //  job is removed from mJobQueue.
-    //  Waiting job count of it's type is decremented
-    //  Running job count of it's type is incremented
+    // Takes the released Job with the highest priority band, preferring
+    // the calling thread's own shard within a band.
     //
-    // Invariants:
-    //  The calling thread owns the JobLock
+    // Returns `false` if no released Job was found. This can happen when
+    // another thread took the Job matching our task before we could see
+    // the Job matching theirs; popJobLocked will find it.
     //
-    void getNextJob (Job& job, ScopedLock const& lock)
+    bool popJob (Job& job)
     {
-        assert (! m_jobSet.empty ());
+        std::size_t const count (m_shards.size ());
+        std::size_t const home (getHomeShard ());
 
-        JobSet::const_iterator iter;
-        for (iter = m_jobSet.begin (); iter != m_jobSet.end (); ++iter)
+        for (int band = JobTypes::bandCount; band-- > 0;)
         {
-            JobTypeData& data (getJobTypeData (iter->getType ()));
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                Shard& shard (*m_shards [(home + i) % count]);
 
-            assert (data.running <= getJobLimit (data.type ()));
+                if (shard.size [band] == 0)
+                    continue;
 
-            // Run this job if we're running below the limit.
-            if (data.running < getJobLimit (data.type ()))
-            {
-                assert (data.waiting > 0);
-                break;
+                std::lock_guard <std::mutex> lock (shard.mutex);
+                std::deque <Job>& jobs (shard.jobs [band]);
+
+                if (jobs.empty ())
+                    continue;
+
+                job = std::move (jobs.front ());
+                jobs.pop_front ();
+                --shard.size [band];
+                return true;
             }
         }
 
-        assert (iter != m_jobSet.end ());
+        return false;
+    }
 
-        JobType const type = iter->getType ();
-        JobTypeData& data (getJobTypeData (type));
+    // Takes the released Job with the highest priority band while holding
+    // every shard lock, so no Job can move out of sight during the search.
+    //
+    // Pre-conditions:
+    //  Called from a task which has not yet taken its Job. Every task is
+    //  added after its Job is released, so at least one Job is present.
+    //
+    void popJobLocked (Job& job)
+    {
+        // Shards are only ever locked one at a time elsewhere
+        std::vector <std::unique_lock <std::mutex>> locks;
+        locks.reserve (m_shards.size ());
+        for (auto const& shard : m_shards)
+            locks.emplace_back (shard->mutex);
 
-        assert (type != jtINVALID);
+        for (int band = JobTypes::bandCount; band-- > 0;)
+        {
+            for (auto const& shard : m_shards)
+            {
+                std::deque <Job>& jobs (shard->jobs [band]);
 
-        job = *iter;
-        m_jobSet.erase (iter);
+                if (jobs.empty ())
+                    continue;
 
-        --data.waiting;
-        ++data.running;
+                job = std::move (jobs.front ());
+                jobs.pop_front ();
+                --shard->size [band];
+                return;
+            }
+        }
+
+        assert (false);
     }
 
     //------------------------------------------------------------------------------
@@ -468,35 +544,42 @@ private:
     // Indicates that a running Job has completed its task.
     //
     // Pre-conditions:
-    //  Job must not exist in mJobSet.
     //  The JobType must not be invalid.
     //
     // Post-conditions:
     //  The running count of that JobType is decremented
-    //  A new task is signaled if there are more waiting Jobs than the limit, if any.
+    //  The oldest deferred Job of that JobType, if any, is released.
     //
-    // Invariants:
-    //  <none>
-    //
-    void finishJob (Job const& job, ScopedLock const& lock)
+    void finishJob (Job const& job)
     {
         JobType const type = job.getType ();
 
-        assert (m_jobSet.find (job) == m_jobSet.end ());
         assert (type != jtINVALID);
 
         JobTypeData& data (getJobTypeData (type));
 
-        // Queue a deferred task if possible
-        if (data.deferred > 0)
+        --data.running;
+
+        if (data.info.limited ())
         {
-            assert (data.running + data.waiting >= getJobLimit (type));
+            Job next;
 
-            --data.deferred;
-            m_workers.addTask ();
-        }
+            {
+                std::lock_guard <std::mutex> lock (data.mutex);
 
-        --data.running;
+                if (data.deferred.empty ())
+                {
+                    --data.active;
+                    return;
+                }
+
+                next = std::move (data.deferred.front ());
+                data.deferred.pop_front ();
+            }
+
+            // The finished job's slot passes to the deferred one
+            releaseJob (std::move (next), data);
+        }
     }
 
     //--------------------------------------------------------------------------
@@ -525,10 +608,10 @@ private:
     // Runs the next appropriate waiting Job.
     //
     // Pre-conditions:
-    //  A RunnableJob must exist in the JobSet
+    //  A released Job must exist for this task
     //
     // Post-conditions:
-    //  The chosen RunnableJob will have Job::doJob() called.
+    //  The chosen Job will have Job::doJob() called.
     //
     // Invariants:
     //  <none>
@@ -537,14 +620,16 @@ private:
     {
         Job job;
 
-        {
-            ScopedLock lock (m_mutex);
-            getNextJob (job, lock);
-            ++m_processCount;
-        }
+        ++m_processCount;
+
+        if (! popJob (job))
+            popJobLocked (job);
 
         JobTypeData& data (getJobTypeData (job.getType ()));
 
+        --data.waiting;
+        ++data.running;
+
         // Skip the job if we are stopping and the
         // skipOnStop flag is set for the job type
         //
@@ -565,12 +650,9 @@ private:
             m_journal.trace << "Skipping processTask ('" << data.name () << "')";
         }
 
-        {
-            ScopedLock lock (m_mutex);
-            finishJob (job, lock);
-            --m_processCount;
-            checkStopped (lock);
-        }
+        finishJob (job);
+        --m_processCount;
+        checkStopped ();
 
         // Note that when Job::~Job is called, the last reference
         // to the associated LoadEvent object (in the Job) may be destroyed.
@@ -590,18 +672,6 @@ private:
         return j.skip ();
     }
 
-    // Returns the limit of running jobs for the given job type.
-    // For jobs with no limit, we return the largest int. Hopefully that
-    // will be enough.
-    //
-    int getJobLimit (JobType type)
-    {
-        JobTypeInfo const& j (getJobTypes ().get (type));
-        assert (j.type () != jtINVALID);
-
-        return j.limit ();
-    }
-
     //--------------------------------------------------------------------------
 
     void onStop ()
@@ -658,9 +728,7 @@ private:
 
     void onChildrenStopped ()
     {
-        ScopedLock lock (m_mutex);
-
-        checkStopped (lock);
+        checkStopped ();
     }
 };
 
@@ -680,4 +748,227 @@ std::unique_ptr <JobQueue> make_JobQueue (
     return std::make_unique <JobQueueImp> (collector, parent, journal);
 }
 
+//------------------------------------------------------------------------------
+
+class JobQueue_test : public beast::unit_test::suite
+{
+public:
+    // Counts finished jobs and lets the test wait for them
+    class Tally
+    {
+    public:
+        Tally ()
+            : m_count (0)
+        {
+        }
+
+        void add ()
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+            ++m_count;
+            m_cond.notify_all ();
+        }
+
+        bool wait (int count)
+        {
+            std::unique_lock <std::mutex> lock (m_mutex);
+            return m_cond.wait_for (lock, std::chrono::seconds (10),
+                [&] { return m_count >= count; });
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_cond;
+        int m_count;
+    };
+
+    static std::unique_ptr <JobQueue> makeQueue (
+        beast::Stoppable& parent, int threads)
+    {
+        std::unique_ptr <JobQueue> queue (make_JobQueue (
+            beast::insight::NullCollector::New (), parent, beast::Journal ()));
+        queue->setThreadCount (threads, false);
+        return queue;
+    }
+
+    void testPriority ()
+    {
+        testcase ("priority");
+
+        beast::RootStoppable root ("test");
+        std::unique_ptr <JobQueue> queue (makeQueue (root, 1));
+
+        // Occupy the only thread while the other jobs are added
+        Tally started;
+        Tally finished;
+        std::mutex mutex;
+        std::condition_variable cond;
+        bool blocked (true);
+
+        queue->addJob (jtADMIN, "block", [&] (Job&)
+        {
+            started.add ();
+            std::unique_lock <std::mutex> lock (mutex);
+            cond.wait (lock, [&] { return ! blocked; });
+        });
+        expect (started.wait (1), "blocking job started");
+
+        JobType const added [] = { jtPACK, jtCLIENT, jtWRITE,
+            jtPROPOSAL_t, jtTRANSACTION, jtLEDGER_DATA, jtACCEPT };
+        JobType const expected [] = { jtPROPOSAL_t, jtACCEPT, jtWRITE,
+            jtCLIENT, jtTRANSACTION, jtPACK, jtLEDGER_DATA };
+
+        std::vector <JobType> order;
+        for (auto type : added)
+        {
+            queue->addJob (type, "test", [&, type] (Job&)
+            {
+                order.push_back (type);
+                finished.add ();
+            });
+        }
+        expect (queue->getJobCountGE (jtCLIENT) == 5);
+
+        {
+            std::lock_guard <std::mutex> lock (mutex);
+            blocked = false;
+            cond.notify_all ();
+        }
+
+        expect (finished.wait (7), "all jobs ran");
+        expect (std::equal (order.begin (), order.end (), expected),
+            "higher bands first, FIFO within a band");
+    }
+
+    void testLimit ()
+    {
+        testcase ("limit");
+
+        beast::RootStoppable root ("test");
+        std::unique_ptr <JobQueue> queue (makeQueue (root, 4));
+
+        int const jobs (40);
+        Tally finished;
+        std::atomic <int> running (0);
+        std::atomic <int> peak (0);
+
+        // jtPUBOLDLEDGER runs at most two at a time
+        for (int i = 0; i < jobs; ++i)
+        {
+            queue->addJob (jtPUBOLDLEDGER, "test", [&] (Job&)
+            {
+                int const now (++running);
+                int seen (peak);
+                while (now > seen && ! peak.compare_exchange_weak (seen, now))
+                    ;
+                std::this_thread::sleep_for (std::chrono::milliseconds (1));
+                --running;
+                finished.add ();
+            });
+        }
+
+        expect (finished.wait (jobs), "all jobs ran");
+        expect (peak <= 2, "limit respected");
+        expect (peak == 2, "limit reached");
+    }
+
+    void run ()
+    {
+        testPriority ();
+        testLimit ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(JobQueue,ripple_core,ripple);
+
+//------------------------------------------------------------------------------
+
+/** Measures the time from adding a tiny job until it starts running. */
+class JobQueue_timing_test : public beast::unit_test::suite
+{
+public:
+    typedef std::chrono::steady_clock clock_type;
+
+    static int const jobCount = 1000000;
+    static int const producerCount = 4;
+
+    static void produce (JobQueue& queue, int id,
+        std::vector <std::int64_t>& latency, std::atomic <int>& remaining,
+            JobQueue_test::Tally& finished)
+    {
+        // A mix of the busiest unlimited job types
+        JobType const types [] = { jtTRANSACTION, jtCLIENT,
+            jtPROPOSAL_t, jtVALIDATION_ut };
+
+        for (int i = id; i < jobCount; i += producerCount)
+        {
+            queue.addJob (types [i % 4], "timing",
+                [i, &latency, &remaining, &finished] (Job& job)
+            {
+                latency [i] = std::chrono::duration_cast <
+                    std::chrono::nanoseconds> (
+                        Job::clock_type::now () - job.queue_time ()).count ();
+                if (--remaining == 0)
+                    finished.add ();
+            });
+        }
+    }
+
+    void measure (int threads)
+    {
+        beast::RootStoppable root ("test");
+        std::unique_ptr <JobQueue> queue (
+            JobQueue_test::makeQueue (root, threads));
+
+        std::vector <std::int64_t> latency (jobCount);
+        std::atomic <int> remaining (jobCount);
+        JobQueue_test::Tally finished;
+
+        clock_type::time_point const start (clock_type::now ());
+        std::vector <std::thread> producers;
+        for (int i = 0; i < producerCount; ++i)
+            producers.emplace_back (&JobQueue_timing_test::produce,
+                std::ref (*queue), i, std::ref (latency),
+                    std::ref (remaining), std::ref (finished));
+        for (auto& t : producers)
+            t.join ();
+        if (! expect (finished.wait (1), "all jobs ran"))
+            return;
+        double const seconds (std::chrono::duration_cast <
+            std::chrono::duration <double>> (clock_type::now () - start).count ());
+
+        std::sort (latency.begin (), latency.end ());
+        auto const percentile = [&latency] (double p)
+        {
+            return latency [static_cast <std::size_t> (
+                p * (latency.size () - 1))] / 1000;
+        };
+
+        std::stringstream ss;
+        ss << threads << " threads: " <<
+            static_cast <std::int64_t> (jobCount / seconds) << " jobs/sec, " <<
+            "latency us p50 " << percentile (0.5) <<
+            ", p90 " << percentile (0.9) <<
+            ", p99 " << percentile (0.99) <<
+            ", p99.9 " << percentile (0.999) <<
+            ", max " << latency.back () / 1000;
+        log << ss.str();
+    }
+
+    void run ()
+    {
+        int const maxThreads (std::max (8u,
+            std::thread::hardware_concurrency ()));
+
+        for (int n = 1; n <= maxThreads; n *= 2)
+        {
+            testcase (std::to_string (n) + " threads");
+            measure (n);
+            pass ();
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(JobQueue_timing,ripple_core,ripple);
+
 }
@@ -22,6 +22,10 @@
 
 #include "JobTypeInfo.h"
 
+#include <atomic>
+#include <deque>
+#include <mutex>
+
 namespace ripple
 {
 
@@ -38,13 +42,21 @@ public:
     JobTypeInfo const& info;
 
     /* The number of jobs waiting */
-    int waiting;
+    std::atomic <int> waiting;
 
     /* The number presently running */
-    int running;
+    std::atomic <int> running;
+
+    /* The remaining members are only used for job types with a limit,
+       and are protected by the mutex.
+    */
+    std::mutex mutex;
+
+    /* The number of jobs queued to run or running */
+    int active;
 
-    /* And the number we deferred executing because of job limits */
-    int deferred;
+    /* Jobs held back until the number active drops below the limit */
+    std::deque <Job> deferred;
 
     /* Notification callbacks */
     beast::insight::Event dequeue;
@@ -56,7 +68,7 @@ public:
         , info (info_)
         , waiting (0)
         , running (0)
-        , deferred (0)
+        , active (0)
     {
         m_load.setTargetLatency (
             info.getAverageLatency (),
@@ -39,6 +39,9 @@ private:
     /** Special jobs are not dispatched via the job queue */
     bool const m_special;
 
+    /** The priority band, see JobTypes::getBand */
+    int const m_band;
+
     /** Average and peak latencies for this job type. 0 is none specified */
     std::uint64_t const m_avgLatency;
     std::uint64_t const m_peakLatency;
@@ -48,12 +51,14 @@ public:
     JobTypeInfo () = delete;
 
     JobTypeInfo (JobType type, std::string name, int limit, 
-            bool skip, bool special, std::uint64_t avgLatency, std::uint64_t peakLatency) 
+            bool skip, bool special, int band,
+                std::uint64_t avgLatency, std::uint64_t peakLatency)
         : m_type (type)
         , m_name (name)
         , m_limit (limit)
         , m_skip (skip)
         , m_special (special)
+        , m_band (band)
         , m_avgLatency (avgLatency)
         , m_peakLatency (peakLatency)
     {
@@ -85,6 +90,17 @@ public:
         return m_special;
     }
 
+    /** Returns `true` if the number of running jobs is limited. */
+    bool limited () const
+    {
+        return m_limit != std::numeric_limits <int>::max ();
+    }
+
+    int band () const
+    {
+        return m_band;
+    }
+
     std::uint64_t getAverageLatency () const
     {
         return m_avgLatency;
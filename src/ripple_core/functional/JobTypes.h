@@ -29,12 +29,49 @@ public:
     typedef std::map <JobType, JobTypeInfo> Map;
     typedef Map::const_iterator const_iterator;
 
+    /** The number of priority bands. */
+    static int const bandCount = 4;
+
+    /** Returns the priority band of a job type.
+        Job types of similar priority share a band. All waiting jobs in a
+        band are started before any job in a lower band; within a band,
+        jobs start roughly in the order they were added.
+    */
+    static int getBand (JobType jt)
+    {
+        // Consensus, timers and administration
+        if (jt >= jtACCEPT)
+            return 3;
+
+        // Ledger advancement, publishing and writes
+        if (jt >= jtUNL)
+            return 2;
+
+        // Clients and network transactions
+        if (jt >= jtCLIENT)
+            return 1;
+
+        // Background work and untrusted peers
+        return 0;
+    }
 
     JobTypes ()
-        : m_unknown (jtINVALID, "invalid", 0, true, true, 0, 0)
+        : m_unknown (jtINVALID, "invalid", 0, true, true, 0, 0, 0)
     {        
         int maxLimit = std::numeric_limits <int>::max ();
 
+        // Rotate the node store and delete old history
+        add (jtROTATE,        "rotateNodeStore",
+            1,        true,   false, 0,     0);
+
+        // Write a snapshot of a validated ledger's state
+        add (jtSNAPSHOT,      "writeSnapshot",
+            1,        true,   false, 0,     0);
+
+        // Prepare fetch packs from a validated ledger
+        add (jtPACK_PREPARE,  "prepareFetchPack",
+            1,        true,   false, 0,     0);
+
         // Make a fetch pack for a peer
         add (jtPACK,          "makeFetchPack",
             1,        true,   false, 0,     0);
@@ -59,6 +96,10 @@ public:
         add (jtPROPOSAL_ut,   "untrustedProposal",
             maxLimit, true,   false, 500,   1250);
 
+        // Hash nodes received for a ledger we're acquiring
+        add (jtLEDGER_VERIFY, "verifyLedgerData",
+            maxLimit, true,   false, 0,     0);
+
         // Received data for a ledger we're acquiring
         add (jtLEDGER_DATA,   "ledgerData",
             2,        true,   false, 0,     0);
@@ -71,9 +112,15 @@ public:
         add (jtCLIENT,        "clientCommand",
             maxLimit, true,   false, 2000,  5000);
 
-        // A websocket command from the client
+        // An RPC command from a client. Limited to half of the most
+        // threads the queue auto-tunes to, so slow commands cannot keep
+        // ledger and consensus jobs from running.
         add (jtRPC,           "RPC",
-            maxLimit, false,  false, 0,     0);
+            3,        false,  false, 0,     0);
+
+        // Check signatures on a batch of transactions
+        add (jtTXN_VERIFY,    "verifyTransactions",
+            maxLimit, true,   false, 250,   1000);
 
         // A transaction received from the network
         add (jtTRANSACTION,   "transaction",
@@ -206,7 +253,7 @@ private:
             std::piecewise_construct,
             std::forward_as_tuple (jt), 
             std::forward_as_tuple (jt, name, limit, skip, special,
-                avgLatency, peakLatency)));
+                getBand (jt), avgLatency, peakLatency)));
 
         assert (result.second == true);
     }
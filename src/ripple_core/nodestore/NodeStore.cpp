@@ -29,12 +29,14 @@
 
 #include "../../ripple/common/seconds_clock.h"
 #include "../../ripple/common/TaggedCache.h"
+#include "../../ripple/common/ShardedTaggedCache.h"
 #include "../../ripple/common/KeyCache.h"
 
 #include "impl/Tuning.h"
 #  include "impl/DecodedBlob.h"
 #  include "impl/EncodedBlob.h"
 #  include "impl/BatchWriter.h"
+#  include "impl/ReadQueue.h"
 # include "backend/HyperDBFactory.h"
 #include "backend/HyperDBFactory.cpp"
 # include "backend/LevelDBFactory.h"
@@ -49,6 +51,8 @@
 #include "impl/Backend.cpp"
 #include "impl/BatchWriter.cpp"
 # include "impl/DatabaseImp.h"
+# include "impl/RotatingBackend.h"
+# include "impl/DatabaseRotatingImp.h"
 #include "impl/Database.cpp"
 #include "impl/DummyScheduler.cpp"
 #include "impl/DecodedBlob.cpp"
@@ -56,6 +60,7 @@
 #include "impl/Factory.cpp"
 #include "impl/Manager.cpp"
 #include "impl/NodeObject.cpp"
+#include "impl/PendingReads.cpp"
 #include "impl/Scheduler.cpp"
 #include "impl/Task.cpp"
 
@@ -63,4 +68,5 @@
 #include "tests/BackendTests.cpp"
 #include "tests/BasicTests.cpp"
 #include "tests/DatabaseTests.cpp"
+#include "tests/ReadQueueTests.cpp"
 #include "tests/TimingTests.cpp"
@@ -29,6 +29,8 @@
 #include "api/DummyScheduler.h"
 #include "api/Factory.h"
 #include "api/Database.h"
+#include "api/DatabaseRotating.h"
+#include "api/PendingReads.h"
 #include "api/Manager.h"
 
 #endif
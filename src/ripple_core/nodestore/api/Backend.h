@@ -58,6 +58,20 @@ public:
     */
     virtual Status fetch (void const* key, NodeObject::Ptr* pObject) = 0;
 
+    /** Fetch a group of objects.
+        Implementations should take advantage of the batch, for example by
+        looking the keys up in sorted order against a single snapshot, or
+        by using a native multi-get.
+        @note This will be called concurrently.
+        @param hashes The keys of the objects to fetch.
+        @param objects [out] One object per key in the same order, or
+                       `nullptr` where the result was not `ok`.
+        @return One status per key, in the same order.
+    */
+    virtual std::vector <Status> fetchBatch (
+        std::vector <uint256 const*> const& hashes,
+            std::vector <NodeObject::Ptr>& objects) = 0;
+
     /** Store a single object.
         Depending on the implementation this may happen immediately
         or deferred using a scheduled task.
@@ -82,8 +96,34 @@ public:
     // VFALCO TODO Implement
     //virtual void visitAll (std::function <void (NodeObject::Ptr)> f) = 0;
 
+    /** Visit objects in key order, starting from a key.
+        Objects are visited until the callback returns `false` or there
+        are no more keys. Only backends which keep their keys in order
+        support this, the default returns `false` without visiting.
+        @note This will be called concurrently.
+        @param key The key to start from. Going backwards, the first object
+                   visited is the last one whose key is not after this one.
+        @param forward `true` to visit keys in ascending order.
+        @return `true` if the backend supports ordered visits.
+    */
+    virtual bool visitFrom (void const* key, bool forward,
+        std::function <bool (NodeObject::Ptr const&)> const& callback);
+
     /** Estimate the number of write operations pending. */
     virtual int getWriteLoad () = 0;
+
+    /** Remove the backend's files when it is destroyed.
+        Used to discard a backend whose contents are no longer needed,
+        for example the oldest generation of a rotating database. Backends
+        which do not keep their data in files ignore this.
+    */
+    virtual void setDeletePath ();
+
+    /** Write out pending objects and make everything stored durable.
+        Returns once the data would survive a crash. Backends which do
+        not keep their data in files ignore this.
+    */
+    virtual void sync ();
 };
 
 }
@@ -62,27 +62,48 @@ public:
     */
     virtual NodeObject::pointer fetch (uint256 const& hash) = 0;
 
+    /** Fetch a group of objects.
+        Objects already in the cache are returned directly. The remainder
+        are read from the backend in a single batched request, which is
+        much cheaper than fetching them one at a time.
+
+        @note This can be called concurrently.
+        @param hashes The keys of the objects to retrieve.
+        @return One object per key in the same order, or nullptr where
+                the object couldn't be retrieved.
+    */
+    virtual std::vector <NodeObject::pointer> fetchBatch (
+        std::vector <uint256 const*> const& hashes) = 0;
+
     /** Fetch an object without waiting.
         If I/O is required to determine whether or not the object is present,
         `false` is returned. Otherwise, `true` is returned and `object` is set
         to refer to the object, or `nullptr` if the object is not present.
-        If I/O is required, the I/O is scheduled.
+
+        If I/O is required, the I/O is scheduled at the given priority and
+        `callback` is invoked exactly once, from a read thread, when it
+        completes. Reads of the same key are merged. When the queue for the
+        priority is full the read is instead performed on the calling thread
+        and `true` is returned, which slows callers down to the rate the
+        backend can sustain.
 
         @note This can be called concurrently.
         @param hash The key of the object to retrieve
         @param object The object retrieved
+        @param priority How urgently the object is needed
+        @param callback Called when a scheduled read completes. May be empty.
         @return Whether the operation completed
+        @see PendingReads
     */
-    virtual bool asyncFetch (uint256 const& hash, NodeObject::pointer& object) = 0;
-
-    /** Wait for all currently pending async reads to complete.
-    */
-    virtual void waitReads () = 0;
+    virtual bool asyncFetch (uint256 const& hash, NodeObject::pointer& object,
+        ReadPriority priority, ReadCallback const& callback) = 0;
 
     /** Get the maximum number of async reads the node store prefers.
+        This shrinks as the read queue for the priority fills up.
+        @param priority The priority the reads will be issued at.
         @return The number of async reads preferred.
     */
-    virtual int getDesiredAsyncReadCount () = 0;
+    virtual int getDesiredAsyncReadCount (ReadPriority priority) = 0;
 
     /** Store the object.
 
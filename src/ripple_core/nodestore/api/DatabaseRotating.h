@@ -0,0 +1,68 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_DATABASEROTATING_H_INCLUDED
+#define RIPPLE_NODESTORE_DATABASEROTATING_H_INCLUDED
+
+namespace ripple {
+namespace NodeStore {
+
+/** A Database whose contents are kept in generations of backends.
+
+    New objects are written to the newest generation, and objects read
+    from an older generation are copied into the newest. Once everything
+    still needed has been copied forward, the oldest generation can be
+    dropped, which deletes its files. This bounds the size of the store
+    without deleting individual objects.
+
+    @see RotatingBackend
+*/
+class DatabaseRotating : public Database
+{
+public:
+    /** Start a new generation.
+        The backend becomes the destination of all writes.
+    */
+    virtual void rotate (std::unique_ptr <Backend> backend) = 0;
+
+    /** Make sure an object is in the newest generation.
+        @note This can be called concurrently.
+        @return `false` if the object is not in any generation.
+    */
+    virtual bool copyForward (uint256 const& hash) = 0;
+
+    /** Drop the oldest generation and delete its files.
+        @return `false` if there was only one generation.
+    */
+    virtual bool dropOldest () = 0;
+
+    /** Make everything written to the newest generation durable.
+        Called before dropping a generation, so that objects copied
+        forward cannot be lost along with it.
+    */
+    virtual void syncNewest () = 0;
+
+    /** Return the number of generations. */
+    virtual std::size_t getGenerations () const = 0;
+};
+
+}
+}
+
+#endif
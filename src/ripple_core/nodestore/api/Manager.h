@@ -73,6 +73,21 @@ public:
         Scheduler& scheduler, beast::Journal journal, int readThreads,
             Parameters const& backendParameters,
                 Parameters fastBackendParameters = Parameters ()) = 0;
+
+    /** Construct a node store database made of generations of backends.
+
+        @param name A diagnostic label for the database.
+        @param scheduler The scheduler to use for performing asynchronous tasks.
+        @param readThreads The number of async read threads to create
+        @param backends The generations, newest first. There must be at
+                        least one.
+
+        @return The opened database.
+        @see DatabaseRotating
+    */
+    virtual std::unique_ptr <DatabaseRotating> make_DatabaseRotating (
+        std::string const& name, Scheduler& scheduler, beast::Journal journal,
+            int readThreads, std::vector <std::unique_ptr <Backend>> backends) = 0;
 };
 
 //------------------------------------------------------------------------------
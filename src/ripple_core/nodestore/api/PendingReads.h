@@ -0,0 +1,71 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_PENDINGREADS_H_INCLUDED
+#define RIPPLE_NODESTORE_PENDINGREADS_H_INCLUDED
+
+#include <condition_variable>
+#include <mutex>
+
+namespace ripple {
+namespace NodeStore {
+
+/** Tracks a group of asynchronous reads so the caller can wait for them.
+
+    Use this instead of waiting on the whole read queue: wait() returns
+    as soon as the reads issued through this object have completed,
+    regardless of how many other reads are pending.
+
+    The completion callbacks hold a reference, so it is safe to abandon
+    the object while reads are still in flight.
+*/
+class PendingReads : public std::enable_shared_from_this <PendingReads>
+{
+public:
+    typedef std::shared_ptr <PendingReads> pointer;
+
+    static pointer New ();
+
+    /** Fetch an object without waiting.
+        This has the same semantics as Database::asyncFetch. When
+        `false` is returned, the read is tracked by this object.
+    */
+    bool asyncFetch (Database& database, uint256 const& hash,
+        NodeObject::Ptr& object, ReadPriority priority);
+
+    /** Block until all the tracked reads have completed. */
+    void wait ();
+
+    /** Returns the number of tracked reads that have not completed. */
+    int getPendingCount ();
+
+private:
+    PendingReads ();
+
+    void onRead ();
+
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    int m_pending;
+};
+
+}
+}
+
+#endif
@@ -45,6 +45,24 @@ enum Status
 /** A batch of NodeObjects to write at once. */
 typedef std::vector <NodeObject::Ptr> Batch;
 
+/** Urgency of an asynchronous read.
+    Pending reads are always serviced most urgent first, so reads needed
+    by consensus or the current ledger are never queued behind history.
+*/
+enum ReadPriority
+{
+    readHistory,
+    readNormal,
+    readUrgent,
+
+    readPriorityCount
+};
+
+/** Called when an asynchronous read completes.
+    The object is `nullptr` if it could not be found.
+*/
+typedef std::function <void (NodeObject::Ptr const&)> ReadCallback;
+
 /** A list of key/value parameter pairs passed to the backend. */
 // VFALCO TODO Use std::string, pair, vector
 typedef beast::StringPairArray Parameters;
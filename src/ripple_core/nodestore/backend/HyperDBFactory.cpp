@@ -94,14 +94,49 @@ public:
     //--------------------------------------------------------------------------
 
     Status fetch (void const* key, NodeObject::Ptr* pObject)
+    {
+        hyperleveldb::ReadOptions const options;
+        return fetch (options, key, pObject);
+    }
+
+    std::vector <Status> fetchBatch (std::vector <uint256 const*> const& hashes,
+        std::vector <NodeObject::Ptr>& objects)
+    {
+        std::vector <Status> results (hashes.size (), ok);
+        objects.resize (hashes.size ());
+
+        // Visit the keys in database order so consecutive lookups
+        // hit the same tables and blocks.
+        std::vector <std::size_t> order (hashes.size ());
+        for (std::size_t i = 0; i < order.size (); ++i)
+            order [i] = i;
+        std::sort (order.begin (), order.end (),
+            [&hashes] (std::size_t lhs, std::size_t rhs)
+            {
+                return memcmp (hashes [lhs]->cbegin (),
+                    hashes [rhs]->cbegin (), uint256::bytes) < 0;
+            });
+
+        // All lookups see the same consistent view
+        hyperleveldb::ReadOptions options;
+        options.snapshot = m_db->GetSnapshot ();
+
+        for (std::size_t i : order)
+            results [i] = fetch (options, hashes [i]->cbegin (), &objects [i]);
+
+        m_db->ReleaseSnapshot (options.snapshot);
+
+        return results;
+    }
+
+    Status fetch (hyperleveldb::ReadOptions const& options,
+        void const* key, NodeObject::Ptr* pObject)
     {
         pObject->reset ();
 
         Status status (ok);
 
-        hyperleveldb::ReadOptions const options;
         hyperleveldb::Slice const slice (static_cast <char const*> (key), m_keyBytes);
-
         std::string string;
 
         hyperleveldb::Status getStatus = m_db->Get (options, slice, &string);
@@ -32,6 +32,7 @@ public:
     BatchWriter m_batch;
     std::string m_name;
     std::unique_ptr <leveldb::DB> m_db;
+    bool m_deletePath;
 
     LevelDBBackend (int keyBytes, Parameters const& keyValues,
         Scheduler& scheduler, beast::Journal journal)
@@ -40,6 +41,7 @@ public:
         , m_scheduler (scheduler)
         , m_batch (*this, scheduler)
         , m_name (keyValues ["path"].toStdString ())
+        , m_deletePath (false)
     {
         if (m_name.empty())
             throw std::runtime_error ("Missing path in LevelDBFactory backend");
@@ -79,6 +81,20 @@ public:
         m_db.reset (db);
     }
 
+    ~LevelDBBackend ()
+    {
+        if (m_deletePath)
+        {
+            m_db.reset ();
+
+            boost::system::error_code ec;
+            boost::filesystem::remove_all (m_name, ec);
+            if (ec)
+                m_journal.error <<
+                    "Unable to remove '" << m_name << "': " << ec.message ();
+        }
+    }
+
     std::string getName()
     {
         return m_name;
@@ -87,12 +103,48 @@ public:
     //--------------------------------------------------------------------------
 
     Status fetch (void const* key, NodeObject::Ptr* pObject)
+    {
+        leveldb::ReadOptions const options;
+        return fetch (options, key, pObject);
+    }
+
+    std::vector <Status> fetchBatch (std::vector <uint256 const*> const& hashes,
+        std::vector <NodeObject::Ptr>& objects)
+    {
+        std::vector <Status> results (hashes.size (), ok);
+        objects.resize (hashes.size ());
+
+        // Visit the keys in database order so consecutive lookups
+        // hit the same tables and blocks.
+        std::vector <std::size_t> order (hashes.size ());
+        for (std::size_t i = 0; i < order.size (); ++i)
+            order [i] = i;
+        std::sort (order.begin (), order.end (),
+            [&hashes] (std::size_t lhs, std::size_t rhs)
+            {
+                return memcmp (hashes [lhs]->cbegin (),
+                    hashes [rhs]->cbegin (), uint256::bytes) < 0;
+            });
+
+        // All lookups see the same consistent view
+        leveldb::ReadOptions options;
+        options.snapshot = m_db->GetSnapshot ();
+
+        for (std::size_t i : order)
+            results [i] = fetch (options, hashes [i]->cbegin (), &objects [i]);
+
+        m_db->ReleaseSnapshot (options.snapshot);
+
+        return results;
+    }
+
+    Status fetch (leveldb::ReadOptions const& options,
+        void const* key, NodeObject::Ptr* pObject)
     {
         pObject->reset ();
 
         Status status (ok);
 
-        leveldb::ReadOptions const options;
         leveldb::Slice const slice (static_cast <char const*> (key), m_keyBytes);
         std::string string;
 
@@ -194,11 +246,71 @@ public:
         }
     }
 
+    bool visitFrom (void const* key, bool forward,
+        std::function <bool (NodeObject::Ptr const&)> const& callback)
+    {
+        leveldb::ReadOptions const options;
+
+        std::unique_ptr <leveldb::Iterator> it (m_db->NewIterator (options));
+
+        leveldb::Slice const start (static_cast <char const*> (key), m_keyBytes);
+
+        it->Seek (start);
+
+        if (! forward)
+        {
+            // Seek finds the first key at or after the start
+            if (! it->Valid ())
+                it->SeekToLast ();
+            else if (it->key ().compare (start) > 0)
+                it->Prev ();
+        }
+
+        for (; it->Valid (); forward ? it->Next () : it->Prev ())
+        {
+            if (it->key ().size () != m_keyBytes)
+                continue;
+
+            DecodedBlob decoded (it->key ().data (),
+                                            it->value ().data (),
+                                            it->value ().size ());
+
+            if (! decoded.wasOk ())
+            {
+                WriteLog (lsFATAL, NodeObject) << "Corrupt NodeObject #" << uint256 (it->key ().data ());
+                continue;
+            }
+
+            if (! callback (decoded.createObject ()))
+                break;
+        }
+
+        return true;
+    }
+
     int getWriteLoad ()
     {
         return m_batch.getWriteLoad ();
     }
 
+    void setDeletePath ()
+    {
+        m_deletePath = true;
+    }
+
+    void sync ()
+    {
+        m_batch.waitForWriting ();
+
+        // An empty synced write flushes the log behind earlier writes
+        leveldb::WriteOptions options;
+        options.sync = true;
+
+        leveldb::WriteBatch wb;
+
+        m_db->Write (options, &wb).ok ();
+    }
+
     //--------------------------------------------------------------------------
 
     void writeBatch (Batch const& batch)
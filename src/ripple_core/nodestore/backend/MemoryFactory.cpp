@@ -66,6 +66,17 @@ public:
         return ok;
     }
 
+    std::vector <Status> fetchBatch (std::vector <uint256 const*> const& hashes,
+        std::vector <NodeObject::Ptr>& objects)
+    {
+        objects.resize (hashes.size ());
+
+        for (std::size_t i = 0; i < hashes.size (); ++i)
+            fetch (hashes [i]->cbegin (), &objects [i]);
+
+        return std::vector <Status> (hashes.size (), ok);
+    }
+
     void store (NodeObject::ref object)
     {
         Map::iterator iter = m_map.find (object->getHash ());
@@ -88,6 +99,33 @@ public:
             callback.visitObject (iter->second);
     }
 
+    bool visitFrom (void const* key, bool forward,
+        std::function <bool (NodeObject::Ptr const&)> const& callback)
+    {
+        uint256 const start (uint256::fromVoid (key));
+
+        if (forward)
+        {
+            for (Map::const_iterator iter = m_map.lower_bound (start);
+                iter != m_map.end (); ++iter)
+            {
+                if (! callback (iter->second))
+                    break;
+            }
+        }
+        else
+        {
+            for (Map::const_reverse_iterator iter (m_map.upper_bound (start));
+                iter != m_map.rend (); ++iter)
+            {
+                if (! callback (iter->second))
+                    break;
+            }
+        }
+
+        return true;
+    }
+
     int getWriteLoad ()
     {
         return 0;
@@ -40,6 +40,13 @@ public:
     {
         return notFound;
     }
+
+    std::vector <Status> fetchBatch (std::vector <uint256 const*> const& hashes,
+        std::vector <NodeObject::Ptr>& objects)
+    {
+        objects.assign (hashes.size (), NodeObject::Ptr ());
+        return std::vector <Status> (hashes.size (), notFound);
+    }
     
     void store (NodeObject::ref object)
     {
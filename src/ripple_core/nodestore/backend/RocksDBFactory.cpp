@@ -83,6 +83,7 @@ public:
     BatchWriter m_batch;
     std::string m_name;
     std::unique_ptr <rocksdb::DB> m_db;
+    bool m_deletePath;
 
     RocksDBBackend (int keyBytes, Parameters const& keyValues,
         Scheduler& scheduler, beast::Journal journal, RocksDBEnv* env)
@@ -91,6 +92,7 @@ public:
         , m_scheduler (scheduler)
         , m_batch (*this, scheduler)
         , m_name (keyValues ["path"].toStdString ())
+        , m_deletePath (false)
     {
         if (m_name.empty())
             throw std::runtime_error ("Missing path in RocksDBFactory backend");
@@ -146,6 +148,16 @@ public:
 
     ~RocksDBBackend ()
     {
+        if (m_deletePath)
+        {
+            m_db.reset ();
+
+            boost::system::error_code ec;
+            boost::filesystem::remove_all (m_name, ec);
+            if (ec)
+                m_journal.error <<
+                    "Unable to remove '" << m_name << "': " << ec.message ();
+        }
     }
 
     std::string getName()
@@ -157,10 +169,6 @@ public:
 
     Status fetch (void const* key, NodeObject::Ptr* pObject)
     {
-        pObject->reset ();
-
-        Status status (ok);
-
         rocksdb::ReadOptions const options;
         rocksdb::Slice const slice (static_cast <char const*> (key), m_keyBytes);
 
@@ -168,6 +176,42 @@ public:
 
         rocksdb::Status getStatus = m_db->Get (options, slice, &string);
 
+        return decode (key, getStatus, string, pObject);
+    }
+
+    std::vector <Status> fetchBatch (std::vector <uint256 const*> const& hashes,
+        std::vector <NodeObject::Ptr>& objects)
+    {
+        std::vector <rocksdb::Slice> keys;
+        keys.reserve (hashes.size ());
+        BOOST_FOREACH (uint256 const* hash, hashes)
+            keys.push_back (rocksdb::Slice (reinterpret_cast <char const*> (
+                hash->cbegin ()), m_keyBytes));
+
+        rocksdb::ReadOptions const options;
+        std::vector <std::string> values;
+
+        std::vector <rocksdb::Status> const getStatus (
+            m_db->MultiGet (options, keys, &values));
+
+        std::vector <Status> results;
+        results.reserve (hashes.size ());
+        objects.resize (hashes.size ());
+
+        for (std::size_t i = 0; i < hashes.size (); ++i)
+            results.push_back (decode (hashes [i]->cbegin (),
+                getStatus [i], values [i], &objects [i]));
+
+        return results;
+    }
+
+    Status decode (void const* key, rocksdb::Status const& getStatus,
+        std::string const& string, NodeObject::Ptr* pObject)
+    {
+        pObject->reset ();
+
+        Status status (ok);
+
         if (getStatus.ok ())
         {
             DecodedBlob decoded (key, string.data (), string.size ());
@@ -266,11 +310,71 @@ public:
         }
     }
 
+    bool visitFrom (void const* key, bool forward,
+        std::function <bool (NodeObject::Ptr const&)> const& callback)
+    {
+        rocksdb::ReadOptions const options;
+
+        std::unique_ptr <rocksdb::Iterator> it (m_db->NewIterator (options));
+
+        rocksdb::Slice const start (static_cast <char const*> (key), m_keyBytes);
+
+        it->Seek (start);
+
+        if (! forward)
+        {
+            // Seek finds the first key at or after the start
+            if (! it->Valid ())
+                it->SeekToLast ();
+            else if (it->key ().compare (start) > 0)
+                it->Prev ();
+        }
+
+        for (; it->Valid (); forward ? it->Next () : it->Prev ())
+        {
+            if (it->key ().size () != m_keyBytes)
+                continue;
+
+            DecodedBlob decoded (it->key ().data (),
+                                            it->value ().data (),
+                                            it->value ().size ());
+
+            if (! decoded.wasOk ())
+            {
+                WriteLog (lsFATAL, NodeObject) << "Corrupt NodeObject #" << uint256 (it->key ().data ());
+                continue;
+            }
+
+            if (! callback (decoded.createObject ()))
+                break;
+        }
+
+        return true;
+    }
+
     int getWriteLoad ()
     {
         return m_batch.getWriteLoad ();
     }
 
+    void setDeletePath ()
+    {
+        m_deletePath = true;
+    }
+
+    void sync ()
+    {
+        m_batch.waitForWriting ();
+
+        // An empty synced write flushes the log behind earlier writes
+        rocksdb::WriteOptions options;
+        options.sync = true;
+
+        rocksdb::WriteBatch wb;
+
+        m_db->Write (options, &wb).ok ();
+    }
+
     //--------------------------------------------------------------------------
 
     void writeBatch (Batch const& batch)
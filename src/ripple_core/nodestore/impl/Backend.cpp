@@ -24,5 +24,19 @@ Backend::~Backend ()
 {
 }
 
+bool Backend::visitFrom (void const*, bool,
+    std::function <bool (NodeObject::Ptr const&)> const&)
+{
+    return false;
+}
+
+void Backend::setDeletePath ()
+{
+}
+
+void Backend::sync ()
+{
+}
+
 }
 }
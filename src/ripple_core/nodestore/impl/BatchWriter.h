@@ -66,10 +66,12 @@ public:
     /** Get an estimate of the amount of writing I/O pending. */
     int getWriteLoad ();
 
+    /** Wait until everything stored so far has been written out. */
+    void waitForWriting ();
+
 private:
     void performScheduledTask ();
     void writeBatch ();
-    void waitForWriting ();
 
 private:
     typedef std::recursive_mutex LockType;
@@ -41,19 +41,16 @@ public:
     std::unique_ptr <Backend> m_fastBackend;
 
     // Positive cache
-    TaggedCache <uint256, NodeObject> m_cache;
+    ShardedTaggedCache <uint256, NodeObject> m_cache;
 
     // Negative cache
     KeyCache <uint256> m_negCache;
 
     std::mutex                m_readLock;
     std::condition_variable   m_readCondVar;
-    std::condition_variable   m_readGenCondVar;
-    std::set <uint256>        m_readSet;        // set of reads to do
-    uint256                   m_readLast;       // last hash read
+    ReadQueue                 m_readQueue;      // reads to do
     std::vector <std::thread> m_readThreads;
     bool                      m_readShut;
-    uint64_t                  m_readGen;        // current read generation
 
     DatabaseImp (std::string const& name,
                  Scheduler& scheduler,
@@ -69,8 +66,8 @@ public:
             get_seconds_clock (), LogPartition::getJournal <TaggedCacheLog> ())
         , m_negCache ("NodeStore", get_seconds_clock (),
             cacheTargetSize, cacheTargetSeconds)
+        , m_readQueue (asyncReadQueueLimit)
         , m_readShut (false)
-        , m_readGen (0)
     {
         for (int i = 0; i < readThreads; ++i)
             m_readThreads.push_back (std::thread (&DatabaseImp::threadEntry, this));
@@ -82,11 +79,22 @@ public:
             std::unique_lock <std::mutex> lock (m_readLock);
             m_readShut = true;
             m_readCondVar.notify_all ();
-            m_readGenCondVar.notify_all ();
         }
 
         BOOST_FOREACH (std::thread& th, m_readThreads)
             th.join ();
+
+        // Let anyone still waiting know their reads will never happen
+        std::vector <ReadQueue::Read> reads;
+        m_readQueue.pop (m_readQueue.size (), reads);
+        while (! reads.empty ())
+        {
+            BOOST_FOREACH (ReadQueue::Read const& read, reads)
+                BOOST_FOREACH (ReadCallback const& callback, read.callbacks)
+                    callback (NodeObject::Ptr ());
+            reads.clear ();
+            m_readQueue.pop (m_readQueue.size (), reads);
+        }
     }
 
     beast::String getName () const
@@ -97,7 +105,8 @@ public:
 
     //------------------------------------------------------------------------------
 
-    bool asyncFetch (uint256 const& hash, NodeObject::pointer& object)
+    bool asyncFetch (uint256 const& hash, NodeObject::pointer& object,
+        ReadPriority priority, ReadCallback const& callback)
     {
         // See if the object is in cache
         object = m_cache.fetch (hash);
@@ -107,31 +116,29 @@ public:
         {
             // No. Post a read
             std::unique_lock <std::mutex> lock (m_readLock);
-            if (m_readSet.insert (hash).second)
+            if (m_readQueue.insert (hash, priority, callback))
+            {
                 m_readCondVar.notify_one ();
+                return false;
+            }
         }
 
-        return false;
+        // The queue is full, so the caller pays for the read
+        object = fetch (hash);
+        return true;
     }
 
-    void waitReads ()
+    int getDesiredAsyncReadCount (ReadPriority priority)
     {
+        std::size_t available;
         {
             std::unique_lock <std::mutex> lock (m_readLock);
-
-            // Wake in two generations
-            std::uint64_t const wakeGeneration = m_readGen + 2;
-
-            while (!m_readShut && !m_readSet.empty () && (m_readGen < wakeGeneration))
-                m_readGenCondVar.wait (lock);
+            available = m_readQueue.available (priority);
         }
 
-    }
-
-    int getDesiredAsyncReadCount ()
-    {
         // We prefer a client not fill our cache
-        return m_cache.getTargetSize() / 4;
+        return std::min (static_cast <int> (available),
+            m_cache.getTargetSize() / 4);
     }
 
     NodeObject::Ptr fetch (uint256 const& hash)
@@ -211,6 +218,106 @@ public:
 
         Status const status = backend.fetch (hash.begin (), &object);
 
+        checkStatus (status, hash);
+
+        return object;
+    }
+
+    std::vector <NodeObject::Ptr> fetchBatch (
+        std::vector <uint256 const*> const& hashes)
+    {
+        std::vector <NodeObject::Ptr> objects (hashes.size ());
+
+        // Satisfy what we can from the caches
+        //
+        std::vector <std::size_t> wanted;
+        for (std::size_t i = 0; i < hashes.size (); ++i)
+        {
+            objects [i] = m_cache.fetch (*hashes [i]);
+
+            if (objects [i] == nullptr &&
+                    ! m_negCache.touch_if_exists (*hashes [i]))
+                wanted.push_back (i);
+        }
+
+        if (wanted.empty ())
+            return objects;
+
+        // Check the fast backend database if we have one
+        //
+        if (m_fastBackend != nullptr)
+            fetchBatchInternal (*m_fastBackend, hashes, wanted, objects);
+
+        // Whatever is left comes from the main database
+        //
+        std::vector <std::size_t> slow;
+        BOOST_FOREACH (std::size_t i, wanted)
+        {
+            if (objects [i] == nullptr)
+                slow.push_back (i);
+        }
+
+        if (! slow.empty ())
+            fetchBatchInternal (*m_backend, hashes, slow, objects);
+
+        BOOST_FOREACH (std::size_t i, wanted)
+        {
+            uint256 const& hash (*hashes [i]);
+
+            if (objects [i] == nullptr)
+            {
+                // Just in case a write occurred
+                objects [i] = m_cache.fetch (hash);
+
+                if (objects [i] == nullptr)
+                    m_negCache.insert (hash);
+            }
+            else
+            {
+                // Ensure all threads get the same object
+                //
+                m_cache.canonicalize (hash, objects [i]);
+            }
+        }
+
+        // If we have a fast back end, store what we read from the
+        // main database there for later.
+        //
+        if (m_fastBackend != nullptr)
+        {
+            BOOST_FOREACH (std::size_t i, slow)
+            {
+                if (objects [i] != nullptr)
+                    m_fastBackend->store (objects [i]);
+            }
+        }
+
+        return objects;
+    }
+
+    // Fetch the objects at the given indexes with one backend request
+    void fetchBatchInternal (Backend& backend,
+        std::vector <uint256 const*> const& hashes,
+            std::vector <std::size_t> const& indexes,
+                std::vector <NodeObject::Ptr>& objects)
+    {
+        std::vector <uint256 const*> keys;
+        keys.reserve (indexes.size ());
+        BOOST_FOREACH (std::size_t i, indexes)
+            keys.push_back (hashes [i]);
+
+        std::vector <NodeObject::Ptr> results;
+        std::vector <Status> const status (backend.fetchBatch (keys, results));
+
+        for (std::size_t i = 0; i < indexes.size (); ++i)
+        {
+            checkStatus (status [i], *keys [i]);
+            objects [indexes [i]] = results [i];
+        }
+    }
+
+    void checkStatus (Status status, uint256 const& hash)
+    {
         switch (status)
         {
         case ok:
@@ -227,8 +334,6 @@ public:
             WriteLog (lsWARNING, NodeObject) << "Unknown status=" << status;
             break;
         }
-
-        return object;
     }
 
     //------------------------------------------------------------------------------
@@ -286,41 +391,40 @@ public:
     void threadEntry ()
     {
         beast::Thread::setCurrentThreadName ("prefetch");
+        std::vector <ReadQueue::Read> reads;
+        reads.reserve (asyncReadBatchSize);
+
         while (1)
         {
-            uint256 hash;
+            reads.clear ();
 
             {
                 std::unique_lock <std::mutex> lock (m_readLock);
 
-                while (!m_readShut && m_readSet.empty ())
-                {
-                    // all work is done
-                    m_readGenCondVar.notify_all ();
+                while (!m_readShut && m_readQueue.empty ())
                     m_readCondVar.wait (lock);
-                }
 
                 if (m_readShut)
                     break;
 
-                // Read in key order to make the back end more efficient
-                std::set <uint256>::iterator it = m_readSet.lower_bound (m_readLast);
-                if (it == m_readSet.end ())
-                {
-                    it = m_readSet.begin ();
+                // Most urgent first, in key order to make
+                // the back end more efficient
+                m_readQueue.pop (asyncReadBatchSize, reads);
+            }
 
-                    // A generation has completed
-                    ++m_readGen;
-                    m_readGenCondVar.notify_all ();
-                }
+            // Perform the reads
+            std::vector <uint256 const*> keys;
+            keys.reserve (reads.size ());
+            BOOST_FOREACH (ReadQueue::Read const& read, reads)
+                keys.push_back (&read.hash);
 
-                hash = *it;
-                m_readSet.erase (it);
-                m_readLast = hash;
-            }
+            std::vector <NodeObject::Ptr> const objects (fetchBatch (keys));
 
-            // Perform the read
-            fetch (hash);
+            for (std::size_t i = 0; i < reads.size (); ++i)
+            {
+                BOOST_FOREACH (ReadCallback const& callback, reads [i].callbacks)
+                    callback (objects [i]);
+            }
          }
      }
 
@@ -0,0 +1,151 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_DATABASEROTATINGIMP_H_INCLUDED
+#define RIPPLE_NODESTORE_DATABASEROTATINGIMP_H_INCLUDED
+
+namespace ripple {
+namespace NodeStore {
+
+class DatabaseRotatingImp
+    : public DatabaseRotating
+    , public beast::LeakChecked <DatabaseRotatingImp>
+{
+public:
+    // Owned by m_database
+    RotatingBackend* m_backend;
+    DatabaseImp m_database;
+
+    DatabaseRotatingImp (std::string const& name,
+                         Scheduler& scheduler,
+                         int readThreads,
+                         std::unique_ptr <RotatingBackend> backend,
+                         beast::Journal journal)
+        : m_backend (backend.get ())
+        , m_database (name, scheduler, readThreads,
+            std::move (backend), nullptr, journal)
+    {
+    }
+
+    //--------------------------------------------------------------------------
+
+    void rotate (std::unique_ptr <Backend> backend)
+    {
+        m_backend->rotate (std::move (backend));
+    }
+
+    bool copyForward (uint256 const& hash)
+    {
+        // A cached object may only be in an older generation
+        NodeObject::Ptr object (m_database.m_cache.fetch (hash));
+        if (object != nullptr)
+        {
+            m_backend->storeNewest (object);
+            return true;
+        }
+
+        // A backend read copies the object forward if needed
+        return m_database.fetch (hash) != nullptr;
+    }
+
+    bool dropOldest ()
+    {
+        return m_backend->dropOldest ();
+    }
+
+    void syncNewest ()
+    {
+        m_backend->sync ();
+    }
+
+    std::size_t getGenerations () const
+    {
+        return m_backend->size ();
+    }
+
+    //--------------------------------------------------------------------------
+
+    beast::String getName () const
+    {
+        return m_database.getName ();
+    }
+
+    NodeObject::Ptr fetch (uint256 const& hash)
+    {
+        return m_database.fetch (hash);
+    }
+
+    std::vector <NodeObject::Ptr> fetchBatch (
+        std::vector <uint256 const*> const& hashes)
+    {
+        return m_database.fetchBatch (hashes);
+    }
+
+    bool asyncFetch (uint256 const& hash, NodeObject::pointer& object,
+        ReadPriority priority, ReadCallback const& callback)
+    {
+        return m_database.asyncFetch (hash, object, priority, callback);
+    }
+
+    int getDesiredAsyncReadCount (ReadPriority priority)
+    {
+        return m_database.getDesiredAsyncReadCount (priority);
+    }
+
+    void store (NodeObjectType type, std::uint32_t index,
+        Blob& data, uint256 const& hash)
+    {
+        m_database.store (type, index, data, hash);
+    }
+
+    void visitAll (VisitCallback& callback)
+    {
+        m_database.visitAll (callback);
+    }
+
+    void import (Database& sourceDatabase)
+    {
+        m_database.import (sourceDatabase);
+    }
+
+    int getWriteLoad ()
+    {
+        return m_database.getWriteLoad ();
+    }
+
+    float getCacheHitRate ()
+    {
+        return m_database.getCacheHitRate ();
+    }
+
+    void tune (int size, int age)
+    {
+        m_database.tune (size, age);
+    }
+
+    void sweep ()
+    {
+        m_database.sweep ();
+    }
+};
+
+}
+}
+
+#endif
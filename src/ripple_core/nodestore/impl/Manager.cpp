@@ -124,6 +124,18 @@ public:
         return std::make_unique <DatabaseImp> (name, scheduler, readThreads,
             std::move (backend), std::move (fastBackend), journal);
     }
+
+    std::unique_ptr <DatabaseRotating> make_DatabaseRotating (
+        std::string const& name, Scheduler& scheduler, beast::Journal journal,
+            int readThreads, std::vector <std::unique_ptr <Backend>> backends)
+    {
+        if (backends.empty ())
+            missing_backend ();
+
+        return std::make_unique <DatabaseRotatingImp> (name, scheduler,
+            readThreads, std::make_unique <RotatingBackend> (
+                std::move (backends)), journal);
+    }
 };
 
 //------------------------------------------------------------------------------
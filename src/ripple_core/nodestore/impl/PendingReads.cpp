@@ -0,0 +1,75 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+namespace ripple {
+namespace NodeStore {
+
+PendingReads::pointer PendingReads::New ()
+{
+    return pointer (new PendingReads);
+}
+
+PendingReads::PendingReads ()
+    : m_pending (0)
+{
+}
+
+bool PendingReads::asyncFetch (Database& database, uint256 const& hash,
+    NodeObject::Ptr& object, ReadPriority priority)
+{
+    // Count the read before issuing it, since the
+    // callback can run before asyncFetch returns.
+    {
+        std::lock_guard <std::mutex> lock (m_mutex);
+        ++m_pending;
+    }
+
+    if (database.asyncFetch (hash, object, priority, std::bind (
+            &PendingReads::onRead, shared_from_this ())))
+    {
+        // Completed immediately, the callback will not be called
+        onRead ();
+        return true;
+    }
+
+    return false;
+}
+
+void PendingReads::wait ()
+{
+    std::unique_lock <std::mutex> lock (m_mutex);
+    while (m_pending > 0)
+        m_cond.wait (lock);
+}
+
+int PendingReads::getPendingCount ()
+{
+    std::lock_guard <std::mutex> lock (m_mutex);
+    return m_pending;
+}
+
+void PendingReads::onRead ()
+{
+    std::lock_guard <std::mutex> lock (m_mutex);
+    if (--m_pending == 0)
+        m_cond.notify_all ();
+}
+
+}
+}
@@ -0,0 +1,172 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_READQUEUE_H_INCLUDED
+#define RIPPLE_NODESTORE_READQUEUE_H_INCLUDED
+
+#include <array>
+#include <map>
+#include <set>
+
+namespace ripple {
+namespace NodeStore {
+
+/** Pending asynchronous reads, ordered by priority.
+
+    Each key appears at most once. Requesting a key that is already queued
+    adds the callback to the existing read, and moves the read to the more
+    urgent band if the new request is more urgent.
+
+    Every priority band holds a bounded number of reads. Within a band,
+    reads are handed out in key order, continuing from the last key taken,
+    so the backend sees mostly sequential lookups.
+
+    @note This is not thread safe, the owner provides the locking.
+*/
+class ReadQueue
+{
+public:
+    /** A read handed out to a read thread. */
+    struct Read
+    {
+        uint256 hash;
+        std::vector <ReadCallback> callbacks;
+    };
+
+    /** Create a queue holding at most `limit` reads per priority. */
+    explicit ReadQueue (std::size_t limit)
+        : m_limit (limit)
+    {
+    }
+
+    /** Returns `true` if no reads are pending. */
+    bool empty () const
+    {
+        return m_reads.empty ();
+    }
+
+    /** Returns the total number of pending reads. */
+    std::size_t size () const
+    {
+        return m_reads.size ();
+    }
+
+    /** Returns the number of reads the band still has room for. */
+    std::size_t available (ReadPriority priority) const
+    {
+        std::size_t const used (m_bands [priority].keys.size ());
+        return (used < m_limit) ? (m_limit - used) : 0;
+    }
+
+    /** Queue a read.
+        @param callback Called when the read completes. May be empty.
+        @return `false` if the key was not queued because the band is full.
+    */
+    bool insert (uint256 const& hash, ReadPriority priority,
+        ReadCallback const& callback)
+    {
+        Map::iterator iter (m_reads.find (hash));
+
+        if (iter == m_reads.end ())
+        {
+            if (available (priority) == 0)
+                return false;
+
+            iter = m_reads.insert (std::make_pair (hash, Entry (priority))).first;
+            m_bands [priority].keys.insert (hash);
+        }
+        else if (priority > iter->second.priority && available (priority) > 0)
+        {
+            // Promote the existing read
+            m_bands [iter->second.priority].keys.erase (hash);
+            m_bands [priority].keys.insert (hash);
+            iter->second.priority = priority;
+        }
+
+        if (callback)
+            iter->second.callbacks.push_back (callback);
+
+        return true;
+    }
+
+    /** Remove up to `count` reads from the most urgent non-empty band.
+        The reads are appended to `reads`.
+    */
+    void pop (std::size_t count, std::vector <Read>& reads)
+    {
+        for (int i = readPriorityCount - 1; i >= 0; --i)
+        {
+            Band& band (m_bands [i]);
+
+            if (band.keys.empty ())
+                continue;
+
+            std::set <uint256>::iterator it (band.keys.lower_bound (band.last));
+
+            // Wrap around to the start of the band
+            if (it == band.keys.end ())
+                it = band.keys.begin ();
+
+            while (it != band.keys.end () && count > 0)
+            {
+                Map::iterator const iter (m_reads.find (*it));
+
+                reads.push_back (Read ());
+                reads.back ().hash = *it;
+                reads.back ().callbacks.swap (iter->second.callbacks);
+
+                band.last = *it;
+                m_reads.erase (iter);
+                band.keys.erase (it++);
+                --count;
+            }
+
+            break;
+        }
+    }
+
+private:
+    struct Entry
+    {
+        explicit Entry (ReadPriority priority_)
+            : priority (priority_)
+        {
+        }
+
+        ReadPriority priority;
+        std::vector <ReadCallback> callbacks;
+    };
+
+    struct Band
+    {
+        std::set <uint256> keys;
+        uint256 last;
+    };
+
+    typedef std::map <uint256, Entry> Map;
+
+    std::size_t const m_limit;
+    Map m_reads;
+    std::array <Band, readPriorityCount> m_bands;
+};
+
+}
+}
+
+#endif
@@ -0,0 +1,214 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_NODESTORE_ROTATINGBACKEND_H_INCLUDED
+#define RIPPLE_NODESTORE_ROTATINGBACKEND_H_INCLUDED
+
+namespace ripple {
+namespace NodeStore {
+
+/** A backend made of several generations of another backend.
+
+    Writes always go to the newest generation. Reads search the generations
+    from newest to oldest, and anything found in an older generation is
+    written into the newest one, so that objects which are still in use
+    migrate forward and the oldest generation can be dropped once nothing
+    needs it any more.
+*/
+class RotatingBackend
+    : public Backend
+    , public beast::LeakChecked <RotatingBackend>
+{
+public:
+    typedef std::vector <std::shared_ptr <Backend>> Backends;
+
+    // The backends are ordered newest first
+    explicit RotatingBackend (std::vector <std::unique_ptr <Backend>> backends)
+    {
+        assert (! backends.empty ());
+
+        BOOST_FOREACH (std::unique_ptr <Backend>& backend, backends)
+            m_backends.push_back (std::shared_ptr <Backend> (std::move (backend)));
+    }
+
+    /** Make a new backend the writable generation. */
+    void rotate (std::unique_ptr <Backend> backend)
+    {
+        std::lock_guard <std::mutex> lock (m_mutex);
+        m_backends.insert (m_backends.begin (),
+            std::shared_ptr <Backend> (std::move (backend)));
+    }
+
+    /** Discard the oldest generation and remove its files.
+        The files go away once the last read in progress has finished.
+        @return `false` if there is only one generation.
+    */
+    bool dropOldest ()
+    {
+        std::shared_ptr <Backend> oldest;
+        {
+            std::lock_guard <std::mutex> lock (m_mutex);
+            if (m_backends.size () < 2)
+                return false;
+            oldest = m_backends.back ();
+            m_backends.pop_back ();
+        }
+        oldest->setDeletePath ();
+        return true;
+    }
+
+    /** Return the number of generations. */
+    std::size_t size () const
+    {
+        std::lock_guard <std::mutex> lock (m_mutex);
+        return m_backends.size ();
+    }
+
+    /** Store an object in the writable generation. */
+    void storeNewest (NodeObject::Ptr const& object)
+    {
+        getBackends ().front ()->store (object);
+    }
+
+    //--------------------------------------------------------------------------
+
+    std::string getName ()
+    {
+        return getBackends ().front ()->getName ();
+    }
+
+    Status fetch (void const* key, NodeObject::Ptr* pObject)
+    {
+        Backends const backends (getBackends ());
+        Status result (notFound);
+
+        for (std::size_t i = 0; i < backends.size (); ++i)
+        {
+            pObject->reset ();
+            Status const status (backends [i]->fetch (key, pObject));
+
+            if (status == ok && *pObject != nullptr)
+            {
+                if (i > 0)
+                    backends.front ()->store (*pObject);
+                return ok;
+            }
+
+            // Remember the first failure, but keep looking
+            if (status != ok && status != notFound && result == notFound)
+                result = status;
+        }
+
+        pObject->reset ();
+        return result;
+    }
+
+    std::vector <Status> fetchBatch (std::vector <uint256 const*> const& hashes,
+        std::vector <NodeObject::Ptr>& objects)
+    {
+        Backends const backends (getBackends ());
+        std::vector <Status> results (hashes.size (), notFound);
+        objects.assign (hashes.size (), NodeObject::Ptr ());
+
+        std::vector <std::size_t> wanted (hashes.size ());
+        for (std::size_t i = 0; i < wanted.size (); ++i)
+            wanted [i] = i;
+
+        for (std::size_t b = 0; b < backends.size () && ! wanted.empty (); ++b)
+        {
+            std::vector <uint256 const*> keys;
+            keys.reserve (wanted.size ());
+            BOOST_FOREACH (std::size_t i, wanted)
+                keys.push_back (hashes [i]);
+
+            std::vector <NodeObject::Ptr> found;
+            std::vector <Status> const status (
+                backends [b]->fetchBatch (keys, found));
+
+            std::vector <std::size_t> missing;
+            for (std::size_t k = 0; k < wanted.size (); ++k)
+            {
+                std::size_t const i (wanted [k]);
+
+                if (status [k] == ok && found [k] != nullptr)
+                {
+                    objects [i] = found [k];
+                    results [i] = ok;
+
+                    if (b > 0)
+                        backends.front ()->store (objects [i]);
+                }
+                else
+                {
+                    if (status [k] != ok && status [k] != notFound &&
+                            results [i] == notFound)
+                        results [i] = status [k];
+                    missing.push_back (i);
+                }
+            }
+            wanted.swap (missing);
+        }
+
+        return results;
+    }
+
+    void store (NodeObject::Ptr const& object)
+    {
+        getBackends ().front ()->store (object);
+    }
+
+    void storeBatch (Batch const& batch)
+    {
+        getBackends ().front ()->storeBatch (batch);
+    }
+
+    // Objects which were copied forward are visited more than once
+    void visitAll (VisitCallback& callback)
+    {
+        Backends const backends (getBackends ());
+        BOOST_FOREACH (std::shared_ptr <Backend> const& backend, backends)
+            backend->visitAll (callback);
+    }
+
+    int getWriteLoad ()
+    {
+        return getBackends ().front ()->getWriteLoad ();
+    }
+
+    // Only the newest generation is written to
+    void sync ()
+    {
+        getBackends ().front ()->sync ();
+    }
+
+private:
+    Backends getBackends () const
+    {
+        std::lock_guard <std::mutex> lock (m_mutex);
+        return m_backends;
+    }
+
+    mutable std::mutex m_mutex;
+    Backends m_backends;
+};
+
+}
+}
+
+#endif
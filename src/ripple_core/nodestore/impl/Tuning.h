@@ -30,6 +30,12 @@ enum
 
     // Expiration time for cached nodes
     ,cacheTargetSeconds = 300
+
+    // Maximum number of keys an async read thread fetches at once
+    ,asyncReadBatchSize = 64
+
+    // Maximum number of queued async reads for each priority
+    ,asyncReadQueueLimit = 4096
 };
 
 }
@@ -69,6 +69,34 @@ public:
                 fetchCopyOfBatch (*backend, &copy, batch);
                 expect (areBatchesEqual (batch, copy), "Should be equal");
             }
+
+            {
+                // Read it back in with one batched fetch
+                Batch copy;
+                fetchBatchCopyOfBatch (*backend, &copy, batch);
+                expect (areBatchesEqual (batch, copy), "Should be equal");
+            }
+
+            {
+                // Objects that were never stored must not be found
+                Batch missing;
+                createPredictableBatch (missing, numObjectsToTest, 10, seedValue);
+
+                std::vector <uint256 const*> hashes;
+                for (int i = 0; i < missing.size (); ++i)
+                    hashes.push_back (&missing [i]->getHash ());
+
+                Batch objects;
+                std::vector <Status> const status (backend->fetchBatch (hashes, objects));
+
+                bool allMissing (status.size () == missing.size ());
+                for (int i = 0; i < status.size (); ++i)
+                {
+                    if (status [i] != notFound || objects [i] != nullptr)
+                        allMissing = false;
+                }
+                expect (allMissing, "Should not be found");
+            }
         }
 
         {
@@ -157,6 +157,17 @@ public:
                 expect (areBatchesEqual (batch, copy), "Should be equal");
             }
 
+            {
+                // Re-open the database and read it back in with
+                // one batched fetch, so nothing comes from the cache
+                std::unique_ptr <Database> db (manager->make_Database (
+                    "test", scheduler, j, 2, nodeParams));
+
+                Batch copy;
+                fetchBatchCopyOfBatch (*db, &copy, batch);
+                expect (areBatchesEqual (batch, copy), "Should be equal");
+            }
+
             if (useEphemeralDatabase)
             {
                 // Verify the ephemeral db
@@ -177,6 +188,95 @@ public:
 
     //--------------------------------------------------------------------------
 
+    // True if every object in the batch is in the backend
+    static bool hasBatch (Backend& backend, Batch const& batch)
+    {
+        for (int i = 0; i < batch.size (); ++i)
+        {
+            NodeObject::Ptr object;
+            if (backend.fetch (batch [i]->getHash ().cbegin (), &object) != ok ||
+                    object == nullptr)
+                return false;
+        }
+        return true;
+    }
+
+    void testRotating (std::int64_t const seedValue)
+    {
+        testcase ("rotating");
+
+        std::unique_ptr <Manager> manager (make_Manager ());
+        DummyScheduler scheduler;
+        beast::Journal j;
+
+        beast::StringPairArray params;
+        params.set ("type", "memory");
+
+        Batch first;
+        createPredictableBatch (first, 0, numObjectsToTest, seedValue);
+        Batch second;
+        createPredictableBatch (second, numObjectsToTest, numObjectsToTest, seedValue);
+
+        {
+            std::vector <std::unique_ptr <Backend>> backends;
+            backends.push_back (manager->make_Backend (params, scheduler, j));
+            Backend* const oldest (backends.back ().get ());
+            RotatingBackend backend (std::move (backends));
+
+            storeBatch (backend, first);
+
+            std::unique_ptr <Backend> next (manager->make_Backend (params, scheduler, j));
+            Backend* const newest (next.get ());
+            backend.rotate (std::move (next));
+            expect (backend.size () == 2);
+
+            storeBatch (backend, second);
+            expect (hasBatch (*newest, second), "Writes should go to the newest");
+            expect (! hasBatch (*oldest, second), "Writes should not go to the oldest");
+            expect (! hasBatch (*newest, first));
+
+            Batch copy;
+            fetchBatchCopyOfBatch (backend, &copy, first);
+            expect (areBatchesEqual (first, copy), "Should be equal");
+            expect (hasBatch (*newest, first), "Reads should be copied forward");
+
+            expect (backend.dropOldest ());
+            expect (! backend.dropOldest (), "Should keep the last generation");
+            expect (backend.size () == 1);
+
+            fetchCopyOfBatch (backend, &copy, second);
+            expect (areBatchesEqual (second, copy), "Should be equal");
+        }
+
+        {
+            std::vector <std::unique_ptr <Backend>> backends;
+            backends.push_back (manager->make_Backend (params, scheduler, j));
+            std::unique_ptr <DatabaseRotating> db (manager->make_DatabaseRotating (
+                "test", scheduler, j, 2, std::move (backends)));
+
+            storeBatch (*db, first);
+
+            std::unique_ptr <Backend> next (manager->make_Backend (params, scheduler, j));
+            Backend* const newest (next.get ());
+            db->rotate (std::move (next));
+            expect (db->getGenerations () == 2);
+
+            bool copied (true);
+            for (int i = 0; i < first.size (); ++i)
+                copied = db->copyForward (first [i]->getHash ()) && copied;
+            expect (copied, "Should copy every object");
+
+            db->syncNewest ();
+            expect (hasBatch (*newest, first), "Should be in the newest");
+
+            expect (db->dropOldest ());
+            expect (! db->copyForward (second [0]->getHash ()),
+                "Should not copy a missing object");
+        }
+    }
+
+    //--------------------------------------------------------------------------
+
     void runBackendTests (bool useEphemeralDatabase, std::int64_t const seedValue)
     {
         testNodeStore ("leveldb", useEphemeralDatabase, true, seedValue);
@@ -221,6 +321,8 @@ public:
 
         testNodeStore ("memory", false, false, seedValue);
 
+        testRotating (seedValue);
+
         runBackendTests (false, seedValue);
 
         runBackendTests (true, seedValue);
@@ -0,0 +1,125 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+namespace ripple {
+namespace NodeStore {
+
+// Tests the ordering, merging and limits of the async read queue
+//
+class ReadQueue_test : public TestBase
+{
+public:
+    static uint256 key (int n)
+    {
+        uint256 hash;
+        *hash.begin () = static_cast <unsigned char> (n);
+        return hash;
+    }
+
+    void testPriority ()
+    {
+        testcase ("priority");
+
+        ReadQueue q (16);
+
+        expect (q.insert (key (1), readHistory, ReadCallback ()));
+        expect (q.insert (key (2), readNormal, ReadCallback ()));
+        expect (q.insert (key (3), readUrgent, ReadCallback ()));
+        expect (q.insert (key (4), readHistory, ReadCallback ()));
+        expect (q.size () == 4);
+
+        std::vector <ReadQueue::Read> reads;
+        q.pop (16, reads);
+        expect (reads.size () == 1 && reads [0].hash == key (3),
+            "Urgent reads come first");
+
+        reads.clear ();
+        q.pop (16, reads);
+        expect (reads.size () == 1 && reads [0].hash == key (2),
+            "Normal reads come before history");
+
+        reads.clear ();
+        q.pop (16, reads);
+        expect (reads.size () == 2 &&
+            reads [0].hash == key (1) && reads [1].hash == key (4),
+                "Reads within a band are in key order");
+        expect (q.empty ());
+    }
+
+    void testMerge ()
+    {
+        testcase ("merge");
+
+        ReadQueue q (16);
+
+        int calls (0);
+        ReadCallback const callback (
+            [&calls] (NodeObject::Ptr const&) { ++calls; });
+
+        expect (q.insert (key (1), readHistory, callback));
+        expect (q.insert (key (1), readUrgent, callback));
+        expect (q.insert (key (1), readNormal, ReadCallback ()));
+        expect (q.size () == 1, "Duplicate reads are merged");
+        expect (q.available (readHistory) == 16, "Read was promoted");
+        expect (q.available (readUrgent) == 15);
+
+        std::vector <ReadQueue::Read> reads;
+        q.pop (16, reads);
+        expect (reads.size () == 1 && reads [0].callbacks.size () == 2);
+
+        BOOST_FOREACH (ReadCallback const& cb, reads [0].callbacks)
+            cb (NodeObject::Ptr ());
+        expect (calls == 2);
+    }
+
+    void testLimit ()
+    {
+        testcase ("limit");
+
+        ReadQueue q (2);
+
+        expect (q.insert (key (1), readHistory, ReadCallback ()));
+        expect (q.insert (key (2), readHistory, ReadCallback ()));
+        expect (q.available (readHistory) == 0);
+        expect (! q.insert (key (3), readHistory, ReadCallback ()),
+            "Full band rejects new reads");
+        expect (q.insert (key (2), readHistory, ReadCallback ()),
+            "Full band accepts duplicate reads");
+        expect (q.insert (key (3), readUrgent, ReadCallback ()),
+            "Other bands are unaffected");
+
+        std::vector <ReadQueue::Read> reads;
+        q.pop (1, reads);
+        q.pop (1, reads);
+        expect (reads.size () == 2 && reads [1].hash == key (1));
+        expect (q.available (readHistory) == 1);
+    }
+
+    void run ()
+    {
+        testPriority ();
+        testMerge ();
+        testLimit ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(ReadQueue,ripple_core,ripple);
+
+}
+}
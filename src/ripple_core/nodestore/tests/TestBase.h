@@ -152,6 +152,36 @@ public:
         }
     }
 
+    // Get a copy of a batch in a backend with a single batched fetch
+    void fetchBatchCopyOfBatch (Backend& backend, Batch* pCopy, Batch const& batch)
+    {
+        pCopy->clear ();
+        pCopy->reserve (batch.size ());
+
+        std::vector <uint256 const*> hashes;
+        hashes.reserve (batch.size ());
+        for (int i = 0; i < batch.size (); ++i)
+            hashes.push_back (&batch [i]->getHash ());
+
+        Batch objects;
+        std::vector <Status> const status (backend.fetchBatch (hashes, objects));
+
+        expect (status.size () == batch.size (), "Should have a status per key");
+        expect (objects.size () == batch.size (), "Should have an object per key");
+
+        for (int i = 0; i < status.size (); ++i)
+        {
+            expect (status [i] == ok, "Should be ok");
+
+            if (status [i] == ok)
+            {
+                expect (objects [i] != nullptr, "Should not be null");
+
+                pCopy->push_back (objects [i]);
+            }
+        }
+    }
+
     // Store all objects in a batch
     static void storeBatch (Database& db, Batch const& batch)
     {
@@ -184,6 +214,28 @@ public:
                 pCopy->push_back (object);
         }
     }
+
+    // Fetch all the hashes in one batch with a single batched fetch.
+    static void fetchBatchCopyOfBatch (Database& db,
+                                       Batch* pCopy,
+                                       Batch const& batch)
+    {
+        pCopy->clear ();
+        pCopy->reserve (batch.size ());
+
+        std::vector <uint256 const*> hashes;
+        hashes.reserve (batch.size ());
+        for (int i = 0; i < batch.size (); ++i)
+            hashes.push_back (&batch [i]->getHash ());
+
+        Batch const objects (db.fetchBatch (hashes));
+
+        for (int i = 0; i < objects.size (); ++i)
+        {
+            if (objects [i] != nullptr)
+                pCopy->push_back (objects [i]);
+        }
+    }
 };
 
 }
@@ -0,0 +1,650 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include "../../beast/beast/unit_test/suite.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+
+// The parallel engine runs four SHA-512 computations side by side in the
+// 64-bit lanes of AVX2 registers. It is compiled for the target with a
+// function attribute so the rest of the program does not require AVX2,
+// and only used after checking the processor at runtime.
+//
+#ifndef RIPPLE_SHA512BATCH_AVX2
+# if defined (__x86_64__) && \
+     (defined (__clang__) ? (__clang_major__ > 3 || \
+         (__clang_major__ == 3 && __clang_minor__ >= 8)) : \
+      (defined (__GNUC__) && (__GNUC__ > 4 || \
+         (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))))
+#  define RIPPLE_SHA512BATCH_AVX2 1
+#  define RIPPLE_SHA512BATCH_TARGET __attribute__ ((target ("avx2")))
+# elif defined (_MSC_VER) && defined (_M_X64) && (_MSC_VER >= 1700)
+#  define RIPPLE_SHA512BATCH_AVX2 1
+#  define RIPPLE_SHA512BATCH_TARGET
+# else
+#  define RIPPLE_SHA512BATCH_AVX2 0
+# endif
+#endif
+
+#if RIPPLE_SHA512BATCH_AVX2
+# include <immintrin.h>
+# ifdef _MSC_VER
+#  include <intrin.h>
+# endif
+#endif
+
+namespace ripple {
+
+namespace {
+
+int const sha512BlockSize = 128;
+
+// Number of messages hashed side by side
+int const sha512Lanes = 4;
+
+std::uint64_t const sha512Init [8] =
+{
+    0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL,
+    0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+    0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL,
+    0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+};
+
+std::uint64_t const sha512K [80] =
+{
+    0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL,
+    0xe9b5dba58189dbbcULL, 0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL,
+    0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL, 0xd807aa98a3030242ULL,
+    0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+    0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL,
+    0xc19bf174cf692694ULL, 0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL,
+    0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL, 0x2de92c6f592b0275ULL,
+    0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+    0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL,
+    0xbf597fc7beef0ee4ULL, 0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL,
+    0x06ca6351e003826fULL, 0x142929670a0e6e70ULL, 0x27b70a8546d22ffcULL,
+    0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+    0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL,
+    0x92722c851482353bULL, 0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL,
+    0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL, 0xd192e819d6ef5218ULL,
+    0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+    0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL,
+    0x34b0bcb5e19b48a8ULL, 0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL,
+    0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL, 0x748f82ee5defb2fcULL,
+    0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+    0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL,
+    0xc67178f2e372532bULL, 0xca273eceea26619cULL, 0xd186b8c721c0c207ULL,
+    0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL, 0x06f067aa72176fbaULL,
+    0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+    0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL,
+    0x431d67c49c100d4cULL, 0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL,
+    0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+inline std::uint64_t loadBigEndian64 (unsigned char const* p)
+{
+    return
+        (std::uint64_t (p[0]) << 56) | (std::uint64_t (p[1]) << 48) |
+        (std::uint64_t (p[2]) << 40) | (std::uint64_t (p[3]) << 32) |
+        (std::uint64_t (p[4]) << 24) | (std::uint64_t (p[5]) << 16) |
+        (std::uint64_t (p[6]) <<  8) |  std::uint64_t (p[7]);
+}
+
+inline void storeBigEndian64 (std::uint64_t v, unsigned char* p)
+{
+    for (int i = 7; i >= 0; --i)
+    {
+        p[i] = static_cast <unsigned char> (v);
+        v >>= 8;
+    }
+}
+
+// Total size of a message once padded to whole blocks
+inline std::size_t paddedSize (std::size_t size)
+{
+    // At least one 0x80 byte and a 128-bit length must follow the message
+    return ((size + 17 + sha512BlockSize - 1) / sha512BlockSize) * sha512BlockSize;
+}
+
+#if RIPPLE_SHA512BATCH_AVX2
+
+bool detectAVX2 ()
+{
+#ifdef _MSC_VER
+    int info [4];
+    __cpuid (info, 0);
+    if (info [0] < 7)
+        return false;
+
+    // The OS must preserve the YMM registers across context switches
+    __cpuid (info, 1);
+    bool const osxsave ((info [2] & (1 << 27)) != 0);
+    bool const avx ((info [2] & (1 << 28)) != 0);
+    if (! osxsave || ! avx || ((_xgetbv (0) & 6) != 6))
+        return false;
+
+    __cpuidex (info, 7, 0);
+    return (info [1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init ();
+    return __builtin_cpu_supports ("avx2") != 0;
+#endif
+}
+
+RIPPLE_SHA512BATCH_TARGET
+inline __m256i rotr (__m256i x, int n)
+{
+    return _mm256_or_si256 (_mm256_srli_epi64 (x, n), _mm256_slli_epi64 (x, 64 - n));
+}
+
+/** Run one block of each lane through the compression function.
+    @param state The chaining values, indexed by word and then lane.
+    @param blocks The next block for each lane.
+*/
+RIPPLE_SHA512BATCH_TARGET
+void compressAVX2 (std::uint64_t (&state) [8][sha512Lanes],
+    unsigned char const* const (&blocks) [sha512Lanes])
+{
+    __m256i w [16];
+
+    // Reverses the bytes of each 64-bit word
+    __m256i const swap = _mm256_set_epi8 (
+        8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7,
+        8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+
+    // Load four words from each lane and transpose them so that
+    // each register holds the same word of every lane.
+    for (int t = 0; t < 16; t += 4)
+    {
+        __m256i const r0 = _mm256_shuffle_epi8 (_mm256_loadu_si256 (
+            reinterpret_cast <__m256i const*> (blocks [0] + t * 8)), swap);
+        __m256i const r1 = _mm256_shuffle_epi8 (_mm256_loadu_si256 (
+            reinterpret_cast <__m256i const*> (blocks [1] + t * 8)), swap);
+        __m256i const r2 = _mm256_shuffle_epi8 (_mm256_loadu_si256 (
+            reinterpret_cast <__m256i const*> (blocks [2] + t * 8)), swap);
+        __m256i const r3 = _mm256_shuffle_epi8 (_mm256_loadu_si256 (
+            reinterpret_cast <__m256i const*> (blocks [3] + t * 8)), swap);
+
+        __m256i const lo01 = _mm256_unpacklo_epi64 (r0, r1);
+        __m256i const hi01 = _mm256_unpackhi_epi64 (r0, r1);
+        __m256i const lo23 = _mm256_unpacklo_epi64 (r2, r3);
+        __m256i const hi23 = _mm256_unpackhi_epi64 (r2, r3);
+
+        w [t + 0] = _mm256_permute2x128_si256 (lo01, lo23, 0x20);
+        w [t + 1] = _mm256_permute2x128_si256 (hi01, hi23, 0x20);
+        w [t + 2] = _mm256_permute2x128_si256 (lo01, lo23, 0x31);
+        w [t + 3] = _mm256_permute2x128_si256 (hi01, hi23, 0x31);
+    }
+
+    __m256i a = _mm256_loadu_si256 (reinterpret_cast <__m256i const*> (state [0]));
+    __m256i b = _mm256_loadu_si256 (reinterpret_cast <__m256i const*> (state [1]));
+    __m256i c = _mm256_loadu_si256 (reinterpret_cast <__m256i const*> (state [2]));
+    __m256i d = _mm256_loadu_si256 (reinterpret_cast <__m256i const*> (state [3]));
+    __m256i e = _mm256_loadu_si256 (reinterpret_cast <__m256i const*> (state [4]));
+    __m256i f = _mm256_loadu_si256 (reinterpret_cast <__m256i const*> (state [5]));
+    __m256i g = _mm256_loadu_si256 (reinterpret_cast <__m256i const*> (state [6]));
+    __m256i h = _mm256_loadu_si256 (reinterpret_cast <__m256i const*> (state [7]));
+
+    __m256i const a0 (a), b0 (b), c0 (c), d0 (d), e0 (e), f0 (f), g0 (g), h0 (h);
+
+    for (int t = 0; t < 80; ++t)
+    {
+        __m256i wt;
+
+        if (t < 16)
+        {
+            wt = w [t];
+        }
+        else
+        {
+            // The schedule only ever needs the previous sixteen words
+            __m256i const w15 (w [(t - 15) & 15]);
+            __m256i const w2 (w [(t - 2) & 15]);
+
+            __m256i const s0 = _mm256_xor_si256 (_mm256_xor_si256 (
+                rotr (w15, 1), rotr (w15, 8)), _mm256_srli_epi64 (w15, 7));
+            __m256i const s1 = _mm256_xor_si256 (_mm256_xor_si256 (
+                rotr (w2, 19), rotr (w2, 61)), _mm256_srli_epi64 (w2, 6));
+
+            wt = _mm256_add_epi64 (_mm256_add_epi64 (w [t & 15], s0),
+                _mm256_add_epi64 (w [(t - 7) & 15], s1));
+            w [t & 15] = wt;
+        }
+
+        __m256i const sum1 = _mm256_xor_si256 (_mm256_xor_si256 (
+            rotr (e, 14), rotr (e, 18)), rotr (e, 41));
+        __m256i const ch = _mm256_xor_si256 (
+            _mm256_and_si256 (e, f), _mm256_andnot_si256 (e, g));
+        __m256i const t1 = _mm256_add_epi64 (
+            _mm256_add_epi64 (_mm256_add_epi64 (h, sum1), ch),
+            _mm256_add_epi64 (_mm256_set1_epi64x (sha512K [t]), wt));
+
+        __m256i const sum0 = _mm256_xor_si256 (_mm256_xor_si256 (
+            rotr (a, 28), rotr (a, 34)), rotr (a, 39));
+        __m256i const maj = _mm256_or_si256 (_mm256_and_si256 (a, b),
+            _mm256_and_si256 (c, _mm256_or_si256 (a, b)));
+        __m256i const t2 = _mm256_add_epi64 (sum0, maj);
+
+        h = g;
+        g = f;
+        f = e;
+        e = _mm256_add_epi64 (d, t1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm256_add_epi64 (t1, t2);
+    }
+
+    _mm256_storeu_si256 (reinterpret_cast <__m256i*> (state [0]), _mm256_add_epi64 (a, a0));
+    _mm256_storeu_si256 (reinterpret_cast <__m256i*> (state [1]), _mm256_add_epi64 (b, b0));
+    _mm256_storeu_si256 (reinterpret_cast <__m256i*> (state [2]), _mm256_add_epi64 (c, c0));
+    _mm256_storeu_si256 (reinterpret_cast <__m256i*> (state [3]), _mm256_add_epi64 (d, d0));
+    _mm256_storeu_si256 (reinterpret_cast <__m256i*> (state [4]), _mm256_add_epi64 (e, e0));
+    _mm256_storeu_si256 (reinterpret_cast <__m256i*> (state [5]), _mm256_add_epi64 (f, f0));
+    _mm256_storeu_si256 (reinterpret_cast <__m256i*> (state [6]), _mm256_add_epi64 (g, g0));
+    _mm256_storeu_si256 (reinterpret_cast <__m256i*> (state [7]), _mm256_add_epi64 (h, h0));
+
+    // Avoid the AVX-SSE transition penalty in the caller
+    _mm256_zeroupper ();
+}
+
+bool const sha512Supported (detectAVX2 ());
+
+#else
+
+bool const sha512Supported (false);
+
+#endif
+
+std::atomic <bool> sha512Enabled (sha512Supported);
+
+}
+
+//------------------------------------------------------------------------------
+
+SHA512Batch::SHA512Batch ()
+{
+}
+
+void SHA512Batch::reserve (std::size_t count)
+{
+    m_messages.reserve (count);
+}
+
+void SHA512Batch::add (void const* data, std::size_t size)
+{
+    Message message;
+    message.prefixSize = 0;
+    message.data = static_cast <unsigned char const*> (data);
+    message.size = size;
+    m_messages.push_back (message);
+}
+
+void SHA512Batch::add (std::uint32_t prefix, void const* data, std::size_t size)
+{
+    Message message;
+    message.prefix [0] = static_cast <unsigned char> (prefix >> 24);
+    message.prefix [1] = static_cast <unsigned char> (prefix >> 16);
+    message.prefix [2] = static_cast <unsigned char> (prefix >> 8);
+    message.prefix [3] = static_cast <unsigned char> (prefix);
+    message.prefixSize = 4;
+    message.data = static_cast <unsigned char const*> (data);
+    message.size = size;
+    m_messages.push_back (message);
+}
+
+void SHA512Batch::clear ()
+{
+    m_messages.clear ();
+}
+
+void SHA512Batch::finish (std::vector <uint256>& hashes)
+{
+    hashes.resize (m_messages.size ());
+
+    // A lone message gains nothing from the parallel engine
+    if (m_messages.size () > 1 && sha512Enabled.load ())
+        hashParallel (hashes);
+    else
+        hashScalar (hashes);
+
+    m_messages.clear ();
+}
+
+bool SHA512Batch::isAccelerated ()
+{
+    return sha512Supported;
+}
+
+bool SHA512Batch::setAccelerated (bool enabled)
+{
+    return sha512Enabled.exchange (enabled && sha512Supported);
+}
+
+void SHA512Batch::hashScalar (std::vector <uint256>& hashes) const
+{
+    for (std::size_t i = 0; i < m_messages.size (); ++i)
+    {
+        Message const& message (m_messages [i]);
+
+        uint256 j[2];
+        SHA512_CTX ctx;
+        SHA512_Init (&ctx);
+        SHA512_Update (&ctx, message.prefix, message.prefixSize);
+        SHA512_Update (&ctx, message.data, message.size);
+        SHA512_Final (j[0].begin (), &ctx);
+
+        hashes [i] = j[0];
+    }
+}
+
+unsigned char const* SHA512Batch::getBlock (Message const& message,
+    std::size_t offset, unsigned char* buffer)
+{
+    std::size_t const total (message.prefixSize + message.size);
+
+    // Blocks lying entirely within the data are used in place
+    if (offset >= message.prefixSize && offset + sha512BlockSize <= total)
+        return message.data + (offset - message.prefixSize);
+
+    std::size_t n (0);
+
+    while (n < sha512BlockSize && offset + n < message.prefixSize)
+    {
+        buffer [n] = message.prefix [offset + n];
+        ++n;
+    }
+
+    if (n < sha512BlockSize && offset + n < total)
+    {
+        std::size_t const position (offset + n - message.prefixSize);
+        std::size_t const count (std::min <std::size_t> (
+            sha512BlockSize - n, message.size - position));
+        memcpy (buffer + n, message.data + position, count);
+        n += count;
+    }
+
+    if (n < sha512BlockSize)
+    {
+        memset (buffer + n, 0, sha512BlockSize - n);
+
+        if (offset + n == total)
+            buffer [n] = 0x80;
+
+        // The last block ends with the message length in bits
+        if (offset + sha512BlockSize == paddedSize (total))
+            storeBigEndian64 (std::uint64_t (total) * 8, buffer + sha512BlockSize - 8);
+    }
+
+    return buffer;
+}
+
+void SHA512Batch::hashParallel (std::vector <uint256>& hashes) const
+{
+#if RIPPLE_SHA512BATCH_AVX2
+    struct Lane
+    {
+        std::size_t message;
+        std::size_t offset;
+        std::size_t end;
+        bool active;
+    };
+
+    std::uint64_t state [8][sha512Lanes] = { };
+    unsigned char buffers [sha512Lanes][sha512BlockSize] = { };
+    unsigned char const* blocks [sha512Lanes];
+    Lane lanes [sha512Lanes];
+    std::size_t next (0);
+    int active (0);
+
+    // Give the lane the next message, if there is one
+    auto const start = [&] (int lane)
+    {
+        if (next < m_messages.size ())
+        {
+            Message const& message (m_messages [next]);
+            lanes [lane].message = next++;
+            lanes [lane].offset = 0;
+            lanes [lane].end = paddedSize (message.prefixSize + message.size);
+            lanes [lane].active = true;
+            ++active;
+
+            for (int i = 0; i < 8; ++i)
+                state [i][lane] = sha512Init [i];
+        }
+        else
+        {
+            // Idle lanes hash garbage which is discarded
+            lanes [lane].active = false;
+            blocks [lane] = buffers [lane];
+        }
+    };
+
+    for (int lane = 0; lane < sha512Lanes; ++lane)
+        start (lane);
+
+    while (active > 0)
+    {
+        for (int lane = 0; lane < sha512Lanes; ++lane)
+        {
+            if (lanes [lane].active)
+                blocks [lane] = getBlock (m_messages [lanes [lane].message],
+                    lanes [lane].offset, buffers [lane]);
+        }
+
+        compressAVX2 (state, blocks);
+
+        for (int lane = 0; lane < sha512Lanes; ++lane)
+        {
+            Lane& l (lanes [lane]);
+
+            if (! l.active)
+                continue;
+
+            l.offset += sha512BlockSize;
+
+            if (l.offset == l.end)
+            {
+                // The half hash is the first four words of the digest
+                unsigned char* const out (hashes [l.message].begin ());
+                for (int i = 0; i < 4; ++i)
+                    storeBigEndian64 (state [i][lane], out + i * 8);
+
+                --active;
+                start (lane);
+            }
+        }
+    }
+#else
+    hashScalar (hashes);
+#endif
+}
+
+//------------------------------------------------------------------------------
+
+class SHA512Batch_test : public beast::unit_test::suite
+{
+public:
+    static uint256 reference (std::size_t prefixSize, std::uint32_t prefix,
+        Blob const& data)
+    {
+        uint256 j[2];
+        unsigned char p[4] = {
+            static_cast <unsigned char> (prefix >> 24),
+            static_cast <unsigned char> (prefix >> 16),
+            static_cast <unsigned char> (prefix >> 8),
+            static_cast <unsigned char> (prefix) };
+
+        SHA512_CTX ctx;
+        SHA512_Init (&ctx);
+        SHA512_Update (&ctx, p, prefixSize);
+        SHA512_Update (&ctx, data.empty () ? p : &data.front (), data.size ());
+        SHA512_Final (j[0].begin (), &ctx);
+        return j[0];
+    }
+
+    void testBatch (bool accelerated)
+    {
+        testcase (accelerated ? "parallel" : "scalar");
+
+        bool const previous (SHA512Batch::setAccelerated (accelerated));
+
+        // Sizes around every padding boundary, with and without a prefix
+        std::vector <Blob> messages;
+        for (std::size_t size = 0; size < 600; ++size)
+        {
+            Blob data (size);
+            for (std::size_t i = 0; i < size; ++i)
+                data [i] = static_cast <unsigned char> (i * 31 + size);
+            messages.push_back (data);
+        }
+
+        SHA512Batch batch;
+        std::vector <uint256> expected;
+        for (std::size_t i = 0; i < messages.size (); ++i)
+        {
+            Blob const& data (messages [i]);
+            unsigned char const* const p (data.empty () ? nullptr : &data.front ());
+
+            if (i % 3 == 0)
+            {
+                batch.add (p, data.size ());
+                expected.push_back (reference (0, 0, data));
+            }
+            else
+            {
+                std::uint32_t const prefix (0x4D494E00 + i);
+                batch.add (prefix, p, data.size ());
+                expected.push_back (reference (4, prefix, data));
+            }
+        }
+
+        std::vector <uint256> hashes;
+        batch.finish (hashes);
+        expect (batch.size () == 0);
+        expect (hashes.size () == expected.size ());
+        expect (hashes == expected, "Batch hashes must match OpenSSL");
+
+        // Every batch size up to a few multiples of the lane count
+        bool ok (true);
+        for (std::size_t count = 0; count <= 13; ++count)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+                batch.add (&messages [1 + i * 37].front (), messages [1 + i * 37].size ());
+
+            batch.finish (hashes);
+            if (hashes.size () != count)
+                ok = false;
+
+            for (std::size_t i = 0; ok && i < count; ++i)
+                if (hashes [i] != reference (0, 0, messages [1 + i * 37]))
+                    ok = false;
+        }
+        expect (ok, "Partial batches must match OpenSSL");
+
+        SHA512Batch::setAccelerated (previous);
+    }
+
+    void run ()
+    {
+        testBatch (false);
+
+        if (SHA512Batch::isAccelerated ())
+            testBatch (true);
+        else
+            log << "parallel SHA-512 is not supported on this processor";
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(SHA512Batch,ripple_data,ripple);
+
+//------------------------------------------------------------------------------
+
+/** Compares batch and one at a time hashing throughput. */
+class SHA512Batch_timing_test : public beast::unit_test::suite
+{
+public:
+    typedef std::chrono::steady_clock clock_type;
+
+    enum
+    {
+        batchSize = 256,
+        totalBytes = 64 * 1024 * 1024
+    };
+
+    double measure (std::size_t size, bool accelerated)
+    {
+        SHA512Batch::setAccelerated (accelerated);
+
+        Blob const data (size * batchSize, 0x5A);
+        std::size_t const rounds (std::max <std::size_t> (1,
+            totalBytes / data.size ()));
+
+        SHA512Batch batch;
+        std::vector <uint256> hashes;
+
+        clock_type::time_point const start (clock_type::now ());
+        for (std::size_t r = 0; r < rounds; ++r)
+        {
+            for (std::size_t i = 0; i < batchSize; ++i)
+                batch.add (0x494E4E00, &data [i * size], size);
+            batch.finish (hashes);
+        }
+        double const seconds (std::chrono::duration_cast <
+            std::chrono::duration <double>> (clock_type::now () - start).count ());
+
+        return (double (rounds) * batchSize) / seconds;
+    }
+
+    void run ()
+    {
+        bool const previous (SHA512Batch::setAccelerated (true));
+
+        // Leaf sizes, an inner node and a large transaction
+        std::size_t const sizes [] = { 64, 128, 256, 512, 1024 };
+
+        for (std::size_t size : sizes)
+        {
+            testcase (std::to_string (size) + " bytes");
+
+            double const scalar (measure (size, false));
+            std::stringstream ss;
+            ss << "scalar " << static_cast <std::int64_t> (scalar) << " hashes/sec";
+
+            if (SHA512Batch::isAccelerated ())
+            {
+                double const parallel (measure (size, true));
+                ss << ", parallel " << static_cast <std::int64_t> (parallel) <<
+                    " hashes/sec (" << (parallel / scalar) << "x)";
+            }
+
+            log << ss.str ();
+            pass ();
+        }
+
+        SHA512Batch::setAccelerated (previous);
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(SHA512Batch_timing,ripple_data,ripple);
+
+}
@@ -0,0 +1,100 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_SHA512BATCH_H
+#define RIPPLE_SHA512BATCH_H
+
+namespace ripple {
+
+/** Computes the SHA-512 half of many independent messages at once.
+
+    Messages are queued with add() and hashed together by finish(). When
+    the processor supports it, several messages are run through the SHA-512
+    compression function in parallel SIMD lanes, which is considerably
+    faster than hashing them one by one. Otherwise each message is hashed
+    with OpenSSL.
+
+    The result for each message is the first 256 bits of its SHA-512
+    digest, the same value produced by Serializer::getSHA512Half and
+    Serializer::getPrefixHash.
+
+    The memory passed to add() is not copied; it must remain valid until
+    finish() returns.
+*/
+class SHA512Batch
+{
+public:
+    SHA512Batch ();
+
+    /** Reserve space for the given number of messages. */
+    void reserve (std::size_t count);
+
+    /** Queue a message. */
+    void add (void const* data, std::size_t size);
+
+    /** Queue a message preceded by a big-endian 32-bit prefix.
+        This matches Serializer::getPrefixHash.
+    */
+    void add (std::uint32_t prefix, void const* data, std::size_t size);
+
+    /** Returns the number of queued messages. */
+    std::size_t size () const
+    {
+        return m_messages.size ();
+    }
+
+    /** Discard all queued messages. */
+    void clear ();
+
+    /** Hash every queued message.
+        The hashes are returned in the order the messages were added. The
+        batch is empty afterwards and can be reused.
+    */
+    void finish (std::vector <uint256>& hashes);
+
+    /** Returns `true` if the processor supports the parallel engine. */
+    static bool isAccelerated ();
+
+    /** Enable or disable the parallel engine.
+        This is used by tests and benchmarks to compare the two. Returns the
+        previous setting. Has no effect if the engine is unsupported.
+    */
+    static bool setAccelerated (bool enabled);
+
+private:
+    struct Message
+    {
+        unsigned char prefix [4];
+        std::size_t prefixSize;
+        unsigned char const* data;
+        std::size_t size;
+    };
+
+    void hashScalar (std::vector <uint256>& hashes) const;
+    void hashParallel (std::vector <uint256>& hashes) const;
+
+    static unsigned char const* getBlock (Message const& message,
+        std::size_t offset, unsigned char* buffer);
+
+    std::vector <Message> m_messages;
+};
+
+}
+
+#endif
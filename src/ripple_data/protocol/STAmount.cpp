@@ -21,6 +21,45 @@ namespace ripple {
 
 SETUP_LOG (STAmount)
 
+// Computes (a * b + c) / d with OpenSSL. A quotient which does not fit in
+// 64 bits comes back as all ones, which is what BN_get_word returns.
+static std::uint64_t mulDivBigNum (std::uint64_t a, std::uint64_t b,
+    std::uint64_t c, std::uint64_t d)
+{
+    CBigNum v;
+
+    if ((BN_add_word64 (&v, a) != 1) ||
+            (BN_mul_word64 (&v, b) != 1) ||
+            (BN_add_word64 (&v, c) != 1) ||
+            (BN_div_word64 (&v, d) == ((std::uint64_t) - 1)))
+    {
+        throw std::runtime_error ("internal bn error");
+    }
+
+    return v.getuint64 ();
+}
+
+// Computes (a * b + c) / d without allocating. The result is identical to
+// mulDivBigNum, including when the quotient overflows.
+static std::uint64_t mulDiv (std::uint64_t a, std::uint64_t b,
+    std::uint64_t c, std::uint64_t d)
+{
+#ifdef __SIZEOF_INT128__
+    if (d == 0)
+        throw std::runtime_error ("internal bn error");
+
+    // Cannot overflow: (2^64 - 1)^2 + 2^64 - 1 < 2^128
+    unsigned __int128 const q ((static_cast <unsigned __int128> (a) * b + c) / d);
+
+    if ((q >> 64) != 0)
+        return std::numeric_limits <std::uint64_t>::max ();
+
+    return static_cast <std::uint64_t> (q);
+#else
+    return mulDivBigNum (a, b, c, d);
+#endif
+}
+
 std::uint64_t STAmount::uRateOne  = STAmount::getRate (STAmount (1), STAmount (1));
 
 bool STAmount::issuerFromString (uint160& uDstIssuer, const std::string& sIssuer)
@@ -933,19 +972,10 @@ STAmount STAmount::divide (const STAmount& num, const STAmount& den, const uint1
         }
 
     // Compute (numerator * 10^17) / denominator
-    CBigNum v;
-
-    if ((BN_add_word64 (&v, numVal) != 1) ||
-            (BN_mul_word64 (&v, tenTo17) != 1) ||
-            (BN_div_word64 (&v, denVal) == ((std::uint64_t) - 1)))
-    {
-        throw std::runtime_error ("internal bn error");
-    }
-
     // 10^16 <= quotient <= 10^18
-    assert (BN_num_bytes (&v) <= 64);
+    std::uint64_t const quotient (mulDiv (numVal, tenTo17, 0, denVal));
 
-    return STAmount (uCurrencyID, uIssuerID, v.getuint64 () + 5,
+    return STAmount (uCurrencyID, uIssuerID, quotient + 5,
                      numOffset - denOffset - 17, num.mIsNegative != den.mIsNegative);
 }
 
@@ -990,20 +1020,10 @@ STAmount STAmount::multiply (const STAmount& v1, const STAmount& v2, const uint1
     }
 
     // Compute (numerator * denominator) / 10^14 with rounding
-    // 10^16 <= result <= 10^18
-    CBigNum v;
-
-    if ((BN_add_word64 (&v, value1) != 1) ||
-            (BN_mul_word64 (&v, value2) != 1) ||
-            (BN_div_word64 (&v, tenTo14) == ((std::uint64_t) - 1)))
-    {
-        throw std::runtime_error ("internal bn error");
-    }
-
     // 10^16 <= product <= 10^18
-    assert (BN_num_bytes (&v) <= 64);
+    std::uint64_t const product (mulDiv (value1, value2, 0, tenTo14));
 
-    return STAmount (uCurrencyID, uIssuerID, v.getuint64 () + 7, offset1 + offset2 + 14,
+    return STAmount (uCurrencyID, uIssuerID, product + 7, offset1 + offset2 + 14,
                      v1.mIsNegative != v2.mIsNegative);
 }
 
@@ -1685,6 +1705,96 @@ public:
 
     //--------------------------------------------------------------------------
 
+    // Returns true if both implementations give the same quotient, or both throw
+    static bool sameMulDiv (std::uint64_t a, std::uint64_t b,
+        std::uint64_t c, std::uint64_t d)
+    {
+        std::uint64_t expected (0);
+        bool expectedThrew (false);
+
+        try
+        {
+            expected = mulDivBigNum (a, b, c, d);
+        }
+        catch (std::exception const&)
+        {
+            expectedThrew = true;
+        }
+
+        try
+        {
+            std::uint64_t const actual (mulDiv (a, b, c, d));
+            return ! expectedThrew && (actual == expected);
+        }
+        catch (std::exception const&)
+        {
+            return expectedThrew;
+        }
+    }
+
+    void testMulDiv ()
+    {
+        testcase ("mulDiv");
+
+        // Every combination of boundary values, including quotients which
+        // overflow and division by zero
+        std::uint64_t const edges [] = { 0, 1, 2, 10, tenTo14m1, tenTo14,
+            STAmount::cMinValue, STAmount::cMinValue + 1, STAmount::cMaxValue,
+            tenTo17, STAmount::cMaxNativeN, STAmount::cMaxNative,
+            0xFFFFFFFFull, 0x100000000ull, 0x8000000000000000ull,
+            std::numeric_limits <std::uint64_t>::max () };
+
+        int failures (0);
+
+        for (auto a : edges)
+            for (auto b : edges)
+                for (auto c : edges)
+                    for (auto d : edges)
+                        if (! sameMulDiv (a, b, c, d))
+                            ++failures;
+
+        expect (failures == 0, "Boundary values must match BIGNUM");
+
+        // The operands the STAmount operations produce
+        std::mt19937_64 gen (42);
+        std::uniform_int_distribution <std::uint64_t> mantissa (
+            STAmount::cMinValue, STAmount::cMaxValue);
+        std::uniform_int_distribution <std::uint64_t> native (
+            STAmount::cMinValue, STAmount::cMaxNative);
+        std::uniform_int_distribution <std::uint64_t> any;
+
+        failures = 0;
+
+        for (int i = 0; i < 250000; ++i)
+        {
+            std::uint64_t const a (mantissa (gen));
+            std::uint64_t const b (mantissa (gen));
+            std::uint64_t const n (native (gen));
+            std::uint64_t const d (mantissa (gen));
+
+            // multiply and mulRound
+            if (! sameMulDiv (a, b, 0, tenTo14) ||
+                    ! sameMulDiv (a, b, tenTo14m1, tenTo14) ||
+                    ! sameMulDiv (n, b, tenTo14m1, tenTo14))
+                ++failures;
+
+            // divide and divRound
+            if (! sameMulDiv (a, tenTo17, 0, d) ||
+                    ! sameMulDiv (a, tenTo17, d - 1, d) ||
+                    ! sameMulDiv (n, tenTo17, d - 1, d) ||
+                    ! sameMulDiv (a, tenTo17, n - 1, n))
+                ++failures;
+
+            // Arbitrary operands
+            if (! sameMulDiv (any (gen), any (gen), any (gen), any (gen) >> (i % 64)))
+                ++failures;
+        }
+
+        expect (failures == 0, "Random values must match BIGNUM");
+    }
+
+    //--------------------------------------------------------------------------
+
     template <class Cond>
     bool
     expect (Cond cond, beast::String const& s)
@@ -1804,6 +1914,7 @@ public:
         testNativeCurrency ();
         testCustomCurrency ();
         testArithmetic ();
+        testMulDiv ();
         testUnderflow ();
         testRounding ();
     }
@@ -1811,4 +1922,99 @@ public:
 
 BEAST_DEFINE_TESTSUITE(STAmount,ripple_data,ripple);
 
+//------------------------------------------------------------------------------
+
+/** Compares native and BIGNUM multiply and divide throughput. */
+class STAmount_timing_test : public beast::unit_test::suite
+{
+public:
+    typedef std::chrono::steady_clock clock_type;
+
+    static int const count = 1000000;
+
+    template <class Function>
+    double measure (Function f)
+    {
+        clock_type::time_point const start (clock_type::now ());
+        for (int i = 0; i < count; ++i)
+            f (i);
+        double const seconds (std::chrono::duration_cast <
+            std::chrono::duration <double>> (clock_type::now () - start).count ());
+        return count / seconds;
+    }
+
+    void report (std::string const& name, double bignum, double native)
+    {
+        std::stringstream ss;
+        ss << name << ": BIGNUM " << static_cast <std::int64_t> (bignum) <<
+            " ops/sec, native " << static_cast <std::int64_t> (native) <<
+                " ops/sec (" << (native / bignum) << "x)";
+        log << ss.str ();
+    }
+
+    void run ()
+    {
+        testcase ("mulDiv");
+
+        std::mt19937_64 gen (42);
+        std::uniform_int_distribution <std::uint64_t> dist (
+            STAmount::cMinValue, STAmount::cMaxValue);
+        std::vector <std::uint64_t> values (1024);
+        for (auto& v : values)
+            v = dist (gen);
+
+        // Keep the results live so the loops are not optimized away
+        std::uint64_t sink (0);
+
+        auto const multiplyWith = [&] (std::uint64_t (*f) (
+            std::uint64_t, std::uint64_t, std::uint64_t, std::uint64_t))
+        {
+            return measure ([&] (int i)
+            {
+                sink += f (values [i & 1023], values [(i + 1) & 1023],
+                    tenTo14m1, tenTo14);
+            });
+        };
+
+        auto const divideWith = [&] (std::uint64_t (*f) (
+            std::uint64_t, std::uint64_t, std::uint64_t, std::uint64_t))
+        {
+            return measure ([&] (int i)
+            {
+                std::uint64_t const d (values [(i + 1) & 1023]);
+                sink += f (values [i & 1023], tenTo17, d - 1, d);
+            });
+        };
+
+        report ("multiply", multiplyWith (&mulDivBigNum), multiplyWith (&mulDiv));
+        report ("divide", divideWith (&mulDivBigNum), divideWith (&mulDiv));
+
+        testcase ("STAmount");
+
+        std::vector <STAmount> amounts;
+        for (auto v : values)
+            amounts.push_back (STAmount (CURRENCY_ONE, ACCOUNT_ONE, v, -15));
+
+        double const multiplies (measure ([&] (int i)
+        {
+            sink += STAmount::multiply (amounts [i & 1023],
+                amounts [(i + 1) & 1023], CURRENCY_ONE, ACCOUNT_ONE).getMantissa ();
+        }));
+
+        double const rates (measure ([&] (int i)
+        {
+            sink += STAmount::getRate (amounts [i & 1023], amounts [(i + 1) & 1023]);
+        }));
+
+        std::stringstream ss;
+        ss << "multiply " << static_cast <std::int64_t> (multiplies) <<
+            " ops/sec, getRate " << static_cast <std::int64_t> (rates) << " ops/sec";
+        log << ss.str ();
+
+        expect (sink != 0);
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(STAmount_timing,ripple_data,ripple);
+
 } // ripple
@@ -0,0 +1,540 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include "../../beast/beast/unit_test/suite.h"
+
+namespace ripple {
+
+STObjectView::STObjectView (std::uint8_t const* data, std::size_t size)
+    : mData (data)
+    , mSize (size)
+{
+    std::size_t pos (0);
+
+    while (pos < mSize)
+    {
+        int type;
+        int name;
+        getFieldID (pos, type, name);
+
+        // An end of object marker ends the view like it ends an STObject
+        if ((type == STI_OBJECT) && (name == 1))
+            break;
+
+        SField::ref field (SField::getField (type, name));
+
+        if (field.isInvalid ())
+        {
+            WriteLog (lsWARNING, STObject) << "Unknown field: field_type=" << type << ", field_name=" << name;
+            throw std::runtime_error ("Unknown field");
+        }
+
+        Entry entry;
+        entry.code = field.fieldCode;
+        entry.offset = pos;
+        skipField (pos, type, 0);
+        entry.size = pos - entry.offset;
+        mFields.push_back (entry);
+    }
+
+    // Stable, so the first of any duplicates is found like in STObject
+    std::stable_sort (mFields.begin (), mFields.end ());
+}
+
+STObjectView::STObjectView (Blob const& data)
+    : STObjectView (data.empty () ? nullptr : &data.front (), data.size ())
+{
+}
+
+//------------------------------------------------------------------------------
+
+void STObjectView::require (std::size_t pos, std::size_t bytes) const
+{
+    if ((pos > mSize) || (bytes > (mSize - pos)))
+        throw std::runtime_error ("object view overrun");
+}
+
+std::uint64_t STObjectView::getBigEndian (std::size_t pos, std::size_t bytes) const
+{
+    require (pos, bytes);
+
+    std::uint64_t value (0);
+
+    for (std::size_t i = 0; i < bytes; ++i)
+        value = (value << 8) | mData [pos + i];
+
+    return value;
+}
+
+// Mirrors Serializer::getFieldID
+void STObjectView::getFieldID (std::size_t& pos, int& type, int& name) const
+{
+    require (pos, 1);
+    type = mData [pos++];
+    name = type & 15;
+    type >>= 4;
+
+    if (type == 0)
+    {
+        // uncommon type
+        require (pos, 1);
+        type = mData [pos++];
+
+        if (type < 16)
+            throw std::runtime_error ("invalid field type");
+    }
+
+    if (name == 0)
+    {
+        // uncommon name
+        require (pos, 1);
+        name = mData [pos++];
+
+        if (name < 16)
+            throw std::runtime_error ("invalid field name");
+    }
+}
+
+// Mirrors Serializer::decodeVLLength
+std::size_t STObjectView::getVLLength (std::size_t& pos) const
+{
+    require (pos, 1);
+    int const b1 (mData [pos++]);
+
+    if (b1 <= 192)
+        return b1;
+
+    if (b1 <= 240)
+    {
+        require (pos, 1);
+        int const b2 (mData [pos++]);
+        return 193 + (b1 - 193) * 256 + b2;
+    }
+
+    if (b1 <= 254)
+    {
+        require (pos, 2);
+        int const b2 (mData [pos++]);
+        int const b3 (mData [pos++]);
+        return 12481 + (b1 - 241) * 65536 + b2 * 256 + b3;
+    }
+
+    throw std::overflow_error ("b1>254");
+}
+
+void STObjectView::skipField (std::size_t& pos, int type, int depth) const
+{
+    // Deeper than any real object, but bounds the recursion
+    if (depth > 64)
+        throw std::runtime_error ("object view too deep");
+
+    std::size_t bytes (0);
+
+    switch (type)
+    {
+    case STI_UINT8:     bytes = 1;  break;
+    case STI_UINT16:    bytes = 2;  break;
+    case STI_UINT32:    bytes = 4;  break;
+    case STI_UINT64:    bytes = 8;  break;
+    case STI_HASH128:   bytes = 16; break;
+    case STI_HASH160:   bytes = 20; break;
+    case STI_HASH256:   bytes = 32; break;
+
+    case STI_AMOUNT:
+        // Native amounts are 8 bytes, others add a currency and issuer
+        require (pos, 1);
+        bytes = ((mData [pos] & 0x80) == 0) ? 8 : 48;
+        break;
+
+    case STI_VL:
+    case STI_ACCOUNT:
+    case STI_VECTOR256:
+        bytes = getVLLength (pos);
+        break;
+
+    case STI_PATHSET:
+        for (;;)
+        {
+            require (pos, 1);
+            int const element (mData [pos++]);
+
+            if (element == STPathElement::typeEnd)
+                return;
+
+            if (element == STPathElement::typeBoundary)
+                continue;
+
+            if (element & ~STPathElement::typeValidBits)
+                throw std::runtime_error ("bad path element");
+
+            std::size_t const size (
+                ((element & STPathElement::typeAccount) ? 20 : 0) +
+                ((element & STPathElement::typeCurrency) ? 20 : 0) +
+                ((element & STPathElement::typeIssuer) ? 20 : 0));
+            require (pos, size);
+            pos += size;
+        }
+
+    case STI_OBJECT:
+    case STI_ARRAY:
+        // Fields up to the end marker. An array holds inner objects.
+        for (;;)
+        {
+            int innerType;
+            int innerName;
+            getFieldID (pos, innerType, innerName);
+
+            if ((innerType == type) && (innerName == 1))
+                return;
+
+            skipField (pos, innerType, depth + 1);
+        }
+
+    default:
+        throw std::runtime_error ("Unknown object type");
+    }
+
+    require (pos, bytes);
+    pos += bytes;
+}
+
+//------------------------------------------------------------------------------
+
+STObjectView::Entry const* STObjectView::findEntry (SField::ref field) const
+{
+    Entry key;
+    key.code = field.fieldCode;
+
+    std::vector <Entry>::const_iterator const iter (std::lower_bound (
+        mFields.begin (), mFields.end (), key));
+
+    if ((iter == mFields.end ()) || (iter->code != field.fieldCode))
+        return nullptr;
+
+    return &*iter;
+}
+
+STObjectView::Entry const& STObjectView::find (SField::ref field,
+    SerializedTypeID type) const
+{
+    Entry const* const entry (findEntry (field));
+
+    if (entry == nullptr)
+        throw std::runtime_error ("Field not found");
+
+    if (field.fieldType != type)
+        throw std::runtime_error ("Wrong field type");
+
+    return *entry;
+}
+
+bool STObjectView::isFieldPresent (SField::ref field) const
+{
+    return findEntry (field) != nullptr;
+}
+
+unsigned char STObjectView::getFieldU8 (SField::ref field) const
+{
+    return static_cast <unsigned char> (
+        getBigEndian (find (field, STI_UINT8).offset, 1));
+}
+
+std::uint16_t STObjectView::getFieldU16 (SField::ref field) const
+{
+    return static_cast <std::uint16_t> (
+        getBigEndian (find (field, STI_UINT16).offset, 2));
+}
+
+std::uint32_t STObjectView::getFieldU32 (SField::ref field) const
+{
+    return static_cast <std::uint32_t> (
+        getBigEndian (find (field, STI_UINT32).offset, 4));
+}
+
+std::uint64_t STObjectView::getFieldU64 (SField::ref field) const
+{
+    return getBigEndian (find (field, STI_UINT64).offset, 8);
+}
+
+uint128 STObjectView::getFieldH128 (SField::ref field) const
+{
+    Entry const& entry (find (field, STI_HASH128));
+    uint128 value;
+    memcpy (value.begin (), mData + entry.offset, value.size ());
+    return value;
+}
+
+uint160 STObjectView::getFieldH160 (SField::ref field) const
+{
+    Entry const& entry (find (field, STI_HASH160));
+    uint160 value;
+    memcpy (value.begin (), mData + entry.offset, value.size ());
+    return value;
+}
+
+uint256 STObjectView::getFieldH256 (SField::ref field) const
+{
+    Entry const& entry (find (field, STI_HASH256));
+    uint256 value;
+    memcpy (value.begin (), mData + entry.offset, value.size ());
+    return value;
+}
+
+uint160 STObjectView::getFieldAccount160 (SField::ref field) const
+{
+    Entry const& entry (find (field, STI_ACCOUNT));
+    std::size_t pos (entry.offset);
+    std::size_t const size (getVLLength (pos));
+
+    // Like STAccount::getValueH160, anything but 160 bits reads as zero
+    uint160 value;
+
+    if (size == value.size ())
+        memcpy (value.begin (), mData + pos, value.size ());
+
+    return value;
+}
+
+Blob STObjectView::getFieldVL (SField::ref field) const
+{
+    Entry const& entry (find (field, STI_VL));
+    std::size_t pos (entry.offset);
+    std::size_t const size (getVLLength (pos));
+    return Blob (mData + pos, mData + pos + size);
+}
+
+STAmount STObjectView::getFieldAmount (SField::ref field) const
+{
+    Entry const& entry (find (field, STI_AMOUNT));
+
+    if (entry.size == 8)
+    {
+        // Native amounts decode without allocating, as in STAmount::construct
+        std::uint64_t const value (getBigEndian (entry.offset, 8));
+
+        if ((value & STAmount::cPosNative) != 0)
+            return STAmount (field, value & ~STAmount::cPosNative, false);
+
+        if (value == 0)
+            throw std::runtime_error ("negative zero is not canonical");
+
+        return STAmount (field, value, true);
+    }
+
+    std::unique_ptr <SerializedType> const amount (getField (field));
+    return *static_cast <STAmount const*> (amount.get ());
+}
+
+std::unique_ptr <SerializedType> STObjectView::getField (SField::ref field) const
+{
+    Entry const* const entry (findEntry (field));
+
+    if (entry == nullptr)
+        throw std::runtime_error ("Field not found");
+
+    Serializer s (Blob (mData + entry->offset, mData + entry->offset + entry->size));
+    SerializerIterator sit (s);
+    return STObject::makeDeserializedObject (field.fieldType, field, sit, 1);
+}
+
+//------------------------------------------------------------------------------
+
+class STObjectView_test : public beast::unit_test::suite
+{
+public:
+    STObject makeObject ()
+    {
+        STObject object (sfGeneric);
+        object.setFieldU8 (sfCloseResolution, 5);
+        object.setFieldU16 (sfTransactionType, 7);
+        object.setFieldU32 (sfSequence, 0x01020304);
+        object.setFieldU64 (sfIndexNext, 0x0102030405060708ull);
+        object.setFieldH128 (sfEmailHash, uint128 (Blob (16, 9)));
+        object.setFieldH160 (sfTakerPaysCurrency, uint160 (10));
+        object.setFieldH256 (sfLedgerIndex, uint256 (11));
+        object.setFieldAccount (sfAccount, uint160 (12));
+        object.setFieldVL (sfSigningPubKey, Blob (300, 0x5A));
+        object.setFieldAmount (sfAmount, STAmount (13));
+        object.setFieldAmount (sfFee, STAmount (14, true));
+        object.setFieldAmount (sfTakerPays, STAmount (uint160 (15), uint160 (16), 17, -3));
+
+        STVector256 indexes;
+        indexes.addValue (uint256 (18));
+        object.setFieldV256 (sfIndexes, indexes);
+
+        STPathSet paths;
+        STPath path;
+        path.addElement (STPathElement (uint160 (19), uint160 (20), uint160 ()));
+        path.addElement (STPathElement (uint160 (), uint160 (21), uint160 (22)));
+        paths.addPath (path);
+        paths.addPath (path);
+        object.setFieldPathSet (sfPaths, paths);
+
+        STObject& inner (object.peekFieldObject (sfFinalFields));
+        inner.setFieldU32 (sfFlags, 23);
+
+        STArray memos (sfMemos);
+        STObject memo (sfMemo);
+        memo.setFieldVL (sfMemoData, Blob (3, 24));
+        memos.push_back (memo);
+        memos.push_back (memo);
+        object.giveObject (std::unique_ptr <SerializedType> (
+            new STArray (memos)));
+
+        object.setFieldU32 (sfFlags, 25);
+
+        return object;
+    }
+
+    void testFields ()
+    {
+        testcase ("fields");
+
+        STObject const object (makeObject ());
+        Serializer s;
+        object.add (s);
+        STObjectView const view (s.peekData ());
+
+        expect (view.getCount () == object.getCount ());
+        expect (view.getFieldU8 (sfCloseResolution) == object.getFieldU8 (sfCloseResolution));
+        expect (view.getFieldU16 (sfTransactionType) == object.getFieldU16 (sfTransactionType));
+        expect (view.getFieldU32 (sfSequence) == object.getFieldU32 (sfSequence));
+        expect (view.getFieldU32 (sfFlags) == object.getFieldU32 (sfFlags));
+        expect (view.getFieldU64 (sfIndexNext) == object.getFieldU64 (sfIndexNext));
+        expect (view.getFieldH128 (sfEmailHash) == object.getFieldH128 (sfEmailHash));
+        expect (view.getFieldH160 (sfTakerPaysCurrency) == object.getFieldH160 (sfTakerPaysCurrency));
+        expect (view.getFieldH256 (sfLedgerIndex) == object.getFieldH256 (sfLedgerIndex));
+        expect (view.getFieldAccount160 (sfAccount) == object.getFieldAccount160 (sfAccount));
+        expect (view.getFieldVL (sfSigningPubKey) == object.getFieldVL (sfSigningPubKey));
+        expect (view.getFieldAmount (sfAmount) == object.getFieldAmount (sfAmount));
+        expect (view.getFieldAmount (sfFee) == object.getFieldAmount (sfFee));
+        expect (view.getFieldAmount (sfTakerPays) == object.getFieldAmount (sfTakerPays));
+
+        // Compound fields decode to the same objects
+        SField::ptr const compound [] = { &sfIndexes, &sfPaths, &sfFinalFields, &sfMemos };
+        for (SField::ptr field : compound)
+        {
+            std::unique_ptr <SerializedType> const decoded (view.getField (*field));
+            expect (*decoded == object.peekAtField (*field), field->getName ());
+        }
+
+        expect (! view.isFieldPresent (sfDestination));
+        expect (view.isFieldPresent (sfMemos));
+
+        try
+        {
+            view.getFieldU32 (sfDestinationTag);
+            fail ("Missing field must throw");
+        }
+        catch (std::runtime_error const&)
+        {
+            pass ();
+        }
+
+        try
+        {
+            view.getFieldU64 (sfSequence);
+            fail ("Wrong type must throw");
+        }
+        catch (std::runtime_error const&)
+        {
+            pass ();
+        }
+    }
+
+    void testMalformed ()
+    {
+        testcase ("malformed");
+
+        Serializer s;
+        makeObject ().add (s);
+        Blob const& data (s.peekData ());
+
+        // Every truncation either fails or ends on a field boundary
+        int failed (0);
+        for (std::size_t size = 1; size < data.size (); ++size)
+        {
+            try
+            {
+                STObjectView const view (&data.front (), size);
+            }
+            catch (std::exception const&)
+            {
+                ++failed;
+            }
+        }
+        expect (failed > 0);
+
+        Blob const unknown (1, 0xE0);   // object type, uncommon name
+        try
+        {
+            STObjectView const view (unknown);
+            fail ("Truncated field ID must throw");
+        }
+        catch (std::runtime_error const&)
+        {
+            pass ();
+        }
+    }
+
+    void testFreeIndex ()
+    {
+        testcase ("free object index");
+
+        STObject object (makeObject ());
+        int const count (object.getCount ());
+
+        // Every field is found at its position
+        bool found (true);
+        for (int i = 0; i < count; ++i)
+            if (object.getFieldIndex (object.getFieldSType (i)) != i)
+                found = false;
+        expect (found, "All fields indexed");
+
+        expect (object.delField (sfSequence));
+        expect (object.getFieldIndex (sfSequence) == -1);
+        expect (object.getCount () == count - 1);
+        expect (object.getFieldU32 (sfFlags) == 25);
+        expect (object.getFieldVL (sfSigningPubKey).size () == 300);
+
+        // A deserialized copy is indexed too
+        Serializer s;
+        object.add (s);
+        SerializerIterator sit (s);
+        STObject copy (sfGeneric);
+        copy.set (sit);
+        expect (copy == object);
+        expect (copy.getFieldAmount (sfTakerPays) == object.getFieldAmount (sfTakerPays));
+
+        // Serialization puts fields in canonical order, so positions differ
+        int const memos (copy.getFieldIndex (sfMemos));
+        expect (memos != -1 && copy.getFieldSType (memos) == sfMemos);
+    }
+
+    void run ()
+    {
+        testFields ();
+        testMalformed ();
+        testFreeIndex ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(STObjectView,ripple_data,ripple);
+
+} // ripple
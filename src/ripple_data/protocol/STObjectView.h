@@ -0,0 +1,97 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_DATA_STOBJECTVIEW_H
+#define RIPPLE_DATA_STOBJECTVIEW_H
+
+namespace ripple {
+
+/** Read-only access to the fields of a serialized object.
+
+    Construction walks the field headers once and records where each field
+    lies, without building any SerializedType objects. A field is only
+    decoded when it is asked for, so reading a few fields of a ledger entry
+    or transaction costs a fraction of deserializing it into an STObject.
+
+    The view does not copy the data; the caller must keep it alive.
+
+    The getters behave like those of a free STObject: they throw if the
+    field is absent or has a different type.
+*/
+class STObjectView
+{
+public:
+    /** Index the fields of serialized object data.
+        @throws std::runtime_error if the data is malformed.
+    */
+    STObjectView (std::uint8_t const* data, std::size_t size);
+    explicit STObjectView (Blob const& data);
+
+    /** Returns the number of fields in the object. */
+    int getCount () const
+    {
+        return mFields.size ();
+    }
+
+    bool isFieldPresent (SField::ref field) const;
+
+    unsigned char getFieldU8 (SField::ref field) const;
+    std::uint16_t getFieldU16 (SField::ref field) const;
+    std::uint32_t getFieldU32 (SField::ref field) const;
+    std::uint64_t getFieldU64 (SField::ref field) const;
+    uint128 getFieldH128 (SField::ref field) const;
+    uint160 getFieldH160 (SField::ref field) const;
+    uint256 getFieldH256 (SField::ref field) const;
+    uint160 getFieldAccount160 (SField::ref field) const;
+    Blob getFieldVL (SField::ref field) const;
+    STAmount getFieldAmount (SField::ref field) const;
+
+    /** Decodes any field, including objects, arrays and path sets. */
+    std::unique_ptr <SerializedType> getField (SField::ref field) const;
+
+private:
+    struct Entry
+    {
+        int code;
+        std::size_t offset;
+        std::size_t size;
+
+        bool operator< (Entry const& other) const
+        {
+            return code < other.code;
+        }
+    };
+
+    void require (std::size_t pos, std::size_t bytes) const;
+    std::uint64_t getBigEndian (std::size_t pos, std::size_t bytes) const;
+    void getFieldID (std::size_t& pos, int& type, int& name) const;
+    std::size_t getVLLength (std::size_t& pos) const;
+    void skipField (std::size_t& pos, int type, int depth) const;
+
+    Entry const& find (SField::ref field, SerializedTypeID type) const;
+    Entry const* findEntry (SField::ref field) const;
+
+    std::uint8_t const* mData;
+    std::size_t mSize;
+    std::vector <Entry> mFields;    // sorted by code
+};
+
+} // ripple
+
+#endif
@@ -138,6 +138,7 @@ std::unique_ptr<SerializedType> STObject::makeDeserializedObject (SerializedType
 void STObject::set (const SOTemplate& type)
 {
     mData.clear ();
+    mFieldIndex.clear ();
     mType = &type;
 
     for (SOTemplate::value_type const& elem : type.peek ())
@@ -203,6 +204,7 @@ bool STObject::setType (const SOTemplate& type)
     }
 
     mData.swap (newData);
+    mFieldIndex.clear ();
     return valid;
 }
 
@@ -263,6 +265,7 @@ bool STObject::set (SerializerIterator& sit, int depth)
     // Empty the destination buffer
     //
     mData.clear ();
+    mFieldIndex.clear ();
 
     // Consume data in the pipe until we run out or reach the end
     //
@@ -289,12 +292,15 @@ bool STObject::set (SerializerIterator& sit, int depth)
                 throw std::runtime_error ("Unknown field");
             }
 
-            // Unflatten the field
+            // Unflatten the field, indexing them all at the end
             //
-            giveObject (makeDeserializedObject (fn.fieldType, fn, sit, depth + 1));
+            mData.push_back (makeDeserializedObject (
+                fn.fieldType, fn, sit, depth + 1).release ());
         }
     }
 
+    rebuildIndex ();
+
     return reachedEndOfObject;
 }
 
@@ -447,15 +453,44 @@ int STObject::getFieldIndex (SField::ref field) const
     if (mType != nullptr)
         return mType->getIndex (field);
 
-    int i = 0;
-    BOOST_FOREACH (const SerializedType & elem, mData)
-    {
-        if (elem.getFName () == field)
-            return i;
+    // The first of any duplicates has the lowest position
+    std::vector <IndexEntry>::const_iterator const iter (std::lower_bound (
+        mFieldIndex.begin (), mFieldIndex.end (), IndexEntry (field.fieldCode, -1)));
+
+    if ((iter == mFieldIndex.end ()) || (iter->first != field.fieldCode))
+        return -1;
+
+    return iter->second;
+}
 
-        ++i;
+int STObject::indexField (int position)
+{
+    if (isFree ())
+    {
+        // The new field is last, so it goes after any with the same code
+        IndexEntry const entry (mData[position].getFName ().fieldCode, position);
+        mFieldIndex.insert (std::upper_bound (
+            mFieldIndex.begin (), mFieldIndex.end (), entry), entry);
     }
-    return -1;
+
+    return position;
+}
+
+void STObject::rebuildIndex ()
+{
+    mFieldIndex.clear ();
+
+    if (! isFree ())
+        return;
+
+    mFieldIndex.reserve (mData.size ());
+
+    int const count (mData.size ());
+
+    for (int i = 0; i < count; ++i)
+        mFieldIndex.push_back (IndexEntry (mData[i].getFName ().fieldCode, i));
+
+    std::sort (mFieldIndex.begin (), mFieldIndex.end ());
 }
 
 const SerializedType& STObject::peekAtField (SField::ref field) const
@@ -623,6 +658,7 @@ bool STObject::delField (SField::ref field)
 void STObject::delField (int index)
 {
     mData.erase (mData.begin () + index);
+    rebuildIndex ();
 }
 
 std::string STObject::getFieldString (SField::ref field) const
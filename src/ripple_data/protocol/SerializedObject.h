@@ -48,7 +48,8 @@ public:
         set (type);
     }
 
-    STObject (const SOTemplate & type, SerializerIterator & sit, SField::ref name) : SerializedType (name)
+    STObject (const SOTemplate & type, SerializerIterator & sit, SField::ref name)
+        : SerializedType (name), mType (nullptr)
     {
         set (sit);
         setType (type);
@@ -57,6 +58,7 @@ public:
     STObject (SField::ref name, boost::ptr_vector<SerializedType>& data) : SerializedType (name), mType (nullptr)
     {
         mData.swap (data);
+        rebuildIndex ();
     }
 
     std::unique_ptr <STObject> oClone () const
@@ -112,22 +114,24 @@ public:
     int addObject (const SerializedType & t)
     {
         mData.push_back (t.clone ().release ());
-        return mData.size () - 1;
+        return indexField (mData.size () - 1);
     }
     int giveObject (std::unique_ptr<SerializedType> t)
     {
         mData.push_back (t.release ());
-        return mData.size () - 1;
+        return indexField (mData.size () - 1);
     }
     int giveObject (SerializedType * t)
     {
         mData.push_back (t);
-        return mData.size () - 1;
+        return indexField (mData.size () - 1);
     }
     const boost::ptr_vector<SerializedType>& peekData () const
     {
         return mData;
     }
+    // Fields must not be added or removed through this, since
+    // that would leave the field index of a free object stale.
     boost::ptr_vector<SerializedType>& peekData ()
     {
         return mData;
@@ -307,9 +311,17 @@ private:
         return new STObject (*this);
     }
 
+    int indexField (int position);
+    void rebuildIndex ();
+
 private:
+    // Field code and position of each field in a free object, sorted by
+    // code and then position. Objects with a template use its index.
+    typedef std::pair <int, int> IndexEntry;
+
     boost::ptr_vector<SerializedType>   mData;
     const SOTemplate*                   mType;
+    std::vector <IndexEntry>            mFieldIndex;
 };
 
 //------------------------------------------------------------------------------
@@ -74,8 +74,10 @@
 #include "protocol/RippleAddress.cpp"
 #include "protocol/SerializedTypes.cpp"
 #include "protocol/Serializer.cpp"
+#include "protocol/SHA512Batch.cpp"
 #include "protocol/SerializedObjectTemplate.cpp"
 #include "protocol/SerializedObject.cpp"
+#include "protocol/STObjectView.cpp"
 #include "protocol/TER.cpp"
 #include "protocol/TxFormats.cpp"
 
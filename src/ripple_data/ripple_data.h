@@ -36,6 +36,7 @@ typedef struct bignum_st BIGNUM;
 #include "protocol/RippleAddress.h"
 #include "protocol/RippleSystem.h"
 #include "protocol/Serializer.h" // needs CKey
+#include "protocol/SHA512Batch.h"
 #include "protocol/TER.h"
 #include "protocol/SerializedTypes.h" // needs Serializer, TER
 #include "protocol/SerializedObjectTemplate.h"
@@ -43,6 +44,7 @@ typedef struct bignum_st BIGNUM;
  #include "protocol/LedgerFormats.h" // needs SOTemplate from SerializedObjectTemplate
  #include "protocol/TxFormats.h"
 #include "protocol/SerializedObject.h"
+#include "protocol/STObjectView.h"
 #include "protocol/TxFlags.h"
 
 #include "utility/UptimeTimerAdapter.h"
@@ -50,6 +50,25 @@ public:
         */
         virtual std::string processRequest (std::string const& request,
                                             beast::IP::Endpoint const& remoteIPAddress) = 0;
+
+        /** Called with the response to an asynchronous request. */
+        typedef std::function <void (std::string const&)> Completion;
+
+        /** Produce a response for a given request, possibly later.
+
+            The completion may be called from any thread, including
+            the calling thread before this function returns. The default
+            implementation processes the request synchronously.
+
+            @param  request The RPC request string.
+            @param  complete Called once with the server's response.
+        */
+        virtual void processRequestAsync (std::string const& request,
+                                          beast::IP::Endpoint const& remoteIPAddress,
+                                          Completion const& complete)
+        {
+            complete (processRequest (request, remoteIPAddress));
+        }
     };
 
     virtual ~RPCServer () { }
@@ -0,0 +1,187 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include "../../beast/beast/unit_test/suite.h"
+
+#include <chrono>
+#include <thread>
+
+namespace ripple {
+
+class RPCServer_test : public beast::unit_test::suite
+{
+public:
+    // Holds every request until the test answers it
+    class TestHandler : public RPCServer::Handler
+    {
+    public:
+        std::string createResponse (int statusCode, std::string const& description)
+        {
+            return HTTPReply (statusCode, description);
+        }
+
+        bool isAuthorized (std::map <std::string, std::string> const& headers)
+        {
+            return headers.find ("x-forbidden") == headers.end ();
+        }
+
+        std::string processRequest (std::string const&, beast::IP::Endpoint const&)
+        {
+            return std::string ();
+        }
+
+        void processRequestAsync (std::string const& request,
+                                  beast::IP::Endpoint const&,
+                                  Completion const& complete)
+        {
+            requests.push_back (request);
+            completions.push_back (complete);
+        }
+
+        // Requests in the order they were handed to the handler
+        std::vector <std::string> requests;
+        std::vector <Completion> completions;
+    };
+
+    typedef boost::asio::ip::tcp::socket socket_type;
+
+    static std::string makeRequest (std::string const& body,
+        std::string const& headers = std::string ())
+    {
+        return "POST / HTTP/1.1\r\n"
+            "Content-Length: " + std::to_string (body.size ()) + "\r\n" +
+            headers +
+            "\r\n" +
+            body;
+    }
+
+    // Run the server's handlers until the condition holds
+    bool pump (boost::asio::io_service& io_service, std::function <bool ()> const& done)
+    {
+        for (int i = 0; i < 2000; ++i)
+        {
+            io_service.poll ();
+            io_service.reset ();
+
+            if (done ())
+                return true;
+
+            std::this_thread::sleep_for (std::chrono::milliseconds (1));
+        }
+
+        return false;
+    }
+
+    // Everything the client can read without blocking. Sets eof once
+    // the server has shut the connection down.
+    static std::string readAvailable (socket_type& client, bool& eof)
+    {
+        std::string result;
+        char buffer [1024];
+
+        for (;;)
+        {
+            boost::system::error_code ec;
+            std::size_t const bytes (client.read_some (
+                boost::asio::buffer (buffer), ec));
+
+            result.append (buffer, bytes);
+
+            if (ec == boost::asio::error::eof)
+                eof = true;
+
+            if (ec)
+                return result;
+        }
+    }
+
+    void testPipeline ()
+    {
+        testcase ("pipeline");
+
+        boost::asio::io_service io_service;
+        beast::ScopedPointer <RippleSSLContext> context (RippleSSLContext::createBare ());
+        TestHandler handler;
+
+        boost::asio::ip::tcp::acceptor acceptor (io_service,
+            boost::asio::ip::tcp::endpoint (
+                boost::asio::ip::address_v4::loopback (), 0));
+
+        socket_type client (io_service);
+        client.connect (acceptor.local_endpoint ());
+        client.non_blocking (true);
+
+        RPCServerImp::pointer server (boost::make_shared <RPCServerImp> (
+            boost::ref (io_service), boost::ref (context->get ()), boost::ref (handler)));
+        acceptor.accept (server->getRawSocket (), server->getRemoteEndpoint ());
+        server->connected ();
+
+        // The second request is refused on the spot and the third one
+        // asks for the connection to be closed
+        std::string const requests (
+            makeRequest ("one") +
+            makeRequest ("two", "X-Forbidden: yes\r\n") +
+            makeRequest ("three", "Connection: close\r\n"));
+
+        boost::asio::write (client, boost::asio::buffer (requests));
+
+        std::string const forbidden (handler.createResponse (403, "Forbidden"));
+        std::string received;
+        bool eof (false);
+
+        // Only the first request executes, the refusal waits behind it
+        expect (pump (io_service, [&] { return handler.requests.size () == 1; }));
+        expect (handler.requests [0] == "one");
+        received += readAvailable (client, eof);
+        expect (received.empty (), "a later reply was written first");
+
+        handler.completions [0] ("reply one");
+
+        // The third request runs after the first one's reply
+        expect (pump (io_service, [&] { return handler.requests.size () == 2; }));
+        expect (handler.requests [1] == "three");
+
+        expect (pump (io_service, [&]
+        {
+            received += readAvailable (client, eof);
+            return received.size () >= std::string ("reply one").size () + forbidden.size ();
+        }));
+        expect (received == "reply one" + forbidden, "replies out of order");
+        expect (! eof, "closed while a reply was owed");
+
+        handler.completions [1] ("reply three");
+
+        expect (pump (io_service, [&]
+        {
+            received += readAvailable (client, eof);
+            return eof;
+        }), "connection not closed");
+        expect (received == "reply one" + forbidden + "reply three");
+        expect (handler.requests.size () == 2);
+    }
+
+    void run ()
+    {
+        testPipeline ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(RPCServer,ripple_net,ripple);
+
+} // ripple
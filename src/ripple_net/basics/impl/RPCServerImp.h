@@ -36,6 +36,11 @@ public:
         : m_handler (handler)
         , mStrand (io_service)
         , mSocket (io_service, context)
+        , mExecuting (false)
+        , mWriting (false)
+        , mReadPaused (false)
+        , mClosing (false)
+        , mShutdown (false)
     {
     }
 
@@ -43,10 +48,21 @@ public:
 
     enum
     {
-        maxQueryBytes = 1024 * 1024
+        maxQueryBytes = 1024 * 1024,
+
+        // Requests a client may have read but not yet answered on one
+        // connection. Reading stops at this limit until replies drain.
+        maxPipelinedRequests = 32
     };
 
     void connected ()
+    {
+        readLine ();
+    }
+
+    //--------------------------------------------------------------------------
+
+    void readLine ()
     {
         boost::asio::async_read_until (
             mSocket,
@@ -58,40 +74,127 @@ public:
                 boost::asio::placeholders::error)));
     }
 
+    // Start reading the next request, unless the client already has
+    // too many outstanding.
+    //
+    void readNext ()
+    {
+        if (mPending.size () >= maxPipelinedRequests)
+        {
+            mReadPaused = true;
+        }
+        else
+        {
+            mReadPaused = false;
+            readLine ();
+        }
+    }
+
+    // Stop reading, and close once the replies already owed are written.
+    //
+    void close ()
+    {
+        mClosing = true;
+
+        writeNext ();
+    }
+
     //--------------------------------------------------------------------------
 
-    void handle_write (const boost::system::error_code& e)
+    // Requests on a connection run one at a time, in the order they
+    // arrived, so a single client cannot flood the job queue.
+    //
+    void executeNext ()
     {
-        if (!e)
+        if (mExecuting)
+            return;
+
+        for (std::deque <Pending>::iterator iter = mPending.begin ();
+            iter != mPending.end (); ++iter)
         {
-            HTTPRequest::Action action = mHTTPRequest.requestDone (false);
+            if (! iter->done)
+            {
+                mExecuting = true;
+
+                handleRequest (iter->request);
+                return;
+            }
+        }
+    }
+
+    void handle_reply (std::string const& reply)
+    {
+        mExecuting = false;
+
+        for (std::deque <Pending>::iterator iter = mPending.begin ();
+            iter != mPending.end (); ++iter)
+        {
+            if (! iter->done)
+            {
+                iter->reply = reply;
+                iter->request.clear ();
+                iter->done = true;
+                break;
+            }
+        }
+
+        executeNext ();
+        writeNext ();
+    }
 
-            if (action == HTTPRequest::haCLOSE_CONN)
+    // Replies are written in request order, one at a time.
+    //
+    void writeNext ()
+    {
+        if (mWriting || mShutdown)
+            return;
+
+        if (mPending.empty ())
+        {
+            if (mClosing)
             {
+                mShutdown = true;
+
                 mSocket.async_shutdown (mStrand.wrap (boost::bind (
                     &RPCServerImp::handle_shutdown,
-                    boost::static_pointer_cast <RPCServerImp> (shared_from_this()),
+                    boost::static_pointer_cast <RPCServerImp> (shared_from_this ()),
                     boost::asio::placeholders::error)));
             }
-            else
-            {
-                boost::asio::async_read_until (
-                    mSocket,
-                    mLineBuffer,
-                    "\r\n",
-                    mStrand.wrap (boost::bind (
-                        &RPCServerImp::handle_read_line,
-                        boost::static_pointer_cast <RPCServerImp> (shared_from_this()),
-                        boost::asio::placeholders::error)));
-            }
         }
+        else if (mPending.front ().done)
+        {
+            mWriting = true;
+
+            boost::asio::async_write (
+                mSocket,
+                boost::asio::buffer (mPending.front ().reply),
+                mStrand.wrap (boost::bind (
+                    &RPCServerImp::handle_write,
+                    boost::static_pointer_cast <RPCServerImp> (shared_from_this ()),
+                    boost::asio::placeholders::error)));
+        }
+    }
+
+    //--------------------------------------------------------------------------
+
+    void handle_write (const boost::system::error_code& e)
+    {
+        mWriting = false;
 
-        if (e != boost::asio::error::operation_aborted)
+        if (e)
         {
-            // VFALCO TODO What is this for? It was commented out.
-            //
-            //connection_manager_.stop (shared_from_this ());
+            // The client is gone, drop anything still owed to it
+            mPending.clear ();
+            mShutdown = true;
+            return;
         }
+
+        mPending.pop_front ();
+
+        if (mReadPaused && ! mClosing)
+            readNext ();
+
+        writeNext ();
     }
 
     //--------------------------------------------------------------------------
@@ -107,21 +210,11 @@ public:
                 // request with no body
                 WriteLog (lsWARNING, RPCServer) << "RPC HTTP request with no body";
 
-                mSocket.async_shutdown (mStrand.wrap (boost::bind (
-                    &RPCServerImp::handle_shutdown,
-                    boost::static_pointer_cast <RPCServerImp> (shared_from_this ()),
-                    boost::asio::placeholders::error)));
+                close ();
             }
             else if (action == HTTPRequest::haREAD_LINE)
             {
-                boost::asio::async_read_until (
-                    mSocket,
-                    mLineBuffer,
-                    "\r\n",
-                    mStrand.wrap (boost::bind (
-                        &RPCServerImp::handle_read_line,
-                        boost::static_pointer_cast <RPCServerImp> (shared_from_this ()),
-                        boost::asio::placeholders::error)));
+                readLine ();
             }
             else if (action == HTTPRequest::haREAD_RAW)
             {
@@ -131,10 +224,7 @@ public:
                 {
                     WriteLog (lsWARNING, RPCServer) << "Illegal RPC request length " << rLen;
 
-                    mSocket.async_shutdown (mStrand.wrap (boost::bind (
-                        &RPCServerImp::handle_shutdown,
-                        boost::static_pointer_cast <RPCServerImp> (shared_from_this ()),
-                        boost::asio::placeholders::error)));
+                    close ();
                 }
                 else
                 {
@@ -165,10 +255,7 @@ public:
             }
             else
             {
-                mSocket.async_shutdown (mStrand.wrap (boost::bind (
-                    &RPCServerImp::handle_shutdown,
-                    boost::static_pointer_cast <RPCServerImp> (shared_from_this ()),
-                    boost::asio::placeholders::error)));
+                close ();
             }
         }
     }
@@ -177,33 +264,44 @@ public:
 
     void handle_read_req (const boost::system::error_code& ec)
     {
-        std::string req;
+        if (ec)
+            return;
+
+        // The line buffer may already hold the start of a pipelined
+        // request, so only take this request's share of it.
+        std::size_t const fromBuffer (std::min <std::size_t> (
+            mLineBuffer.size (), mHTTPRequest.getDataSize ()));
 
-        if (mLineBuffer.size ())
+        Pending pending;
+
+        if (fromBuffer)
         {
-            req.assign (boost::asio::buffer_cast <const char*> (mLineBuffer.data ()), mLineBuffer.size ());
+            pending.request.assign (boost::asio::buffer_cast <const char*> (
+                mLineBuffer.data ()), fromBuffer);
 
-            mLineBuffer.consume (mLineBuffer.size ());
+            mLineBuffer.consume (fromBuffer);
         }
 
-        req += strCopy (mQueryVec);
+        pending.request += strCopy (mQueryVec);
 
         if (! m_handler.isAuthorized (mHTTPRequest.peekHeaders ()))
         {
-            mReplyStr = m_handler.createResponse (403, "Forbidden");
+            pending.request.clear ();
+            pending.reply = m_handler.createResponse (403, "Forbidden");
+            pending.done = true;
         }
+
+        mPending.push_back (pending);
+
+        // The parser is finished with this request, so the next one can
+        // be read while this one waits for its turn to execute.
+        if (mHTTPRequest.requestDone (false) == HTTPRequest::haCLOSE_CONN)
+            mClosing = true;
         else
-        {
-            mReplyStr = handleRequest (req);
-        }
+            readNext ();
 
-        boost::asio::async_write (
-            mSocket,
-            boost::asio::buffer (mReplyStr),
-            mStrand.wrap (boost::bind (
-                &RPCServerImp::handle_write,
-                boost::static_pointer_cast <RPCServerImp> (shared_from_this ()),
-                boost::asio::placeholders::error)));
+        executeNext ();
+        writeNext ();
     }
 
     //--------------------------------------------------------------------------
@@ -217,13 +315,24 @@ public:
 
     // JSON-RPC request must contain "method", "params", and "id" fields.
     //
-    std::string handleRequest (const std::string& request)
+    // The reply is delivered back on the strand, in whichever thread
+    // the handler finished the request.
+    //
+    void handleRequest (const std::string& request)
     {
         WriteLog (lsTRACE, RPCServer) << "handleRequest " << request;
-    
-        return m_handler.processRequest (request, 
+
+        pointer const self (boost::static_pointer_cast <RPCServerImp> (
+            shared_from_this ()));
+
+        m_handler.processRequestAsync (request,
             beast::IPAddressConversion::from_asio (
-                m_remote_endpoint.address()));
+                m_remote_endpoint.address()),
+            [self] (std::string const& reply)
+            {
+                self->mStrand.post (boost::bind (
+                    &RPCServerImp::handle_reply, self, reply));
+            });
     }
 
     //--------------------------------------------------------------------------
@@ -246,6 +355,16 @@ public:
     }
 
 private:
+    // A request read from the connection and, once done, its reply
+    struct Pending
+    {
+        Pending () : done (false) { }
+
+        std::string request;
+        std::string reply;
+        bool done;
+    };
+
     Handler& m_handler;
 
     boost::asio::io_service::strand mStrand;
@@ -254,9 +373,16 @@ private:
 
     boost::asio::streambuf mLineBuffer;
     Blob mQueryVec;
-    std::string mReplyStr;
 
     HTTPRequest mHTTPRequest;
+
+    // Outstanding requests in arrival order, guarded by the strand
+    std::deque <Pending> mPending;
+    bool mExecuting;
+    bool mWriting;
+    bool mReadPaused;
+    bool mClosing;
+    bool mShutdown;
 };
 
 } // ripple
@@ -59,3 +59,4 @@
 #include "rpc/InfoSub.cpp"
 
 #include "basics/RPCDoor.cpp"
+#include "basics/RPCServerTests.cpp"
@@ -17,6 +17,8 @@
 */
 //==============================================================================
 
+#include "../../beast/beast/unit_test/suite.h"
+
 namespace ripple {
 
 // This is the primary interface into the "client" portion of the program.
@@ -39,6 +41,40 @@ InfoSub::Source::Source (char const* name, Stoppable& parent)
 
 //------------------------------------------------------------------------------
 
+InfoSub::Message::Message (Json::Value const& json)
+    : m_json (json)
+    , m_rendered (false)
+{
+}
+
+InfoSub::Message::pointer InfoSub::Message::New (Json::Value const& json)
+{
+    return boost::make_shared <Message> (json);
+}
+
+std::string const& InfoSub::Message::getText () const
+{
+    ScopedLockType sl (m_lock);
+
+    if (! m_rendered)
+    {
+        {
+            JsonStreamWriter writer ([this] (void const* data, std::size_t bytes)
+            {
+                m_text.append (static_cast <char const*> (data), bytes);
+            });
+
+            writer.append (m_json);
+        }
+        m_text.push_back ('\n');
+        m_rendered = true;
+    }
+
+    return m_text;
+}
+
+//------------------------------------------------------------------------------
+
 InfoSub::InfoSub (Source& source, Consumer consumer)
     : m_consumer (consumer)
     , m_source (source)
@@ -67,6 +103,11 @@ void InfoSub::send (const Json::Value& jvObj, const std::string& sObj, bool broa
     send (jvObj, broadcast);
 }
 
+void InfoSub::send (Message::pointer const& message, bool broadcast)
+{
+    send (message->getJson (), message->getText (), broadcast);
+}
+
 std::uint64_t InfoSub::getSeq ()
 {
     return mSeq;
@@ -85,17 +126,221 @@ void InfoSub::insertSubAccountInfo (RippleAddress addr, std::uint32_t uLedgerInd
 
 void InfoSub::clearPathRequest ()
 {
+    ScopedLockType sl (mLock);
+
     mPathRequest.reset ();
 }
 
 void InfoSub::setPathRequest (const boost::shared_ptr<PathRequest>& req)
 {
+    ScopedLockType sl (mLock);
+
     mPathRequest = req;
 }
 
-const boost::shared_ptr<PathRequest>& InfoSub::getPathRequest ()
+boost::shared_ptr<PathRequest> InfoSub::getPathRequest ()
 {
+    ScopedLockType sl (mLock);
+
     return mPathRequest;
 }
 
+//------------------------------------------------------------------------------
+
+// Measures the cost of publishing one message against the number of
+// subscribers. Each subscriber copies the text into its own payload, as
+// a websocket connection does.
+class InfoSub_timing_test : public beast::unit_test::suite
+{
+public:
+    typedef std::chrono::high_resolution_clock clock_type;
+
+    enum
+    {
+        publishes = 20
+    };
+
+    class NullSource : public InfoSub::Source
+    {
+    public:
+        explicit NullSource (beast::Stoppable& parent)
+            : Source ("NullSource", parent)
+        {
+        }
+
+        void subAccount (InfoSub::ref, const boost::unordered_set<RippleAddress>&, std::uint32_t, bool) { }
+        void unsubAccount (std::uint64_t, const boost::unordered_set<RippleAddress>&, bool) { }
+        bool subLedger (InfoSub::ref, Json::Value&) { return true; }
+        bool unsubLedger (std::uint64_t) { return true; }
+        bool subServer (InfoSub::ref, Json::Value&) { return true; }
+        bool unsubServer (std::uint64_t) { return true; }
+        bool subBook (InfoSub::ref, RippleCurrency const&, RippleCurrency const&,
+            RippleIssuer const&, RippleIssuer const&) { return true; }
+        bool unsubBook (std::uint64_t, RippleCurrency const&, RippleCurrency const&,
+            RippleIssuer const&, RippleIssuer const&) { return true; }
+        bool subTransactions (InfoSub::ref) { return true; }
+        bool unsubTransactions (std::uint64_t) { return true; }
+        bool subRTTransactions (InfoSub::ref) { return true; }
+        bool unsubRTTransactions (std::uint64_t) { return true; }
+        InfoSub::pointer findRpcSub (const std::string&) { return InfoSub::pointer (); }
+        InfoSub::pointer addRpcSub (const std::string&, InfoSub::ref) { return InfoSub::pointer (); }
+    };
+
+    class Subscriber : public InfoSub
+    {
+    public:
+        explicit Subscriber (Source& source)
+            : InfoSub (source, Consumer ())
+            , m_bytes (0)
+        {
+        }
+
+        void send (const Json::Value& jvObj, bool)
+        {
+            Json::FastWriter w;
+            payload (w.write (jvObj));
+        }
+
+        void send (const Json::Value&, const std::string& sObj, bool)
+        {
+            payload (sObj);
+        }
+
+        void send (Message::pointer const& message, bool)
+        {
+            payload (message->getText ());
+        }
+
+        std::size_t bytes () const
+        {
+            return m_bytes;
+        }
+
+    private:
+        void payload (std::string const& text)
+        {
+            std::string copy (text);
+            m_bytes += copy.size ();
+        }
+
+        std::size_t m_bytes;
+    };
+
+    // Shaped like a validated payment with its metadata
+    static Json::Value transaction ()
+    {
+        Json::Value jv (Json::objectValue);
+        jv ["type"] = "transaction";
+        jv ["validated"] = true;
+        jv ["status"] = "closed";
+        jv ["ledger_index"] = 4000000;
+        jv ["ledger_hash"] = "2E1C2A8A04A4BAE8C02CBD2A7E6E2AC1A7D5E0A5C7C8D2F0E7B6A4D3C2B1A098";
+        jv ["engine_result"] = "tesSUCCESS";
+        jv ["engine_result_code"] = 0;
+        jv ["engine_result_message"] = "The transaction was applied.";
+
+        Json::Value& tx (jv ["transaction"]);
+        tx ["TransactionType"] = "Payment";
+        tx ["Account"] = "rHb9CJAWyB4rj91VRWn96DkukG4bwdtyTh";
+        tx ["Destination"] = "rPMh7Pi9ct699iZUTWaytJUoHcJ7cgyziK";
+        tx ["Amount"]["currency"] = "USD";
+        tx ["Amount"]["issuer"] = "rvYAfWj5gh67oV6fW32ZzP3Aw4Eubs59B";
+        tx ["Amount"]["value"] = "12.5";
+        tx ["Fee"] = "10";
+        tx ["Flags"] = 0;
+        tx ["Sequence"] = 1234;
+        tx ["SigningPubKey"] = "0330E7FC9D56BB25D6893BA3F317AE5BCF33B3291BD63DB32654A313222F7FD020";
+        tx ["TxnSignature"] = "304502210098D4D4E4B4B3B7C2D9A3F2B1C0E9D8C7B6A5F4E3D2C1B0A99887766554433221102206B5C4D3E2F1A0B9C8D7E6F5A4B3C2D1E0F9A8B7C6D5E4F3A2B1C0D9E8F7A6B5";
+        tx ["hash"] = "E3FE6EA3D48F0C2B639448020EA4F03D4F4F8FFDB243A852A0F59177921B4879";
+        tx ["date"] = 449000000;
+
+        Json::Value& nodes (jv ["meta"]["AffectedNodes"] = Json::Value (Json::arrayValue));
+        for (int i = 0; i < 6; ++i)
+        {
+            Json::Value& node (nodes.append (Json::objectValue) ["ModifiedNode"]);
+            node ["LedgerEntryType"] = "RippleState";
+            node ["LedgerIndex"] = "13F1A95D7AAB7108D5CE7EEAF504B2894B8C674E6D68499076441C4837282BF8";
+            node ["PreviousTxnID"] = "4A2F2D5E1C0B9A8F7E6D5C4B3A2918F7E6D5C4B3A29180F7E6D5C4B3A2918F7E";
+            node ["PreviousTxnLgrSeq"] = 3999990 + i;
+            node ["FinalFields"]["Balance"]["currency"] = "USD";
+            node ["FinalFields"]["Balance"]["issuer"] = "rrrrrrrrrrrrrrrrrrrrBZbvji";
+            node ["FinalFields"]["Balance"]["value"] = "-1000.25";
+            node ["FinalFields"]["Flags"] = 131072;
+            node ["PreviousFields"]["Balance"]["value"] = "-987.75";
+        }
+        jv ["meta"]["TransactionIndex"] = 3;
+        jv ["meta"]["TransactionResult"] = "tesSUCCESS";
+
+        return jv;
+    }
+
+    template <class Publish>
+    double measure (std::vector <InfoSub::pointer> const& subscribers, Publish publish)
+    {
+        clock_type::time_point const start (clock_type::now ());
+        for (int i = 0; i < publishes; ++i)
+            publish (subscribers);
+        return std::chrono::duration_cast <std::chrono::duration <double>> (
+            clock_type::now () - start).count () * 1000000 / publishes;
+    }
+
+    void run ()
+    {
+        beast::RootStoppable root ("root");
+        NullSource source (root);
+        Json::Value const jv (transaction ());
+
+        testcase ("publish");
+
+        int const counts [] = { 1, 10, 100, 1000, 5000 };
+        for (int count : counts)
+        {
+            std::vector <InfoSub::pointer> subscribers;
+            for (int i = 0; i < count; ++i)
+                subscribers.push_back (boost::make_shared <Subscriber> (boost::ref (source)));
+
+            // Every subscriber renders its own copy of the JSON
+            double const each (measure (subscribers,
+                [&jv] (std::vector <InfoSub::pointer> const& subs)
+                {
+                    for (auto const& sub : subs)
+                        sub->send (jv, true);
+                }));
+
+            // Rendered once for each of the transaction, book and account streams
+            double const streams (measure (subscribers,
+                [&jv] (std::vector <InfoSub::pointer> const& subs)
+                {
+                    for (int stream = 0; stream < 3; ++stream)
+                    {
+                        Json::FastWriter w;
+                        std::string const text (w.write (jv));
+                        for (std::size_t i = stream; i < subs.size (); i += 3)
+                            subs [i]->send (jv, text, true);
+                    }
+                }));
+
+            // Rendered once in total and shared
+            double const shared (measure (subscribers,
+                [&jv] (std::vector <InfoSub::pointer> const& subs)
+                {
+                    InfoSub::Message::pointer const message (InfoSub::Message::New (jv));
+                    for (auto const& sub : subs)
+                        sub->send (message, true);
+                }));
+
+            std::stringstream ss;
+            ss << count << " subscribers: " <<
+                each << "us rendered per subscriber, " <<
+                streams << "us rendered per stream, " <<
+                shared << "us shared";
+            log << ss.str ();
+        }
+
+        pass ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE_MANUAL(InfoSub_timing,ripple_net,ripple);
+
 } // ripple
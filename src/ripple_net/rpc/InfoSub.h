@@ -98,6 +98,39 @@ public:
         virtual pointer addRpcSub (const std::string& strUrl, ref rspEntry) = 0;
     };
 
+public:
+    /** A message published to many subscribers.
+        The message is immutable and shared by reference with every
+        subscriber it is sent to. Its text is rendered from the JSON the
+        first time a subscriber needs it, and at most once.
+    */
+    class Message : public beast::Uncopyable
+    {
+    public:
+        typedef boost::shared_ptr <Message const> pointer;
+
+        explicit Message (Json::Value const& json);
+
+        static pointer New (Json::Value const& json);
+
+        Json::Value const& getJson () const
+        {
+            return m_json;
+        }
+
+        /** Returns the message as JSON text, as Json::FastWriter writes it. */
+        std::string const& getText () const;
+
+    private:
+        Json::Value const m_json;
+
+        typedef RippleMutex LockType;
+        typedef std::lock_guard <LockType> ScopedLockType;
+        mutable LockType m_lock;
+        mutable bool m_rendered;
+        mutable std::string m_text;
+    };
+
 public:
     InfoSub (Source& source, Consumer consumer);
 
@@ -110,6 +143,11 @@ public:
     // VFALCO NOTE Why is this virtual?
     virtual void send (const Json::Value & jvObj, const std::string & sObj, bool broadcast);
 
+    /** Send a message shared with other subscribers.
+        The default sends the message's JSON and text.
+    */
+    virtual void send (Message::pointer const& message, bool broadcast);
+
     std::uint64_t getSeq ();
 
     void onSendEmpty ();
@@ -120,7 +158,7 @@ public:
 
     void setPathRequest (const boost::shared_ptr<PathRequest>& req);
 
-    boost::shared_ptr <PathRequest> const& getPathRequest ();
+    boost::shared_ptr <PathRequest> getPathRequest ();
 
 protected:
     typedef RippleMutex LockType;
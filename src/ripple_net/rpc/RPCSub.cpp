@@ -71,6 +71,11 @@ public:
     }
 
     void send (const Json::Value& jvObj, bool broadcast)
+    {
+        send (Message::New (jvObj), broadcast);
+    }
+
+    void send (Message::pointer const& message, bool broadcast)
     {
         ScopedLockType sl (mLock);
 
@@ -82,9 +87,11 @@ public:
         }
 
         WriteLog (broadcast ? lsDEBUG : lsINFO, RPCSub) <<
-            "RPCCall::fromNetwork push: " << jvObj;
+            "RPCCall::fromNetwork push: " << message->getJson ();
 
-        mDeque.push_back (std::make_pair (mSeq++, jvObj));
+        // Queued events share the published message, the copy with
+        // our sequence number is only made when the event is sent
+        mDeque.push_back (std::make_pair (mSeq++, message));
 
         if (!mSending)
         {
@@ -132,11 +139,11 @@ private:
                 }
                 else
                 {
-                    std::pair<int, Json::Value> pEvent  = mDeque.front ();
+                    std::pair<int, Message::pointer> pEvent  = mDeque.front ();
 
                     mDeque.pop_front ();
 
-                    jvEvent     = pEvent.second;
+                    jvEvent     = pEvent.second->getJson ();
                     jvEvent["seq"]  = pEvent.first;
 
                     bSend       = true;
@@ -190,7 +197,7 @@ private:
 
     bool                    mSending;                   // Sending threead is active.
 
-    std::deque<std::pair<int, Json::Value> >    mDeque;
+    std::deque<std::pair<int, Message::pointer> >   mDeque;
 };
 
 //------------------------------------------------------------------------------
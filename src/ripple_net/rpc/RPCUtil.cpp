@@ -110,6 +110,11 @@ std::string HTTPReply (int nStatus, const std::string& strMsg)
                           "<BODY><H1>401 Unauthorized.</H1></BODY>\r\n"
                           "</HTML>\r\n", rfc1123Time ().c_str (), FormatFullVersion ().c_str ());
 
+    return HTTPReplyHeader (nStatus, strMsg.size () + 2) + strMsg + "\r\n";
+}
+
+std::string HTTPReplyHeader (int nStatus, std::size_t contentLength)
+{
     std::string strStatus;
 
     if (nStatus == 200) strStatus = "OK";
@@ -117,6 +122,7 @@ std::string HTTPReply (int nStatus, const std::string& strMsg)
     else if (nStatus == 403) strStatus = "Forbidden";
     else if (nStatus == 404) strStatus = "Not Found";
     else if (nStatus == 500) strStatus = "Internal Server Error";
+    else if (nStatus == 503) strStatus = "Service Unavailable";
 
     std::string access;
 
@@ -128,19 +134,36 @@ std::string HTTPReply (int nStatus, const std::string& strMsg)
                "Date: %s\r\n"
                "Connection: Keep-Alive\r\n"
                "%s"
-               "Content-Length: %d\r\n"
+               "Content-Length: %llu\r\n"
                "Content-Type: application/json; charset=UTF-8\r\n"
                "Server: " SYSTEM_NAME "-json-rpc/%s\r\n"
-               "\r\n"
-               "%s\r\n",
+               "\r\n",
                nStatus,
                strStatus.c_str (),
                rfc1123Time ().c_str (),
                access.c_str (),
-               strMsg.size () + 2,
+               static_cast <unsigned long long> (contentLength),
                //SERVER_VERSION,
-               BuildInfo::getFullVersionString (),
-               strMsg.c_str ());
+               BuildInfo::getFullVersionString ());
+}
+
+void HTTPReplyStream (const Json::Value& result, JsonStreamWriter::Output const& output)
+{
+    // The body is the same as JSONRPCReply's, sized first so the
+    // header can be sent before the body is written out in chunks.
+    std::size_t const size = 2 + 8 + JsonStreamWriter::measure (result) + 1;
+
+    std::string const header (HTTPReplyHeader (200, size + 3));
+    output (header.data (), header.size ());
+
+    {
+        JsonStreamWriter writer (output, 65536);
+        writer.startObject ();
+        writer.add ("result", result);
+        writer.endObject ();
+    }
+
+    output ("\n\r\n", 3);
 }
 
 int ReadHTTPStatus (std::basic_istream<char>& stream)
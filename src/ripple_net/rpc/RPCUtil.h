@@ -38,6 +38,14 @@ extern std::string createHTTPPost (const std::string& strHost, const std::string
 
 extern std::string HTTPReply (int nStatus, const std::string& strMsg);
 
+extern std::string HTTPReplyHeader (int nStatus, std::size_t contentLength);
+
+/** Write a successful HTTP reply carrying a JSON-RPC result.
+    The result is written out in chunks as it is rendered, rather than
+    first being converted to a string.
+*/
+extern void HTTPReplyStream (const Json::Value& result, JsonStreamWriter::Output const& output);
+
 // VFALCO TODO Create a HTTPHeaders class with a nice interface instead of the std::map
 //
 extern bool HTTPAuthorized (std::map <std::string, std::string> const& mapHeaders);
@@ -0,0 +1,88 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#ifndef RIPPLE_OVERLAY_MESSAGEBUFFER_H_INCLUDED
+#define RIPPLE_OVERLAY_MESSAGEBUFFER_H_INCLUDED
+
+#include "../../beast/beast/smart_ptr/SharedObject.h"
+#include "../../beast/beast/smart_ptr/SharedPtr.h"
+
+#include <cstdint>
+#include <memory>
+
+namespace ripple {
+
+/** A reference-counted block of bytes holding one framed peer message.
+
+    Blocks are recycled through a process-wide pool, sorted into classes
+    by capacity, so that reading from peers and broadcasting to them does
+    not allocate once the pool is warm. Blocks above the largest class
+    are allocated and freed normally.
+
+    The contents are written once, by whoever made the buffer, and are
+    then shared read-only by every reader, send queue and job holding a
+    reference.
+*/
+class MessageBuffer : public beast::SharedObject
+{
+public:
+    typedef beast::SharedPtr <MessageBuffer> ptr;
+
+    /** Returns a buffer holding exactly `bytes` uninitialized bytes. */
+    static ptr make (std::size_t bytes);
+
+    std::uint8_t* data ()
+    {
+        return m_data.get ();
+    }
+
+    std::uint8_t const* data () const
+    {
+        return m_data.get ();
+    }
+
+    std::size_t size () const
+    {
+        return m_size;
+    }
+
+    /** Discards bytes from the end, while the buffer is being filled. */
+    void truncate (std::size_t bytes)
+    {
+        assert (bytes <= m_size);
+        m_size = bytes;
+    }
+
+private:
+    class Pool;
+
+    MessageBuffer (std::size_t capacity, int sizeClass);
+
+    // Returns the block to its pool instead of deleting it
+    void destroy () const override;
+
+    std::unique_ptr <std::uint8_t []> m_data;
+    std::size_t const m_capacity;
+    int const m_sizeClass;
+    std::size_t m_size;
+};
+
+}
+
+#endif
@@ -22,10 +22,14 @@
 
 #include "ripple.pb.h"
 
+#include "MessageBuffer.h"
+
 #include "../beast/modules/beast_core/system/BeforeBoost.h"
 #include <boost/enable_shared_from_this.hpp>
 #include <boost/shared_ptr.hpp>
 
+#include <mutex>
+
 namespace ripple {
 
 // VFALCO NOTE If we forward declare PackedMessage and write out shared_ptr
@@ -52,34 +56,88 @@ public:
     */
     static size_t const kHeaderBytes = 6;
 
+    /** Set in the length field of the header when the payload is compressed.
+        A compressed payload is the uncompressed size as four big-endian
+        bytes, followed by the zlib stream.
+    */
+    static std::uint32_t const kCompressedFlag = 0x80000000;
+
+    /** Compression algorithms, advertised as a bitmask in TMHello.
+    */
+    static std::uint32_t const kCompressionZlib = 1;
+
+    /** Smaller payloads are never compressed.
+    */
+    static size_t const kCompressionThreshold = 1024;
+
+    /** Serialize a message into a new frame.
+    */
     PackedMessage (::google::protobuf::Message const& message, int type);
 
+    /** Wrap an existing frame, header included, without copying.
+        This is used to relay a message exactly as it was received.
+    */
+    explicit PackedMessage (MessageBuffer::ptr const& frame);
+
     /** Retrieve the packed message data.
     */
-    // VFALCO TODO shouldn't this be const?
-    std::vector <uint8_t>& getBuffer ()
+    std::uint8_t const* data () const
+    {
+        return mBuffer->data ();
+    }
+
+    std::size_t size () const
+    {
+        return mBuffer->size ();
+    }
+
+    /** Retrieve the shared frame holding the packed message.
+    */
+    MessageBuffer::ptr const& getFrame () const
     {
         return mBuffer;
     }
 
+    /** Retrieve the frame to send on a link which accepts compression.
+        Large ledger data and fetch pack messages are compressed the first
+        time this is called, and the result is shared by every link. Other
+        messages, and those which do not shrink, are returned unchanged.
+    */
+    MessageBuffer::ptr const& getCompressedFrame ();
+
+    /** Expand a compressed frame into a new, uncompressed one.
+        Returns nullptr if the frame is corrupt.
+    */
+    static MessageBuffer::ptr decompress (MessageBuffer const& frame);
+
     /** Determine bytewise equality.
     */
     bool operator == (PackedMessage const& other) const;
 
-    /** Calculate the length of a packed message.
+    /** Calculate the length of a packed message from its header.
+        The header must hold at least kHeaderBytes bytes.
     */
-    static unsigned getLength (std::vector <uint8_t> const& buf);
+    static unsigned getLength (std::uint8_t const* header);
 
-    /** Determine the type of a packed message.
+    /** Determine if the payload of a packed message is compressed.
     */
-    static int getType (std::vector <uint8_t> const& buf);
+    static bool isCompressed (std::uint8_t const* header);
+
+    /** Determine the type of a packed message from its header.
+        The header must hold at least kHeaderBytes bytes.
+    */
+    static int getType (std::uint8_t const* header);
 
 private:
     // Encodes the size and type into a header at the beginning of buf
     //
-    void encodeHeader (unsigned size, int type);
+    static void encodeHeader (std::uint8_t* buf, std::uint32_t size, int type);
+
+    MessageBuffer::ptr mBuffer;
 
-    std::vector <uint8_t> mBuffer;
+    // The frame for links which accept compression, made on first use
+    std::mutex mCompressedLock;
+    MessageBuffer::ptr mCompressed;
 };
 
 }
@@ -0,0 +1,180 @@
+//------------------------------------------------------------------------------
+/*
+    This file is part of rippled: https://github.com/ripple/rippled
+    Copyright (c) 2012, 2013 Ripple Labs Inc.
+
+    Permission to use, copy, modify, and/or distribute this software for any
+    purpose  with  or without fee is hereby granted, provided that the above
+    copyright notice and this permission notice appear in all copies.
+
+    THE  SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+    WITH  REGARD  TO  THIS  SOFTWARE  INCLUDING  ALL  IMPLIED  WARRANTIES  OF
+    MERCHANTABILITY  AND  FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+    ANY  SPECIAL ,  DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+    WHATSOEVER  RESULTING  FROM  LOSS  OF USE, DATA OR PROFITS, WHETHER IN AN
+    ACTION  OF  CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+    OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+*/
+//==============================================================================
+
+#include "../../beast/beast/unit_test/suite.h"
+
+#include <mutex>
+#include <vector>
+
+namespace ripple {
+
+class MessageBuffer::Pool
+{
+public:
+    // Capacities are powers of two from 256 bytes to 64 kilobytes
+    static std::size_t const smallestCapacity = 256;
+    static int const classCount = 9;
+
+    // The most free blocks kept in each class
+    static std::size_t const maximumFree = 256;
+
+    static Pool& instance ()
+    {
+        static Pool pool;
+        return pool;
+    }
+
+    ~Pool ()
+    {
+        for (auto& bin : m_bins)
+        {
+            for (auto buffer : bin.free)
+                delete buffer;
+        }
+    }
+
+    MessageBuffer* acquire (std::size_t bytes)
+    {
+        int sizeClass (0);
+        std::size_t capacity (smallestCapacity);
+
+        while (capacity < bytes && sizeClass < classCount)
+        {
+            capacity <<= 1;
+            ++sizeClass;
+        }
+
+        if (sizeClass == classCount)
+            return new MessageBuffer (bytes, -1);
+
+        Bin& bin (m_bins [sizeClass]);
+
+        {
+            std::lock_guard <std::mutex> lock (bin.mutex);
+
+            if (! bin.free.empty ())
+            {
+                MessageBuffer* const buffer (bin.free.back ());
+                bin.free.pop_back ();
+                return buffer;
+            }
+        }
+
+        return new MessageBuffer (capacity, sizeClass);
+    }
+
+    void release (MessageBuffer* buffer)
+    {
+        if (buffer->m_sizeClass >= 0)
+        {
+            Bin& bin (m_bins [buffer->m_sizeClass]);
+
+            std::lock_guard <std::mutex> lock (bin.mutex);
+
+            if (bin.free.size () < maximumFree)
+            {
+                bin.free.push_back (buffer);
+                return;
+            }
+        }
+
+        delete buffer;
+    }
+
+private:
+    struct Bin
+    {
+        std::mutex mutex;
+        std::vector <MessageBuffer*> free;
+    };
+
+    Bin m_bins [classCount];
+};
+
+//------------------------------------------------------------------------------
+
+MessageBuffer::MessageBuffer (std::size_t capacity, int sizeClass)
+    : m_data (new std::uint8_t [capacity])
+    , m_capacity (capacity)
+    , m_sizeClass (sizeClass)
+    , m_size (0)
+{
+}
+
+MessageBuffer::ptr MessageBuffer::make (std::size_t bytes)
+{
+    MessageBuffer* const buffer (Pool::instance ().acquire (bytes));
+    assert (buffer->m_capacity >= bytes);
+    buffer->m_size = bytes;
+    return buffer;
+}
+
+void MessageBuffer::destroy () const
+{
+    Pool::instance ().release (const_cast <MessageBuffer*> (this));
+}
+
+//------------------------------------------------------------------------------
+
+class MessageBuffer_test : public beast::unit_test::suite
+{
+public:
+    void run ()
+    {
+        // A released block is handed out again for a similar size
+        std::uint8_t const* first;
+        {
+            MessageBuffer::ptr const b (MessageBuffer::make (300));
+            expect (b->size () == 300);
+            first = b->data ();
+        }
+        {
+            MessageBuffer::ptr const b (MessageBuffer::make (500));
+            expect (b->size () == 500);
+            expect (b->data () == first, "block reused");
+        }
+
+        // Shared references keep the block alive
+        {
+            MessageBuffer::ptr a (MessageBuffer::make (10));
+            a->data () [0] = 42;
+            MessageBuffer::ptr const b (a);
+            a = nullptr;
+            expect (b->data () [0] == 42);
+        }
+
+        // Assigning a new buffer leaves it with one reference
+        {
+            MessageBuffer::ptr a;
+            a = MessageBuffer::make (10);
+            expect (a->getReferenceCount () == 1);
+        }
+
+        // Oversized blocks bypass the pool
+        {
+            MessageBuffer::ptr const b (MessageBuffer::make (1024 * 1024));
+            expect (b->size () == 1024 * 1024);
+            b->data () [b->size () - 1] = 1;
+        }
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(MessageBuffer,overlay,ripple);
+
+}
@@ -17,6 +17,8 @@
 */
 //==============================================================================
 
+#include "../../beast/beast/unit_test/suite.h"
+
 namespace ripple {
 
 PackedMessage::PackedMessage (::google::protobuf::Message const& message, int type)
@@ -25,13 +27,14 @@ PackedMessage::PackedMessage (::google::protobuf::Message const& message, int ty
 
     assert (messageBytes != 0);
 
-    mBuffer.resize (kHeaderBytes + messageBytes);
+    mBuffer = MessageBuffer::make (kHeaderBytes + messageBytes);
 
-    encodeHeader (messageBytes, type);
+    encodeHeader (mBuffer->data (), messageBytes, type);
 
     if (messageBytes != 0)
     {
-        message.SerializeToArray (&mBuffer [PackedMessage::kHeaderBytes], messageBytes);
+        message.SerializeWithCachedSizesToArray (
+            mBuffer->data () + PackedMessage::kHeaderBytes);
 
 #ifdef BEAST_DEBUG
         //Log::out() << "PackedMessage: type=" << type << ", datalen=" << msg_size;
@@ -39,53 +42,226 @@ PackedMessage::PackedMessage (::google::protobuf::Message const& message, int ty
     }
 }
 
-bool PackedMessage::operator== (PackedMessage const& other) const
+PackedMessage::PackedMessage (MessageBuffer::ptr const& frame)
+    : mBuffer (frame)
 {
-    return mBuffer == other.mBuffer;
+    assert (mBuffer->size () >= kHeaderBytes);
+    assert (! isCompressed (mBuffer->data ()));
+    assert (getLength (mBuffer->data ()) + kHeaderBytes == mBuffer->size ());
 }
 
-unsigned PackedMessage::getLength (std::vector <uint8_t> const& buf)
+MessageBuffer::ptr const& PackedMessage::getCompressedFrame ()
 {
-    unsigned result;
+    int const type (getType (mBuffer->data ()));
+    std::size_t const messageBytes (mBuffer->size () - kHeaderBytes);
+
+    if ((type != protocol::mtLEDGER_DATA && type != protocol::mtGET_OBJECTS) ||
+        (messageBytes < kCompressionThreshold))
+    {
+        return mBuffer;
+    }
+
+    std::lock_guard <std::mutex> lock (mCompressedLock);
 
-    if (buf.size () >= PackedMessage::kHeaderBytes)
+    if (mCompressed == nullptr)
     {
-        result = buf [0];
-        result <<= 8;
-        result |= buf [1];
-        result <<= 8;
-        result |= buf [2];
-        result <<= 8;
-        result |= buf [3];
+        uLongf compressedBytes (compressBound (messageBytes));
+        MessageBuffer::ptr const frame (MessageBuffer::make (
+            kHeaderBytes + 4 + compressedBytes));
+        std::uint8_t* const payload (frame->data () + kHeaderBytes);
+
+        payload[0] = static_cast<std::uint8_t> ((messageBytes >> 24) & 0xFF);
+        payload[1] = static_cast<std::uint8_t> ((messageBytes >> 16) & 0xFF);
+        payload[2] = static_cast<std::uint8_t> ((messageBytes >> 8) & 0xFF);
+        payload[3] = static_cast<std::uint8_t> (messageBytes & 0xFF);
+
+        // Fast compression; SHAMap nodes are highly redundant
+        if ((compress2 (payload + 4, &compressedBytes,
+                mBuffer->data () + kHeaderBytes, messageBytes,
+                    Z_BEST_SPEED) == Z_OK) &&
+            (4 + compressedBytes < messageBytes))
+        {
+            frame->truncate (kHeaderBytes + 4 + compressedBytes);
+            encodeHeader (frame->data (),
+                (4 + compressedBytes) | kCompressedFlag, type);
+            mCompressed = frame;
+        }
+        else
+        {
+            mCompressed = mBuffer;
+        }
     }
-    else
+
+    return mCompressed;
+}
+
+MessageBuffer::ptr PackedMessage::decompress (MessageBuffer const& frame)
+{
+    std::uint8_t const* const header (frame.data ());
+    std::size_t const payloadBytes (getLength (header));
+
+    assert (isCompressed (header));
+
+    if ((frame.size () != kHeaderBytes + payloadBytes) || (payloadBytes < 4))
+        return nullptr;
+
+    std::uint8_t const* const payload (header + kHeaderBytes);
+
+    std::uint32_t messageBytes;
+    messageBytes = payload [0];
+    messageBytes <<= 8;
+    messageBytes |= payload [1];
+    messageBytes <<= 8;
+    messageBytes |= payload [2];
+    messageBytes <<= 8;
+    messageBytes |= payload [3];
+
+    // Same limit as for uncompressed messages
+    if ((messageBytes == 0) || (messageBytes > (32 * 1024 * 1024)))
+        return nullptr;
+
+    MessageBuffer::ptr const result (
+        MessageBuffer::make (kHeaderBytes + messageBytes));
+
+    uLongf expandedBytes (messageBytes);
+
+    if ((uncompress (result->data () + kHeaderBytes, &expandedBytes,
+            payload + 4, payloadBytes - 4) != Z_OK) ||
+        (expandedBytes != messageBytes))
     {
-        result = 0;
+        return nullptr;
     }
 
+    encodeHeader (result->data (), messageBytes, getType (header));
+
     return result;
 }
 
-int PackedMessage::getType (std::vector<uint8_t> const& buf)
+bool PackedMessage::operator== (PackedMessage const& other) const
+{
+    return (size () == other.size ()) &&
+        (memcmp (data (), other.data (), size ()) == 0);
+}
+
+unsigned PackedMessage::getLength (std::uint8_t const* header)
+{
+    unsigned result;
+
+    result = header [0];
+    result <<= 8;
+    result |= header [1];
+    result <<= 8;
+    result |= header [2];
+    result <<= 8;
+    result |= header [3];
+
+    return result & ~kCompressedFlag;
+}
+
+bool PackedMessage::isCompressed (std::uint8_t const* header)
 {
-    if (buf.size () < PackedMessage::kHeaderBytes)
-        return 0;
+    return (header [0] & 0x80) != 0;
+}
 
-    int ret = buf[4];
+int PackedMessage::getType (std::uint8_t const* header)
+{
+    int ret = header[4];
     ret <<= 8;
-    ret |= buf[5];
+    ret |= header[5];
     return ret;
 }
 
-void PackedMessage::encodeHeader (unsigned size, int type)
+void PackedMessage::encodeHeader (std::uint8_t* buf, std::uint32_t size, int type)
 {
-    assert (mBuffer.size () >= PackedMessage::kHeaderBytes);
-    mBuffer[0] = static_cast<boost::uint8_t> ((size >> 24) & 0xFF);
-    mBuffer[1] = static_cast<boost::uint8_t> ((size >> 16) & 0xFF);
-    mBuffer[2] = static_cast<boost::uint8_t> ((size >> 8) & 0xFF);
-    mBuffer[3] = static_cast<boost::uint8_t> (size & 0xFF);
-    mBuffer[4] = static_cast<boost::uint8_t> ((type >> 8) & 0xFF);
-    mBuffer[5] = static_cast<boost::uint8_t> (type & 0xFF);
+    buf[0] = static_cast<boost::uint8_t> ((size >> 24) & 0xFF);
+    buf[1] = static_cast<boost::uint8_t> ((size >> 16) & 0xFF);
+    buf[2] = static_cast<boost::uint8_t> ((size >> 8) & 0xFF);
+    buf[3] = static_cast<boost::uint8_t> (size & 0xFF);
+    buf[4] = static_cast<boost::uint8_t> ((type >> 8) & 0xFF);
+    buf[5] = static_cast<boost::uint8_t> (type & 0xFF);
 }
 
+//------------------------------------------------------------------------------
+
+class PackedMessage_test : public beast::unit_test::suite
+{
+public:
+    void testFraming ()
+    {
+        testcase ("framing");
+
+        protocol::TMPing ping;
+        ping.set_type (protocol::TMPing::ptPING);
+        ping.set_seq (7);
+
+        PackedMessage const packed (ping, protocol::mtPING);
+        expect (packed.size () == PackedMessage::kHeaderBytes + ping.ByteSize ());
+        expect (PackedMessage::getLength (packed.data ()) == ping.ByteSize ());
+        expect (PackedMessage::getType (packed.data ()) == protocol::mtPING);
+        expect (! PackedMessage::isCompressed (packed.data ()));
+
+        // A frame relayed as received is byte-identical
+        PackedMessage const relayed (packed.getFrame ());
+        expect (relayed == packed);
+        expect (relayed.data () == packed.data (), "frame shared");
+
+        protocol::TMPing parsed;
+        expect (parsed.ParseFromArray (
+            packed.data () + PackedMessage::kHeaderBytes,
+                packed.size () - PackedMessage::kHeaderBytes));
+        expect (parsed.seq () == 7);
+    }
+
+    void testCompression ()
+    {
+        testcase ("compression");
+
+        // Ledger data full of similar nodes compresses well
+        protocol::TMLedgerData data;
+        data.set_ledgerhash (std::string (32, 'h'));
+        data.set_ledgerseq (1);
+        data.set_type (protocol::liAS_NODE);
+        for (int i = 0; i < 100; ++i)
+        {
+            protocol::TMLedgerNode& node (*data.add_nodes ());
+            node.set_nodedata (std::string (200, static_cast <char> (i % 4)));
+            node.set_nodeid (std::string (33, static_cast <char> (i)));
+        }
+
+        PackedMessage packed (data, protocol::mtLEDGER_DATA);
+        MessageBuffer::ptr const compressed (packed.getCompressedFrame ());
+        expect (PackedMessage::isCompressed (compressed->data ()));
+        expect (compressed->size () < packed.size () / 4);
+        expect (PackedMessage::getType (compressed->data ()) == protocol::mtLEDGER_DATA);
+        expect (PackedMessage::getLength (compressed->data ()) +
+            PackedMessage::kHeaderBytes == compressed->size ());
+        expect (packed.getCompressedFrame () == compressed, "compressed once");
+
+        MessageBuffer::ptr const expanded (PackedMessage::decompress (*compressed));
+        expect (expanded != nullptr);
+        expect (PackedMessage (expanded) == packed, "round trip");
+
+        // A damaged stream is rejected
+        MessageBuffer::ptr const damaged (MessageBuffer::make (compressed->size ()));
+        memcpy (damaged->data (), compressed->data (), compressed->size ());
+        damaged->data () [damaged->size () / 2] ^= 0x55;
+        damaged->data () [damaged->size () - 1] ^= 0x55;
+        expect (PackedMessage::decompress (*damaged) == nullptr);
+
+        // Other types and small messages are sent as is
+        protocol::TMPing ping;
+        ping.set_type (protocol::TMPing::ptPING);
+        PackedMessage small (ping, protocol::mtPING);
+        expect (small.getCompressedFrame () == small.getFrame ());
+    }
+
+    void run ()
+    {
+        testFraming ();
+        testCompression ();
+    }
+};
+
+BEAST_DEFINE_TESTSUITE(PackedMessage,overlay,ripple);
+
 }
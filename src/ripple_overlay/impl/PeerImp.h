@@ -204,7 +204,10 @@ public:
 
     boost::asio::deadline_timer         m_timer;
 
-    std::vector<uint8_t>                m_readBuffer;
+    // The header of the message being read, then the complete frame.
+    // The frame is shared with the jobs that relay it.
+    std::uint8_t                        m_readHeader [PackedMessage::kHeaderBytes];
+    MessageBuffer::ptr                  m_readBuffer;
     std::list<PackedMessage::pointer>   mSendQ;
     PackedMessage::pointer              mSendingPacket;
     protocol::TMStatusChange            mLastStatus;
@@ -218,6 +221,9 @@ public:
     // True if close was called
     bool m_was_canceled;
 
+    // True if both sides accept compressed messages
+    bool m_compression;
+
     //--------------------------------------------------------------------------
     /** New incoming peer from the specified socket */
     PeerImp (
@@ -248,6 +254,7 @@ public:
             , m_timer (socket->get_io_service())
             , m_slot (slot)
             , m_was_canceled (false)
+            , m_compression (false)
     {
     }
         
@@ -284,6 +291,7 @@ public:
             , m_timer (io_service)
             , m_slot (slot)
             , m_was_canceled (false)
+            , m_compression (false)
     {
     }
     
@@ -722,7 +730,14 @@ private:
             return;
         }
 
-        unsigned msg_len = PackedMessage::getLength (m_readBuffer);
+        unsigned msg_len = PackedMessage::getLength (m_readHeader);
+
+        // A peer may only compress after we offer to accept it
+        if (PackedMessage::isCompressed (m_readHeader) && !m_compression)
+        {
+            detach ("hrh-compressed");
+            return;
+        }
 
         // WRITEME: Compare to maximum message length, abort if too large
         if ((msg_len > (32 * 1024 * 1024)) || (msg_len == 0))
@@ -824,7 +839,22 @@ private:
     void processReadBuffer ()
     {
         // must not hold peer lock
-        int type = PackedMessage::getType (m_readBuffer);
+        if (PackedMessage::isCompressed (m_readBuffer->data ()))
+        {
+            MessageBuffer::ptr const frame (
+                PackedMessage::decompress (*m_readBuffer));
+
+            if (frame == nullptr)
+            {
+                m_journal.warning << "Compressed message is corrupt";
+                charge (Resource::feeInvalidRequest);
+                return;
+            }
+
+            m_readBuffer = frame;
+        }
+
+        int type = PackedMessage::getType (m_readBuffer->data ());
 
         LoadEvent::autoptr event (
             getApp().getJobQueue ().getLoadEventAP (jtPEER, "Peer::read"));
@@ -848,7 +878,9 @@ private:
                 return;
             }
 
-            size_t msgLen (m_readBuffer.size () - PackedMessage::kHeaderBytes);
+            std::uint8_t const* msgData (
+                m_readBuffer->data () + PackedMessage::kHeaderBytes);
+            size_t msgLen (m_readBuffer->size () - PackedMessage::kHeaderBytes);
 
             switch (type)
             {
@@ -857,8 +889,7 @@ private:
                 event->reName ("Peer::hello");
                 protocol::TMHello msg;
 
-                if (msg.ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                        msgLen))
+                if (msg.ParseFromArray (msgData, msgLen))
                     recvHello (msg);
                 else
                     m_journal.warning << "parse error: " << type;
@@ -870,8 +901,7 @@ private:
                 event->reName ("Peer::cluster");
                 protocol::TMCluster msg;
 
-                if (msg.ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                        msgLen))
+                if (msg.ParseFromArray (msgData, msgLen))
                     recvCluster (msg);
                 else
                     m_journal.warning << "parse error: " << type;
@@ -883,8 +913,7 @@ private:
                 event->reName ("Peer::errormessage");
                 protocol::TMErrorMsg msg;
 
-                if (msg.ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                        msgLen))
+                if (msg.ParseFromArray (msgData, msgLen))
                     recvErrorMessage (msg);
                 else
                     m_journal.warning << "parse error: " << type;
@@ -896,8 +925,7 @@ private:
                 event->reName ("Peer::ping");
                 protocol::TMPing msg;
 
-                if (msg.ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                        msgLen))
+                if (msg.ParseFromArray (msgData, msgLen))
                     recvPing (msg);
                 else
                     m_journal.warning << "parse error: " << type;
@@ -909,8 +937,7 @@ private:
                 event->reName ("Peer::getcontacts");
                 protocol::TMGetContacts msg;
 
-                if (msg.ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                        msgLen))
+                if (msg.ParseFromArray (msgData, msgLen))
                     recvGetContacts (msg);
                 else
                     m_journal.warning << "parse error: " << type;
@@ -922,8 +949,7 @@ private:
                 event->reName ("Peer::contact");
                 protocol::TMContact msg;
 
-                if (msg.ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                        msgLen))
+                if (msg.ParseFromArray (msgData, msgLen))
                     recvContact (msg);
                 else
                     m_journal.warning << "parse error: " << type;
@@ -935,8 +961,7 @@ private:
                 event->reName ("Peer::getpeers");
                 protocol::TMGetPeers msg;
 
-                if (msg.ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                        msgLen))
+                if (msg.ParseFromArray (msgData, msgLen))
                     recvGetPeers (msg);
                 else
                     m_journal.warning << "parse error: " << type;
@@ -948,8 +973,7 @@ private:
                 event->reName ("Peer::peers");
                 protocol::TMPeers msg;
 
-                if (msg.ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                        msgLen))
+                if (msg.ParseFromArray (msgData, msgLen))
                     recvPeers (msg);
                 else
                     m_journal.warning << "parse error: " << type;
@@ -961,8 +985,7 @@ private:
                 event->reName ("Peer::endpoints");
                 protocol::TMEndpoints msg;
 
-                if(msg.ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                       msgLen))
+                if(msg.ParseFromArray (msgData, msgLen))
                     recvEndpoints (msg);
                 else
                     m_journal.warning << "parse error: " << type;;
@@ -974,8 +997,7 @@ private:
                 event->reName ("Peer::searchtransaction");
                 protocol::TMSearchTransaction msg;
 
-                if (msg.ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                        msgLen))
+                if (msg.ParseFromArray (msgData, msgLen))
                     recvSearchTransaction (msg);
                 else
                     m_journal.warning << "parse error: " << type;
@@ -987,8 +1009,7 @@ private:
                 event->reName ("Peer::getaccount");
                 protocol::TMGetAccount msg;
 
-                if (msg.ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                        msgLen))
+                if (msg.ParseFromArray (msgData, msgLen))
                     recvGetAccount (msg);
                 else
                     m_journal.warning << "parse error: " << type;
@@ -1000,8 +1021,7 @@ private:
                 event->reName ("Peer::account");
                 protocol::TMAccount msg;
 
-                if (msg.ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                        msgLen))
+                if (msg.ParseFromArray (msgData, msgLen))
                     recvAccount (msg);
                 else
                     m_journal.warning << "parse error: " << type;
@@ -1013,8 +1033,7 @@ private:
                 event->reName ("Peer::transaction");
                 protocol::TMTransaction msg;
 
-                if (msg.ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                        msgLen))
+                if (msg.ParseFromArray (msgData, msgLen))
                     recvTransaction (msg);
                 else
                     m_journal.warning << "parse error: " << type;
@@ -1026,8 +1045,7 @@ private:
                 event->reName ("Peer::statuschange");
                 protocol::TMStatusChange msg;
 
-                if (msg.ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                        msgLen))
+                if (msg.ParseFromArray (msgData, msgLen))
                     recvStatus (msg);
                 else
                     m_journal.warning << "parse error: " << type;
@@ -1040,9 +1058,8 @@ private:
                 boost::shared_ptr<protocol::TMProposeSet> msg (
                 	boost::make_shared<protocol::TMProposeSet> ());
 
-                if (msg->ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                         msgLen))
-                    recvPropose (msg);
+                if (msg->ParseFromArray (msgData, msgLen))
+                    recvPropose (msg, m_readBuffer);
                 else
                     m_journal.warning << "parse error: " << type;
             }
@@ -1054,8 +1071,7 @@ private:
                 boost::shared_ptr<protocol::TMGetLedger> msg ( 
                     boost::make_shared<protocol::TMGetLedger> ());
 
-                if (msg->ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                        msgLen))
+                if (msg->ParseFromArray (msgData, msgLen))
                     recvGetLedger (msg);
                 else
                     m_journal.warning << "parse error: " << type;
@@ -1068,8 +1084,7 @@ private:
                 boost::shared_ptr<protocol::TMLedgerData> msg (
                 	boost::make_shared<protocol::TMLedgerData> ());
 
-                if (msg->ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                         msgLen))
+                if (msg->ParseFromArray (msgData, msgLen))
                     recvLedger (msg);
                 else
                     m_journal.warning << "parse error: " << type;
@@ -1081,8 +1096,7 @@ private:
                 event->reName ("Peer::haveset");
                 protocol::TMHaveTransactionSet msg;
 
-                if (msg.ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                        msgLen))
+                if (msg.ParseFromArray (msgData, msgLen))
                     recvHaveTxSet (msg);
                 else
                     m_journal.warning << "parse error: " << type;
@@ -1095,9 +1109,8 @@ private:
                 boost::shared_ptr<protocol::TMValidation> msg (
                 	boost::make_shared<protocol::TMValidation> ());
 
-                if (msg->ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                         msgLen))
-                    recvValidation (msg);
+                if (msg->ParseFromArray (msgData, msgLen))
+                    recvValidation (msg, m_readBuffer);
                 else
                     m_journal.warning << "parse error: " << type;
             }
@@ -1108,7 +1121,7 @@ private:
             {
                 protocol::TM msg;
 
-                if (msg.ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes], msgLen))
+                if (msg.ParseFromArray (msgData, msgLen))
                     recv (msg);
                 else
                     m_journal.warning << "parse error: " << type;
@@ -1123,8 +1136,7 @@ private:
                 boost::shared_ptr<protocol::TMGetObjectByHash> msg =
                     boost::make_shared<protocol::TMGetObjectByHash> ();
 
-                if (msg->ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                         msgLen))
+                if (msg->ParseFromArray (msgData, msgLen))
                     recvGetObjectByHash (msg);
                 else
                     m_journal.warning << "parse error: " << type;
@@ -1136,8 +1148,7 @@ private:
                 event->reName ("Peer::proofofwork");
                 protocol::TMProofWork msg;
 
-                if (msg.ParseFromArray (&m_readBuffer[PackedMessage::kHeaderBytes],
-                                        msgLen))
+                if (msg.ParseFromArray (msgData, msgLen))
                     recvProofWork (msg);
                 else
                     m_journal.warning << "parse error: " << type;
@@ -1148,7 +1159,7 @@ private:
             default:
                 event->reName ("Peer::unknown");
                 m_journal.warning << "Unknown Msg: " << type;
-                m_journal.warning << strHex (&m_readBuffer[0], m_readBuffer.size ());
+                m_journal.warning << strHex (m_readBuffer->data (), m_readBuffer->size ());
             }
         }
     }
@@ -1157,11 +1168,10 @@ private:
     {
         if (!m_detaching)
         {
-            m_readBuffer.clear ();
-            m_readBuffer.resize (PackedMessage::kHeaderBytes);
+            m_readBuffer = nullptr;
 
             boost::asio::async_read (getStream (),
-                boost::asio::buffer (m_readBuffer),
+                boost::asio::buffer (m_readHeader),
                 m_strand.wrap (boost::bind (&PeerImp::handleReadHeader,
                     boost::static_pointer_cast <PeerImp> (shared_from_this ()),
                     boost::asio::placeholders::error,
@@ -1171,17 +1181,19 @@ private:
 
     void startReadBody (unsigned msg_len)
     {
-        // The first PackedMessage::kHeaderBytes bytes of m_readbuf already
-        // contains the header. Expand it to fit in the body as well, and
-        // start async read into the body.
+        // The header is in m_readHeader. Take a pooled frame big enough
+        // for the header and body, and start async read into the body.
 
         if (!m_detaching)
         {
-            m_readBuffer.resize (PackedMessage::kHeaderBytes + msg_len);
+            m_readBuffer = MessageBuffer::make (
+                PackedMessage::kHeaderBytes + msg_len);
+            memcpy (m_readBuffer->data (), m_readHeader,
+                PackedMessage::kHeaderBytes);
 
             boost::asio::async_read (getStream (),
                 boost::asio::buffer (
-                    &m_readBuffer [PackedMessage::kHeaderBytes], msg_len),
+                    m_readBuffer->data () + PackedMessage::kHeaderBytes, msg_len),
                 m_strand.wrap (boost::bind (
                     &PeerImp::handleReadBody,
                     boost::static_pointer_cast <PeerImp> (shared_from_this ()),
@@ -1197,8 +1209,13 @@ private:
         {
             mSendingPacket = packet;
 
+            // The packet holds on to the frame until the write completes
+            MessageBuffer::ptr const& frame (m_compression
+                ? packet->getCompressedFrame ()
+                : packet->getFrame ());
+
             boost::asio::async_write (getStream (),
-                boost::asio::buffer (packet->getBuffer ()),
+                boost::asio::buffer (frame->data (), frame->size ()),
                 m_strand.wrap (boost::bind (
                     &PeerImp::handleWrite,
                     boost::static_pointer_cast <PeerImp> (shared_from_this ()),
@@ -1329,6 +1346,9 @@ private:
         // take over the functionality.
         h.set_nodeprivate (true);
 
+        if (getConfig ().PEER_COMPRESSION)
+            h.set_compression (PackedMessage::kCompressionZlib);
+
         Ledger::pointer closedLedger = getApp().getLedgerMaster ().getClosedLedger ();
 
         if (closedLedger && closedLedger->isClosed ())
@@ -1416,6 +1436,10 @@ private:
 
             mHello = packet;
 
+            m_compression = getConfig ().PEER_COMPRESSION &&
+                packet.has_compression () &&
+                (packet.compression () & PackedMessage::kCompressionZlib);
+
             // Determine if this peer belongs to our cluster and get it's name
             m_clusterNode = getApp().getUNL().nodeInCluster (m_nodePublicKey, m_nodeName);
 
@@ -1536,16 +1560,22 @@ private:
             if (m_clusterNode)
                 flags |= SF_TRUSTED | SF_SIGGOOD;
 
-            if (getApp().getJobQueue().getJobCount(jtTRANSACTION) > 100)
+            if (getApp().getJobQueue().getJobCount(jtTRANSACTION) > 100 ||
+                getApp().getTxVerifier().size() > 1000)
                 m_journal.info << "Transaction queue is full";
             else if (getApp().getLedgerMaster().getValidatedLedgerAge() > 240)
                 m_journal.trace << "No new transactions until synchronized";
-            else
+            else if (isSetBit (flags, SF_SIGGOOD))
                 getApp().getJobQueue ().addJob (jtTRANSACTION,
                     "recvTransaction->checkTransaction",
                     BIND_TYPE (
                         &PeerImp::checkTransaction, P_1, flags, stx,
                         boost::weak_ptr<Peer> (shared_from_this ())));
+            else
+                getApp().getTxVerifier ().verify (stx,
+                    BIND_TYPE (
+                        &PeerImp::checkedTransaction, P_1, P_2, flags,
+                        boost::weak_ptr<Peer> (shared_from_this ())));
 
     #ifndef TRUST_NETWORK
         }
@@ -1557,7 +1587,9 @@ private:
     #endif
     }
 
-    void recvValidation (const boost::shared_ptr<protocol::TMValidation>& packet)
+    // The frame is the message as received, which is relayed unchanged
+    void recvValidation (const boost::shared_ptr<protocol::TMValidation>& packet,
+        MessageBuffer::ptr const& frame)
     {
         std::uint32_t closeTime = getApp().getOPs().getCloseTimeNC();
 
@@ -1598,7 +1630,7 @@ private:
                     "recvValidation->checkValidation",
                     BIND_TYPE (
                         &PeerImp::checkValidation, P_1, &m_peers, val,
-                        isTrusted, m_clusterNode, packet,
+                        isTrusted, m_clusterNode, frame,
                         boost::weak_ptr<Peer> (shared_from_this ())));
             }
             else
@@ -1771,6 +1803,9 @@ private:
             bool pLDo = true;
             bool progress = false;
 
+            std::vector <std::pair <uint256, boost::shared_ptr <Blob> > > entries;
+            entries.reserve (packet.objects_size ());
+
             for (int i = 0; i < packet.objects_size (); ++i)
             {
                 const protocol::TMIndexedObject& obj = packet.objects (i);
@@ -1801,15 +1836,15 @@ private:
                         uint256 hash;
                         memcpy (hash.begin (), obj.hash ().data (), 256 / 8);
 
-                        boost::shared_ptr< Blob > data (
-                            boost::make_shared< Blob > (
-                                obj.data ().begin (), obj.data ().end ()));
-
-                        getApp().getOPs ().addFetchPack (hash, data);
+                        entries.emplace_back (hash, boost::make_shared< Blob > (
+                            obj.data ().begin (), obj.data ().end ()));
                     }
                 }
             }
 
+            // Verified together, which is much faster than one at a time
+            getApp().getOPs ().addFetchPack (entries);
+
             if ((pLDo && (pLSeq != 0)) &&
                 m_journal.active(beast::Journal::Severity::kDebug))
                 m_journal.debug << "Received partial fetch pack for " << pLSeq;
@@ -1996,7 +2031,9 @@ private:
         }
     }
 
-    void recvPropose (const boost::shared_ptr<protocol::TMProposeSet>& packet)
+    // The frame is the message as received, which is relayed unchanged
+    void recvPropose (const boost::shared_ptr<protocol::TMProposeSet>& packet,
+        MessageBuffer::ptr const& frame)
     {
         assert (packet);
         protocol::TMProposeSet& set = *packet;
@@ -2067,7 +2104,7 @@ private:
 
         getApp().getJobQueue ().addJob (isTrusted ? jtPROPOSAL_t : jtPROPOSAL_ut,
             "recvPropose->checkPropose", BIND_TYPE (
-                &PeerImp::checkPropose, P_1, &m_peers, packet, proposal, consensusLCL,
+                &PeerImp::checkPropose, P_1, &m_peers, packet, frame, proposal, consensusLCL,
                 m_nodePublicKey, boost::weak_ptr<Peer> (shared_from_this ()), m_clusterNode));
     }
 
@@ -2600,6 +2637,25 @@ private:
         }
     }
 
+    // Called from the TxVerifier once the signature has been checked
+    static void checkedTransaction (SerializedTransaction::pointer stx, bool valid,
+        int flags, boost::weak_ptr<Peer> peer)
+    {
+        if (! valid)
+        {
+            getApp().getHashRouter ().setFlag (stx->getTransactionID (), SF_BAD);
+            Peer::charge (peer, Resource::feeInvalidSignature);
+            return;
+        }
+
+        getApp().getHashRouter ().setFlag (stx->getTransactionID (), SF_SIGGOOD);
+
+        getApp().getJobQueue ().addJob (jtTRANSACTION,
+            "recvTransaction->checkTransaction",
+            BIND_TYPE (
+                &PeerImp::checkTransaction, P_1, flags | SF_SIGGOOD, stx, peer));
+    }
+
     static void checkTransaction (Job&, int flags, SerializedTransaction::pointer stx, boost::weak_ptr<Peer> peer)
     {
     #ifndef TRUST_NETWORK
@@ -2644,6 +2700,7 @@ private:
 
     // Called from our JobQueue
     static void checkPropose (Job& job, Peers* pPeers, boost::shared_ptr<protocol::TMProposeSet> packet,
+                              MessageBuffer::ptr frame,
                               LedgerProposal::pointer proposal, uint256 consensusLCL, RippleAddress nodePublic,
                               boost::weak_ptr<Peer> peer, bool fromCluster)
     {
@@ -2693,7 +2750,7 @@ private:
 
         if (isTrusted)
         {
-            getApp().getOPs ().processTrustedProposal (proposal, packet, nodePublic, prevLedger, sigGood);
+            getApp().getOPs ().processTrustedProposal (proposal, packet, frame, nodePublic, prevLedger, sigGood);
         }
         else if (sigGood && (prevLedger == consensusLCL))
         {
@@ -2705,7 +2762,7 @@ private:
                 proposal->getSuppressionID (), peers, SF_RELAYED))
             {
                 pPeers->foreach (send_if_not (
-                    boost::make_shared<PackedMessage> (set, protocol::mtPROPOSE_LEDGER),
+                    boost::make_shared<PackedMessage> (frame),
                     peer_in_set(peers)));
 	    }
         }
@@ -2716,7 +2773,7 @@ private:
     }
 
     static void checkValidation (Job&, Peers* pPeers, SerializedValidation::pointer val, bool isTrusted, bool isCluster,
-                                 boost::shared_ptr<protocol::TMValidation> packet, boost::weak_ptr<Peer> peer)
+                                 MessageBuffer::ptr frame, boost::weak_ptr<Peer> peer)
     {
     #ifndef TRUST_NETWORK
 
@@ -2757,7 +2814,7 @@ private:
                     getApp().getHashRouter ().swapSet (signingHash, peers, SF_RELAYED))
             {
                 pPeers->foreach (send_if_not (
-                    boost::make_shared<PackedMessage> (*packet, protocol::mtVALIDATION),
+                    boost::make_shared<PackedMessage> (frame),
                     peer_in_set(peers))); 
             }
         }
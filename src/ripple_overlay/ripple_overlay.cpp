@@ -28,6 +28,9 @@
 #include "../ripple_app/misc/ProofOfWork.h"
 #include "../ripple_app/misc/ProofOfWorkFactory.h"
 
+#include BEAST_ZLIB_INCLUDE_PATH
+
+#include "impl/MessageBuffer.cpp"
 #include "impl/PackedMessage.cpp"
 #include "impl/PeerImp.h"
 #include "impl/PeerDoor.cpp"
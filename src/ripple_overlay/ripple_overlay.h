@@ -22,6 +22,7 @@
 
 #include "../ripple_data/ripple_data.h"
 
+#include "api/MessageBuffer.h"
 #include "api/PackedMessage.h"
 #include "api/Peer.h"
 #include "api/Peers.h"